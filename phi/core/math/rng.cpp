@@ -1,5 +1,7 @@
 #include "rng.hpp"
 
+#include <cmath>
+
 namespace Phi
 {
     RNG::RNG(uint32_t seed)
@@ -57,4 +59,104 @@ namespace Phi
         std::uniform_int_distribution<int> dist(min, max);
         return dist(engine);
     }
+
+    CounterRNG::CounterRNG(uint32_t seed, uint32_t stream)
+    {
+        this->stream = stream;
+        SetSeed(seed);
+    }
+
+    CounterRNG::~CounterRNG()
+    {
+    }
+
+    void CounterRNG::SetSeed(uint32_t seed)
+    {
+        this->seed = seed;
+
+        // Scramble seed and stream into a random starting point of the 2^64 sequence
+        // so neighbouring seeds / streams give unrelated (and practically never overlapping) outputs
+        key = Mix(((uint64_t)stream << 32) | seed);
+
+        Reseed();
+    }
+
+    glm::vec3 CounterRNG::RandomDirection()
+    {
+        // Marsaglia (1972): rejection sample the unit disk and project onto the sphere
+        while (true)
+        {
+            float u = NextFloat() * 2.0f - 1.0f;
+            float v = NextFloat() * 2.0f - 1.0f;
+            float s = u * u + v * v;
+            if (s < 1.0f)
+            {
+                float r = 2.0f * std::sqrt(1.0f - s);
+                return glm::vec3(u * r, v * r, 1.0f - 2.0f * s);
+            }
+        }
+    }
+
+    glm::vec3 CounterRNG::RandomPosition(const glm::vec3& min, const glm::vec3& max)
+    {
+        float x = NextFloat(min.x, max.x);
+        float y = NextFloat(min.y, max.y);
+        float z = NextFloat(min.z, max.z);
+        return glm::vec3(x, y, z);
+    }
+
+    void CounterRNG::FillUInts(uint32_t* out, int count)
+    {
+        for (int i = 0; i < count; ++i) out[i] = Generate(key, counter + i);
+        counter += count;
+    }
+
+    void CounterRNG::FillFloats(float* out, int count, float min, float max)
+    {
+        if (max < min)
+        {
+            for (int i = 0; i < count; ++i) out[i] = min;
+            return;
+        }
+
+        float range = max - min;
+        for (int i = 0; i < count; ++i) out[i] = min + range * ToFloat(Generate(key, counter + i));
+        counter += count;
+    }
+
+    void CounterRNG::FillInts(int* out, int count, int min, int max)
+    {
+        if (max < min)
+        {
+            for (int i = 0; i < count; ++i) out[i] = min;
+            return;
+        }
+
+        for (int i = 0; i < count; ++i) out[i] = ToInt(Generate(key, counter + i), min, max);
+        counter += count;
+    }
+
+    void CounterRNG::FillDirections(glm::vec3* out, int count)
+    {
+        // Rejection sampling consumes a variable amount of the sequence per direction
+        for (int i = 0; i < count; ++i) out[i] = RandomDirection();
+    }
+
+    void CounterRNG::FillPositions(glm::vec3* out, int count, const glm::vec3& min, const glm::vec3& max)
+    {
+        // Like NextFloat(min, max), axes where max < min don't consume a value
+        const bool drawX = !(max.x < min.x), drawY = !(max.y < min.y), drawZ = !(max.z < min.z);
+        const uint64_t offsetY = drawX;
+        const uint64_t offsetZ = offsetY + drawY;
+        const uint64_t stride = offsetZ + drawZ;
+        for (int i = 0; i < count; ++i)
+        {
+            uint64_t n = counter + i * stride;
+            float x = drawX ? min.x + (max.x - min.x) * ToFloat(Generate(key, n)) : min.x;
+            float y = drawY ? min.y + (max.y - min.y) * ToFloat(Generate(key, n + offsetY)) : min.y;
+            float z = drawZ ? min.z + (max.z - min.z) * ToFloat(Generate(key, n + offsetZ)) : min.z;
+            out[i] = glm::vec3(x, y, z);
+        }
+        counter += (uint64_t)count * stride;
+    }
 }
\ No newline at end of file
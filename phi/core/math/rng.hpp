@@ -103,4 +103,127 @@ namespace Phi
             std::uniform_int_distribution<int> d20Dist{1, 20};
             std::uniform_int_distribution<int> d100Dist{1, 100};
     };
+
+    // Counter-based pseudo random number generator
+    //
+    // The nth output is a pure function of (seed, stream, n): the SplitMix64
+    // output function applied to a Weyl sequence keyed by the seed and stream.
+    // This makes the generator cheap to copy, snapshot and split into
+    // independent sub-streams for parallel simulation that stays reproducible
+    // regardless of how work is scheduled across threads
+    //
+    // The bulk Fill*() methods produce exactly the same sequence as the
+    // equivalent single-value calls, but in tight loops the compiler can vectorize
+    class CounterRNG
+    {
+        // Interface
+        public:
+
+            CounterRNG(uint32_t seed = 0, uint32_t stream = 0);
+            ~CounterRNG();
+
+            // Default copy constructor/assignment
+            CounterRNG(const CounterRNG&) = default;
+            CounterRNG& operator=(const CounterRNG&) = default;
+
+            // Default move constructor/assignment
+            CounterRNG(CounterRNG&& other) = default;
+            CounterRNG& operator=(CounterRNG&& other) = default;
+
+            // Seed management
+
+            // Sets the seed of this RNG instance and restarts its sequence
+            void SetSeed(uint32_t seed);
+
+            // Gets the seed of this RNG instance
+            inline uint32_t GetSeed() const { return seed; }
+
+            // Gets the sub-stream this instance generates
+            inline uint32_t GetStream() const { return stream; }
+
+            // Resets to the initial value for the current seed and stream
+            inline void Reseed() { counter = 0; }
+
+            // Gets the position in the sequence (the number of values generated since seeding)
+            inline uint64_t GetCounter() const { return counter; }
+
+            // Jumps to the given position in the sequence, used to restore saved states
+            inline void SetCounter(uint64_t counter) { this->counter = counter; }
+
+            // Returns a generator for an independent sub-stream of the current seed
+            // The same (seed, streamId) pair always produces the same sequence
+            CounterRNG Split(uint32_t streamId) const { return CounterRNG(seed, streamId); }
+
+            // Basic RNG
+
+            // Generates a uniformly distributed 32-bit unsigned integer
+            inline uint32_t NextUInt() { return Generate(key, counter++); }
+
+            // Generates a uniformly distributed float in the range [0, 1)
+            inline float NextFloat() { return ToFloat(NextUInt()); }
+
+            // Generates a uniformly distributed boolean
+            inline bool FlipCoin() { return NextUInt() >> 31; }
+
+            // Custom generation
+
+            // Generates a uniformly distributed float within the range [min, max)
+            // NOTE: If max < min, min is always returned as a fail-safe
+            inline float NextFloat(float min, float max) { return max < min ? min : min + (max - min) * NextFloat(); }
+
+            // Generates a uniformly distributed int within the range [min, max]
+            // NOTE: If max < min, min is always returned as a fail-safe
+            inline int NextInt(int min, int max) { return max < min ? min : ToInt(NextUInt(), min, max); }
+
+            // Vector generation
+
+            // Returns a normalized 3D direction vector, uniformly distributed over the unit sphere
+            glm::vec3 RandomDirection();
+
+            // Returns a random position within the minimum and maximum bounds given
+            glm::vec3 RandomPosition(const glm::vec3& min, const glm::vec3& max);
+
+            // Bulk generation
+            // Each fills count elements starting at out
+
+            void FillUInts(uint32_t* out, int count);
+            void FillFloats(float* out, int count, float min = 0.0f, float max = 1.0f);
+            void FillInts(int* out, int count, int min, int max);
+            void FillDirections(glm::vec3* out, int count);
+            void FillPositions(glm::vec3* out, int count, const glm::vec3& min, const glm::vec3& max);
+
+        // Data / implementation
+        private:
+
+            // Seed, stream and the key derived from them
+            uint32_t seed;
+            uint32_t stream;
+            uint64_t key;
+
+            // Position in the sequence
+            uint64_t counter = 0;
+
+            // SplitMix64 output function (Steele et al. 2014)
+            static inline uint64_t Mix(uint64_t z)
+            {
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            }
+
+            // Returns the output at position n of the sequence for the given key
+            static inline uint32_t Generate(uint64_t key, uint64_t n)
+            {
+                return (uint32_t)(Mix(key + (n + 1) * 0x9E3779B97F4A7C15ull) >> 32);
+            }
+
+            // Conversions from raw 32-bit values
+            static inline float ToFloat(uint32_t x) { return (x >> 8) * (1.0f / 16'777'216.0f); }
+            static inline int ToInt(uint32_t x, int min, int max)
+            {
+                // Multiply-shift range reduction (no modulo, handles the full int range)
+                uint64_t range = (uint64_t)((int64_t)max - min) + 1;
+                return (int)(min + (int64_t)((x * range) >> 32));
+            }
+    };
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Phi
+{
+    // Helpers for compact native binary formats
+    // Values are stored in native byte order and layout, so data is only portable between identical builds
+    namespace Serialization
+    {
+        // Appends a trivially copyable value
+        template <typename T>
+        inline void Write(std::vector<char>& out, const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written directly");
+            const char* bytes = (const char*)&value;
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+
+        // Appends count trivially copyable values
+        template <typename T>
+        inline void WriteArray(std::vector<char>& out, const T* values, size_t count)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written directly");
+            const char* bytes = (const char*)values;
+            out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+        }
+
+        // Appends a uint32_t length followed by the characters
+        inline void WriteString(std::vector<char>& out, const std::string& value)
+        {
+            Write(out, (uint32_t)value.size());
+            out.insert(out.end(), value.begin(), value.end());
+        }
+
+        // Reads a value and advances the cursor, returns false if there isn't enough data left
+        template <typename T>
+        inline bool Read(const char*& cursor, const char* end, T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read directly");
+            if (end - cursor < (ptrdiff_t)sizeof(T)) return false;
+            std::memcpy(&value, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return true;
+        }
+
+        // Reads count values and advances the cursor, returns false if there isn't enough data left
+        template <typename T>
+        inline bool ReadArray(const char*& cursor, const char* end, T* values, size_t count)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read directly");
+            if ((size_t)(end - cursor) < sizeof(T) * count) return false;
+            std::memcpy(values, cursor, sizeof(T) * count);
+            cursor += sizeof(T) * count;
+            return true;
+        }
+
+        // Reads a string written by WriteString() and advances the cursor
+        inline bool ReadString(const char*& cursor, const char* end, std::string& value)
+        {
+            uint32_t length = 0;
+            if (!Read(cursor, end, length) || end - cursor < (ptrdiff_t)length) return false;
+            value.assign(cursor, length);
+            cursor += length;
+            return true;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace Phi
+{
+    // Standard library compatible allocator that aligns every allocation to the given boundary
+    // Useful for containers whose data is processed with aligned SIMD loads / stores
+    // Alignment must be a power of two and at least alignof(T)
+    template <typename T, size_t Alignment = 32>
+    class AlignedAllocator
+    {
+        // Interface
+        public:
+
+            typedef T value_type;
+
+            // Rebinding support for containers that allocate other types internally
+            template <typename U>
+            struct rebind
+            {
+                typedef AlignedAllocator<U, Alignment> other;
+            };
+
+            AlignedAllocator() = default;
+
+            // Converting constructor required by the allocator requirements
+            template <typename U>
+            AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+            // Allocates uninitialized storage for n elements
+            T* allocate(size_t n)
+            {
+                return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+            }
+
+            // Frees storage previously obtained from allocate()
+            void deallocate(T* p, size_t)
+            {
+                ::operator delete(p, std::align_val_t(Alignment));
+            }
+
+            // All instances are interchangeable
+            template <typename U>
+            bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+
+            template <typename U>
+            bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+    };
+}
\ No newline at end of file
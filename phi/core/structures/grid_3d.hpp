@@ -40,6 +40,12 @@ namespace Phi
                 return data[Index(x, y, z)];
             }
 
+            // Fast read-only access, no bounds checking
+            inline const T& operator()(int x, int y, int z) const
+            {
+                return data[Index(x, y, z)];
+            }
+
             // Clears the grid (default initializes each entry)
             void Clear();
 
@@ -0,0 +1,100 @@
+#include "thread_pool.hpp"
+
+namespace Phi
+{
+    ThreadPool::ThreadPool(int numThreads)
+    {
+        // Default to the hardware concurrency
+        if (numThreads < 1) numThreads = (int)std::thread::hardware_concurrency();
+        if (numThreads < 1) numThreads = 1;
+
+        // The calling thread counts as one
+        workers.reserve(numThreads - 1);
+        for (int i = 0; i < numThreads - 1; ++i)
+        {
+            workers.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        // Signal all workers to exit
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        workReady.notify_all();
+
+        // Wait for them to finish
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::ParallelFor(int count, const std::function<void(int)>& job)
+    {
+        if (count < 1) return;
+
+        // Run inline when there is no one to share the work with
+        if (workers.empty() || count == 1)
+        {
+            for (int i = 0; i < count; ++i) job(i);
+            return;
+        }
+
+        // Publish the batch and wake the workers
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentJob = &job;
+            jobCount = count;
+            nextJob = 0;
+            busyWorkers = (int)workers.size();
+            generation++;
+        }
+        workReady.notify_all();
+
+        // Help out on the calling thread
+        RunJobs();
+
+        // Wait until every job has finished and every worker has let go of the batch
+        std::unique_lock<std::mutex> lock(mutex);
+        workDone.wait(lock, [this]{ return busyWorkers == 0; });
+        currentJob = nullptr;
+    }
+
+    void ThreadPool::RunJobs()
+    {
+        // Claim jobs one at a time so uneven workloads balance out
+        int i;
+        while ((i = nextJob.fetch_add(1, std::memory_order_relaxed)) < jobCount)
+        {
+            (*currentJob)(i);
+        }
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        size_t lastGeneration = 0;
+
+        while (true)
+        {
+            // Wait for a new batch (or shutdown)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workReady.wait(lock, [&]{ return stopping || generation != lastGeneration; });
+                if (stopping) return;
+                lastGeneration = generation;
+            }
+
+            RunJobs();
+
+            // Report back
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busyWorkers--;
+            }
+            workDone.notify_one();
+        }
+    }
+}
\ No newline at end of file
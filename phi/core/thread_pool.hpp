@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Phi
+{
+    // A fixed set of persistent worker threads used to split
+    // independent jobs across cores without per-frame thread creation
+    class ThreadPool
+    {
+        // Interface
+        public:
+
+            // Creates a pool that runs jobs on the given number of threads
+            // The calling thread always participates, so numThreads - 1 workers are spawned
+            // Values less than 1 use every hardware thread available
+            ThreadPool(int numThreads = 0);
+
+            ~ThreadPool();
+
+            // Delete copy constructor/assignment
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            // Delete move constructor/assignment
+            ThreadPool(ThreadPool&& other) = delete;
+            ThreadPool& operator=(ThreadPool&& other) = delete;
+
+            // Calls job(i) for every i in [0, count) and blocks until all calls have returned
+            // Calls may run concurrently and in any order, so jobs must be independent
+            // NOTE: Must not be called from inside a job
+            void ParallelFor(int count, const std::function<void(int)>& job);
+
+            // Returns the number of threads jobs are spread across (including the caller)
+            int GetThreadCount() const { return (int)workers.size() + 1; }
+
+        // Data / implementation
+        private:
+
+            // Worker threads
+            std::vector<std::thread> workers;
+
+            // Current batch of work
+            const std::function<void(int)>* currentJob = nullptr;
+            int jobCount = 0;
+            std::atomic<int> nextJob = 0;
+
+            // Synchronization
+            std::mutex mutex;
+            std::condition_variable workReady;
+            std::condition_variable workDone;
+            size_t generation = 0;
+            int busyWorkers = 0;
+            bool stopping = false;
+
+            // Runs jobs from the current batch until none are left
+            void RunJobs();
+
+            // Worker thread entry point
+            void WorkerLoop();
+    };
+}
\ No newline at end of file
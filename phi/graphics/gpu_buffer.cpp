@@ -255,6 +255,22 @@ namespace Phi
         return true;
     }
 
+    void* GPUBuffer::Reserve(GLuint size)
+    {
+        // Ensure buffer has space for write
+        if (!CanWrite(size))
+        {
+            Phi::Error("Buffer reserve failed @", this, ", would have overflowed");
+            return nullptr;
+        }
+
+        void* reserved = pCurrent;
+
+        pCurrent += size;
+
+        return reserved;
+    }
+
     void GPUBuffer::Overwrite(const void* const data, GLuint size)
     {
         glBindBuffer(GL_ARRAY_BUFFER, id);
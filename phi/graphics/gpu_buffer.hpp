@@ -63,6 +63,11 @@ namespace Phi
             bool Write(const DrawArraysCommand& cmd);
             bool Write(const void* const data, GLuint size);
 
+            // Reserves size bytes at the current write position and advances past them
+            // Returns a pointer to the reserved (mapped) memory, or nullptr if it would overflow
+            // Useful for producing data directly in the buffer instead of copying it in
+            void* Reserve(GLuint size);
+
             // Overwrites the entire buffer using glBufferData
             // NOTE: Only valid on static buffers, and will give the
             // GL_DYNAMIC_DRAW hint instead of the default GL_STATIC_DRAW
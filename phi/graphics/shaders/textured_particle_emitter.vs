@@ -32,7 +32,7 @@ layout(std430, binding = 0) buffer EmitterSSBO
 layout(location = 0) in vec3 vQuad;
 
 // Instanced particle vertex data
-layout(location = 1) in vec3 vPos;
+layout(location = 1) in vec4 vPos; // xyz = position, w = color intensity
 layout(location = 2) in vec4 vColor;
 layout(location = 3) in vec2 vSize;
 
@@ -49,14 +49,14 @@ void main()
     vec3 cameraRight = invView[0].xyz;
 
     // Calculate final worldspace position
-    vec3 vertexPosWorld = (emitters[gl_DrawID].transform * vec4(vPos, 1.0)).xyz + (cameraRight * vQuad.x * vSize.x) + (cameraUp * vQuad.y * vSize.y);
+    vec3 vertexPosWorld = (emitters[gl_DrawID].transform * vec4(vPos.xyz, 1.0)).xyz + (cameraRight * vQuad.x * vSize.x) + (cameraUp * vQuad.y * vSize.y);
 
     // Set gl_Position
     gl_Position = viewProj * vec4(vertexPosWorld, 1.0);
 
     // Fragment shader outputs
     fragPos = vertexPosWorld;
-    fragColor = vec4(vColor.rgb * vColor.a, vColor.a);
+    fragColor = vec4(vColor.rgb * vPos.w * vColor.a, vColor.a);
     uv = vQuad.xy + vec2(0.5);
     texID = emitters[gl_DrawID].textureID.x;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #version 460
 
 const int MAX_MATERIALS = 1024;
+const int HIDDEN_MATERIAL = -2;
 
 // Global time
 uniform float time;
@@ -100,6 +101,13 @@ void main()
     ivec3 voxelPos = ivec3(bitfieldExtract(int(voxel.x), 0, 16), bitfieldExtract(int(voxel.x), 16, 16), bitfieldExtract(int(voxel.y), 0, 16));
     int voxelMaterial = bitfieldExtract(int(voxel.y), 16, 16);
 
+    // Slots kept for removed voxels collapse to a single point, leaving no triangles to draw
+    if (voxelMaterial == HIDDEN_MATERIAL)
+    {
+        gl_Position = vec4(0.0);
+        return;
+    }
+
     // Mirroring hack (render only 3 faces per voxel)
     
     // Calculate mirror mask
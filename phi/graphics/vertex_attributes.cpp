@@ -125,6 +125,11 @@ namespace Phi
                 currentOffset += numComponents * sizeof(GLint);
                 break;
             
+            case GL_HALF_FLOAT:
+                glVertexAttribPointer(attribCount, numComponents, type, normalized, stride, (void*)offset);
+                currentOffset += numComponents * sizeof(GLhalf);
+                break;
+
             case GL_UNSIGNED_BYTE:
                 glVertexAttribPointer(attribCount, numComponents, type, normalized, stride, (void*)offset);
                 currentOffset += numComponents * sizeof(GLubyte);
@@ -9,11 +9,14 @@
 #include "core/input.hpp"
 #include "core/logging.hpp"
 #include "core/resource_manager.hpp"
+#include "core/serialization.hpp"
+#include "core/thread_pool.hpp"
 #include "core/math/aggregate_volume.hpp"
 #include "core/math/constants.hpp"
 #include "core/math/noise.hpp"
 #include "core/math/rng.hpp"
 #include "core/math/shapes.hpp"
+#include "core/structures/aligned_allocator.hpp"
 #include "core/structures/free_list.hpp"
 #include "core/structures/grid_3d.hpp"
 #include "core/structures/quadtree.hpp"
@@ -42,11 +45,23 @@
 #include "scene/components/collision/bounding_sphere.hpp"
 #include "scene/components/lighting/directional_light.hpp"
 #include "scene/components/lighting/point_light.hpp"
+#include "scene/components/particles/attractor_field.hpp"
 #include "scene/components/particles/cpu_particle_effect.hpp"
+#include "scene/components/particles/cpu_particle_effect_pool.hpp"
 #include "scene/components/particles/cpu_particle_emitter.hpp"
+#include "scene/components/particles/particle_arena.hpp"
+#include "scene/components/particles/particle_budget.hpp"
+#include "scene/components/particles/particle_collider.hpp"
+#include "scene/components/particles/particle_data.hpp"
+#include "scene/components/particles/particle_flock.hpp"
+#include "scene/components/particles/particle_kernels.hpp"
+#include "scene/components/particles/particle_packing.hpp"
+#include "scene/components/particles/particle_sorter.hpp"
+#include "scene/components/particles/turbulence_field.hpp"
 #include "scene/components/renderable/basic_mesh.hpp"
 #include "scene/components/renderable/environment.hpp"
 #include "scene/components/renderable/voxel_mesh.hpp"
+#include "scene/components/simulation/voxel_bricks.hpp"
 #include "scene/components/simulation/voxel_chunk.hpp"
 #include "scene/components/simulation/voxel_map.hpp"
 #include "scene/components/simulation/voxel_material.hpp"
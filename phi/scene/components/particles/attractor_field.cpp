@@ -0,0 +1,162 @@
+#include "attractor_field.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Phi
+{
+    AttractorField::AttractorField()
+    {
+    }
+
+    AttractorField::~AttractorField()
+    {
+    }
+
+    void AttractorField::Bake(const ParticleKernels::AttractorData* attractors, int count, int resolution)
+    {
+        // Remember what we were baked from
+        baked.assign(attractors, attractors + count);
+        this->resolution = resolution = std::max(resolution, 2);
+
+        // Bounds of every sphere of influence, the field is zero outside
+        glm::vec3 max{0.0f};
+        min = glm::vec3(0.0f);
+        for (int i = 0; i < count; ++i)
+        {
+            glm::vec3 attractorMin = attractors[i].position - attractors[i].radius;
+            glm::vec3 attractorMax = attractors[i].position + attractors[i].radius;
+            min = i == 0 ? attractorMin : glm::min(min, attractorMin);
+            max = i == 0 ? attractorMax : glm::max(max, attractorMax);
+        }
+
+        cellSize = glm::max((max - min) / (float)(resolution - 1), glm::vec3(1e-6f));
+        invCellSize = 1.0f / cellSize;
+
+        // Evaluate the exact field at every sample
+        grid.Resize(resolution, resolution, resolution);
+        for (int z = 0; z < resolution; ++z)
+        {
+            for (int y = 0; y < resolution; ++y)
+            {
+                for (int x = 0; x < resolution; ++x)
+                {
+                    grid(x, y, z) = Evaluate(attractors, count, min + glm::vec3(x, y, z) * cellSize);
+                }
+            }
+        }
+    }
+
+    bool AttractorField::Matches(const ParticleKernels::AttractorData* attractors, int count, int resolution) const
+    {
+        if (count != (int)baked.size() || std::max(resolution, 2) != this->resolution) return false;
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (attractors[i].position != baked[i].position ||
+                attractors[i].radius != baked[i].radius ||
+                attractors[i].strength != baked[i].strength)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    glm::vec3 AttractorField::Sample(const glm::vec3& position) const
+    {
+        // A single particle at rest accelerated for one second
+        glm::vec3 acceleration{0.0f};
+        Apply(&position.x, &position.y, &position.z, &acceleration.x, &acceleration.y, &acceleration.z, 1.0f, 1);
+        return acceleration;
+    }
+
+    void AttractorField::Apply(const float* posX, const float* posY, const float* posZ,
+                               float* velX, float* velY, float* velZ, float delta, int count) const
+    {
+        const float limit = (float)(resolution - 1);
+        const int dy = resolution;
+        const int dz = resolution * resolution;
+
+        for (int i = 0; i < count; ++i)
+        {
+            // Continuous grid coordinates
+            float gx = (posX[i] - min.x) * invCellSize.x;
+            float gy = (posY[i] - min.y) * invCellSize.y;
+            float gz = (posZ[i] - min.z) * invCellSize.z;
+
+            // Outside of the grid there are no attractors in range
+            // NOTE: Bitwise & keeps this a single, well predicted branch
+            bool inside = (gx >= 0.0f) & (gy >= 0.0f) & (gz >= 0.0f) & (gx < limit) & (gy < limit) & (gz < limit);
+            if (!inside) continue;
+
+            // Cell and position within it
+            int x = (int)gx;
+            int y = (int)gy;
+            int z = (int)gz;
+            float fx = gx - x;
+            float fy = gy - y;
+            float fz = gz - z;
+
+            // Corner samples, rows are contiguous in x
+            const glm::vec3* c000 = &grid(x, y, z);
+            const glm::vec3* c010 = c000 + dy;
+            const glm::vec3* c001 = c000 + dz;
+            const glm::vec3* c011 = c000 + dy + dz;
+
+            // Trilinear interpolation
+            glm::vec3 x00 = c000[0] + (c000[1] - c000[0]) * fx;
+            glm::vec3 x10 = c010[0] + (c010[1] - c010[0]) * fx;
+            glm::vec3 x01 = c001[0] + (c001[1] - c001[0]) * fx;
+            glm::vec3 x11 = c011[0] + (c011[1] - c011[0]) * fx;
+            glm::vec3 y0 = x00 + (x10 - x00) * fy;
+            glm::vec3 y1 = x01 + (x11 - x01) * fy;
+            glm::vec3 acceleration = y0 + (y1 - y0) * fz;
+
+            velX[i] += acceleration.x * delta;
+            velY[i] += acceleration.y * delta;
+            velZ[i] += acceleration.z * delta;
+        }
+    }
+
+    float AttractorField::ErrorBound(const glm::vec3& position) const
+    {
+        float h = glm::length(cellSize);
+
+        float bound = 0.0f;
+        for (const auto& attractor : baked)
+        {
+            float distance = glm::distance(position, attractor.position);
+
+            // Every sample used is outside of the radius, both values are zero
+            if (distance >= attractor.radius + h) continue;
+
+            // Interpolated and exact values are both at most |s| in magnitude
+            float strength = std::abs(attractor.strength);
+            float nearest = distance - h;
+            bound += nearest > 0.0f ? strength * std::min(2.0f, h * (1.0f / nearest + 1.0f / attractor.radius)) : 2.0f * strength;
+        }
+
+        return bound;
+    }
+
+    glm::vec3 AttractorField::Evaluate(const ParticleKernels::AttractorData* attractors, int count, const glm::vec3& position)
+    {
+        glm::vec3 acceleration{0.0f};
+        for (int i = 0; i < count; ++i)
+        {
+            const auto& attractor = attractors[i];
+
+            // Same falloff as ParticleKernels::Attract
+            glm::vec3 d = attractor.position - position;
+            float distance = glm::length(d);
+            if (distance < attractor.radius && distance > 0.0f)
+            {
+                acceleration += d * (attractor.strength * (1.0f - distance * (1.0f / attractor.radius)) / distance);
+            }
+        }
+
+        return acceleration;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <phi/core/structures/grid_3d.hpp>
+#include <phi/scene/components/particles/particle_kernels.hpp>
+
+namespace Phi
+{
+    // A set of attractors baked into a coarse 3D grid of accelerations
+    //
+    // Sampling the field costs one trilinear fetch per particle regardless of how many
+    // attractors were baked into it, at the cost of accuracy near attractor centers
+    //
+    // Error bound: the exact acceleration of a single attractor with strength s and radius r
+    // at distance d from its center is continuous everywhere except the center, and Lipschitz
+    // with constant |s| * (1 / d + 1 / r). Trilinear interpolation returns a convex combination
+    // of the cell's corner values, each within one cell diagonal h of the particle, so the error
+    // per attractor is at most |s| * min(2, h * (1 / (d - h) + 1 / r)), and zero when d >= r + h.
+    // ErrorBound() sums this over all attractors
+    class AttractorField
+    {
+        // Interface
+        public:
+
+            AttractorField();
+            ~AttractorField();
+
+            // Delete copy constructor/assignment
+            AttractorField(const AttractorField&) = delete;
+            AttractorField& operator=(const AttractorField&) = delete;
+
+            // Delete move constructor/assignment
+            AttractorField(AttractorField&& other) = delete;
+            AttractorField& operator=(AttractorField&& other) = delete;
+
+            // Bakes the given attractors into a grid with resolution samples along each axis
+            // covering the bounds of every attractor's sphere of influence
+            void Bake(const ParticleKernels::AttractorData* attractors, int count, int resolution);
+
+            // Returns true if the field was baked from exactly these attractors and resolution
+            bool Matches(const ParticleKernels::AttractorData* attractors, int count, int resolution) const;
+
+            // Returns the interpolated acceleration at the given position
+            glm::vec3 Sample(const glm::vec3& position) const;
+
+            // Accelerates count particles by the interpolated field over delta seconds
+            void Apply(const float* posX, const float* posY, const float* posZ,
+                       float* velX, float* velY, float* velZ, float delta, int count) const;
+
+            // Returns the maximum error of Sample() at the given position vs the exact acceleration
+            float ErrorBound(const glm::vec3& position) const;
+
+            // Accessors
+            int GetResolution() const { return resolution; }
+            const glm::vec3& GetCellSize() const { return cellSize; }
+
+            // Returns the exact acceleration from the given attractors at a position
+            // Matches ParticleKernels::Attract for a delta of 1
+            static glm::vec3 Evaluate(const ParticleKernels::AttractorData* attractors, int count, const glm::vec3& position);
+
+        // Data / implementation
+        private:
+
+            // Grid of accelerations
+            Grid3D<glm::vec3> grid{1, 1, 1, glm::vec3(0.0f)};
+            int resolution = 0;
+
+            // World space placement of the grid
+            glm::vec3 min{0.0f};
+            glm::vec3 cellSize{1.0f};
+            glm::vec3 invCellSize{1.0f};
+
+            // Attractors the field was baked from
+            std::vector<ParticleKernels::AttractorData> baked;
+    };
+}
\ No newline at end of file
@@ -1,16 +1,31 @@
 #include "cpu_particle_effect.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <filesystem>
 #include <iostream>
+#include <type_traits>
 
 #include <yaml-cpp/yaml.h>
 #include <phi/core/file.hpp>
 #include <phi/core/logging.hpp>
+#include <phi/core/serialization.hpp>
 #include <phi/scene/node.hpp>
 
 namespace Phi
 {
+    namespace
+    {
+        // Whether a mode read from a compiled effect is one of the values up to and including the last one
+        template <typename Mode>
+        bool ValidMode(Mode mode, Mode last)
+        {
+            return (int)mode >= 0 && (int)mode <= (int)last;
+        }
+    }
+
     CPUParticleEffect::CPUParticleEffect()
     {
     }
@@ -29,53 +44,241 @@ namespace Phi
 
     void CPUParticleEffect::Update(float delta)
     {
+        // Paused effects don't simulate at all
+        if (state == State::Paused) return;
+
         // Grab sibling transform component
         glm::mat4 transform = glm::mat4(1.0f);
         Transform* t = GetNode()->Get<Transform>();
         if (t) transform = t->GetGlobalMatrix();
 
-        switch (state)
+        // Gather voxels to collide with
+        UpdateColliders(transform);
+
+        // Skip this frame if the level of detail says so
+        float tickDelta = 0.0f;
+        if (!UpdateLOD(delta, transform, tickDelta)) return;
+
+        // Update all emitters, stopped effects still simulate and despawn particles
+        for (auto& emitter : loadedEmitters)
         {
-            case State::Play:
+            emitter.SetFixedTimestep(fixedTimestep, maxSubsteps);
+            emitter.Update(tickDelta, state == State::Play, spawnRelativeTransform, transform, &collider);
+        }
+    }
 
-                // Update all emitters
-                for (auto& emitter : loadedEmitters)
-                {
-                    emitter.Update(delta, true, spawnRelativeTransform, transform);
-                }
+    void CPUParticleEffect::QueueUpdates(std::vector<EmitterUpdate>& updates, float delta)
+    {
+        // Paused effects don't simulate at all
+        if (state == State::Paused) return;
 
-                break;
-            
-            case State::Stopped:
+        // Grab sibling transform component
+        glm::mat4 transform = glm::mat4(1.0f);
+        Transform* t = GetNode()->Get<Transform>();
+        if (t) transform = t->GetGlobalMatrix();
 
-                // Update all emitters
-                for (auto& emitter : loadedEmitters)
-                {
-                    emitter.Update(delta, false, spawnRelativeTransform, transform);
-                }
+        // Gather voxels to collide with
+        UpdateColliders(transform);
 
-                break;
-            
-            default:
-                break;
+        // Skip this frame if the level of detail says so
+        float tickDelta = 0.0f;
+        if (!UpdateLOD(delta, transform, tickDelta)) return;
+
+        // Queue all emitters
+        for (auto& emitter : loadedEmitters)
+        {
+            emitter.SetFixedTimestep(fixedTimestep, maxSubsteps);
+            updates.push_back({&emitter, transform, tickDelta, state == State::Play, spawnRelativeTransform, &collider});
         }
     }
 
+    void CPUParticleEffect::QueueDetachedUpdates(std::vector<EmitterUpdate>& updates, float delta, const glm::mat4& transform)
+    {
+        // Paused effects don't simulate at all
+        if (state == State::Paused) return;
+
+        // Queue all emitters, there is no scene to take a level of detail or colliders from
+        for (auto& emitter : loadedEmitters)
+        {
+            emitter.SetFixedTimestep(fixedTimestep, maxSubsteps);
+            updates.push_back({&emitter, transform, delta, state == State::Play, spawnRelativeTransform, nullptr});
+        }
+    }
+
+    bool CPUParticleEffect::UpdateLOD(float delta, const glm::mat4& transform, float& tickDelta)
+    {
+        Scene& scene = GetNode()->GetScene();
+        Camera* camera = scene.GetActiveCamera();
+        bool wasDormant = lodStats.level == LODLevel::Dormant;
+
+        // Blend factor from the nearest (0) to the lowest (1) level of detail
+        float t = 0.0f;
+        if (lodSettings.enabled && camera)
+        {
+            glm::vec3 position = glm::vec3(transform[3]);
+            lodStats.distance = glm::distance(position, camera->GetPosition());
+            lodStats.visible = Sphere(position, lodSettings.radius).Intersects(camera->GetViewFrustum());
+
+            if (lodStats.visible)
+            {
+                float range = std::max(lodSettings.farDistance - lodSettings.nearDistance, 0.0001f);
+                t = glm::clamp((lodStats.distance - lodSettings.nearDistance) / range, 0.0f, 1.0f);
+                lodStats.invisibleTime = 0.0f;
+            }
+            else
+            {
+                // Off-screen effects always use the lowest level
+                t = 1.0f;
+                lodStats.invisibleTime += delta;
+            }
+        }
+        else
+        {
+            lodStats.visible = true;
+            lodStats.invisibleTime = 0.0f;
+        }
+
+        // Select the level
+        if (!lodStats.visible && lodStats.invisibleTime > GetMaxLifespan())
+        {
+            lodStats.level = LODLevel::Dormant;
+        }
+        else
+        {
+            lodStats.level = t > 0.0f ? LODLevel::Reduced : LODLevel::Full;
+        }
+
+        // Scale tick rate and spawning, by distance and by the scene's particle budget
+        lodStats.tickInterval = 1 + (int)std::round(t * (std::max(lodSettings.maxTickInterval, 1) - 1));
+        lodStats.spawnScale = glm::mix(1.0f, lodSettings.minSpawnScale, t);
+        lodStats.budgetScale = scene.GetParticleBudget().GetScale(lodSettings.budgetPriority);
+        for (auto& emitter : loadedEmitters)
+        {
+            emitter.lodScale = lodStats.spawnScale;
+            emitter.SetBudgetScale(lodStats.budgetScale);
+        }
+
+        // Dormant effects only keep track of time
+        lodAccumulator += delta;
+        if (lodStats.level == LODLevel::Dormant)
+        {
+            lodStats.dormantFrames++;
+            return false;
+        }
+
+        // Catch up on waking
+        if (wasDormant)
+        {
+            FastForward(lodAccumulator, transform);
+            lodAccumulator = 0.0f;
+            lodFrames = 0;
+            lodStats.fastForwards++;
+            return false;
+        }
+
+        // Fold this frame into a later update if we're not due yet
+        if (++lodFrames < lodStats.tickInterval)
+        {
+            lodStats.skippedTicks++;
+            return false;
+        }
+
+        tickDelta = lodAccumulator;
+        lodAccumulator = 0.0f;
+        lodFrames = 0;
+        lodStats.ticks++;
+        return true;
+    }
+
+    void CPUParticleEffect::FastForward(float time, const glm::mat4& transform)
+    {
+        // The effect went dormant at least one max lifespan ago, so every particle alive
+        // back then has expired and only the most recent lifespan needs to be simulated
+        float simulated = std::min(time, GetMaxLifespan());
+        bool spawning = state == State::Play;
+        for (auto& emitter : loadedEmitters)
+        {
+            emitter.activeParticles = 0;
+            emitter.first = emitter.base;
+            emitter.oldest = 0;
+            if (spawning) emitter.totalElapsedTime += time - simulated;
+        }
+
+        // Simulate in small steps so spawn timings stay close to a normal run
+        int steps = (int)std::ceil(simulated / FAST_FORWARD_STEP);
+        for (int i = 0; i < steps; ++i)
+        {
+            for (auto& emitter : loadedEmitters)
+            {
+                emitter.Update(simulated / steps, spawning, spawnRelativeTransform, transform, &collider);
+            }
+        }
+    }
+
+    int CPUParticleEffect::GetActiveParticles() const
+    {
+        int count = 0;
+        for (const auto& emitter : loadedEmitters) count += emitter.GetActiveParticles();
+        return count;
+    }
+
+    void CPUParticleEffect::UpdateColliders(const glm::mat4& transform)
+    {
+        collider.Clear();
+
+        // Don't touch the scene unless some emitter collides
+        bool colliding = std::any_of(loadedEmitters.begin(), loadedEmitters.end(),
+            [](const CPUParticleEmitter& emitter) { return emitter.definition->affectorProperties.collisionEnabled; });
+        if (!colliding) return;
+
+        // Particles are in world space unless they are rendered relative to the transform
+        glm::mat4 particleToWorld = renderRelativeTransform ? transform : glm::mat4(1.0f);
+
+        Scene& scene = GetNode()->GetScene();
+        VoxelMap* map = scene.GetActiveVoxelMap();
+        if (map) collider.SetMap(map, particleToWorld);
+
+        for (auto&&[id, object] : scene.Each<VoxelObject>())
+        {
+            Transform* t = object.GetNode()->Get<Transform>();
+            glm::mat4 objectToWorld = t ? t->GetGlobalMatrix() : glm::mat4(1.0f);
+            collider.AddObject(&object, glm::inverse(objectToWorld) * particleToWorld);
+        }
+    }
+
+    float CPUParticleEffect::GetMaxLifespan() const
+    {
+        float maxLifespan = 0.0f;
+        for (const auto& emitter : loadedEmitters)
+        {
+            const auto& props = emitter.definition->particleProperties;
+            float lifespan = props.lifespanMode == CPUParticleEmitter::LifespanMode::Constant ? props.lifespan : props.lifespanMax;
+            maxLifespan = std::max(maxLifespan, lifespan);
+        }
+        return maxLifespan;
+    }
+
     void CPUParticleEffect::Render()
     {
         // Grab transform component if it exists
         Transform* transform = GetNode()->Get<Transform>();
+        glm::mat4 renderTransform = (renderRelativeTransform && transform) ? transform->GetGlobalMatrix() : glm::mat4(1.0f);
+
+        // Emitters outside of the active camera's view are culled
+        Camera* camera = GetNode()->GetScene().GetActiveCamera();
+        Frustum frustum;
+        if (camera) frustum = camera->GetViewFrustum();
         
         // Render all emitters
         for (auto& emitter : loadedEmitters)
         {
-            emitter.Render((renderRelativeTransform && transform) ? transform->GetGlobalMatrix() : glm::mat4(1.0f));
+            emitter.Render(renderTransform, camera ? &frustum : nullptr);
         }
     }
 
-    void CPUParticleEffect::FlushRenderQueue()
+    void CPUParticleEffect::FlushRenderQueue(const glm::mat4& view)
     {
-        CPUParticleEmitter::FlushRenderQueue();
+        CPUParticleEmitter::FlushRenderQueue(view);
     }
 
     void CPUParticleEffect::Play()
@@ -95,7 +298,7 @@ namespace Phi
         // Reset counters in all emitters
         for (auto& emitter : loadedEmitters)
         {
-            emitter.particleProperties.burstDone = false;
+            emitter.burstDone = false;
         }
     }
 
@@ -108,14 +311,104 @@ namespace Phi
         {
             emitter.Reset();
         }
+
+        // Start over at full detail
+        lodStats = LODStats();
+        lodAccumulator = 0.0f;
+        lodFrames = 0;
+    }
+
+    bool CPUParticleEffect::IsFinished() const
+    {
+        if (state == State::Paused) return false;
+
+        return std::all_of(loadedEmitters.begin(), loadedEmitters.end(), [this](const CPUParticleEmitter& emitter)
+        {
+            return state == State::Stopped ? emitter.GetActiveParticles() == 0 : emitter.IsFinished();
+        });
+    }
+
+    void CPUParticleEffect::SetFixedTimestep(float step, int maxSubsteps)
+    {
+        fixedTimestep = std::max(step, 0.0f);
+        this->maxSubsteps = std::max(maxSubsteps, 1);
+        for (auto& emitter : loadedEmitters)
+        {
+            emitter.SetFixedTimestep(fixedTimestep, this->maxSubsteps);
+        }
+    }
+
+    void CPUParticleEffect::SaveSnapshot(std::vector<char>& out) const
+    {
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = SNAPSHOT_VERSION;
+        header.emitterCount = (uint32_t)loadedEmitters.size();
+        header.lodAccumulator = lodAccumulator;
+        header.lodFrames = lodFrames;
+        Serialization::Write(out, header);
+
+        for (const auto& emitter : loadedEmitters)
+        {
+            emitter.SaveState(out);
+        }
+    }
+
+    bool CPUParticleEffect::LoadSnapshot(const std::vector<char>& data)
+    {
+        const char* cursor = data.data();
+        const char* end = cursor + data.size();
+
+        // Validate the header
+        SnapshotHeader header;
+        if (!Serialization::Read(cursor, end, header) ||
+            std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+            header.version != SNAPSHOT_VERSION ||
+            header.emitterCount != loadedEmitters.size())
+        {
+            Error("Snapshot does not belong to effect: ", name);
+            return false;
+        }
+
+        // Restore emitters, starting over if any of them fail part way through
+        for (auto& emitter : loadedEmitters)
+        {
+            if (!emitter.LoadState(cursor, end))
+            {
+                Error("Invalid snapshot for effect: ", name);
+                Restart();
+                return false;
+            }
+        }
+
+        lodAccumulator = header.lodAccumulator;
+        lodFrames = header.lodFrames;
+        return true;
     }
 
     bool CPUParticleEffect::Load(const std::string& path)
     {
+        // Files that were loaded before are instanced without touching the disk
+        const std::string globalPath = File::GlobalizePath(path);
+        auto cached = definitionCache.find(globalPath);
+        if (cached != definitionCache.end())
+        {
+            Instantiate(*cached->second);
+            return true;
+        }
+
+        // Compiled effects skip the parser entirely
+        if (std::filesystem::path(path).extension() == ".effectbin")
+        {
+            if (!LoadBinary(path)) return false;
+            CacheDefinition(globalPath);
+            return true;
+        }
+
         try
         {
             // Load the file using yaml-cpp
-            YAML::Node effect = YAML::LoadFile(File::GlobalizePath(path));
+            YAML::Node effect = YAML::LoadFile(globalPath);
 
             // Check validity
             if (!effect) return false;
@@ -127,6 +420,8 @@ namespace Phi
             name = effect["effect_name"] ? effect["effect_name"].as<std::string>() : name;
             spawnRelativeTransform = effect["spawn_relative"] ? effect["spawn_relative"].as<bool>() : spawnRelativeTransform;
             renderRelativeTransform = effect["render_relative"] ? effect["render_relative"].as<bool>() : renderRelativeTransform;
+            fixedTimestep = effect["fixed_timestep"] ? effect["fixed_timestep"].as<float>() : fixedTimestep;
+            maxSubsteps = effect["max_substeps"] ? effect["max_substeps"].as<int>() : maxSubsteps;
 
             // Grab the emitters from the file
             YAML::Node emitters = effect["emitters"];
@@ -151,6 +446,7 @@ namespace Phi
                 }
             }
 
+            CacheDefinition(globalPath);
             return true;
         }
 
@@ -165,6 +461,9 @@ namespace Phi
 
     void CPUParticleEffect::Save(const std::string& path, bool singleFile) const
     {
+        // Later loads must see the new contents
+        definitionCache.erase(File::GlobalizePath(path));
+
         if (singleFile)
         {
             // Output the entire effect contents to a single file
@@ -175,28 +474,34 @@ namespace Phi
             // Name, spawnRelative and renderRelative
             outputFile << "effect_name: " << name.c_str() << "\nspawn_relative: "
                 << (spawnRelativeTransform ? "true" : "false") << "\nrender_relative: "
-                << (renderRelativeTransform ? "true" : "false") << "\nemitters: [\n";
+                << (renderRelativeTransform ? "true" : "false") << "\n";
+            if (fixedTimestep > 0.0f)
+            {
+                outputFile << "fixed_timestep: " << fixedTimestep << "\nmax_substeps: " << maxSubsteps << "\n";
+            }
+            outputFile << "emitters: [\n";
             
             // Output all emitters
             for (const auto& emitter : loadedEmitters)
             {
                 // Main properties
-                outputFile << "{\n\temitter_name: " << emitter.name.c_str() << ",\n";
-                if (emitter.randomSeed)
+                outputFile << "{\n\temitter_name: " << emitter.definition->name.c_str() << ",\n";
+                if (emitter.definition->randomSeed)
                 {
                     outputFile << "\tseed: random,\n";
                 }
                 else
                 {
-                    outputFile << "\tseed: " << emitter.rng.GetSeed() << ",\n";
+                    outputFile << "\tseed: " << emitter.definition->seed << ",\n";
                 }
-                outputFile << "\tduration: " << emitter.duration << ",\n";
-                outputFile << "\tmax_particles: " << emitter.maxActiveParticles << ",\n";
-                outputFile << "\toffset: {x: " << emitter.offset.x << ", y: " << emitter.offset.y << ", z: " << emitter.offset.z << "},\n";
+                outputFile << "\tduration: " << emitter.definition->duration << ",\n";
+                outputFile << "\tmax_particles: " << emitter.definition->maxActiveParticles << ",\n";
+                if (emitter.definition->orderedPool) outputFile << "\tordered_pool: true,\n";
+                outputFile << "\toffset: {x: " << emitter.definition->offset.x << ", y: " << emitter.definition->offset.y << ", z: " << emitter.definition->offset.z << "},\n";
 
                 // Blend mode
                 outputFile << "\tblend_mode: ";
-                switch (emitter.blendMode)
+                switch (emitter.definition->blendMode)
                 {
                     case CPUParticleEmitter::BlendMode::None:
                         outputFile << "none,\n";
@@ -210,42 +515,43 @@ namespace Phi
                         outputFile << "standard,\n";
                         break;
                 }
+                if (emitter.definition->depthSort) outputFile << "\tdepth_sort: true,\n";
 
                 // Texture
-                if (emitter.texture) outputFile << "\ttexture: " << emitter.texPath << ",\n";
+                if (emitter.definition->texture) outputFile << "\ttexture: " << emitter.definition->texPath << ",\n";
 
                 // Spawn / burst properties
                 outputFile << "\tspawn_mode: ";
-                switch (emitter.particleProperties.spawnMode)
+                switch (emitter.definition->particleProperties.spawnMode)
                 {
                     case CPUParticleEmitter::SpawnMode::Continuous:
                         outputFile << "continuous,\n";
-                        outputFile << "\tspawn_rate: " << emitter.particleProperties.spawnRate << ",\n\n";
+                        outputFile << "\tspawn_rate: " << emitter.definition->particleProperties.spawnRate << ",\n\n";
                         break;
                     
                     case CPUParticleEmitter::SpawnMode::ContinuousBurst:
                         outputFile << "continuous_burst,\n";
-                        outputFile << "\tspawn_rate: " << emitter.particleProperties.spawnRate << ",\n";
-                        outputFile << "\tburst_count: " << emitter.particleProperties.burstCount << ",\n\n";
+                        outputFile << "\tspawn_rate: " << emitter.definition->particleProperties.spawnRate << ",\n";
+                        outputFile << "\tburst_count: " << emitter.definition->particleProperties.burstCount << ",\n\n";
                         break;
                     
                     case CPUParticleEmitter::SpawnMode::Random:
                         outputFile << "random,\n";
-                        outputFile << "\tspawn_rate_min: " << emitter.particleProperties.spawnRateMin << ",\n";
-                        outputFile << "\tspawn_rate_max: " << emitter.particleProperties.spawnRateMax << ",\n\n";
+                        outputFile << "\tspawn_rate_min: " << emitter.definition->particleProperties.spawnRateMin << ",\n";
+                        outputFile << "\tspawn_rate_max: " << emitter.definition->particleProperties.spawnRateMax << ",\n\n";
                         break;
                     
                     case CPUParticleEmitter::SpawnMode::RandomBurst:
                         outputFile << "random_burst,\n";
-                        outputFile << "\tspawn_rate_min: " << emitter.particleProperties.spawnRateMin << ",\n";
-                        outputFile << "\tspawn_rate_max: " << emitter.particleProperties.spawnRateMax << ",\n";
-                        outputFile << "\tburst_count_min: " << emitter.particleProperties.burstCountMin << ",\n";
-                        outputFile << "\tburst_count_max: " << emitter.particleProperties.burstCountMax << ",\n\n";
+                        outputFile << "\tspawn_rate_min: " << emitter.definition->particleProperties.spawnRateMin << ",\n";
+                        outputFile << "\tspawn_rate_max: " << emitter.definition->particleProperties.spawnRateMax << ",\n";
+                        outputFile << "\tburst_count_min: " << emitter.definition->particleProperties.burstCountMin << ",\n";
+                        outputFile << "\tburst_count_max: " << emitter.definition->particleProperties.burstCountMax << ",\n\n";
                         break;
                     
                     case CPUParticleEmitter::SpawnMode::SingleBurst:
                         outputFile << "single_burst,\n";
-                        outputFile << "\tburst_count: " << emitter.particleProperties.burstCount << ",\n\n";
+                        outputFile << "\tburst_count: " << emitter.definition->particleProperties.burstCount << ",\n\n";
                         break;
                 }
 
@@ -254,149 +560,149 @@ namespace Phi
 
                 // Position
                 outputFile << "\t\tposition: {type: ";
-                switch (emitter.particleProperties.positionMode)
+                switch (emitter.definition->particleProperties.positionMode)
                 {
                     case CPUParticleEmitter::PositionMode::Constant:
-                        outputFile << "constant, value: {x: " << emitter.particleProperties.position.x
-                            << ", y: " << emitter.particleProperties.position.y
-                            << ", z: " << emitter.particleProperties.position.z << "}},\n";
+                        outputFile << "constant, value: {x: " << emitter.definition->particleProperties.position.x
+                            << ", y: " << emitter.definition->particleProperties.position.y
+                            << ", z: " << emitter.definition->particleProperties.position.z << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::PositionMode::RandomMinMax:
-                        outputFile << "random_min_max, min: {x: " << emitter.particleProperties.positionMin.x
-                            << ", y: " << emitter.particleProperties.positionMin.y
-                            << ", z: " << emitter.particleProperties.positionMin.z
-                            << "}, max: {x: " << emitter.particleProperties.positionMax.x
-                            << ", y: " << emitter.particleProperties.positionMax.y
-                            << ", z: " << emitter.particleProperties.positionMax.z << "}},\n";
+                        outputFile << "random_min_max, min: {x: " << emitter.definition->particleProperties.positionMin.x
+                            << ", y: " << emitter.definition->particleProperties.positionMin.y
+                            << ", z: " << emitter.definition->particleProperties.positionMin.z
+                            << "}, max: {x: " << emitter.definition->particleProperties.positionMax.x
+                            << ", y: " << emitter.definition->particleProperties.positionMax.y
+                            << ", z: " << emitter.definition->particleProperties.positionMax.z << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::PositionMode::RandomSphere:
-                        outputFile << "random_sphere, center: {x: " << emitter.particleProperties.position.x
-                            << ", y: " << emitter.particleProperties.position.y
-                            << ", z: " << emitter.particleProperties.position.z << "}, radius: " << emitter.particleProperties.spawnRadius << "},\n";
+                        outputFile << "random_sphere, center: {x: " << emitter.definition->particleProperties.position.x
+                            << ", y: " << emitter.definition->particleProperties.position.y
+                            << ", z: " << emitter.definition->particleProperties.position.z << "}, radius: " << emitter.definition->particleProperties.spawnRadius << "},\n";
                         break;
                 }
 
                 // Velocity
                 outputFile << "\t\tvelocity: {type: ";
-                switch (emitter.particleProperties.velocityMode)
+                switch (emitter.definition->particleProperties.velocityMode)
                 {
                     case CPUParticleEmitter::VelocityMode::Constant:
-                        outputFile << "constant, value: {x: " << emitter.particleProperties.velocity.x
-                            << ", y: " << emitter.particleProperties.velocity.y
-                            << ", z: " << emitter.particleProperties.velocity.z;
+                        outputFile << "constant, value: {x: " << emitter.definition->particleProperties.velocity.x
+                            << ", y: " << emitter.definition->particleProperties.velocity.y
+                            << ", z: " << emitter.definition->particleProperties.velocity.z;
                         break;
                     
                     case CPUParticleEmitter::VelocityMode::RandomMinMax:
-                        outputFile << "random_min_max, min: {x: " << emitter.particleProperties.velocityMin.x
-                            << ", y: " << emitter.particleProperties.velocityMin.y
-                            << ", z: " << emitter.particleProperties.velocityMin.z
-                            << "}, max: {x: " << emitter.particleProperties.velocityMax.x
-                            << ", y: " << emitter.particleProperties.velocityMax.y
-                            << ", z: " << emitter.particleProperties.velocityMax.z;
+                        outputFile << "random_min_max, min: {x: " << emitter.definition->particleProperties.velocityMin.x
+                            << ", y: " << emitter.definition->particleProperties.velocityMin.y
+                            << ", z: " << emitter.definition->particleProperties.velocityMin.z
+                            << "}, max: {x: " << emitter.definition->particleProperties.velocityMax.x
+                            << ", y: " << emitter.definition->particleProperties.velocityMax.y
+                            << ", z: " << emitter.definition->particleProperties.velocityMax.z;
                         break;
                 }
 
                 // Output velocity damping no matter the mode
-                outputFile << "}, damping: " << emitter.particleProperties.damping << "},\n";
+                outputFile << "}, damping: " << emitter.definition->particleProperties.damping << "},\n";
 
                 // Color
                 outputFile << "\t\tcolor: {type: ";
-                switch (emitter.particleProperties.colorMode)
+                switch (emitter.definition->particleProperties.colorMode)
                 {
                     case CPUParticleEmitter::ColorMode::Constant:
-                        outputFile << "constant, value: {r: " << emitter.particleProperties.color.r
-                            << ", g: " << emitter.particleProperties.color.g
-                            << ", b: " << emitter.particleProperties.color.b << "}},\n";
+                        outputFile << "constant, value: {r: " << emitter.definition->particleProperties.color.r
+                            << ", g: " << emitter.definition->particleProperties.color.g
+                            << ", b: " << emitter.definition->particleProperties.color.b << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::ColorMode::RandomMinMax:
-                        outputFile << "random_min_max, min: {r: " << emitter.particleProperties.colorMin.r
-                            << ", g: " << emitter.particleProperties.colorMin.g
-                            << ", b: " << emitter.particleProperties.colorMin.b
-                            << "}, max: {r: " << emitter.particleProperties.colorMax.r
-                            << ", g: " << emitter.particleProperties.colorMax.g
-                            << ", b: " << emitter.particleProperties.colorMax.b << "}},\n";
+                        outputFile << "random_min_max, min: {r: " << emitter.definition->particleProperties.colorMin.r
+                            << ", g: " << emitter.definition->particleProperties.colorMin.g
+                            << ", b: " << emitter.definition->particleProperties.colorMin.b
+                            << "}, max: {r: " << emitter.definition->particleProperties.colorMax.r
+                            << ", g: " << emitter.definition->particleProperties.colorMax.g
+                            << ", b: " << emitter.definition->particleProperties.colorMax.b << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::ColorMode::RandomLerp:
-                        outputFile << "random_lerp, color_a: {r: " << emitter.particleProperties.colorA.r
-                            << ", g: " << emitter.particleProperties.colorA.g
-                            << ", b: " << emitter.particleProperties.colorA.b
-                            << "}, color_b: {r: " << emitter.particleProperties.colorB.r
-                            << ", g: " << emitter.particleProperties.colorB.g
-                            << ", b: " << emitter.particleProperties.colorB.b << "}},\n";
+                        outputFile << "random_lerp, color_a: {r: " << emitter.definition->particleProperties.colorA.r
+                            << ", g: " << emitter.definition->particleProperties.colorA.g
+                            << ", b: " << emitter.definition->particleProperties.colorA.b
+                            << "}, color_b: {r: " << emitter.definition->particleProperties.colorB.r
+                            << ", g: " << emitter.definition->particleProperties.colorB.g
+                            << ", b: " << emitter.definition->particleProperties.colorB.b << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::ColorMode::LerpOverLifetime:
-                        outputFile << "lerp_over_lifetime, start_color: {r: " << emitter.particleProperties.startColor.r
-                        << ", g: " << emitter.particleProperties.startColor.g << ", b: " << emitter.particleProperties.startColor.b
-                        << "}, end_color: {r: " << emitter.particleProperties.endColor.r << ", g: " << emitter.particleProperties.endColor.g
-                        << ", b: " << emitter.particleProperties.endColor.b << "}},\n";
+                        outputFile << "lerp_over_lifetime, start_color: {r: " << emitter.definition->particleProperties.startColor.r
+                        << ", g: " << emitter.definition->particleProperties.startColor.g << ", b: " << emitter.definition->particleProperties.startColor.b
+                        << "}, end_color: {r: " << emitter.definition->particleProperties.endColor.r << ", g: " << emitter.definition->particleProperties.endColor.g
+                        << ", b: " << emitter.definition->particleProperties.endColor.b << "}},\n";
                         break;
                 }
 
                 // Size
                 outputFile << "\t\tsize: {type: ";
-                switch (emitter.particleProperties.sizeMode)
+                switch (emitter.definition->particleProperties.sizeMode)
                 {
                     case CPUParticleEmitter::SizeMode::Constant:
-                        outputFile << "constant, value: {x: " << emitter.particleProperties.size.x
-                            << ", y: " << emitter.particleProperties.size.y << "}},\n";
+                        outputFile << "constant, value: {x: " << emitter.definition->particleProperties.size.x
+                            << ", y: " << emitter.definition->particleProperties.size.y << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::SizeMode::RandomMinMax:
-                        outputFile << "random_min_max, min: {x: " << emitter.particleProperties.sizeMin.x
-                            << ", y: " << emitter.particleProperties.sizeMin.y
-                            << "}, max: {x: " << emitter.particleProperties.sizeMax.x
-                            << ", y: " << emitter.particleProperties.sizeMax.y << "}},\n";
+                        outputFile << "random_min_max, min: {x: " << emitter.definition->particleProperties.sizeMin.x
+                            << ", y: " << emitter.definition->particleProperties.sizeMin.y
+                            << "}, max: {x: " << emitter.definition->particleProperties.sizeMax.x
+                            << ", y: " << emitter.definition->particleProperties.sizeMax.y << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::SizeMode::RandomLerp:
-                        outputFile << "random_lerp, min: {x: " << emitter.particleProperties.sizeMin.x
-                            << ", y: " << emitter.particleProperties.sizeMin.y
-                            << "}, max: {x: " << emitter.particleProperties.sizeMax.x
-                            << ", y: " << emitter.particleProperties.sizeMax.y << "}},\n";
+                        outputFile << "random_lerp, min: {x: " << emitter.definition->particleProperties.sizeMin.x
+                            << ", y: " << emitter.definition->particleProperties.sizeMin.y
+                            << "}, max: {x: " << emitter.definition->particleProperties.sizeMax.x
+                            << ", y: " << emitter.definition->particleProperties.sizeMax.y << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::SizeMode::LerpOverLifetime:
-                        outputFile << "lerp_over_lifetime, start_size: {x: " << emitter.particleProperties.startSize.x
-                            << ", y: " << emitter.particleProperties.startSize.y
-                            << "}, end_size: {x: " << emitter.particleProperties.endSize.x
-                            << ", y: " << emitter.particleProperties.endSize.y << "}},\n";
+                        outputFile << "lerp_over_lifetime, start_size: {x: " << emitter.definition->particleProperties.startSize.x
+                            << ", y: " << emitter.definition->particleProperties.startSize.y
+                            << "}, end_size: {x: " << emitter.definition->particleProperties.endSize.x
+                            << ", y: " << emitter.definition->particleProperties.endSize.y << "}},\n";
                         break;
                 }
 
                 // Opacity
                 outputFile << "\t\topacity: {type: ";
-                switch (emitter.particleProperties.opacityMode)
+                switch (emitter.definition->particleProperties.opacityMode)
                 {
                     case CPUParticleEmitter::OpacityMode::Constant:
-                        outputFile << "constant, value: " << emitter.particleProperties.opacity << "},\n";
+                        outputFile << "constant, value: " << emitter.definition->particleProperties.opacity << "},\n";
                         break;
                     
                     case CPUParticleEmitter::OpacityMode::RandomMinMax:
-                        outputFile << "random_min_max, min: " << emitter.particleProperties.opacityMin
-                            << ", max: " << emitter.particleProperties.opacityMax << "},\n";
+                        outputFile << "random_min_max, min: " << emitter.definition->particleProperties.opacityMin
+                            << ", max: " << emitter.definition->particleProperties.opacityMax << "},\n";
                         break;
                     case CPUParticleEmitter::OpacityMode::LerpOverLifetime:
-                        outputFile << "lerp_over_lifetime, start_opacity: " << emitter.particleProperties.startOpacity
-                            << ", end_opacity: " << emitter.particleProperties.endOpacity << "},\n";
+                        outputFile << "lerp_over_lifetime, start_opacity: " << emitter.definition->particleProperties.startOpacity
+                            << ", end_opacity: " << emitter.definition->particleProperties.endOpacity << "},\n";
                         break;
                 }
 
                 // Lifespan
                 outputFile << "\t\tlifespan: {type: ";
-                switch (emitter.particleProperties.lifespanMode)
+                switch (emitter.definition->particleProperties.lifespanMode)
                 {
                     case CPUParticleEmitter::LifespanMode::Constant:
-                        outputFile << "constant, value: " << emitter.particleProperties.lifespan << "},\n";
+                        outputFile << "constant, value: " << emitter.definition->particleProperties.lifespan << "},\n";
                         break;
                     
                     case CPUParticleEmitter::LifespanMode::RandomMinMax:
-                        outputFile << "random_min_max, min: " << emitter.particleProperties.lifespanMin
-                            << ", max: " << emitter.particleProperties.lifespanMax << "},\n";
+                        outputFile << "random_min_max, min: " << emitter.definition->particleProperties.lifespanMin
+                            << ", max: " << emitter.definition->particleProperties.lifespanMax << "},\n";
                         break;
                 }
 
@@ -404,15 +710,43 @@ namespace Phi
                 
                 // Basic Affectors
                 outputFile << "\taffectors: {\n";
-                outputFile << "\t\tadd_velocity: " << (emitter.affectorProperties.addVelocity ? "true,\n" : "false,\n");
-                outputFile << "\t\tgravity: " << (emitter.affectorProperties.gravityEnabled ? "true,\n" : "false,\n");
+                outputFile << "\t\tadd_velocity: " << (emitter.definition->affectorProperties.addVelocity ? "true,\n" : "false,\n");
+                outputFile << "\t\tgravity: " << (emitter.definition->affectorProperties.gravityEnabled ? "true,\n" : "false,\n");
+                if (emitter.definition->affectorProperties.bakeAttractors)
+                {
+                    outputFile << "\t\tbake_attractors: true,\n";
+                    outputFile << "\t\tattractor_field_resolution: " << emitter.definition->affectorProperties.attractorFieldResolution << ",\n";
+                }
+                if (emitter.definition->affectorProperties.collisionEnabled)
+                {
+                    const char* responses[] = {"kill", "bounce", "stick"};
+                    outputFile << "\t\tcollision: " << responses[(int)emitter.definition->affectorProperties.collisionResponse] << ",\n";
+                    outputFile << "\t\trestitution: " << emitter.definition->affectorProperties.restitution << ",\n";
+                }
+                if (emitter.definition->affectorProperties.turbulenceEnabled)
+                {
+                    const glm::vec3& scroll = emitter.definition->affectorProperties.turbulenceScroll;
+                    outputFile << "\t\tturbulence: true,\n";
+                    outputFile << "\t\tturbulence_frequency: " << emitter.definition->affectorProperties.turbulenceFrequency << ",\n";
+                    outputFile << "\t\tturbulence_strength: " << emitter.definition->affectorProperties.turbulenceStrength << ",\n";
+                    outputFile << "\t\tturbulence_scroll: {x: " << scroll.x << ", y: " << scroll.y << ", z: " << scroll.z << "},\n";
+                }
+                if (emitter.definition->affectorProperties.flockingEnabled)
+                {
+                    outputFile << "\t\tflocking: true,\n";
+                    outputFile << "\t\tflocking_radius: " << emitter.definition->affectorProperties.flockingRadius << ",\n";
+                    outputFile << "\t\tseparation: " << emitter.definition->affectorProperties.separation << ",\n";
+                    outputFile << "\t\tcohesion: " << emitter.definition->affectorProperties.cohesion << ",\n";
+                    outputFile << "\t\talignment: " << emitter.definition->affectorProperties.alignment << ",\n";
+                    outputFile << "\t\tmax_neighbours: " << emitter.definition->affectorProperties.maxNeighbours << ",\n";
+                }
                 outputFile << "\t},\n\n";
 
                 // Attractors
                 outputFile << "\tattractors: [";
-                for (int i = 0; i < emitter.attractors.size(); ++i)
+                for (size_t i = 0; i < emitter.definition->attractors.size(); ++i)
                 {
-                    const auto& a = emitter.attractors[i];
+                    const auto& a = emitter.definition->attractors[i];
                     outputFile << "\n\t\t{position: {x: " << a.position.x << ", y: " << a.position.y << ", z: " << a.position.z
                         << "}, radius: " << a.radius << ", strength: " << a.strength << ", relative: " << (a.relativeToTransform ? "true" : "false") << "},";
                 }
@@ -433,7 +767,12 @@ namespace Phi
             // Name, spawnRelative and renderRelative
             effectFile << "effect_name: " << name.c_str() << "\nspawn_relative: "
                 << (spawnRelativeTransform ? "true" : "false") << "\nrender_relative: "
-                << (renderRelativeTransform ? "true" : "false") << "\nemitters: [\n";
+                << (renderRelativeTransform ? "true" : "false") << "\n";
+            if (fixedTimestep > 0.0f)
+            {
+                effectFile << "fixed_timestep: " << fixedTimestep << "\nmax_substeps: " << maxSubsteps << "\n";
+            }
+            effectFile << "emitters: [\n";
             
             // Find if an extension is given
             size_t pos = path.find_last_of('.');
@@ -446,12 +785,12 @@ namespace Phi
                 if (pos == std::string::npos)
                 {
                     // No extension given
-                    emitterGlobalPath = effectFile.GetGlobalPath() + "-" + emitter.name + ".emitter";
+                    emitterGlobalPath = effectFile.GetGlobalPath() + "-" + emitter.definition->name + ".emitter";
                 }
                 else
                 {
                     // Extension supplied from user choice (remove extension)
-                    emitterGlobalPath = effectFile.GetGlobalPath().substr(0, pos) + "-" + emitter.name + ".emitter";
+                    emitterGlobalPath = effectFile.GetGlobalPath().substr(0, pos) + "-" + emitter.definition->name + ".emitter";
                 }
 
                 // Write the emitter reference to the effect file
@@ -463,22 +802,23 @@ namespace Phi
                 File emitterFile(emitterGlobalPath, File::Mode::Write);
 
                 // Main properties
-                emitterFile << "emitter_name: " << emitter.name.c_str() << "\n";
-                if (emitter.randomSeed)
+                emitterFile << "emitter_name: " << emitter.definition->name.c_str() << "\n";
+                if (emitter.definition->randomSeed)
                 {
                     emitterFile << "seed: random\n";
                 }
                 else
                 {
-                    emitterFile << "seed: " << emitter.rng.GetSeed() << "\n";
+                    emitterFile << "seed: " << emitter.definition->seed << "\n";
                 }
-                emitterFile << "duration: " << emitter.duration << "\n";
-                emitterFile << "max_particles: " << emitter.maxActiveParticles << "\n";
-                emitterFile << "offset: {x: " << emitter.offset.x << ", y: " << emitter.offset.y << ", z: " << emitter.offset.z << "}\n";
+                emitterFile << "duration: " << emitter.definition->duration << "\n";
+                emitterFile << "max_particles: " << emitter.definition->maxActiveParticles << "\n";
+                if (emitter.definition->orderedPool) emitterFile << "ordered_pool: true\n";
+                emitterFile << "offset: {x: " << emitter.definition->offset.x << ", y: " << emitter.definition->offset.y << ", z: " << emitter.definition->offset.z << "}\n";
 
                 // Blend mode
                 emitterFile << "blend_mode: ";
-                switch (emitter.blendMode)
+                switch (emitter.definition->blendMode)
                 {
                     case CPUParticleEmitter::BlendMode::None:
                         emitterFile << "none\n";
@@ -492,42 +832,43 @@ namespace Phi
                         emitterFile << "standard\n";
                         break;
                 }
+                if (emitter.definition->depthSort) emitterFile << "depth_sort: true\n";
 
                 // Texture
-                if (emitter.texture) emitterFile << "texture: " << emitter.texPath << "\n";
+                if (emitter.definition->texture) emitterFile << "texture: " << emitter.definition->texPath << "\n";
 
                 // Spawn / burst properties
                 emitterFile << "spawn_mode: ";
-                switch (emitter.particleProperties.spawnMode)
+                switch (emitter.definition->particleProperties.spawnMode)
                 {
                     case CPUParticleEmitter::SpawnMode::Continuous:
                         emitterFile << "continuous\n";
-                        emitterFile << "spawn_rate: " << emitter.particleProperties.spawnRate << "\n\n";
+                        emitterFile << "spawn_rate: " << emitter.definition->particleProperties.spawnRate << "\n\n";
                         break;
                     
                     case CPUParticleEmitter::SpawnMode::ContinuousBurst:
                         emitterFile << "continuous_burst\n";
-                        emitterFile << "spawn_rate: " << emitter.particleProperties.spawnRate << "\n";
-                        emitterFile << "burst_count: " << emitter.particleProperties.burstCount << "\n\n";
+                        emitterFile << "spawn_rate: " << emitter.definition->particleProperties.spawnRate << "\n";
+                        emitterFile << "burst_count: " << emitter.definition->particleProperties.burstCount << "\n\n";
                         break;
                     
                     case CPUParticleEmitter::SpawnMode::Random:
                         emitterFile << "random\n";
-                        emitterFile << "spawn_rate_min: " << emitter.particleProperties.spawnRateMin << "\n";
-                        emitterFile << "spawn_rate_max: " << emitter.particleProperties.spawnRateMax << "\n\n";
+                        emitterFile << "spawn_rate_min: " << emitter.definition->particleProperties.spawnRateMin << "\n";
+                        emitterFile << "spawn_rate_max: " << emitter.definition->particleProperties.spawnRateMax << "\n\n";
                         break;
                     
                     case CPUParticleEmitter::SpawnMode::RandomBurst:
                         emitterFile << "random_burst\n";
-                        emitterFile << "spawn_rate_min: " << emitter.particleProperties.spawnRateMin << "\n";
-                        emitterFile << "spawn_rate_max: " << emitter.particleProperties.spawnRateMax << "\n";
-                        emitterFile << "burst_count_min: " << emitter.particleProperties.burstCountMin << "\n";
-                        emitterFile << "burst_count_max: " << emitter.particleProperties.burstCountMax << "\n\n";
+                        emitterFile << "spawn_rate_min: " << emitter.definition->particleProperties.spawnRateMin << "\n";
+                        emitterFile << "spawn_rate_max: " << emitter.definition->particleProperties.spawnRateMax << "\n";
+                        emitterFile << "burst_count_min: " << emitter.definition->particleProperties.burstCountMin << "\n";
+                        emitterFile << "burst_count_max: " << emitter.definition->particleProperties.burstCountMax << "\n\n";
                         break;
                     
                     case CPUParticleEmitter::SpawnMode::SingleBurst:
                         emitterFile << "single_burst\n";
-                        emitterFile << "burst_count: " << emitter.particleProperties.burstCount << "\n\n";
+                        emitterFile << "burst_count: " << emitter.definition->particleProperties.burstCount << "\n\n";
                         break;
                 }
 
@@ -536,149 +877,149 @@ namespace Phi
 
                 // Position
                 emitterFile << "\tposition: {type: ";
-                switch (emitter.particleProperties.positionMode)
+                switch (emitter.definition->particleProperties.positionMode)
                 {
                     case CPUParticleEmitter::PositionMode::Constant:
-                        emitterFile << "constant, value: {x: " << emitter.particleProperties.position.x
-                            << ", y: " << emitter.particleProperties.position.y
-                            << ", z: " << emitter.particleProperties.position.z << "}},\n";
+                        emitterFile << "constant, value: {x: " << emitter.definition->particleProperties.position.x
+                            << ", y: " << emitter.definition->particleProperties.position.y
+                            << ", z: " << emitter.definition->particleProperties.position.z << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::PositionMode::RandomMinMax:
-                        emitterFile << "random_min_max, min: {x: " << emitter.particleProperties.positionMin.x
-                            << ", y: " << emitter.particleProperties.positionMin.y
-                            << ", z: " << emitter.particleProperties.positionMin.z
-                            << "}, max: {x: " << emitter.particleProperties.positionMax.x
-                            << ", y: " << emitter.particleProperties.positionMax.y
-                            << ", z: " << emitter.particleProperties.positionMax.z << "}},\n";
+                        emitterFile << "random_min_max, min: {x: " << emitter.definition->particleProperties.positionMin.x
+                            << ", y: " << emitter.definition->particleProperties.positionMin.y
+                            << ", z: " << emitter.definition->particleProperties.positionMin.z
+                            << "}, max: {x: " << emitter.definition->particleProperties.positionMax.x
+                            << ", y: " << emitter.definition->particleProperties.positionMax.y
+                            << ", z: " << emitter.definition->particleProperties.positionMax.z << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::PositionMode::RandomSphere:
-                        emitterFile << "random_sphere, center: {x: " << emitter.particleProperties.position.x
-                            << ", y: " << emitter.particleProperties.position.y
-                            << ", z: " << emitter.particleProperties.position.z << "}, radius: " << emitter.particleProperties.spawnRadius << "},\n";
+                        emitterFile << "random_sphere, center: {x: " << emitter.definition->particleProperties.position.x
+                            << ", y: " << emitter.definition->particleProperties.position.y
+                            << ", z: " << emitter.definition->particleProperties.position.z << "}, radius: " << emitter.definition->particleProperties.spawnRadius << "},\n";
                         break;
                 }
 
                 // Velocity
                 emitterFile << "\tvelocity: {type: ";
-                switch (emitter.particleProperties.velocityMode)
+                switch (emitter.definition->particleProperties.velocityMode)
                 {
                     case CPUParticleEmitter::VelocityMode::Constant:
-                        emitterFile << "constant, value: {x: " << emitter.particleProperties.velocity.x
-                            << ", y: " << emitter.particleProperties.velocity.y
-                            << ", z: " << emitter.particleProperties.velocity.z;
+                        emitterFile << "constant, value: {x: " << emitter.definition->particleProperties.velocity.x
+                            << ", y: " << emitter.definition->particleProperties.velocity.y
+                            << ", z: " << emitter.definition->particleProperties.velocity.z;
                         break;
                     
                     case CPUParticleEmitter::VelocityMode::RandomMinMax:
-                        emitterFile << "random_min_max, min: {x: " << emitter.particleProperties.velocityMin.x
-                            << ", y: " << emitter.particleProperties.velocityMin.y
-                            << ", z: " << emitter.particleProperties.velocityMin.z
-                            << "}, max: {x: " << emitter.particleProperties.velocityMax.x
-                            << ", y: " << emitter.particleProperties.velocityMax.y
-                            << ", z: " << emitter.particleProperties.velocityMax.z;
+                        emitterFile << "random_min_max, min: {x: " << emitter.definition->particleProperties.velocityMin.x
+                            << ", y: " << emitter.definition->particleProperties.velocityMin.y
+                            << ", z: " << emitter.definition->particleProperties.velocityMin.z
+                            << "}, max: {x: " << emitter.definition->particleProperties.velocityMax.x
+                            << ", y: " << emitter.definition->particleProperties.velocityMax.y
+                            << ", z: " << emitter.definition->particleProperties.velocityMax.z;
                         break;
                 }
 
                 // Output velocity damping no matter the mode
-                emitterFile << "}, damping: " << emitter.particleProperties.damping << "},\n";
+                emitterFile << "}, damping: " << emitter.definition->particleProperties.damping << "},\n";
 
                 // Color
                 emitterFile << "\tcolor: {type: ";
-                switch (emitter.particleProperties.colorMode)
+                switch (emitter.definition->particleProperties.colorMode)
                 {
                     case CPUParticleEmitter::ColorMode::Constant:
-                        emitterFile << "constant, value: {r: " << emitter.particleProperties.color.r
-                            << ", g: " << emitter.particleProperties.color.g
-                            << ", b: " << emitter.particleProperties.color.b << "}},\n";
+                        emitterFile << "constant, value: {r: " << emitter.definition->particleProperties.color.r
+                            << ", g: " << emitter.definition->particleProperties.color.g
+                            << ", b: " << emitter.definition->particleProperties.color.b << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::ColorMode::RandomMinMax:
-                        emitterFile << "random_min_max, min: {r: " << emitter.particleProperties.colorMin.r
-                            << ", g: " << emitter.particleProperties.colorMin.g
-                            << ", b: " << emitter.particleProperties.colorMin.b
-                            << "}, max: {r: " << emitter.particleProperties.colorMax.r
-                            << ", g: " << emitter.particleProperties.colorMax.g
-                            << ", b: " << emitter.particleProperties.colorMax.b << "}},\n";
+                        emitterFile << "random_min_max, min: {r: " << emitter.definition->particleProperties.colorMin.r
+                            << ", g: " << emitter.definition->particleProperties.colorMin.g
+                            << ", b: " << emitter.definition->particleProperties.colorMin.b
+                            << "}, max: {r: " << emitter.definition->particleProperties.colorMax.r
+                            << ", g: " << emitter.definition->particleProperties.colorMax.g
+                            << ", b: " << emitter.definition->particleProperties.colorMax.b << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::ColorMode::RandomLerp:
-                        emitterFile << "random_lerp, color_a: {r: " << emitter.particleProperties.colorA.r
-                            << ", g: " << emitter.particleProperties.colorA.g
-                            << ", b: " << emitter.particleProperties.colorA.b
-                            << "}, color_b: {r: " << emitter.particleProperties.colorB.r
-                            << ", g: " << emitter.particleProperties.colorB.g
-                            << ", b: " << emitter.particleProperties.colorB.b << "}},\n";
+                        emitterFile << "random_lerp, color_a: {r: " << emitter.definition->particleProperties.colorA.r
+                            << ", g: " << emitter.definition->particleProperties.colorA.g
+                            << ", b: " << emitter.definition->particleProperties.colorA.b
+                            << "}, color_b: {r: " << emitter.definition->particleProperties.colorB.r
+                            << ", g: " << emitter.definition->particleProperties.colorB.g
+                            << ", b: " << emitter.definition->particleProperties.colorB.b << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::ColorMode::LerpOverLifetime:
-                        emitterFile << "lerp_over_lifetime, start_color: {r: " << emitter.particleProperties.startColor.r
-                        << ", g: " << emitter.particleProperties.startColor.g << ", b: " << emitter.particleProperties.startColor.b
-                        << "}, end_color: {r: " << emitter.particleProperties.endColor.r << ", g: " << emitter.particleProperties.endColor.g
-                        << ", b: " << emitter.particleProperties.endColor.b << "}},\n";
+                        emitterFile << "lerp_over_lifetime, start_color: {r: " << emitter.definition->particleProperties.startColor.r
+                        << ", g: " << emitter.definition->particleProperties.startColor.g << ", b: " << emitter.definition->particleProperties.startColor.b
+                        << "}, end_color: {r: " << emitter.definition->particleProperties.endColor.r << ", g: " << emitter.definition->particleProperties.endColor.g
+                        << ", b: " << emitter.definition->particleProperties.endColor.b << "}},\n";
                         break;
                 }
 
                 // Size
                 emitterFile << "\tsize: {type: ";
-                switch (emitter.particleProperties.sizeMode)
+                switch (emitter.definition->particleProperties.sizeMode)
                 {
                     case CPUParticleEmitter::SizeMode::Constant:
-                        emitterFile << "constant, value: {x: " << emitter.particleProperties.size.x
-                            << ", y: " << emitter.particleProperties.size.y << "}},\n";
+                        emitterFile << "constant, value: {x: " << emitter.definition->particleProperties.size.x
+                            << ", y: " << emitter.definition->particleProperties.size.y << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::SizeMode::RandomMinMax:
-                        emitterFile << "random_min_max, min: {x: " << emitter.particleProperties.sizeMin.x
-                            << ", y: " << emitter.particleProperties.sizeMin.y
-                            << "}, max: {x: " << emitter.particleProperties.sizeMax.x
-                            << ", y: " << emitter.particleProperties.sizeMax.y << "}},\n";
+                        emitterFile << "random_min_max, min: {x: " << emitter.definition->particleProperties.sizeMin.x
+                            << ", y: " << emitter.definition->particleProperties.sizeMin.y
+                            << "}, max: {x: " << emitter.definition->particleProperties.sizeMax.x
+                            << ", y: " << emitter.definition->particleProperties.sizeMax.y << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::SizeMode::RandomLerp:
-                        emitterFile << "random_lerp, min: {x: " << emitter.particleProperties.sizeMin.x
-                            << ", y: " << emitter.particleProperties.sizeMin.y
-                            << "}, max: {x: " << emitter.particleProperties.sizeMax.x
-                            << ", y: " << emitter.particleProperties.sizeMax.y << "}},\n";
+                        emitterFile << "random_lerp, min: {x: " << emitter.definition->particleProperties.sizeMin.x
+                            << ", y: " << emitter.definition->particleProperties.sizeMin.y
+                            << "}, max: {x: " << emitter.definition->particleProperties.sizeMax.x
+                            << ", y: " << emitter.definition->particleProperties.sizeMax.y << "}},\n";
                         break;
                     
                     case CPUParticleEmitter::SizeMode::LerpOverLifetime:
-                        emitterFile << "lerp_over_lifetime, start_size: {x: " << emitter.particleProperties.startSize.x
-                            << ", y: " << emitter.particleProperties.startSize.y
-                            << "}, end_size: {x: " << emitter.particleProperties.endSize.x
-                            << ", y: " << emitter.particleProperties.endSize.y << "}},\n";
+                        emitterFile << "lerp_over_lifetime, start_size: {x: " << emitter.definition->particleProperties.startSize.x
+                            << ", y: " << emitter.definition->particleProperties.startSize.y
+                            << "}, end_size: {x: " << emitter.definition->particleProperties.endSize.x
+                            << ", y: " << emitter.definition->particleProperties.endSize.y << "}},\n";
                         break;
                 }
 
                 // Opacity
                 emitterFile << "\topacity: {type: ";
-                switch (emitter.particleProperties.opacityMode)
+                switch (emitter.definition->particleProperties.opacityMode)
                 {
                     case CPUParticleEmitter::OpacityMode::Constant:
-                        emitterFile << "constant, value: " << emitter.particleProperties.opacity << "},\n";
+                        emitterFile << "constant, value: " << emitter.definition->particleProperties.opacity << "},\n";
                         break;
                     
                     case CPUParticleEmitter::OpacityMode::RandomMinMax:
-                        emitterFile << "random_min_max, min: " << emitter.particleProperties.opacityMin
-                            << ", max: " << emitter.particleProperties.opacityMax << "},\n";
+                        emitterFile << "random_min_max, min: " << emitter.definition->particleProperties.opacityMin
+                            << ", max: " << emitter.definition->particleProperties.opacityMax << "},\n";
                         break;
                     case CPUParticleEmitter::OpacityMode::LerpOverLifetime:
-                        emitterFile << "lerp_over_lifetime, start_opacity: " << emitter.particleProperties.startOpacity
-                            << ", end_opacity: " << emitter.particleProperties.endOpacity << "},\n";
+                        emitterFile << "lerp_over_lifetime, start_opacity: " << emitter.definition->particleProperties.startOpacity
+                            << ", end_opacity: " << emitter.definition->particleProperties.endOpacity << "},\n";
                         break;
                 }
 
                 // Lifespan
                 emitterFile << "\tlifespan: {type: ";
-                switch (emitter.particleProperties.lifespanMode)
+                switch (emitter.definition->particleProperties.lifespanMode)
                 {
                     case CPUParticleEmitter::LifespanMode::Constant:
-                        emitterFile << "constant, value: " << emitter.particleProperties.lifespan << "},\n";
+                        emitterFile << "constant, value: " << emitter.definition->particleProperties.lifespan << "},\n";
                         break;
                     
                     case CPUParticleEmitter::LifespanMode::RandomMinMax:
-                        emitterFile << "random_min_max, min: " << emitter.particleProperties.lifespanMin
-                            << ", max: " << emitter.particleProperties.lifespanMax << "},\n";
+                        emitterFile << "random_min_max, min: " << emitter.definition->particleProperties.lifespanMin
+                            << ", max: " << emitter.definition->particleProperties.lifespanMax << "},\n";
                         break;
                 }
 
@@ -686,15 +1027,43 @@ namespace Phi
                 
                 // Basic Affectors
                 emitterFile << "affectors: {\n";
-                emitterFile << "\tadd_velocity: " << (emitter.affectorProperties.addVelocity ? "true,\n" : "false,\n");
-                emitterFile << "\tgravity: " << (emitter.affectorProperties.gravityEnabled ? "true,\n" : "false,\n");
+                emitterFile << "\tadd_velocity: " << (emitter.definition->affectorProperties.addVelocity ? "true,\n" : "false,\n");
+                emitterFile << "\tgravity: " << (emitter.definition->affectorProperties.gravityEnabled ? "true,\n" : "false,\n");
+                if (emitter.definition->affectorProperties.bakeAttractors)
+                {
+                    emitterFile << "\tbake_attractors: true,\n";
+                    emitterFile << "\tattractor_field_resolution: " << emitter.definition->affectorProperties.attractorFieldResolution << ",\n";
+                }
+                if (emitter.definition->affectorProperties.collisionEnabled)
+                {
+                    const char* responses[] = {"kill", "bounce", "stick"};
+                    emitterFile << "\tcollision: " << responses[(int)emitter.definition->affectorProperties.collisionResponse] << ",\n";
+                    emitterFile << "\trestitution: " << emitter.definition->affectorProperties.restitution << ",\n";
+                }
+                if (emitter.definition->affectorProperties.turbulenceEnabled)
+                {
+                    const glm::vec3& scroll = emitter.definition->affectorProperties.turbulenceScroll;
+                    emitterFile << "\tturbulence: true,\n";
+                    emitterFile << "\tturbulence_frequency: " << emitter.definition->affectorProperties.turbulenceFrequency << ",\n";
+                    emitterFile << "\tturbulence_strength: " << emitter.definition->affectorProperties.turbulenceStrength << ",\n";
+                    emitterFile << "\tturbulence_scroll: {x: " << scroll.x << ", y: " << scroll.y << ", z: " << scroll.z << "},\n";
+                }
+                if (emitter.definition->affectorProperties.flockingEnabled)
+                {
+                    emitterFile << "\tflocking: true,\n";
+                    emitterFile << "\tflocking_radius: " << emitter.definition->affectorProperties.flockingRadius << ",\n";
+                    emitterFile << "\tseparation: " << emitter.definition->affectorProperties.separation << ",\n";
+                    emitterFile << "\tcohesion: " << emitter.definition->affectorProperties.cohesion << ",\n";
+                    emitterFile << "\talignment: " << emitter.definition->affectorProperties.alignment << ",\n";
+                    emitterFile << "\tmax_neighbours: " << emitter.definition->affectorProperties.maxNeighbours << ",\n";
+                }
                 emitterFile << "}\n\n";
 
                 // Attractors
                 emitterFile << "attractors: [";
-                for (int i = 0; i < emitter.attractors.size(); ++i)
+                for (size_t i = 0; i < emitter.definition->attractors.size(); ++i)
                 {
-                    const auto& a = emitter.attractors[i];
+                    const auto& a = emitter.definition->attractors[i];
                     emitterFile << "\n\t{position: {x: " << a.position.x << ", y: " << a.position.y << ", z: " << a.position.z
                         << "}, radius: " << a.radius << ", strength: " << a.strength << ", relative: " << (a.relativeToTransform ? "true" : "false") << "},";
                 }
@@ -705,16 +1074,229 @@ namespace Phi
         }
     }
 
+    bool CPUParticleEffect::LoadBinary(const std::string& path)
+    {
+        // Read the whole file at once
+        std::ifstream file(File::GlobalizePath(path), std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            Error("Could not open compiled effect: ", path);
+            return false;
+        }
+        std::vector<char> data((size_t)file.tellg());
+        file.seekg(0);
+        file.read(data.data(), data.size());
+
+        const char* cursor = data.data();
+        const char* end = cursor + data.size();
+
+        // Validate the header
+        BinaryHeader header;
+        if (!Serialization::Read(cursor, end, header) || std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0)
+        {
+            Error("Invalid compiled effect: ", path);
+            return false;
+        }
+        if (header.version != BINARY_VERSION ||
+            header.particlePropertiesSize != sizeof(CPUParticleEmitter::ParticleProperties) ||
+            header.affectorPropertiesSize != sizeof(CPUParticleEmitter::AffectorProperties))
+        {
+            Error("Compiled effect version mismatch, recompile it from the source effect: ", path);
+            return false;
+        }
+
+        // Reset if we're to continue loading
+        Reset();
+        spawnRelativeTransform = header.spawnRelative;
+        renderRelativeTransform = header.renderRelative;
+        fixedTimestep = header.fixedTimestep;
+        maxSubsteps = header.maxSubsteps;
+        bool valid = Serialization::ReadString(cursor, end, name);
+
+        // Releases the textures of the emitters loaded so far along with them
+        auto fail = [&](const char* message)
+        {
+            Error(message, path);
+            for (auto& emitter : loadedEmitters) emitter.RemoveTexture();
+            Reset();
+            return false;
+        };
+
+        // Read all emitters, counts are only trusted as far as the data left can hold them
+        const size_t minEmitterSize = sizeof(BinaryEmitterHeader) + 2 * sizeof(uint32_t) +
+            sizeof(CPUParticleEmitter::ParticleProperties) + sizeof(CPUParticleEmitter::AffectorProperties);
+        valid = valid && header.emitterCount <= (size_t)(end - cursor) / minEmitterSize;
+        if (valid) loadedEmitters.reserve(header.emitterCount);
+        for (uint32_t i = 0; i < header.emitterCount && valid; ++i)
+        {
+            CPUParticleEmitter::Definition definition;
+
+            BinaryEmitterHeader emitterHeader;
+            valid = Serialization::Read(cursor, end, emitterHeader) &&
+                Serialization::ReadString(cursor, end, definition.name) &&
+                Serialization::ReadString(cursor, end, definition.texPath) &&
+                Serialization::Read(cursor, end, definition.particleProperties) &&
+                Serialization::Read(cursor, end, definition.affectorProperties);
+            if (!valid) break;
+
+            // An out of range mode would fall through every switch on it and index past the render queues
+            const CPUParticleEmitter::ParticleProperties& properties = definition.particleProperties;
+            if (!ValidMode(properties.spawnMode, CPUParticleEmitter::SpawnMode::SingleBurst) ||
+                !ValidMode(properties.positionMode, CPUParticleEmitter::PositionMode::RandomSphere) ||
+                !ValidMode(properties.velocityMode, CPUParticleEmitter::VelocityMode::RandomMinMax) ||
+                !ValidMode(properties.colorMode, CPUParticleEmitter::ColorMode::LerpOverLifetime) ||
+                !ValidMode(properties.sizeMode, CPUParticleEmitter::SizeMode::LerpOverLifetime) ||
+                !ValidMode(properties.opacityMode, CPUParticleEmitter::OpacityMode::LerpOverLifetime) ||
+                !ValidMode(properties.lifespanMode, CPUParticleEmitter::LifespanMode::RandomMinMax) ||
+                !ValidMode(definition.affectorProperties.collisionResponse, ParticleCollider::Response::Stick) ||
+                !ValidMode((CPUParticleEmitter::BlendMode)emitterHeader.blendMode, CPUParticleEmitter::BlendMode::Standard))
+            {
+                return fail("Invalid compiled effect: ");
+            }
+
+            definition.offset = emitterHeader.offset;
+            definition.duration = emitterHeader.duration;
+            definition.maxActiveParticles = std::clamp(emitterHeader.maxActiveParticles, 0, (int)CPUParticleEmitter::MAX_PARTICLES);
+            definition.seed = emitterHeader.seed;
+            definition.randomSeed = emitterHeader.randomSeed;
+            definition.blendMode = (CPUParticleEmitter::BlendMode)emitterHeader.blendMode;
+            definition.depthSort = emitterHeader.depthSort;
+            definition.orderedPool = emitterHeader.orderedPool;
+
+            // Attractors
+            valid = emitterHeader.attractorCount <= (size_t)(end - cursor) / sizeof(BinaryAttractor);
+            if (!valid) break;
+            definition.attractors.reserve(emitterHeader.attractorCount);
+            for (uint32_t a = 0; a < emitterHeader.attractorCount && valid; ++a)
+            {
+                BinaryAttractor attractor;
+                valid = Serialization::Read(cursor, end, attractor);
+                if (valid) definition.attractors.emplace_back(attractor.position, attractor.radius, attractor.strength, attractor.relativeToTransform);
+            }
+            if (!valid) break;
+
+            // Texture
+            if (definition.texPath.size() > 0) definition.texture = ResourceManager::Instance().LoadTexture2D(definition.texPath);
+
+            // Seeds the emitter, initializes its particle pool and kernels
+            loadedEmitters.emplace_back(std::make_shared<CPUParticleEmitter::Definition>(std::move(definition)));
+        }
+
+        if (!valid) return fail("Truncated compiled effect: ");
+
+        return true;
+    }
+
+    bool CPUParticleEffect::SaveBinary(const std::string& path) const
+    {
+        static_assert(std::is_trivially_copyable_v<CPUParticleEmitter::ParticleProperties>, "Particle properties must be trivially copyable");
+        static_assert(std::is_trivially_copyable_v<CPUParticleEmitter::AffectorProperties>, "Affector properties must be trivially copyable");
+
+        // Later loads must see the new contents
+        definitionCache.erase(File::GlobalizePath(path));
+
+        std::vector<char> data;
+
+        // Header
+        BinaryHeader header{};
+        std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+        header.version = BINARY_VERSION;
+        header.particlePropertiesSize = sizeof(CPUParticleEmitter::ParticleProperties);
+        header.affectorPropertiesSize = sizeof(CPUParticleEmitter::AffectorProperties);
+        header.emitterCount = (uint32_t)loadedEmitters.size();
+        header.spawnRelative = spawnRelativeTransform;
+        header.renderRelative = renderRelativeTransform;
+        header.fixedTimestep = fixedTimestep;
+        header.maxSubsteps = maxSubsteps;
+        Serialization::Write(data, header);
+        Serialization::WriteString(data, name);
+
+        // Emitters
+        for (const auto& emitter : loadedEmitters)
+        {
+            BinaryEmitterHeader emitterHeader{};
+            emitterHeader.offset = emitter.definition->offset;
+            emitterHeader.duration = emitter.definition->duration;
+            emitterHeader.maxActiveParticles = emitter.definition->maxActiveParticles;
+            emitterHeader.seed = emitter.definition->seed;
+            emitterHeader.randomSeed = emitter.definition->randomSeed;
+            emitterHeader.blendMode = (uint8_t)emitter.definition->blendMode;
+            emitterHeader.depthSort = emitter.definition->depthSort;
+            emitterHeader.orderedPool = emitter.definition->orderedPool;
+            emitterHeader.attractorCount = (uint32_t)emitter.definition->attractors.size();
+            Serialization::Write(data, emitterHeader);
+
+            Serialization::WriteString(data, emitter.definition->name);
+            Serialization::WriteString(data, emitter.definition->texture ? emitter.definition->texPath : "");
+            Serialization::Write(data, emitter.definition->particleProperties);
+            Serialization::Write(data, emitter.definition->affectorProperties);
+
+            for (const auto& a : emitter.definition->attractors)
+            {
+                Serialization::Write(data, BinaryAttractor{a.position, a.radius, a.strength, a.relativeToTransform});
+            }
+        }
+
+        // Output
+        std::ofstream file(File::GlobalizePath(path), std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            Error("Could not write compiled effect: ", path);
+            return false;
+        }
+        file.write(data.data(), data.size());
+        return true;
+    }
+
+    void CPUParticleEffect::CacheDefinition(const std::string& globalPath) const
+    {
+        auto definition = std::make_shared<Definition>();
+        definition->name = name;
+        definition->renderRelativeTransform = renderRelativeTransform;
+        definition->spawnRelativeTransform = spawnRelativeTransform;
+        definition->fixedTimestep = fixedTimestep;
+        definition->maxSubsteps = maxSubsteps;
+        for (const auto& emitter : loadedEmitters)
+        {
+            definition->emitters.push_back(emitter.GetDefinition());
+        }
+        definitionCache[globalPath] = std::move(definition);
+    }
+
+    void CPUParticleEffect::Instantiate(const Definition& definition)
+    {
+        Reset();
+        name = definition.name;
+        renderRelativeTransform = definition.renderRelativeTransform;
+        spawnRelativeTransform = definition.spawnRelativeTransform;
+        fixedTimestep = definition.fixedTimestep;
+        maxSubsteps = definition.maxSubsteps;
+
+        // Each emitter is seeded and gets its own particle pool, nothing else is copied
+        loadedEmitters.reserve(definition.emitters.size());
+        for (const auto& emitter : definition.emitters)
+        {
+            loadedEmitters.emplace_back(emitter);
+        }
+    }
+
     void CPUParticleEffect::Reset()
     {
         // Reset to default state
         state = State::Play;
         renderRelativeTransform = false;
         spawnRelativeTransform = false;
+        fixedTimestep = 0.0f;
+        maxSubsteps = 8;
 
         // Remove all emitters
         loadedEmitters.clear();
 
+        // Reset level of detail state, keeping the settings
+        lodStats = LODStats();
+        lodAccumulator = 0.0f;
+        lodFrames = 0;
+
         // Reset name
         name = "New Effect";
     }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -27,6 +30,77 @@ namespace Phi
                 Stopped
             };
 
+            // Simulation level of detail
+            enum class LODLevel
+            {
+                Full,       // Visible and near, updated every frame
+                Reduced,    // Far or off-screen, updated every few frames with the accumulated delta
+                Dormant     // Off-screen for longer than the longest particle lifespan, not updated at all
+            };
+
+            // Controls how simulation cost scales with distance from and visibility to the active camera
+            struct LODSettings
+            {
+                bool enabled = true;
+
+                // Radius of the sphere around the effect's origin used for visibility tests
+                float radius = 8.0f;
+
+                // Visible effects closer than this are simulated at full rate
+                float nearDistance = 32.0f;
+
+                // Effects at or beyond this distance, and all off-screen effects, use the lowest rate
+                float farDistance = 256.0f;
+
+                // Frames between updates at the lowest rate
+                int maxTickInterval = 8;
+
+                // Spawn rate and max particle scale at the lowest rate
+                float minSpawnScale = 0.25f;
+
+                // How much the scene's particle budget spares this effect, see ParticleBudget::GetScale()
+                float budgetPriority = 1.0f;
+            };
+
+            // Current level of detail state and counters
+            struct LODStats
+            {
+                LODLevel level{LODLevel::Full};
+                bool visible = true;
+                float distance = 0.0f;
+                int tickInterval = 1;
+                float spawnScale = 1.0f;
+
+                // Quality scale imposed by the scene's particle budget, on top of the spawn scale
+                float budgetScale = 1.0f;
+
+                // Seconds since the effect was last visible
+                float invisibleTime = 0.0f;
+
+                // Frames the emitters were updated on, and frames folded into a later update
+                uint64_t ticks = 0;
+                uint64_t skippedTicks = 0;
+
+                // Frames spent dormant, and the number of times the effect woke up and was fast-forwarded
+                uint64_t dormantFrames = 0;
+                uint64_t fastForwards = 0;
+            };
+
+            // A single deferred emitter update
+            // Updates of distinct emitters are independent and may run concurrently
+            struct EmitterUpdate
+            {
+                CPUParticleEmitter* emitter = nullptr;
+                glm::mat4 transform{1.0f};
+                float delta = 0.0f;
+                bool updateSpawns = true;
+                bool spawnRelative = false;
+                const ParticleCollider* collider = nullptr;
+
+                // Performs the update
+                void Run() const { emitter->Update(delta, updateSpawns, spawnRelative, transform, collider); }
+            };
+
             // Creates an empty particle effect
             CPUParticleEffect();
 
@@ -52,11 +126,20 @@ namespace Phi
             // Updates all particle emitters in the effect
             void Update(float delta);
 
+            // Appends the emitter updates Update() would perform to the given list instead of running them
+            // Reads the scene (e.g. transforms), so it must be called from the main thread
+            void QueueUpdates(std::vector<EmitterUpdate>& updates, float delta);
+
+            // Like QueueUpdates(), for effects that aren't attached to a node (e.g. headless tools)
+            // Uses the given transform, without level of detail or collision
+            void QueueDetachedUpdates(std::vector<EmitterUpdate>& updates, float delta, const glm::mat4& transform = glm::mat4(1.0f));
+
             // Renders all emitters that belong to this effect
             void Render();
 
             // Flushes all effects / emitters queued for rendering by Render()
-            static void FlushRenderQueue();
+            // Standard blended particles are sorted back to front as seen through the given view matrix
+            static void FlushRenderQueue(const glm::mat4& view);
 
             // Controls
 
@@ -77,24 +160,73 @@ namespace Phi
             // Clears all active particles and resets timers / accumulators for emitters
             void Restart();
 
+            // Returns true once no emitter will spawn any more particles and all particles have died
+            // Always true for stopped effects without particles, never for paused ones
+            bool IsFinished() const;
+
+            // Simulates every emitter in steps of exactly the given length, 0 uses the frame delta instead
+            // See CPUParticleEmitter::SetFixedTimestep()
+            void SetFixedTimestep(float step, int maxSubsteps = 8);
+
             // Serialization
 
-            // Loads the effect properties from a YAML file on disk
+            // Loads the effect properties from a YAML or compiled (.effectbin) file on disk
+            // Each file is only read once, later loads of the same path share the emitter
+            // definitions of the first one and just create new instances of them
             // Accepts local paths like data:// and user://
             bool Load(const std::string& path);
 
+            // Forgets all loaded effect files, so the next load of each reads it from disk again
+            // Effects that are already loaded keep their definitions
+            static void ClearCache() { definitionCache.clear(); }
+
             // Saves the effect to disk
             // Accepts local paths like data:// and user://
             void Save(const std::string& path, bool singleFile = false) const;
 
+            // Loads the effect from a compiled binary file on disk
+            // Accepts local paths like data:// and user://
+            bool LoadBinary(const std::string& path);
+
+            // Saves the effect to a compiled binary file, which loads without any parsing
+            // Load a YAML effect and call this to convert it
+            // Accepts local paths like data:// and user://
+            bool SaveBinary(const std::string& path) const;
+
             // Removes all emitters and resets to default values
             void Reset();
 
+            // Snapshots
+
+            // Appends the simulation state of every emitter (see CPUParticleEmitter::SaveState())
+            // Restoring a snapshot and applying the same updates with a fixed timestep reproduces the
+            // same frames bit for bit, so pre-warmed states can be cached for instant start-up
+            void SaveSnapshot(std::vector<char>& out) const;
+
+            // Restores a snapshot taken by SaveSnapshot() of an effect loaded from the same file
+            // Returns false (and restarts the effect if any emitter was already restored) if invalid
+            bool LoadSnapshot(const std::vector<char>& data);
+
             // Accessors
 
             // Returns the name of the effect
             inline const std::string& GetName() const { return name; }
 
+            // Gives read-write access to the level of detail settings
+            LODSettings& LOD() { return lodSettings; }
+
+            // Returns the fixed timestep length, or 0 if the frame delta is used
+            float GetFixedTimestep() const { return fixedTimestep; }
+
+            // Returns the current level of detail state and counters
+            const LODStats& GetLODStats() const { return lodStats; }
+
+            // Returns the number of live particles across all emitters
+            int GetActiveParticles() const;
+
+            // Returns the number of emitters in the effect
+            int GetEmitterCount() const { return (int)loadedEmitters.size(); }
+
         // Data / implementation
         private:
 
@@ -111,6 +243,113 @@ namespace Phi
             bool renderRelativeTransform = false;
             bool spawnRelativeTransform = false;
 
+            // Fixed timestep, disabled when 0
+            float fixedTimestep = 0.0f;
+            int maxSubsteps = 8;
+
+            // Level of detail
+            LODSettings lodSettings;
+            LODStats lodStats;
+            float lodAccumulator = 0.0f;
+            int lodFrames = 0;
+
+            // Voxel volumes particles collide with, gathered once per update
+            ParticleCollider collider;
+
+            // Everything loaded from an effect file, shared by all effects loaded from it
+            struct Definition
+            {
+                std::string name;
+                bool renderRelativeTransform = false;
+                bool spawnRelativeTransform = false;
+                float fixedTimestep = 0.0f;
+                int maxSubsteps = 8;
+                std::vector<std::shared_ptr<const CPUParticleEmitter::Definition>> emitters;
+            };
+
+            // Definitions of the files loaded so far, by global path
+            static inline std::unordered_map<std::string, std::shared_ptr<const Definition>> definitionCache;
+
+            // Adds the current settings and emitter definitions to the cache under the given global path
+            void CacheDefinition(const std::string& globalPath) const;
+
+            // Replaces the settings and emitters with new instances of a cached definition
+            void Instantiate(const Definition& definition);
+
+            // Step size used when fast-forwarding dormant effects
+            static constexpr float FAST_FORWARD_STEP = 1.0f / 30.0f;
+
+            // Updates the level of detail from the active camera
+            // Returns true if the emitters should be updated this frame, with the delta to use
+            bool UpdateLOD(float delta, const glm::mat4& transform, float& tickDelta);
+
+            // Brings dormant emitters up to date as if they had been simulated for the given time
+            void FastForward(float time, const glm::mat4& transform);
+
+            // Gathers the voxel objects and map the emitters collide with, if any emitter has collision enabled
+            void UpdateColliders(const glm::mat4& transform);
+
+            // Returns the longest lifespan any particle of this effect can have
+            float GetMaxLifespan() const;
+
+            // Compiled binary format
+            //
+            // Header, effect name, then for each emitter: BinaryEmitterHeader, name, texture path,
+            // the raw ParticleProperties and AffectorProperties structures, and attractors.
+            // Strings are a uint32_t length followed by the characters. All values are stored
+            // in native byte order and layout, any change to the property structures requires
+            // bumping BINARY_VERSION (their sizes are also validated on load)
+            static inline const char BINARY_MAGIC[4] = {'P', 'H', 'F', 'X'};
+            static const uint32_t BINARY_VERSION = 7;
+
+            struct BinaryHeader
+            {
+                char magic[4];
+                uint32_t version;
+                uint32_t particlePropertiesSize;
+                uint32_t affectorPropertiesSize;
+                uint32_t emitterCount;
+                uint8_t spawnRelative;
+                uint8_t renderRelative;
+                uint8_t padding[2];
+                float fixedTimestep;
+                int32_t maxSubsteps;
+            };
+
+            struct BinaryEmitterHeader
+            {
+                glm::vec3 offset;
+                float duration;
+                int32_t maxActiveParticles;
+                uint32_t seed;
+                uint8_t randomSeed;
+                uint8_t blendMode;
+                uint8_t depthSort;
+                uint8_t orderedPool;
+                uint32_t attractorCount;
+            };
+
+            struct BinaryAttractor
+            {
+                glm::vec3 position;
+                float radius;
+                float strength;
+                uint32_t relativeToTransform;
+            };
+
+            // Snapshot format: SnapshotHeader, then each emitter's saved state in order
+            static inline const char SNAPSHOT_MAGIC[4] = {'P', 'H', 'S', 'S'};
+            static const uint32_t SNAPSHOT_VERSION = 1;
+
+            struct SnapshotHeader
+            {
+                char magic[4];
+                uint32_t version;
+                uint32_t emitterCount;
+                float lodAccumulator;
+                int32_t lodFrames;
+            };
+
             // Friends
             
             // Necessary for the particle effect editor to work
@@ -0,0 +1,81 @@
+#include "cpu_particle_effect_pool.hpp"
+
+#include <algorithm>
+
+#include <phi/core/logging.hpp>
+#include <phi/scene/node.hpp>
+#include <phi/scene/components/transform.hpp>
+
+namespace Phi
+{
+    CPUParticleEffectPool::CPUParticleEffectPool(Scene& scene, const std::string& path, int capacity)
+        : scene(scene), path(path)
+    {
+        idle.reserve(capacity);
+        for (int i = 0; i < capacity; ++i)
+        {
+            Grow();
+        }
+    }
+
+    CPUParticleEffectPool::~CPUParticleEffectPool()
+    {
+        for (CPUParticleEffect* effect : active) effect->GetNode()->Delete();
+        for (CPUParticleEffect* effect : idle) effect->GetNode()->Delete();
+    }
+
+    CPUParticleEffect* CPUParticleEffectPool::Acquire(const glm::vec3& position)
+    {
+        if (idle.empty()) Grow();
+
+        CPUParticleEffect* effect = idle.back();
+        idle.pop_back();
+        active.push_back(effect);
+
+        // Move before restarting, so nothing is spawned at the old position
+        Transform* transform = effect->GetNode()->Get<Transform>();
+        if (transform) transform->SetPosition(position);
+        effect->Restart();
+        return effect;
+    }
+
+    void CPUParticleEffectPool::Release(CPUParticleEffect* effect)
+    {
+        auto it = std::find(active.begin(), active.end(), effect);
+        if (it == active.end())
+        {
+            Error("Released particle effect does not belong to the pool: ", path);
+            return;
+        }
+
+        // Order doesn't matter, swap with the last one
+        *it = active.back();
+        active.pop_back();
+
+        // Paused effects are neither simulated nor rendered
+        effect->Restart();
+        effect->Pause();
+        idle.push_back(effect);
+    }
+
+    int CPUParticleEffectPool::ReleaseFinished()
+    {
+        int released = 0;
+        for (int i = (int)active.size() - 1; i >= 0; --i)
+        {
+            if (active[i]->IsFinished())
+            {
+                Release(active[i]);
+                released++;
+            }
+        }
+        return released;
+    }
+
+    void CPUParticleEffectPool::Grow()
+    {
+        CPUParticleEffect& effect = scene.CreateNode3D()->AddComponent<CPUParticleEffect>(path);
+        effect.Pause();
+        idle.push_back(&effect);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <phi/scene/scene.hpp>
+#include <phi/scene/components/particles/cpu_particle_effect.hpp>
+
+namespace Phi
+{
+    // Recycles instances of one particle effect within a scene
+    //
+    // Short-lived effects (impacts, explosions, etc.) are acquired when they start and released
+    // when they are done, instead of creating and deleting a node each time. Released instances
+    // keep their nodes and particle storage and are paused, so they cost nothing to update or
+    // render, and acquiring one only restarts it. New instances share the emitter definitions of
+    // the first (see CPUParticleEffect::Load()), so the effect file is only ever read once
+    //
+    // NOTE: The pool owns its nodes, so it must be destroyed before the scene is cleared or destroyed
+    class CPUParticleEffectPool
+    {
+        // Interface
+        public:
+
+            // Creates a pool for the given effect file, with the given number of instances created up front
+            // Accepts local paths like data:// and user://
+            CPUParticleEffectPool(Scene& scene, const std::string& path, int capacity = 0);
+            ~CPUParticleEffectPool();
+
+            // Delete copy constructor/assignment
+            CPUParticleEffectPool(const CPUParticleEffectPool&) = delete;
+            CPUParticleEffectPool& operator=(const CPUParticleEffectPool&) = delete;
+
+            // Delete move constructor/assignment
+            CPUParticleEffectPool(CPUParticleEffectPool&& other) = delete;
+            CPUParticleEffectPool& operator=(CPUParticleEffectPool&& other) = delete;
+
+            // Restarts an idle instance at the given position and returns it
+            // A new instance is only created when none are idle
+            CPUParticleEffect* Acquire(const glm::vec3& position);
+
+            // Clears and pauses an acquired instance, making it available to Acquire() again
+            void Release(CPUParticleEffect* effect);
+
+            // Releases every acquired instance that has finished (see CPUParticleEffect::IsFinished())
+            // Returns the number of instances released
+            int ReleaseFinished();
+
+            // Returns the number of acquired instances
+            int GetActive() const { return (int)active.size(); }
+
+            // Returns the number of instances waiting to be acquired
+            int GetIdle() const { return (int)idle.size(); }
+
+        // Data / implementation
+        private:
+
+            Scene& scene;
+            std::string path;
+
+            // Instances by availability
+            // NOTE: Effects are never moved by the scene (their move constructors are deleted), so pointers stay valid
+            std::vector<CPUParticleEffect*> active;
+            std::vector<CPUParticleEffect*> idle;
+
+            // Creates a new instance on its own node and parks it in the idle list
+            void Grow();
+    };
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "cpu_particle_emitter.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <chrono>
 
@@ -8,16 +10,25 @@
 
 #include <phi/core/file.hpp>
 #include <phi/core/logging.hpp>
+#include <phi/core/serialization.hpp>
 #include <phi/scene/scene.hpp>
+#include <phi/scene/components/particles/particle_kernels.hpp>
 
 namespace Phi
 {
     void CPUParticleEmitter::IncreaseReferences()
+    {
+        // Update static reference counter
+        // NOTE: OpenGL resources are created lazily on the first flush,
+        // so emitters can be loaded and simulated without a context
+        refCount++;
+    }
+
+    void CPUParticleEmitter::InitializeResources()
     {
         // Manage static resources
-        if (refCount == 0)
+        if (quadBuffer == nullptr)
         {
-
             // Load shaders
             untexturedShader = new Shader();
             untexturedShader->LoadSource(GL_VERTEX_SHADER, "phi://graphics/shaders/untextured_particle_emitter.vs");
@@ -33,8 +44,8 @@ namespace Phi
             quadBuffer = new GPUBuffer(BufferType::Static, sizeof(quadData), quadData);
             texturedIndirectBuffer = new GPUBuffer(BufferType::DynamicDoubleBuffer, sizeof(DrawArraysCommand) * MAX_EMITTERS);
             untexturedIndirectBuffer = new GPUBuffer(BufferType::DynamicDoubleBuffer, sizeof(DrawArraysCommand) * MAX_EMITTERS);
-            texturedParticleBuffer = new GPUBuffer(BufferType::DynamicDoubleBuffer, sizeof(Particle) * MAX_PARTICLES * MAX_EMITTERS);
-            untexturedParticleBuffer = new GPUBuffer(BufferType::DynamicDoubleBuffer, sizeof(Particle) * MAX_PARTICLES * MAX_EMITTERS);
+            texturedParticleBuffer = new GPUBuffer(BufferType::DynamicDoubleBuffer, sizeof(PackedParticle) * MAX_PARTICLES * MAX_EMITTERS);
+            untexturedParticleBuffer = new GPUBuffer(BufferType::DynamicDoubleBuffer, sizeof(PackedParticle) * MAX_PARTICLES * MAX_EMITTERS);
             texturedEmitterBuffer = new GPUBuffer(BufferType::DynamicDoubleBuffer, (sizeof(glm::mat4) + sizeof(glm::vec4)) * MAX_EMITTERS);
             untexturedEmitterBuffer = new GPUBuffer(BufferType::DynamicDoubleBuffer, sizeof(glm::mat4) * MAX_EMITTERS);
 
@@ -42,41 +53,34 @@ namespace Phi
             texturedVAO = new VertexAttributes(VertexFormat::POS, quadBuffer);
             texturedVAO->Bind();
             texturedParticleBuffer->Bind(GL_ARRAY_BUFFER);
-            texturedVAO->AddAttribute(3, GL_FLOAT, 1, sizeof(Particle), 0);
-            texturedVAO->AddAttribute(4, GL_FLOAT, 1, sizeof(Particle), offsetof(Particle, color));
-            texturedVAO->AddAttribute(2, GL_FLOAT, 1, sizeof(Particle), offsetof(Particle, size));
+            texturedVAO->AddAttribute(4, GL_HALF_FLOAT, 1, sizeof(PackedParticle), offsetof(PackedParticle, position));
+            texturedVAO->AddAttribute(4, GL_UNSIGNED_BYTE, 1, sizeof(PackedParticle), offsetof(PackedParticle, color), GL_TRUE);
+            texturedVAO->AddAttribute(2, GL_HALF_FLOAT, 1, sizeof(PackedParticle), offsetof(PackedParticle, size));
 
             untexturedVAO = new VertexAttributes(VertexFormat::POS, quadBuffer);
             untexturedVAO->Bind();
             untexturedParticleBuffer->Bind(GL_ARRAY_BUFFER);
-            untexturedVAO->AddAttribute(3, GL_FLOAT, 1, sizeof(Particle), 0);
-            untexturedVAO->AddAttribute(4, GL_FLOAT, 1, sizeof(Particle), offsetof(Particle, color));
-            untexturedVAO->AddAttribute(2, GL_FLOAT, 1, sizeof(Particle), offsetof(Particle, size));
+            untexturedVAO->AddAttribute(4, GL_HALF_FLOAT, 1, sizeof(PackedParticle), offsetof(PackedParticle, position));
+            untexturedVAO->AddAttribute(4, GL_UNSIGNED_BYTE, 1, sizeof(PackedParticle), offsetof(PackedParticle, color), GL_TRUE);
+            untexturedVAO->AddAttribute(2, GL_HALF_FLOAT, 1, sizeof(PackedParticle), offsetof(PackedParticle, size));
 
             // Debug logging
             Log("CPUParticleEmitter resources initialized");
         }
-
-        // Update static reference counter
-        refCount++;
     }
 
     CPUParticleEmitter::CPUParticleEmitter()
+        : definition(std::make_shared<Definition>())
     {
         // Reference counter update
         IncreaseReferences();
 
-        // Set random seed if necessary
-        if (randomSeed)
-        {
-            rng.SetSeed(GLOBAL_RNG.NextInt(INT32_MIN, INT32_MAX));
-        }
-
-        // Initialize particle pool
-        particlePool.resize(maxActiveParticles);
+        // Seed, initialize particle pool and select kernels for the default modes
+        SetDefinition(definition);
     }
 
     CPUParticleEmitter::CPUParticleEmitter(const std::string& path)
+        : definition(std::make_shared<Definition>())
     {
         // Reference counter update
         IncreaseReferences();
@@ -84,10 +88,12 @@ namespace Phi
         if (!Load(path))
         {
             Error("Invalid Emitter File: ", path);
+            UpdateKernels();
         }
     }
 
     CPUParticleEmitter::CPUParticleEmitter(const YAML::Node& node)
+        : definition(std::make_shared<Definition>())
     {
         // Reference counter update
         IncreaseReferences();
@@ -95,54 +101,69 @@ namespace Phi
         if (!Load(node))
         {
             Error("Invalid Emitter Node: ", node);
+            UpdateKernels();
         }
     }
 
+    CPUParticleEmitter::CPUParticleEmitter(std::shared_ptr<const Definition> definition)
+    {
+        // Reference counter update
+        IncreaseReferences();
+
+        SetDefinition(std::move(definition));
+    }
+
     CPUParticleEmitter::CPUParticleEmitter(CPUParticleEmitter&& other)
     {
         // Needed so that the moved-from object doesn't remove static resources on destruction
         refCount++;
 
         // Steal all resources!
-        name = std::move(other.name);
-        randomSeed = std::move(other.randomSeed);
-        texPath = std::move(other.texPath);
-        texture = std::move(other.texture);
-        blendMode = std::move(other.blendMode);
-        duration = std::move(other.duration);
-        maxActiveParticles = std::move(other.maxActiveParticles);
-        particleProperties = std::move(other.particleProperties);
-        affectorProperties = std::move(other.affectorProperties);
-        attractors = std::move(other.attractors);
-        particlePool = std::move(other.particlePool);
-        activeParticles = std::move(other.activeParticles);
+        // NOTE: The definition is shared rather than stolen, so the moved-from emitter stays valid
+        definition = other.definition;
+        StealPool(other);
+        bounds = other.bounds;
         oldest = std::move(other.oldest);
         totalElapsedTime = std::move(other.totalElapsedTime);
         spawnAccumulator = std::move(other.spawnAccumulator);
+        spawnRateRandom = other.spawnRateRandom;
+        burstCountRandom = other.burstCountRandom;
+        burstDone = other.burstDone;
         rng = std::move(other.rng);
-        offset = std::move(other.offset);
+        kernels = other.kernels;
+        lodScale = other.lodScale;
+        budgetScale = other.budgetScale;
+        fixedTimestep = other.fixedTimestep;
+        maxSubsteps = other.maxSubsteps;
+        stepAccumulator = other.stepAccumulator;
+        attractorField = std::move(other.attractorField);
+        turbulenceField = std::move(other.turbulenceField);
+        flock = std::move(other.flock);
     }
 
     CPUParticleEmitter& CPUParticleEmitter::operator=(CPUParticleEmitter&& other)
     {
         // Steal all resources!
-        name = std::move(other.name);
-        randomSeed = std::move(other.randomSeed);
-        texPath = std::move(other.texPath);
-        texture = std::move(other.texture);
-        blendMode = std::move(other.blendMode);
-        duration = std::move(other.duration);
-        maxActiveParticles = std::move(other.maxActiveParticles);
-        particleProperties = std::move(other.particleProperties);
-        affectorProperties = std::move(other.affectorProperties);
-        attractors = std::move(other.attractors);
-        particlePool = std::move(other.particlePool);
-        activeParticles = std::move(other.activeParticles);
+        definition = other.definition;
+        if (arenaRange >= 0) arena.Release(arenaRange);
+        StealPool(other);
+        bounds = other.bounds;
         oldest = std::move(other.oldest);
         totalElapsedTime = std::move(other.totalElapsedTime);
         spawnAccumulator = std::move(other.spawnAccumulator);
+        spawnRateRandom = other.spawnRateRandom;
+        burstCountRandom = other.burstCountRandom;
+        burstDone = other.burstDone;
         rng = std::move(other.rng);
-        offset = std::move(other.offset);
+        kernels = other.kernels;
+        lodScale = other.lodScale;
+        budgetScale = other.budgetScale;
+        fixedTimestep = other.fixedTimestep;
+        maxSubsteps = other.maxSubsteps;
+        stepAccumulator = other.stepAccumulator;
+        attractorField = std::move(other.attractorField);
+        turbulenceField = std::move(other.turbulenceField);
+        flock = std::move(other.flock);
 
         // Return self for chaining
         return *this;
@@ -150,11 +171,14 @@ namespace Phi
 
     CPUParticleEmitter::~CPUParticleEmitter()
     {
+        // Return the particle pool
+        if (arenaRange >= 0) arena.Release(arenaRange);
+
         // Decrease reference counter
         if (refCount > 0) refCount--;
 
         // Cleanup static resources
-        if (refCount <= 0)
+        if (refCount <= 0 && quadBuffer)
         {
             delete quadBuffer;
             delete texturedShader;
@@ -168,12 +192,54 @@ namespace Phi
             delete texturedVAO;
             delete untexturedVAO;
 
+            quadBuffer = nullptr;
+            texturedShader = nullptr;
+            untexturedShader = nullptr;
+            texturedIndirectBuffer = nullptr;
+            untexturedIndirectBuffer = nullptr;
+            texturedParticleBuffer = nullptr;
+            untexturedParticleBuffer = nullptr;
+            texturedEmitterBuffer = nullptr;
+            untexturedEmitterBuffer = nullptr;
+            texturedVAO = nullptr;
+            untexturedVAO = nullptr;
+
             // Debug logging
             Log("CPUParticleEmitter resources destroyed");
         }
     }
 
-    void CPUParticleEmitter::Update(float delta, bool updateSpawns, bool spawnRelative, const glm::mat4& transform)
+    void CPUParticleEmitter::Update(float delta, bool updateSpawns, bool spawnRelative, const glm::mat4& transform, const ParticleCollider* collider)
+    {
+        // Variable timestep
+        if (fixedTimestep <= 0.0f)
+        {
+            Step(delta, updateSpawns, spawnRelative, transform, collider);
+            return;
+        }
+
+        // Take as many whole steps as have accumulated, dropping what we can't catch up on
+        stepAccumulator += delta;
+        int steps = (int)(stepAccumulator / fixedTimestep);
+        stepAccumulator -= steps * fixedTimestep;
+        steps = std::min(steps, maxSubsteps);
+
+        for (int i = 0; i < steps; ++i)
+        {
+            Step(fixedTimestep, updateSpawns, spawnRelative, transform, collider);
+        }
+    }
+
+    void CPUParticleEmitter::SetFixedTimestep(float step, int maxSubsteps)
+    {
+        // Leftover time of a different step length is meaningless
+        if (step != fixedTimestep) stepAccumulator = 0.0f;
+
+        fixedTimestep = std::max(step, 0.0f);
+        this->maxSubsteps = std::max(maxSubsteps, 1);
+    }
+
+    void CPUParticleEmitter::Step(float delta, bool updateSpawns, bool spawnRelative, const glm::mat4& transform, const ParticleCollider* collider)
     {
         // Only update counters if updating spawns and below duration or infinite duration
         if (updateSpawns)
@@ -181,213 +247,300 @@ namespace Phi
             // Update global time
             totalElapsedTime += delta;
 
+            // Spawn rates, burst sizes and the particle limit are scaled down by the effect's level of detail and the particle budget
+            const float spawnScale = lodScale * budgetScale;
+            const float spawnDelta = delta * spawnScale;
+
             int numSpawns = 0;
-            if (totalElapsedTime < duration || duration < 0)
+            if (totalElapsedTime < definition->duration || definition->duration < 0)
             {
                 // Calculate the number of spawns for this update
-                switch (particleProperties.spawnMode)
+                switch (definition->particleProperties.spawnMode)
                 {
                     case SpawnMode::Continuous:
-                        spawnAccumulator += delta * particleProperties.spawnRate;
+                        spawnAccumulator += spawnDelta * definition->particleProperties.spawnRate;
                         numSpawns = (int)spawnAccumulator;
                         spawnAccumulator -= numSpawns;
                         break;
                     
                     case SpawnMode::Random:
-                        spawnAccumulator += delta * particleProperties.spawnRateRandom;
+                        spawnAccumulator += spawnDelta * spawnRateRandom;
                         numSpawns = (int)spawnAccumulator;
                         spawnAccumulator -= numSpawns;
                         if (numSpawns > 0)
                         {
                             // Calculate next spawnRate randomly
-                            particleProperties.spawnRateRandom = rng.NextFloat(particleProperties.spawnRateMin, particleProperties.spawnRateMax);
+                            spawnRateRandom = rng.NextFloat(definition->particleProperties.spawnRateMin, definition->particleProperties.spawnRateMax);
                         }
                         break;
                     
                     case SpawnMode::ContinuousBurst:
-                        spawnAccumulator += delta * particleProperties.spawnRate;
-                        numSpawns = (int)spawnAccumulator * particleProperties.burstCount;
+                        spawnAccumulator += spawnDelta * definition->particleProperties.spawnRate;
+                        numSpawns = (int)spawnAccumulator * definition->particleProperties.burstCount;
                         spawnAccumulator -= (int)spawnAccumulator;
                         break;
                     
                     case SpawnMode::RandomBurst:
-                        spawnAccumulator += delta * particleProperties.spawnRateRandom;
-                        numSpawns = (int)spawnAccumulator * particleProperties.burstCountRandom;
+                        spawnAccumulator += spawnDelta * spawnRateRandom;
+                        numSpawns = (int)spawnAccumulator * burstCountRandom;
                         spawnAccumulator -= (int)spawnAccumulator;
                         if (numSpawns > 0)
                         {
                             // Calculate next spawnRate randomly
-                            particleProperties.spawnRateRandom = rng.NextFloat(particleProperties.spawnRateMin, particleProperties.spawnRateMax);
-                            particleProperties.burstCountRandom = rng.NextInt(particleProperties.burstCountMin, particleProperties.burstCountMax);
+                            spawnRateRandom = rng.NextFloat(definition->particleProperties.spawnRateMin, definition->particleProperties.spawnRateMax);
+                            burstCountRandom = rng.NextInt(definition->particleProperties.burstCountMin, definition->particleProperties.burstCountMax);
                         }
                         break;
                     
                     case SpawnMode::SingleBurst:
-                        if (!particleProperties.burstDone)
+                        if (!burstDone)
                         {
                             // Set burst amount
-                            numSpawns = particleProperties.burstCount;
+                            numSpawns = (int)std::ceil(definition->particleProperties.burstCount * spawnScale);
 
                             // Update flag
-                            particleProperties.burstDone = true;
+                            burstDone = true;
                         }
                         break;
                 }
             }
 
-            // Spawn new particles
-            for (int i = 0; i < numSpawns; ++i)
+            // Choose the slots of new particles
+            const int particleLimit = spawnScale < 1.0f ? std::max(1, (int)(definition->maxActiveParticles * spawnScale)) : definition->maxActiveParticles;
+            spawnIndices.clear();
+            if (definition->orderedPool && definition->maxActiveParticles > 0)
             {
-                // Calculate the index of the particle to spawn
-                int nextParticle = oldest;
-                if (activeParticles < maxActiveParticles)
+                // Spawns beyond the limit would only recycle particles spawned this update
+                numSpawns = std::min(numSpawns, particleLimit);
+
+                // Recycle the oldest particles by dropping them from the front, one per spawn at the limit
+                int recycled = std::clamp(activeParticles + numSpawns - particleLimit, 0, numSpawns);
+                first += recycled;
+                activeParticles -= recycled;
+
+                // New particles are appended at the back, once that runs past the end of the
+                // storage the active window is moved back to the start. The storage holds twice
+                // the particle limit, so this happens at most once every maxActiveParticles spawns
+                if (first + activeParticles + numSpawns > base + capacity)
                 {
-                    // Use the next available particle if we can
-                    nextParticle = activeParticles;
-
-                    // Increase counter only if not recycling
-                    activeParticles++;
+                    particles->Move(first, base, activeParticles);
+                    first = base;
                 }
 
-                // Ensure oldest is always valid when recycling
-                if (nextParticle == oldest)
+                for (int i = 0; i < numSpawns; ++i)
                 {
-                    if (oldest < activeParticles - 1)
+                    int nextParticle = first + activeParticles++;
+                    particles->age[nextParticle] = 0.0f;
+                    spawnIndices.push_back(nextParticle);
+                }
+            }
+            else
+            {
+                for (int i = 0; i < numSpawns && definition->maxActiveParticles > 0; ++i)
+                {
+                    // Calculate the index of the particle to spawn
+                    int nextParticle = oldest;
+                    if (activeParticles < particleLimit)
                     {
-                        oldest = particlePool[0].ageNormalized > particlePool[oldest + 1].ageNormalized ? 0 : oldest + 1;
+                        // Use the next available particle if we can
+                        nextParticle = activeParticles;
+
+                        // Increase counter only if not recycling
+                        activeParticles++;
                     }
-                    else
+
+                    // Ensure oldest is always valid when recycling
+                    if (nextParticle == oldest)
                     {
-                        oldest = 0;
+                        if (oldest < activeParticles - 1)
+                        {
+                            oldest = particles->age[first] > particles->age[first + oldest + 1] ? 0 : oldest + 1;
+                        }
+                        else
+                        {
+                            oldest = 0;
+                        }
                     }
+
+                    // Reset age immediately, as choosing the oldest particle depends on it
+                    particles->age[first + nextParticle] = 0.0f;
+                    spawnIndices.push_back(first + nextParticle);
                 }
+            }
 
-                // Grab the next particle
-                Particle& spawned = particlePool[nextParticle];
+            // Initialize new particles, one attribute at a time
+            if (spawnIndices.size() > 0)
+            {
+                const int* indices = spawnIndices.data();
+                int count = (int)spawnIndices.size();
+
+                (this->*kernels.spawnPositions[spawnRelative])(indices, count, transform);
+                (this->*kernels.spawnVelocities)(indices, count, transform);
+                (this->*kernels.spawnColors)(indices, count, transform);
+                (this->*kernels.spawnSizes)(indices, count, transform);
+                (this->*kernels.spawnOpacities)(indices, count, transform);
+                (this->*kernels.spawnLifespans)(indices, count, transform);
+            }
+        }
 
-                // Initialize properties
-                spawned.ageNormalized = 0.0f;
+        // Age all particles, analytic emitters bound the spawn positions of the survivors at the same time
+        if (kernels.analytic) ParticleKernels::AgeAndBound(*particles, first, activeParticles, delta, bounds);
+        else ParticleKernels::Age(particles->age.data() + first, particles->invLifespan.data() + first, delta, activeParticles);
 
-                // Position
-                switch (particleProperties.positionMode)
-                {
-                    case PositionMode::Constant:
-                        spawned.position = particleProperties.position;
-                        break;
-                    
-                    case PositionMode::RandomMinMax:
-                        spawned.position = rng.RandomPosition(particleProperties.positionMin, particleProperties.positionMax);
-                        break;
-                    
-                    case PositionMode::RandomSphere:
-                        spawned.position = rng.RandomDirection() * rng.NextFloat(0.0f, 1.0f) * particleProperties.spawnRadius + particleProperties.position;
-                        break;
-                }
+        // Remove particles that should die
+        RemoveExpired();
 
-                // Transform position if requested
-                if (spawnRelative)
-                {
-                    spawned.position = glm::vec3(transform * glm::vec4(spawned.position, 1.0f)) + offset;
-                }
-                else
-                {
-                    spawned.position += offset;
-                }
+        // Everything else is evaluated from the spawn state when drawn
+        if (kernels.analytic) return;
 
-                // Velocity
-                switch (particleProperties.velocityMode)
-                {
-                    case VelocityMode::Constant:
-                        spawned.velocity = particleProperties.velocity;
-                        break;
-                    
-                    case VelocityMode::RandomMinMax:
-                        spawned.velocity.x = rng.NextFloat(particleProperties.velocityMin.x, particleProperties.velocityMax.x);
-                        spawned.velocity.y = rng.NextFloat(particleProperties.velocityMin.y, particleProperties.velocityMax.y);
-                        spawned.velocity.z = rng.NextFloat(particleProperties.velocityMin.z, particleProperties.velocityMax.z);
-                        break;
-                }
+        // Resolve attractor positions once instead of once per particle
+        attractorData.clear();
+        for (const auto& attractor : definition->attractors)
+        {
+            glm::vec3 position = attractor.relativeToTransform ? glm::vec3(transform * glm::vec4(attractor.position, 1.0f)) : attractor.position;
+            attractorData.push_back({position, attractor.radius, attractor.strength});
+        }
 
-                // Color
-                switch (particleProperties.colorMode)
-                {
-                    case ColorMode::Constant:
-                        spawned.color.r = particleProperties.color.r;
-                        spawned.color.g = particleProperties.color.g;
-                        spawned.color.b = particleProperties.color.b;
-                        break;
-                    
-                    case ColorMode::RandomMinMax:
-                        spawned.color.r = rng.NextFloat(particleProperties.colorMin.r, particleProperties.colorMax.r);
-                        spawned.color.g = rng.NextFloat(particleProperties.colorMin.g, particleProperties.colorMax.g);
-                        spawned.color.b = rng.NextFloat(particleProperties.colorMin.b, particleProperties.colorMax.b);
-                        break;
-                    
-                    case ColorMode::RandomLerp:
-                        glm::vec3 interpolated = glm::mix(particleProperties.colorA, particleProperties.colorB, rng.NextFloat(0.0f, 1.0f));
-                        spawned.color.r = interpolated.r;
-                        spawned.color.g = interpolated.g;
-                        spawned.color.b = interpolated.b;
-                        break;
-                }
+        // Simulate all surviving particles with the specialized kernel
+        ParticleKernels::SimulateParams params;
+        params.particles = particles;
+        params.first = first;
+        params.count = activeParticles;
+        params.delta = delta;
+        params.startColor = definition->particleProperties.startColor;
+        params.endColor = definition->particleProperties.endColor;
+        params.startSize = definition->particleProperties.startSize;
+        params.endSize = definition->particleProperties.endSize;
+        params.startOpacity = definition->particleProperties.startOpacity;
+        params.endOpacity = definition->particleProperties.endOpacity;
+        params.gravity = GRAVITATIONAL_ACCELERATION * delta;
+        params.damping = 1 - (definition->particleProperties.damping * delta);
+        params.bounds = &bounds;
+
+        const bool bakeAttractors = definition->affectorProperties.bakeAttractors && attractorData.size() > 0;
+        const bool turbulence = definition->affectorProperties.turbulenceEnabled && activeParticles > 0;
+        const bool flocking = definition->affectorProperties.flockingEnabled && activeParticles > 1;
+        if (bakeAttractors || turbulence || flocking)
+        {
+            // Same order as the exact path: forces are applied before damping
+            if (!bakeAttractors)
+            {
+                params.attractors = attractorData.data();
+                params.attractorCount = (int)attractorData.size();
+            }
+            kernels.simulateUndamped(params);
 
-                // Size
-                switch (particleProperties.sizeMode)
-                {
-                    case SizeMode::Constant:
-                        spawned.size = particleProperties.size;
-                        break;
-                    
-                    case SizeMode::RandomMinMax:
-                        spawned.size.x = rng.NextFloat(particleProperties.sizeMin.x, particleProperties.sizeMax.x);
-                        spawned.size.y = rng.NextFloat(particleProperties.sizeMin.y, particleProperties.sizeMax.y);
-                        break;
-                    
-                    case SizeMode::RandomLerp:
-                        spawned.size = glm::mix(particleProperties.sizeMin, particleProperties.sizeMax, rng.NextFloat(0.0f, 1.0f));
-                        break;
-                }
+            float* posX = particles->posX.data() + first;
+            float* posY = particles->posY.data() + first;
+            float* posZ = particles->posZ.data() + first;
+            float* velX = particles->velX.data() + first;
+            float* velY = particles->velY.data() + first;
+            float* velZ = particles->velZ.data() + first;
 
-                // Opacity
-                switch (particleProperties.opacityMode)
+            if (bakeAttractors)
+            {
+                // Rebake only when attractors or the transform moved them
+                const int resolution = definition->affectorProperties.attractorFieldResolution;
+                if (!attractorField) attractorField = std::make_unique<AttractorField>();
+                if (!attractorField->Matches(attractorData.data(), (int)attractorData.size(), resolution))
                 {
-                    case OpacityMode::Constant:
-                        spawned.color.a = particleProperties.opacity;
-                        break;
-                    
-                    case OpacityMode::RandomMinMax:
-                        spawned.color.a = rng.NextFloat(particleProperties.opacityMin, particleProperties.opacityMax);
-                        break;
+                    attractorField->Bake(attractorData.data(), (int)attractorData.size(), resolution);
                 }
-                
-                // Lifetime
-                switch (particleProperties.lifespanMode)
+                attractorField->Apply(posX, posY, posZ, velX, velY, velZ, delta, activeParticles);
+            }
+
+            if (turbulence)
+            {
+                // The pattern scrolls with the emitter's elapsed time
+                if (!turbulenceField) turbulenceField = std::make_unique<TurbulenceField>();
+                glm::vec3 scrollOffset = -definition->affectorProperties.turbulenceScroll * totalElapsedTime;
+                turbulenceField->Cover(posX, posY, posZ, activeParticles, definition->affectorProperties.turbulenceFrequency, scrollOffset);
+                turbulenceField->Apply(posX, posY, posZ, velX, velY, velZ, definition->affectorProperties.turbulenceStrength, delta, activeParticles);
+            }
+
+            if (flocking)
+            {
+                // Neighbours are found in a grid rebuilt from this step's positions
+                const auto& affectors = definition->affectorProperties;
+                if (!flock) flock = std::make_unique<ParticleFlock>();
+                flock->Build(posX, posY, posZ, velX, velY, velZ, activeParticles, affectors.flockingRadius);
+                flock->Apply(velX, velY, velZ, affectors.separation, affectors.cohesion, affectors.alignment, delta, affectors.maxNeighbours);
+            }
+
+            if (definition->particleProperties.damping > 0.0f)
+            {
+                ParticleKernels::Scale(velX, params.damping, activeParticles);
+                ParticleKernels::Scale(velY, params.damping, activeParticles);
+                ParticleKernels::Scale(velZ, params.damping, activeParticles);
+            }
+        }
+        else
+        {
+            params.attractors = attractorData.data();
+            params.attractorCount = (int)attractorData.size();
+            kernels.simulate(params);
+        }
+
+        // Collide with voxels once particles have moved
+        if (definition->affectorProperties.collisionEnabled && collider && !collider->IsEmpty())
+        {
+            const auto response = definition->affectorProperties.collisionResponse;
+            int collisions = collider->Collide(*particles, first, activeParticles, delta, response, definition->affectorProperties.restitution, &bounds);
+            if (collisions > 0 && response == ParticleCollider::Response::Kill) RemoveExpired();
+        }
+    }
+
+    void CPUParticleEmitter::RemoveExpired()
+    {
+        if (definition->orderedPool)
+        {
+            // Particles are in spawn order, so when they all share a lifespan the expired ones are at the front
+            while (activeParticles > 0 && particles->age[first] > 1.0f)
+            {
+                first++;
+                activeParticles--;
+            }
+
+            // Particles sharing a lifespan expire in spawn order, so there is nothing else to remove. Ones spawned
+            // before the lifespan was edited differ from the newest, and are scanned for until they are gone
+            if (kernels.expireInOrder && (activeParticles == 0 ||
+                particles->invLifespan[first] == particles->invLifespan[first + activeParticles - 1]))
+            {
+                if (activeParticles == 0) first = base;
+                return;
+            }
+
+            // Anything else expired (random lifespans, collisions) is removed while preserving order
+            const float* age = particles->age.data();
+            const int end = first + activeParticles;
+            int expired = 0;
+            for (int i = first; i < end; ++i)
+            {
+                expired += age[i] > 1.0f;
+            }
+
+            if (expired > 0)
+            {
+                int kept = first;
+                for (int i = first; i < end; ++i)
                 {
-                    case LifespanMode::Constant:
-                        spawned.lifespanNormalized = 1 / particleProperties.lifespan;
-                        break;
-                    
-                    case LifespanMode::RandomMinMax:
-                        spawned.lifespanNormalized = 1 / rng.NextFloat(particleProperties.lifespanMin, particleProperties.lifespanMax);
-                        break;
+                    if (age[i] > 1.0f) continue;
+                    if (i != kept) particles->Copy(i, kept);
+                    kept++;
                 }
+                activeParticles = kept - first;
             }
+
+            if (activeParticles == 0) first = base;
+            return;
         }
 
-        // Simulate all particles
         for (int i = 0; i < activeParticles; ++i)
         {
-            // Grab the next active particle
-            Particle& particle = particlePool[i];
-
-            // Age particle
-            particle.ageNormalized += delta * particle.lifespanNormalized;
-
-            // Check for particles that should die
-            if (particle.ageNormalized > 1.0f)
+            if (particles->age[first + i] > 1.0f)
             {
                 // Replace with last active particle
-                std::swap(particle, particlePool[activeParticles - 1]);
+                particles->Copy(first + activeParticles - 1, first + i);
 
                 // Decrease counter
                 activeParticles--;
@@ -398,7 +551,7 @@ namespace Phi
                 {
                     if (oldest < activeParticles - 1)
                     {
-                        oldest = particlePool[0].ageNormalized > particlePool[oldest + 1].ageNormalized ? 0 : oldest + 1;
+                        oldest = particles->age[first] > particles->age[first + oldest + 1] ? 0 : oldest + 1;
                     }
                     else
                     {
@@ -408,72 +561,382 @@ namespace Phi
 
                 // Ensure we process the one we just swapped
                 i--;
-                continue;
             }
+        }
+    }
+
+    void CPUParticleEmitter::SetOrderedPool(bool enabled)
+    {
+        EditDefinition().orderedPool = enabled;
+        activeParticles = 0;
+        first = base;
+        oldest = 0;
+        bounds = {};
+        ResizePool();
+    }
+
+    void CPUParticleEmitter::ResizePool()
+    {
+        activeParticles = std::min(activeParticles, std::max(definition->maxActiveParticles, 0));
+        if (oldest >= activeParticles) oldest = 0;
+
+        // Ordered pools need room to append behind the active window
+        const int newCapacity = std::max(definition->maxActiveParticles, 0) * (definition->orderedPool ? 2 : 1);
+        if (newCapacity == capacity)
+        {
+            // Move the active window to the start of the range
+            if (first > base) particles->Move(first, base, activeParticles);
+            first = base;
+            return;
+        }
+
+        // Surviving particles are copied to the start of a new range
+        ParticleArena::Range range;
+        if (newCapacity > 0)
+        {
+            range = arena.Allocate(newCapacity, this);
+            range.data->CopyFrom(*particles, first, range.offset, activeParticles);
+        }
+        if (arenaRange >= 0) arena.Release(arenaRange);
+
+        arenaRange = range.id;
+        particles = range.data ? range.data : &noParticles;
+        base = range.offset;
+        capacity = range.capacity;
+        first = base;
+    }
+
+    void CPUParticleEmitter::StealPool(CPUParticleEmitter& other)
+    {
+        particles = other.particles;
+        activeParticles = other.activeParticles;
+        first = other.first;
+        base = other.base;
+        capacity = other.capacity;
+        arenaRange = other.arenaRange;
+        if (arenaRange >= 0) arena.SetOwner(arenaRange, this);
+
+        // The moved-from emitter is left without a pool
+        other.particles = &noParticles;
+        other.activeParticles = 0;
+        other.first = 0;
+        other.base = 0;
+        other.capacity = 0;
+        other.arenaRange = -1;
+    }
+
+    void CPUParticleEmitter::Relocate(int offset)
+    {
+        first += offset - base;
+        base = offset;
+    }
+
+    void CPUParticleEmitter::UpdateKernels()
+    {
+        // Spawn passes
+        switch (definition->particleProperties.positionMode)
+        {
+            case PositionMode::Constant:
+                kernels.spawnPositions[0] = &CPUParticleEmitter::SpawnPositions<PositionMode::Constant, false>;
+                kernels.spawnPositions[1] = &CPUParticleEmitter::SpawnPositions<PositionMode::Constant, true>;
+                break;
+            
+            case PositionMode::RandomMinMax:
+                kernels.spawnPositions[0] = &CPUParticleEmitter::SpawnPositions<PositionMode::RandomMinMax, false>;
+                kernels.spawnPositions[1] = &CPUParticleEmitter::SpawnPositions<PositionMode::RandomMinMax, true>;
+                break;
+            
+            case PositionMode::RandomSphere:
+                kernels.spawnPositions[0] = &CPUParticleEmitter::SpawnPositions<PositionMode::RandomSphere, false>;
+                kernels.spawnPositions[1] = &CPUParticleEmitter::SpawnPositions<PositionMode::RandomSphere, true>;
+                break;
+        }
+
+        switch (definition->particleProperties.velocityMode)
+        {
+            case VelocityMode::Constant: kernels.spawnVelocities = &CPUParticleEmitter::SpawnVelocities<VelocityMode::Constant>; break;
+            case VelocityMode::RandomMinMax: kernels.spawnVelocities = &CPUParticleEmitter::SpawnVelocities<VelocityMode::RandomMinMax>; break;
+        }
+
+        switch (definition->particleProperties.colorMode)
+        {
+            case ColorMode::Constant: kernels.spawnColors = &CPUParticleEmitter::SpawnColors<ColorMode::Constant>; break;
+            case ColorMode::RandomMinMax: kernels.spawnColors = &CPUParticleEmitter::SpawnColors<ColorMode::RandomMinMax>; break;
+            case ColorMode::RandomLerp: kernels.spawnColors = &CPUParticleEmitter::SpawnColors<ColorMode::RandomLerp>; break;
+            case ColorMode::LerpOverLifetime: kernels.spawnColors = &CPUParticleEmitter::SpawnColors<ColorMode::LerpOverLifetime>; break;
+        }
+
+        switch (definition->particleProperties.sizeMode)
+        {
+            case SizeMode::Constant: kernels.spawnSizes = &CPUParticleEmitter::SpawnSizes<SizeMode::Constant>; break;
+            case SizeMode::RandomMinMax: kernels.spawnSizes = &CPUParticleEmitter::SpawnSizes<SizeMode::RandomMinMax>; break;
+            case SizeMode::RandomLerp: kernels.spawnSizes = &CPUParticleEmitter::SpawnSizes<SizeMode::RandomLerp>; break;
+            case SizeMode::LerpOverLifetime: kernels.spawnSizes = &CPUParticleEmitter::SpawnSizes<SizeMode::LerpOverLifetime>; break;
+        }
+
+        switch (definition->particleProperties.opacityMode)
+        {
+            case OpacityMode::Constant: kernels.spawnOpacities = &CPUParticleEmitter::SpawnOpacities<OpacityMode::Constant>; break;
+            case OpacityMode::RandomMinMax: kernels.spawnOpacities = &CPUParticleEmitter::SpawnOpacities<OpacityMode::RandomMinMax>; break;
+            case OpacityMode::LerpOverLifetime: kernels.spawnOpacities = &CPUParticleEmitter::SpawnOpacities<OpacityMode::LerpOverLifetime>; break;
+        }
+
+        switch (definition->particleProperties.lifespanMode)
+        {
+            case LifespanMode::Constant: kernels.spawnLifespans = &CPUParticleEmitter::SpawnLifespans<LifespanMode::Constant>; break;
+            case LifespanMode::RandomMinMax: kernels.spawnLifespans = &CPUParticleEmitter::SpawnLifespans<LifespanMode::RandomMinMax>; break;
+        }
+
+        // Only random lifespans and collisions can expire particles out of spawn order
+        kernels.expireInOrder = definition->particleProperties.lifespanMode == LifespanMode::Constant &&
+                                !definition->affectorProperties.collisionEnabled;
+
+        // Particles can be evaluated in closed form unless something other than gravity changes their velocity
+        const auto& affectors = definition->affectorProperties;
+        SetAnalytic(definition->attractors.empty() && definition->particleProperties.damping <= 0.0f &&
+                    !affectors.turbulenceEnabled && !affectors.flockingEnabled && !affectors.collisionEnabled);
+
+        // Simulation kernel
+        uint32_t flags = 0;
+        if (definition->particleProperties.colorMode == ColorMode::LerpOverLifetime) flags |= ParticleKernels::LerpColor;
+        if (definition->particleProperties.sizeMode == SizeMode::LerpOverLifetime) flags |= ParticleKernels::LerpSize;
+        if (definition->particleProperties.opacityMode == OpacityMode::LerpOverLifetime) flags |= ParticleKernels::LerpOpacity;
+        if (definition->affectorProperties.addVelocity) flags |= ParticleKernels::AddVelocity;
+        if (definition->affectorProperties.gravityEnabled) flags |= ParticleKernels::Gravity;
+        if (definition->particleProperties.damping > 0.0f) flags |= ParticleKernels::Damping;
+        kernels.simulate = ParticleKernels::GetSimulateKernel(flags);
+        kernels.simulateUndamped = ParticleKernels::GetSimulateKernel(flags & ~ParticleKernels::Damping);
+    }
+
+    void CPUParticleEmitter::SetAnalytic(bool analytic)
+    {
+        if (analytic == kernels.analytic) return;
+        kernels.analytic = analytic;
+
+        // Solve for the state the particles would have had at spawn, or from it, so they continue where they are
+        const auto& affectors = definition->affectorProperties;
+        const glm::vec3 acceleration = affectors.gravityEnabled ? GRAVITATIONAL_ACCELERATION : glm::vec3(0.0f);
+        const float direction = analytic ? -1.0f : 1.0f;
+        for (int i = first; i < first + activeParticles; ++i)
+        {
+            float t = particles->age[i] / particles->invLifespan[i];
+            glm::vec3 velocity(particles->velX[i], particles->velY[i], particles->velZ[i]);
+            glm::vec3 spawnVelocity = analytic ? velocity - acceleration * t : velocity;
+            if (affectors.addVelocity)
+            {
+                glm::vec3 displacement = (spawnVelocity + acceleration * (t * 0.5f)) * t * direction;
+                particles->posX[i] += displacement.x;
+                particles->posY[i] += displacement.y;
+                particles->posZ[i] += displacement.z;
+            }
+
+            velocity = analytic ? spawnVelocity : velocity + acceleration * t;
+            particles->velX[i] = velocity.x;
+            particles->velY[i] = velocity.y;
+            particles->velZ[i] = velocity.z;
+        }
+
+        // Bounds are of different positions in each mode
+        bounds = {};
+        for (int i = first; i < first + activeParticles; ++i)
+        {
+            glm::vec3 position(particles->posX[i], particles->posY[i], particles->posZ[i]);
+            bounds.min = glm::min(bounds.min, position);
+            bounds.max = glm::max(bounds.max, position);
+        }
+    }
+
+    void CPUParticleEmitter::Evaluate(ParticleData& out, bool positionsOnly)
+    {
+        const int count = activeParticles;
+        for (ParticleData::Stream* stream : {&out.posX, &out.posY, &out.posZ, &out.colR, &out.colG, &out.colB, &out.colA, &out.sizeX, &out.sizeY})
+        {
+            if ((int)stream->size() < count) stream->resize(count);
+        }
+
+        // Positions
+        const auto& affectors = definition->affectorProperties;
+        if (affectors.addVelocity)
+        {
+            const glm::vec3 acceleration = affectors.gravityEnabled ? GRAVITATIONAL_ACCELERATION : glm::vec3(0.0f);
+            ParticleKernels::Ballistic(*particles, first, count, acceleration, out.posX.data(), out.posY.data(), out.posZ.data());
+        }
+        else
+        {
+            std::copy_n(particles->posX.data() + first, count, out.posX.data());
+            std::copy_n(particles->posY.data() + first, count, out.posY.data());
+            std::copy_n(particles->posZ.data() + first, count, out.posZ.data());
+        }
+        if (positionsOnly) return;
 
-            // Over lifetime effects
+        // Attributes over lifetime only depend on age, the rest were set at spawn
+        const auto& props = definition->particleProperties;
+        const float* age = particles->age.data() + first;
+        auto attribute = [&](ParticleData::Stream& dst, const ParticleData::Stream& src, bool lerp, float start, float end)
+        {
+            if (lerp) ParticleKernels::Lerp(dst.data(), age, start, end, count);
+            else std::copy_n(src.data() + first, count, dst.data());
+        };
+
+        const bool lerpColor = props.colorMode == ColorMode::LerpOverLifetime;
+        attribute(out.colR, particles->colR, lerpColor, props.startColor.r, props.endColor.r);
+        attribute(out.colG, particles->colG, lerpColor, props.startColor.g, props.endColor.g);
+        attribute(out.colB, particles->colB, lerpColor, props.startColor.b, props.endColor.b);
+        attribute(out.colA, particles->colA, props.opacityMode == OpacityMode::LerpOverLifetime, props.startOpacity, props.endOpacity);
+
+        const bool lerpSize = props.sizeMode == SizeMode::LerpOverLifetime;
+        attribute(out.sizeX, particles->sizeX, lerpSize, props.startSize.x, props.endSize.x);
+        attribute(out.sizeY, particles->sizeY, lerpSize, props.startSize.y, props.endSize.y);
+    }
 
-            // Calculate next color
-            if (particleProperties.colorMode == ColorMode::LerpOverLifetime)
+    template <CPUParticleEmitter::PositionMode Mode, bool Relative>
+    void CPUParticleEmitter::SpawnPositions(const int* indices, int count, const glm::mat4& transform)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            glm::vec3 position{0.0f};
+            if constexpr (Mode == PositionMode::Constant)
+            {
+                position = definition->particleProperties.position;
+            }
+            else if constexpr (Mode == PositionMode::RandomMinMax)
             {
-                glm::vec3 newColor = glm::mix(particleProperties.startColor, particleProperties.endColor, particle.ageNormalized);
-                particle.color.r = newColor.r;
-                particle.color.g = newColor.g;
-                particle.color.b = newColor.b;
+                position = rng.RandomPosition(definition->particleProperties.positionMin, definition->particleProperties.positionMax);
+            }
+            else if constexpr (Mode == PositionMode::RandomSphere)
+            {
+                position = rng.RandomDirection() * rng.NextFloat(0.0f, 1.0f) * definition->particleProperties.spawnRadius + definition->particleProperties.position;
             }
 
-            // Calculate next size
-            if (particleProperties.sizeMode == SizeMode::LerpOverLifetime)
+            // Transform position if requested
+            if constexpr (Relative)
+            {
+                position = glm::vec3(transform * glm::vec4(position, 1.0f)) + definition->offset;
+            }
+            else
             {
-                glm::vec2 newSize = glm::mix(particleProperties.startSize, particleProperties.endSize, particle.ageNormalized);
-                particle.size.x = newSize.x;
-                particle.size.y = newSize.y;
+                position += definition->offset;
             }
 
-            // Calculate next opacity value
-            if (particleProperties.opacityMode == OpacityMode::LerpOverLifetime)
+            int index = indices[i];
+            particles->posX[index] = position.x;
+            particles->posY[index] = position.y;
+            particles->posZ[index] = position.z;
+        }
+    }
+
+    template <CPUParticleEmitter::VelocityMode Mode>
+    void CPUParticleEmitter::SpawnVelocities(const int* indices, int count, const glm::mat4&)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            int index = indices[i];
+            if constexpr (Mode == VelocityMode::Constant)
+            {
+                particles->velX[index] = definition->particleProperties.velocity.x;
+                particles->velY[index] = definition->particleProperties.velocity.y;
+                particles->velZ[index] = definition->particleProperties.velocity.z;
+            }
+            else if constexpr (Mode == VelocityMode::RandomMinMax)
             {
-                particle.color.a = glm::mix(particleProperties.startOpacity, particleProperties.endOpacity, particle.ageNormalized);
+                particles->velX[index] = rng.NextFloat(definition->particleProperties.velocityMin.x, definition->particleProperties.velocityMax.x);
+                particles->velY[index] = rng.NextFloat(definition->particleProperties.velocityMin.y, definition->particleProperties.velocityMax.y);
+                particles->velZ[index] = rng.NextFloat(definition->particleProperties.velocityMin.z, definition->particleProperties.velocityMax.z);
             }
+        }
+    }
+
+    template <CPUParticleEmitter::ColorMode Mode>
+    void CPUParticleEmitter::SpawnColors(const int* indices, int count, const glm::mat4&)
+    {
+        // Colors over lifetime are set by the simulation kernel
+        if constexpr (Mode == ColorMode::LerpOverLifetime) return;
 
-            // Affectors
+        for (int i = 0; i < count; ++i)
+        {
+            glm::vec3 color{0.0f};
+            if constexpr (Mode == ColorMode::Constant)
+            {
+                color = definition->particleProperties.color;
+            }
+            else if constexpr (Mode == ColorMode::RandomMinMax)
+            {
+                color.r = rng.NextFloat(definition->particleProperties.colorMin.r, definition->particleProperties.colorMax.r);
+                color.g = rng.NextFloat(definition->particleProperties.colorMin.g, definition->particleProperties.colorMax.g);
+                color.b = rng.NextFloat(definition->particleProperties.colorMin.b, definition->particleProperties.colorMax.b);
+            }
+            else if constexpr (Mode == ColorMode::RandomLerp)
+            {
+                color = glm::mix(definition->particleProperties.colorA, definition->particleProperties.colorB, rng.NextFloat(0.0f, 1.0f));
+            }
 
-            // Add velocity
-            if (affectorProperties.addVelocity) particle.position += particle.velocity * delta;
+            int index = indices[i];
+            particles->colR[index] = color.r;
+            particles->colG[index] = color.g;
+            particles->colB[index] = color.b;
+        }
+    }
 
-            // Apply gravity
-            if (affectorProperties.gravityEnabled) particle.velocity += GRAVITATIONAL_ACCELERATION * delta;
+    template <CPUParticleEmitter::SizeMode Mode>
+    void CPUParticleEmitter::SpawnSizes(const int* indices, int count, const glm::mat4&)
+    {
+        // Sizes over lifetime are set by the simulation kernel
+        if constexpr (Mode == SizeMode::LerpOverLifetime) return;
 
-            // Apply attractors
-            for (int i = 0; i < attractors.size(); ++i)
+        for (int i = 0; i < count; ++i)
+        {
+            glm::vec2 size{0.0f};
+            if constexpr (Mode == SizeMode::Constant)
+            {
+                size = definition->particleProperties.size;
+            }
+            else if constexpr (Mode == SizeMode::RandomMinMax)
             {
-                // Grab the attractor
-                const auto& attractor = attractors[i];
+                size.x = rng.NextFloat(definition->particleProperties.sizeMin.x, definition->particleProperties.sizeMax.x);
+                size.y = rng.NextFloat(definition->particleProperties.sizeMin.y, definition->particleProperties.sizeMax.y);
+            }
+            else if constexpr (Mode == SizeMode::RandomLerp)
+            {
+                size = glm::mix(definition->particleProperties.sizeMin, definition->particleProperties.sizeMax, rng.NextFloat(0.0f, 1.0f));
+            }
 
-                // Get vector from particle to attractor, depending on relative setting
-                glm::vec3 particleToAttractor;
-                if (attractor.relativeToTransform)
-                {
-                    particleToAttractor = glm::vec3(transform * glm::vec4(attractor.position, 1.0f)) - particle.position;
-                }
-                else
-                {
-                    particleToAttractor = attractor.position - particle.position;
-                }
+            int index = indices[i];
+            particles->sizeX[index] = size.x;
+            particles->sizeY[index] = size.y;
+        }
+    }
 
-                // Calculate effect on velocity
-                float distance = glm::length(particleToAttractor);
-                glm::vec3 n = glm::normalize(particleToAttractor) * glm::abs(attractor.strength);
-                if (distance < attractor.radius)
-                {
-                    particle.velocity += glm::mix(attractor.strength >= 0 ? n : -n, glm::vec3(0.0f), distance / attractor.radius) * delta;
-                }
+    template <CPUParticleEmitter::OpacityMode Mode>
+    void CPUParticleEmitter::SpawnOpacities(const int* indices, int count, const glm::mat4&)
+    {
+        // Opacity over lifetime is set by the simulation kernel
+        if constexpr (Mode == OpacityMode::LerpOverLifetime) return;
+
+        for (int i = 0; i < count; ++i)
+        {
+            if constexpr (Mode == OpacityMode::Constant)
+            {
+                particles->colA[indices[i]] = definition->particleProperties.opacity;
+            }
+            else if constexpr (Mode == OpacityMode::RandomMinMax)
+            {
+                particles->colA[indices[i]] = rng.NextFloat(definition->particleProperties.opacityMin, definition->particleProperties.opacityMax);
             }
+        }
+    }
 
-            // Apply damping
-            if (particleProperties.damping > 0.0f)
+    template <CPUParticleEmitter::LifespanMode Mode>
+    void CPUParticleEmitter::SpawnLifespans(const int* indices, int count, const glm::mat4&)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if constexpr (Mode == LifespanMode::Constant)
             {
-                particle.velocity *= 1 - (particleProperties.damping * delta);
+                particles->invLifespan[indices[i]] = 1 / definition->particleProperties.lifespan;
+            }
+            else if constexpr (Mode == LifespanMode::RandomMinMax)
+            {
+                particles->invLifespan[indices[i]] = 1 / rng.NextFloat(definition->particleProperties.lifespanMin, definition->particleProperties.lifespanMax);
             }
         }
     }
@@ -482,12 +945,16 @@ namespace Phi
     {
         // Reset all counters and timers
         activeParticles = 0;
+        first = base;
+        oldest = 0;
+        bounds = {};
         totalElapsedTime = 0.0f;
         spawnAccumulator = 0.0f;
-        particleProperties.burstDone = false;
+        stepAccumulator = 0.0f;
+        burstDone = false;
 
         // Reset the seed
-        if (randomSeed)
+        if (definition->randomSeed)
         {
             rng.SetSeed(GLOBAL_RNG.NextInt(INT32_MIN, INT32_MAX));
         }
@@ -497,22 +964,135 @@ namespace Phi
         }
 
         // Reset to default random values for this seed
-        particleProperties.spawnRateRandom = rng.NextFloat(particleProperties.spawnRateMin, particleProperties.spawnRateMax);
-        particleProperties.burstCountRandom = rng.NextInt(particleProperties.burstCountMin, particleProperties.burstCountMax);
+        spawnRateRandom = rng.NextFloat(definition->particleProperties.spawnRateMin, definition->particleProperties.spawnRateMax);
+        burstCountRandom = rng.NextInt(definition->particleProperties.burstCountMin, definition->particleProperties.burstCountMax);
+    }
+
+    bool CPUParticleEmitter::IsFinished() const
+    {
+        if (activeParticles > 0) return false;
+
+        const bool expired = definition->duration >= 0.0f && totalElapsedTime >= definition->duration;
+        const bool burst = definition->particleProperties.spawnMode == SpawnMode::SingleBurst && burstDone;
+        return expired || burst;
     }
 
-    void CPUParticleEmitter::Render(const glm::mat4& transform)
+    void CPUParticleEmitter::SetDefinition(std::shared_ptr<const Definition> definition)
+    {
+        this->definition = std::move(definition);
+
+        // Explicit seeds restart from the definition's, random ones are drawn by Reset()
+        rng.SetSeed(this->definition->seed);
+        Reset();
+
+        // Initialize particle pool and select kernels for the definition's modes
+        ResizePool();
+        UpdateKernels();
+    }
+
+    CPUParticleEmitter::Definition& CPUParticleEmitter::EditDefinition()
+    {
+        // Copy on write, so emitters sharing the old definition aren't affected
+        // The copy takes its own texture reference, so changing its texture leaves theirs loaded
+        if (definition.use_count() > 1)
+        {
+            definition = std::make_shared<Definition>(*definition);
+            if (definition->texture) ResourceManager::Instance().LoadTexture2D(definition->texPath);
+        }
+
+        // Only ever shared as const, this emitter now holds the only reference
+        return const_cast<Definition&>(*definition);
+    }
+
+    std::vector<CPUParticleEmitter::Attractor>& CPUParticleEmitter::Attractors()
+    {
+        // Attractors can't be evaluated analytically, and the caller may be about to add one
+        // UpdateKernels() returns to analytic evaluation if the list ends up empty
+        Definition& def = EditDefinition();
+        SetAnalytic(false);
+        return def.attractors;
+    }
+
+    AABB CPUParticleEmitter::GetBounds() const
+    {
+        if (bounds.IsEmpty()) return AABB(bounds.min, bounds.max);
+        glm::vec3 min = bounds.min;
+        glm::vec3 max = bounds.max;
+
+        // Analytic emitters only bound spawn positions, so add the furthest any particle can travel
+        const auto& props = definition->particleProperties;
+        const auto& affectors = definition->affectorProperties;
+        if (kernels.analytic && affectors.addVelocity)
+        {
+            const float lifespan = props.lifespanMode == LifespanMode::Constant ? props.lifespan : std::max(props.lifespanMin, props.lifespanMax);
+            const glm::vec3 acceleration = affectors.gravityEnabled ? GRAVITATIONAL_ACCELERATION : glm::vec3(0.0f);
+            const bool constant = props.velocityMode == VelocityMode::Constant;
+            const glm::vec3 velocities[2] = {constant ? props.velocity : props.velocityMin, constant ? props.velocity : props.velocityMax};
+
+            // Displacement is linear in velocity and quadratic in time, so its extremes are at the
+            // velocity limits and at either the end of the lifespan or the turning point
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float lowest = 0.0f;
+                float highest = 0.0f;
+                const float a = acceleration[axis];
+                for (const glm::vec3& velocity : velocities)
+                {
+                    const float v = velocity[axis];
+                    const float turn = a != 0.0f ? glm::clamp(-v / a, 0.0f, lifespan) : 0.0f;
+                    for (float t : {lifespan, turn})
+                    {
+                        float d = (v + a * t * 0.5f) * t;
+                        lowest = std::min(lowest, d);
+                        highest = std::max(highest, d);
+                    }
+                }
+                min[axis] += lowest;
+                max[axis] += highest;
+            }
+        }
+
+        // Billboards extend by at most half their diagonal in any direction
+        glm::vec2 largest = glm::max(glm::max(glm::abs(props.size), glm::max(glm::abs(props.sizeMin), glm::abs(props.sizeMax))),
+                                     glm::max(glm::abs(props.startSize), glm::abs(props.endSize)));
+        glm::vec3 margin(glm::length(largest) * 0.5f);
+        return AABB(min - margin, max + margin);
+    }
+
+    void CPUParticleEmitter::Render(const glm::mat4& transform, const Frustum* frustum)
     {
         // Early out if unnecessary
         if (activeParticles < 1) return;
+
+        // Cull against the world space bounds of the particles
+        if (frustum && !bounds.IsEmpty())
+        {
+            AABB local = GetBounds();
+            AABB world(glm::vec3(INFINITY), glm::vec3(-INFINITY));
+            for (int c = 0; c < 8; ++c)
+            {
+                glm::vec3 corner(local.MinMax(c & 1).x, local.MinMax(c & 2).y, local.MinMax(c & 4).z);
+                glm::vec3 transformed = glm::vec3(transform * glm::vec4(corner, 1.0f));
+                world.min = glm::min(world.min, transformed);
+                world.max = glm::max(world.max, transformed);
+            }
+
+            if (!world.IntersectsFast(*frustum))
+            {
+                cullingStats.culledEmitters++;
+                cullingStats.culledParticles += activeParticles;
+                return;
+            }
+        }
+        cullingStats.visibleEmitters++;
         
         // Increase counter
         queuedEmitters++;
 
         // Add to correct queue
-        if (texture)
+        if (definition->texture)
         {
-            switch (blendMode)
+            switch (definition->blendMode)
             {
                 case BlendMode::None:
                     renderQueues[(int)RenderQueue::TexturedNoBlend].push_back(EmitterData(this, transform));
@@ -529,7 +1109,7 @@ namespace Phi
         }
         else
         {
-            switch (blendMode)
+            switch (definition->blendMode)
             {
                 case BlendMode::None:
                     renderQueues[(int)RenderQueue::UntexturedNoBlend].push_back(EmitterData(this, transform));
@@ -546,11 +1126,21 @@ namespace Phi
         }
     }
 
-    void CPUParticleEmitter::FlushRenderQueue()
+    void CPUParticleEmitter::FlushRenderQueue(const glm::mat4& view)
     {
+        // Reset sorting budget
+        sortedParticles = 0;
+
+        // Keep the culling counters of the frame being flushed
+        lastCullingStats = cullingStats;
+        cullingStats = {};
+
         // Don't issue a draw call if there's nothing to render
         if (queuedEmitters == 0) return;
 
+        // Ensure static resources exist
+        InitializeResources();
+
         // Iterate all queues
         for (int i = 0; i < (int)RenderQueue::COUNT; ++i)
         {
@@ -561,6 +1151,39 @@ namespace Phi
             // Early out if empty
             if (queue.size() == 0) continue;
 
+            // Standard blending needs back to front order, both between and within emitters
+            if (queueType == RenderQueue::TexturedStandardBlend || queueType == RenderQueue::UntexturedStandardBlend)
+            {
+                for (auto& emitterData : queue)
+                {
+                    auto& emitter = emitterData.emitter;
+                    glm::mat4 modelView = view * emitterData.transform;
+
+                    if (emitter->definition->depthSort && sortedParticles + emitter->activeParticles <= sortBudget)
+                    {
+                        // Analytic emitters are sorted by their evaluated positions, which start at 0
+                        const ParticleData* data = emitter->particles;
+                        int first = emitter->first;
+                        if (emitter->kernels.analytic)
+                        {
+                            emitter->Evaluate(evaluated, true);
+                            data = &evaluated;
+                            first = 0;
+                        }
+                        emitterData.depth = emitter->sorter.Sort(data->posX.data() + first, data->posY.data() + first, data->posZ.data() + first, emitter->activeParticles, modelView);
+                        emitterData.sorted = true;
+                        sortedParticles += emitter->activeParticles;
+                    }
+                    else
+                    {
+                        // Fall back to the depth of the emitter's origin
+                        emitterData.depth = -(modelView * glm::vec4(emitter->definition->offset, 1.0f)).z;
+                    }
+                }
+
+                std::stable_sort(queue.begin(), queue.end(), [](const EmitterData& a, const EmitterData& b) { return a.depth > b.depth; });
+            }
+
             // Counters
             int queueCount = 0;
 
@@ -711,19 +1334,35 @@ namespace Phi
                 // Write draw command
                 iBuffer->Write(cmd);
 
+                // Analytic emitters are evaluated at their current age first
+                const ParticleData* data = emitter->particles;
+                int first = emitter->first;
+                if (emitter->kernels.analytic)
+                {
+                    emitter->Evaluate(evaluated, false);
+                    data = &evaluated;
+                    first = 0;
+                }
+
+                // Packed positions are relative to the center of the particles, which moves into the transform
+                glm::vec3 anchor = ParticlePacking::Anchor(*data, first, emitter->activeParticles);
+                glm::mat4 anchoredTransform = transform;
+                anchoredTransform[3] = transform * glm::vec4(anchor, 1.0f);
+
                 // Write emitter data
-                eBuffer->Write(transform);
+                eBuffer->Write(anchoredTransform);
                 if (eBuffer == texturedEmitterBuffer)
                 {
                     // Write texture ID (padded to vec4 for alignment)
                     eBuffer->Write(glm::ivec4(queuedTextures.size()));
 
                     // Queue the proper texture
-                    queuedTextures.push_back(emitter->texture);
+                    queuedTextures.push_back(emitter->definition->texture);
                 }
 
-                // Write particles to proper buffer
-                pBuffer->Write(emitter->particlePool.data(), emitter->activeParticles * sizeof(Particle));
+                // Pack particles directly into the proper buffer
+                PackedParticle* pParticles = (PackedParticle*)pBuffer->Reserve(emitter->activeParticles * sizeof(PackedParticle));
+                if (pParticles) ParticlePacking::Pack(pParticles, *data, first, emitter->activeParticles, anchor, emitterData.sorted ? emitter->sorter.GetOrder() : nullptr);
 
                 // Update counters
                 queuedParticles += emitter->activeParticles;
@@ -769,6 +1408,67 @@ namespace Phi
         }
     }
 
+    void CPUParticleEmitter::SaveState(std::vector<char>& out) const
+    {
+        SavedState state{};
+        state.activeParticles = activeParticles;
+        state.oldest = oldest;
+        state.totalElapsedTime = totalElapsedTime;
+        state.spawnAccumulator = spawnAccumulator;
+        state.stepAccumulator = stepAccumulator;
+        state.spawnRateRandom = spawnRateRandom;
+        state.burstCountRandom = burstCountRandom;
+        state.burstDone = burstDone;
+        state.rngSeed = rng.GetSeed();
+        state.rngStream = rng.GetStream();
+        state.rngCounter = rng.GetCounter();
+        Serialization::Write(out, state);
+
+        // Only the active part of each stream, restored at the start of the pool
+        for (const ParticleData::Stream* stream : particles->Streams())
+        {
+            Serialization::WriteArray(out, stream->data() + first, activeParticles);
+        }
+    }
+
+    bool CPUParticleEmitter::LoadState(const char*& cursor, const char* end)
+    {
+        SavedState state;
+        if (!Serialization::Read(cursor, end, state)) return false;
+        if (state.activeParticles < 0 || state.activeParticles > definition->maxActiveParticles ||
+            state.oldest < 0 || (state.oldest >= state.activeParticles && state.oldest != 0))
+        {
+            return false;
+        }
+
+        for (ParticleData::Stream* stream : particles->Streams())
+        {
+            if (!Serialization::ReadArray(cursor, end, stream->data() + base, state.activeParticles)) return false;
+        }
+
+        activeParticles = state.activeParticles;
+        first = base;
+        oldest = state.oldest;
+        totalElapsedTime = state.totalElapsedTime;
+        spawnAccumulator = state.spawnAccumulator;
+        stepAccumulator = state.stepAccumulator;
+        spawnRateRandom = state.spawnRateRandom;
+        burstCountRandom = state.burstCountRandom;
+        burstDone = state.burstDone;
+        rng = CounterRNG(state.rngSeed, state.rngStream);
+        rng.SetCounter(state.rngCounter);
+
+        // Bounds are normally tracked by the simulation, restored particles haven't been simulated yet
+        bounds = {};
+        for (int i = first; i < first + activeParticles; ++i)
+        {
+            glm::vec3 position(particles->posX[i], particles->posY[i], particles->posZ[i]);
+            bounds.min = glm::min(bounds.min, position);
+            bounds.max = glm::max(bounds.max, position);
+        }
+        return true;
+    }
+
     bool CPUParticleEmitter::Load(const std::string& path)
     {
         // YAML parsing library throws exceptions... catch and handle
@@ -794,10 +1494,14 @@ namespace Phi
 
     bool CPUParticleEmitter::Load(const YAML::Node& node)
     {
+        // Fields missing from the node keep their current values, the texture with a reference of its own
+        Definition def = *definition;
+        if (def.texture) def.texture = ResourceManager::Instance().LoadTexture2D(def.texPath);
+
         try
         {
             // Parse fields in order
-            name = node["emitter_name"] ? node["emitter_name"].as<std::string>() : name;
+            def.name = node["emitter_name"] ? node["emitter_name"].as<std::string>() : def.name;
 
             // Seed
             if (node["seed"])
@@ -809,8 +1513,8 @@ namespace Phi
                     int seed = node["seed"].as<int>();
 
                     // These lines will only run if the conversion is successful (seed is explicit)
-                    rng.SetSeed(seed);
-                    randomSeed = false;
+                    def.seed = seed;
+                    def.randomSeed = false;
                 }
                 catch (YAML::BadConversion& e)
                 {
@@ -818,7 +1522,7 @@ namespace Phi
                     std::string v = node["seed"].as<std::string>();
                     if (v == "random")
                     {
-                        rng.SetSeed(GLOBAL_RNG.NextInt(INT32_MIN, INT32_MAX));
+                        def.randomSeed = true;
                     }
                 }
             }
@@ -827,15 +1531,19 @@ namespace Phi
             YAML::Node offsetNode = node["offset"];
             if (offsetNode)
             {
-                offset.x = offsetNode["x"] ? offsetNode["x"].as<float>() : offset.x;
-                offset.y = offsetNode["y"] ? offsetNode["y"].as<float>() : offset.y;
-                offset.z = offsetNode["z"] ? offsetNode["z"].as<float>() : offset.z;
+                def.offset.x = offsetNode["x"] ? offsetNode["x"].as<float>() : def.offset.x;
+                def.offset.y = offsetNode["y"] ? offsetNode["y"].as<float>() : def.offset.y;
+                def.offset.z = offsetNode["z"] ? offsetNode["z"].as<float>() : def.offset.z;
             }
             
             if (node["texture"])
             {
-                texPath = node["texture"].as<std::string>();
-                texture = ResourceManager::Instance().LoadTexture2D(texPath);
+                // Load before releasing the copied reference, in case it's the same texture
+                std::string texPath = node["texture"].as<std::string>();
+                Texture2D* texture = ResourceManager::Instance().LoadTexture2D(texPath);
+                if (def.texture) ResourceManager::Instance().UnloadTexture2D(def.texPath);
+                def.texPath = texPath;
+                def.texture = texture;
             }
 
             YAML::Node blendModeNode = node["blend_mode"];
@@ -844,58 +1552,59 @@ namespace Phi
                 std::string bs = blendModeNode.as<std::string>();
                 if (bs == "none")
                 {
-                    blendMode = BlendMode::None;
+                    def.blendMode = BlendMode::None;
                 }
                 else if (bs == "additive")
                 {
-                    blendMode = BlendMode::Additive;
+                    def.blendMode = BlendMode::Additive;
                 }
                 else if (bs == "standard")
                 {
-                    blendMode = BlendMode::Standard;
+                    def.blendMode = BlendMode::Standard;
                 }
             }
 
+            def.depthSort = node["depth_sort"] ? node["depth_sort"].as<bool>() : def.depthSort;
+
             YAML::Node spawnTypeNode = node["spawn_mode"];
             if (spawnTypeNode)
             {
                 std::string spawnTypeString = spawnTypeNode.as<std::string>();
                 if (spawnTypeString == "continuous")
                 {
-                    particleProperties.spawnMode = SpawnMode::Continuous;
+                    def.particleProperties.spawnMode = SpawnMode::Continuous;
                     
                 }
                 else if (spawnTypeString == "continuous_burst")
                 {
-                    particleProperties.spawnMode = SpawnMode::ContinuousBurst;
+                    def.particleProperties.spawnMode = SpawnMode::ContinuousBurst;
                 }
                 else if (spawnTypeString == "random")
                 {
-                    particleProperties.spawnMode = SpawnMode::Random;
+                    def.particleProperties.spawnMode = SpawnMode::Random;
 
                 }
                 else if (spawnTypeString == "random_burst")
                 {
-                    particleProperties.spawnMode = SpawnMode::RandomBurst;
+                    def.particleProperties.spawnMode = SpawnMode::RandomBurst;
                 }
                 else if (spawnTypeString == "single_burst")
                 {
-                    particleProperties.spawnMode = SpawnMode::SingleBurst;
+                    def.particleProperties.spawnMode = SpawnMode::SingleBurst;
                 }
             }
 
-            particleProperties.spawnRate = node["spawn_rate"] ? node["spawn_rate"].as<float>() : particleProperties.spawnRate;
-            particleProperties.spawnRateMin = node["spawn_rate_min"] ? node["spawn_rate_min"].as<float>() : particleProperties.spawnRateMin;
-            particleProperties.spawnRateMax = node["spawn_rate_max"] ? node["spawn_rate_max"].as<float>() : particleProperties.spawnRateMax;
-            particleProperties.spawnRateRandom = rng.NextFloat(particleProperties.spawnRateMin, particleProperties.spawnRateMax);
+            def.particleProperties.spawnRate = node["spawn_rate"] ? node["spawn_rate"].as<float>() : def.particleProperties.spawnRate;
+            def.particleProperties.spawnRateMin = node["spawn_rate_min"] ? node["spawn_rate_min"].as<float>() : def.particleProperties.spawnRateMin;
+            def.particleProperties.spawnRateMax = node["spawn_rate_max"] ? node["spawn_rate_max"].as<float>() : def.particleProperties.spawnRateMax;
         
-            particleProperties.burstCount = node["burst_count"] ? node["burst_count"].as<int>() : particleProperties.burstCount;
-            particleProperties.burstCountMin = node["burst_count_min"] ? node["burst_count_min"].as<int>() : particleProperties.burstCountMin;
-            particleProperties.burstCountMax = node["burst_count_max"] ? node["burst_count_max"].as<int>() : particleProperties.burstCountMax;
-            particleProperties.burstCountRandom = rng.NextInt(particleProperties.burstCountMin, particleProperties.burstCountMax);
+            def.particleProperties.burstCount = node["burst_count"] ? node["burst_count"].as<int>() : def.particleProperties.burstCount;
+            def.particleProperties.burstCountMin = node["burst_count_min"] ? node["burst_count_min"].as<int>() : def.particleProperties.burstCountMin;
+            def.particleProperties.burstCountMax = node["burst_count_max"] ? node["burst_count_max"].as<int>() : def.particleProperties.burstCountMax;
 
-            duration = node["duration"] ? node["duration"].as<float>() : duration;
-            maxActiveParticles = node["max_particles"] ? node["max_particles"].as<int>() : maxActiveParticles;
+            def.duration = node["duration"] ? node["duration"].as<float>() : def.duration;
+            def.maxActiveParticles = node["max_particles"] ? node["max_particles"].as<int>() : def.maxActiveParticles;
+            def.orderedPool = node["ordered_pool"] ? node["ordered_pool"].as<bool>() : def.orderedPool;
 
             YAML::Node props = node["particle_properties"];
             if (props)
@@ -907,28 +1616,28 @@ namespace Phi
                     std::string posType = posProps["type"].as<std::string>();
                     if (posType == "constant")
                     {
-                        particleProperties.positionMode = PositionMode::Constant;
-                        particleProperties.position.x = posProps["value"]["x"] ? posProps["value"]["x"].as<float>() : particleProperties.position.x;
-                        particleProperties.position.y = posProps["value"]["y"] ? posProps["value"]["y"].as<float>() : particleProperties.position.y;
-                        particleProperties.position.z = posProps["value"]["z"] ? posProps["value"]["z"].as<float>() : particleProperties.position.z;
+                        def.particleProperties.positionMode = PositionMode::Constant;
+                        def.particleProperties.position.x = posProps["value"]["x"] ? posProps["value"]["x"].as<float>() : def.particleProperties.position.x;
+                        def.particleProperties.position.y = posProps["value"]["y"] ? posProps["value"]["y"].as<float>() : def.particleProperties.position.y;
+                        def.particleProperties.position.z = posProps["value"]["z"] ? posProps["value"]["z"].as<float>() : def.particleProperties.position.z;
                     }
                     else if (posType == "random_min_max")
                     {
-                        particleProperties.positionMode = PositionMode::RandomMinMax;
-                        particleProperties.positionMin.x = posProps["min"]["x"] ? posProps["min"]["x"].as<float>() : particleProperties.positionMin.x;
-                        particleProperties.positionMin.y = posProps["min"]["y"] ? posProps["min"]["y"].as<float>() : particleProperties.positionMin.y;
-                        particleProperties.positionMin.z = posProps["min"]["z"] ? posProps["min"]["z"].as<float>() : particleProperties.positionMin.z;
-                        particleProperties.positionMax.x = posProps["max"]["x"] ? posProps["max"]["x"].as<float>() : particleProperties.positionMax.x;
-                        particleProperties.positionMax.y = posProps["max"]["y"] ? posProps["max"]["y"].as<float>() : particleProperties.positionMax.y;
-                        particleProperties.positionMax.z = posProps["max"]["z"] ? posProps["max"]["z"].as<float>() : particleProperties.positionMax.z;
+                        def.particleProperties.positionMode = PositionMode::RandomMinMax;
+                        def.particleProperties.positionMin.x = posProps["min"]["x"] ? posProps["min"]["x"].as<float>() : def.particleProperties.positionMin.x;
+                        def.particleProperties.positionMin.y = posProps["min"]["y"] ? posProps["min"]["y"].as<float>() : def.particleProperties.positionMin.y;
+                        def.particleProperties.positionMin.z = posProps["min"]["z"] ? posProps["min"]["z"].as<float>() : def.particleProperties.positionMin.z;
+                        def.particleProperties.positionMax.x = posProps["max"]["x"] ? posProps["max"]["x"].as<float>() : def.particleProperties.positionMax.x;
+                        def.particleProperties.positionMax.y = posProps["max"]["y"] ? posProps["max"]["y"].as<float>() : def.particleProperties.positionMax.y;
+                        def.particleProperties.positionMax.z = posProps["max"]["z"] ? posProps["max"]["z"].as<float>() : def.particleProperties.positionMax.z;
                     }
                     else if (posType == "random_sphere")
                     {
-                        particleProperties.positionMode = PositionMode::RandomSphere;
-                        particleProperties.position.x = posProps["center"]["x"] ? posProps["center"]["x"].as<float>() : particleProperties.position.x;
-                        particleProperties.position.y = posProps["center"]["y"] ? posProps["center"]["y"].as<float>() : particleProperties.position.y;
-                        particleProperties.position.z = posProps["center"]["z"] ? posProps["center"]["z"].as<float>() : particleProperties.position.z;
-                        particleProperties.spawnRadius = posProps["radius"] ? posProps["radius"].as<float>() : particleProperties.spawnRadius;
+                        def.particleProperties.positionMode = PositionMode::RandomSphere;
+                        def.particleProperties.position.x = posProps["center"]["x"] ? posProps["center"]["x"].as<float>() : def.particleProperties.position.x;
+                        def.particleProperties.position.y = posProps["center"]["y"] ? posProps["center"]["y"].as<float>() : def.particleProperties.position.y;
+                        def.particleProperties.position.z = posProps["center"]["z"] ? posProps["center"]["z"].as<float>() : def.particleProperties.position.z;
+                        def.particleProperties.spawnRadius = posProps["radius"] ? posProps["radius"].as<float>() : def.particleProperties.spawnRadius;
                     }
                 }
 
@@ -939,24 +1648,24 @@ namespace Phi
                     std::string velType = velProps["type"].as<std::string>();
                     if (velType == "constant")
                     {
-                        particleProperties.velocityMode = VelocityMode::Constant;
-                        particleProperties.velocity.x = velProps["value"]["x"] ? velProps["value"]["x"].as<float>() : particleProperties.velocity.x;
-                        particleProperties.velocity.y = velProps["value"]["y"] ? velProps["value"]["y"].as<float>() : particleProperties.velocity.y;
-                        particleProperties.velocity.z = velProps["value"]["z"] ? velProps["value"]["z"].as<float>() : particleProperties.velocity.z;
+                        def.particleProperties.velocityMode = VelocityMode::Constant;
+                        def.particleProperties.velocity.x = velProps["value"]["x"] ? velProps["value"]["x"].as<float>() : def.particleProperties.velocity.x;
+                        def.particleProperties.velocity.y = velProps["value"]["y"] ? velProps["value"]["y"].as<float>() : def.particleProperties.velocity.y;
+                        def.particleProperties.velocity.z = velProps["value"]["z"] ? velProps["value"]["z"].as<float>() : def.particleProperties.velocity.z;
                     }
                     else if (velType == "random_min_max")
                     {
-                        particleProperties.velocityMode = VelocityMode::RandomMinMax;
-                        particleProperties.velocityMin.x = velProps["min"]["x"] ? velProps["min"]["x"].as<float>() : particleProperties.velocityMin.x;
-                        particleProperties.velocityMin.y = velProps["min"]["y"] ? velProps["min"]["y"].as<float>() : particleProperties.velocityMin.y;
-                        particleProperties.velocityMin.z = velProps["min"]["z"] ? velProps["min"]["z"].as<float>() : particleProperties.velocityMin.z;
-                        particleProperties.velocityMax.x = velProps["max"]["x"] ? velProps["max"]["x"].as<float>() : particleProperties.velocityMax.x;
-                        particleProperties.velocityMax.y = velProps["max"]["y"] ? velProps["max"]["y"].as<float>() : particleProperties.velocityMax.y;
-                        particleProperties.velocityMax.z = velProps["max"]["z"] ? velProps["max"]["z"].as<float>() : particleProperties.velocityMax.z;
+                        def.particleProperties.velocityMode = VelocityMode::RandomMinMax;
+                        def.particleProperties.velocityMin.x = velProps["min"]["x"] ? velProps["min"]["x"].as<float>() : def.particleProperties.velocityMin.x;
+                        def.particleProperties.velocityMin.y = velProps["min"]["y"] ? velProps["min"]["y"].as<float>() : def.particleProperties.velocityMin.y;
+                        def.particleProperties.velocityMin.z = velProps["min"]["z"] ? velProps["min"]["z"].as<float>() : def.particleProperties.velocityMin.z;
+                        def.particleProperties.velocityMax.x = velProps["max"]["x"] ? velProps["max"]["x"].as<float>() : def.particleProperties.velocityMax.x;
+                        def.particleProperties.velocityMax.y = velProps["max"]["y"] ? velProps["max"]["y"].as<float>() : def.particleProperties.velocityMax.y;
+                        def.particleProperties.velocityMax.z = velProps["max"]["z"] ? velProps["max"]["z"].as<float>() : def.particleProperties.velocityMax.z;
                     }
 
                     // Parse damping
-                    particleProperties.damping = velProps["damping"] ? velProps["damping"].as<float>() : particleProperties.damping;
+                    def.particleProperties.damping = velProps["damping"] ? velProps["damping"].as<float>() : def.particleProperties.damping;
                 }
 
                 // Color
@@ -967,70 +1676,70 @@ namespace Phi
                     if (colType == "constant")
                     {
                         // Set the type
-                        particleProperties.colorMode = ColorMode::Constant;
+                        def.particleProperties.colorMode = ColorMode::Constant;
 
                         // Load the value
                         if (colorProps["value"])
                         {
-                            particleProperties.color.r = colorProps["value"]["r"] ? colorProps["value"]["r"].as<float>() : particleProperties.color.r;
-                            particleProperties.color.g = colorProps["value"]["g"] ? colorProps["value"]["g"].as<float>() : particleProperties.color.g;
-                            particleProperties.color.b = colorProps["value"]["b"] ? colorProps["value"]["b"].as<float>() : particleProperties.color.b;
+                            def.particleProperties.color.r = colorProps["value"]["r"] ? colorProps["value"]["r"].as<float>() : def.particleProperties.color.r;
+                            def.particleProperties.color.g = colorProps["value"]["g"] ? colorProps["value"]["g"].as<float>() : def.particleProperties.color.g;
+                            def.particleProperties.color.b = colorProps["value"]["b"] ? colorProps["value"]["b"].as<float>() : def.particleProperties.color.b;
                         }
                     }
                     else if (colType == "random_min_max")
                     {
                         // Set the type
-                        particleProperties.colorMode = ColorMode::RandomMinMax;
+                        def.particleProperties.colorMode = ColorMode::RandomMinMax;
 
                         // Load min and max
                         if (colorProps["min"])
                         {
-                            particleProperties.colorMin.r = colorProps["min"]["r"] ? colorProps["min"]["r"].as<float>() : particleProperties.colorMin.r;
-                            particleProperties.colorMin.g = colorProps["min"]["g"] ? colorProps["min"]["g"].as<float>() : particleProperties.colorMin.g;
-                            particleProperties.colorMin.b = colorProps["min"]["b"] ? colorProps["min"]["b"].as<float>() : particleProperties.colorMin.b;
+                            def.particleProperties.colorMin.r = colorProps["min"]["r"] ? colorProps["min"]["r"].as<float>() : def.particleProperties.colorMin.r;
+                            def.particleProperties.colorMin.g = colorProps["min"]["g"] ? colorProps["min"]["g"].as<float>() : def.particleProperties.colorMin.g;
+                            def.particleProperties.colorMin.b = colorProps["min"]["b"] ? colorProps["min"]["b"].as<float>() : def.particleProperties.colorMin.b;
                         }
                         if (colorProps["max"])
                         {
-                            particleProperties.colorMax.r = colorProps["max"]["r"] ? colorProps["max"]["r"].as<float>() : particleProperties.colorMax.r;
-                            particleProperties.colorMax.g = colorProps["max"]["g"] ? colorProps["max"]["g"].as<float>() : particleProperties.colorMax.g;
-                            particleProperties.colorMax.b = colorProps["max"]["b"] ? colorProps["max"]["b"].as<float>() : particleProperties.colorMax.b;
+                            def.particleProperties.colorMax.r = colorProps["max"]["r"] ? colorProps["max"]["r"].as<float>() : def.particleProperties.colorMax.r;
+                            def.particleProperties.colorMax.g = colorProps["max"]["g"] ? colorProps["max"]["g"].as<float>() : def.particleProperties.colorMax.g;
+                            def.particleProperties.colorMax.b = colorProps["max"]["b"] ? colorProps["max"]["b"].as<float>() : def.particleProperties.colorMax.b;
                         }
                     }
                     else if (colType == "random_lerp")
                     {
                         // Set the type
-                        particleProperties.colorMode = ColorMode::RandomLerp;
+                        def.particleProperties.colorMode = ColorMode::RandomLerp;
 
                         // Load colors A and B
                         if (colorProps["color_a"])
                         {
-                            particleProperties.colorA.r = colorProps["color_a"]["r"] ? colorProps["color_a"]["r"].as<float>() : particleProperties.colorA.r;
-                            particleProperties.colorA.g = colorProps["color_a"]["g"] ? colorProps["color_a"]["g"].as<float>() : particleProperties.colorA.g;
-                            particleProperties.colorA.b = colorProps["color_a"]["b"] ? colorProps["color_a"]["b"].as<float>() : particleProperties.colorA.b;
+                            def.particleProperties.colorA.r = colorProps["color_a"]["r"] ? colorProps["color_a"]["r"].as<float>() : def.particleProperties.colorA.r;
+                            def.particleProperties.colorA.g = colorProps["color_a"]["g"] ? colorProps["color_a"]["g"].as<float>() : def.particleProperties.colorA.g;
+                            def.particleProperties.colorA.b = colorProps["color_a"]["b"] ? colorProps["color_a"]["b"].as<float>() : def.particleProperties.colorA.b;
                         }
                         if (colorProps["color_b"])
                         {
-                            particleProperties.colorB.r = colorProps["color_b"]["r"] ? colorProps["color_b"]["r"].as<float>() : particleProperties.colorB.r;
-                            particleProperties.colorB.g = colorProps["color_b"]["g"] ? colorProps["color_b"]["g"].as<float>() : particleProperties.colorB.g;
-                            particleProperties.colorB.b = colorProps["color_b"]["b"] ? colorProps["color_b"]["b"].as<float>() : particleProperties.colorB.b;
+                            def.particleProperties.colorB.r = colorProps["color_b"]["r"] ? colorProps["color_b"]["r"].as<float>() : def.particleProperties.colorB.r;
+                            def.particleProperties.colorB.g = colorProps["color_b"]["g"] ? colorProps["color_b"]["g"].as<float>() : def.particleProperties.colorB.g;
+                            def.particleProperties.colorB.b = colorProps["color_b"]["b"] ? colorProps["color_b"]["b"].as<float>() : def.particleProperties.colorB.b;
                         }
                     }
                     else if (colType == "lerp_over_lifetime")
                     {
-                        particleProperties.colorMode = ColorMode::LerpOverLifetime;
+                        def.particleProperties.colorMode = ColorMode::LerpOverLifetime;
 
                         // Load start and end colors
                         if (colorProps["start_color"])
                         {
-                            particleProperties.startColor.r = colorProps["start_color"]["r"] ? colorProps["start_color"]["r"].as<float>() : particleProperties.startColor.r;
-                            particleProperties.startColor.g = colorProps["start_color"]["g"] ? colorProps["start_color"]["g"].as<float>() : particleProperties.startColor.g;
-                            particleProperties.startColor.b = colorProps["start_color"]["b"] ? colorProps["start_color"]["b"].as<float>() : particleProperties.startColor.b;
+                            def.particleProperties.startColor.r = colorProps["start_color"]["r"] ? colorProps["start_color"]["r"].as<float>() : def.particleProperties.startColor.r;
+                            def.particleProperties.startColor.g = colorProps["start_color"]["g"] ? colorProps["start_color"]["g"].as<float>() : def.particleProperties.startColor.g;
+                            def.particleProperties.startColor.b = colorProps["start_color"]["b"] ? colorProps["start_color"]["b"].as<float>() : def.particleProperties.startColor.b;
                         }
                         if (colorProps["end_color"])
                         {
-                            particleProperties.endColor.r = colorProps["end_color"]["r"] ? colorProps["end_color"]["r"].as<float>() : particleProperties.endColor.r;
-                            particleProperties.endColor.g = colorProps["end_color"]["g"] ? colorProps["end_color"]["g"].as<float>() : particleProperties.endColor.g;
-                            particleProperties.endColor.b = colorProps["end_color"]["b"] ? colorProps["end_color"]["b"].as<float>() : particleProperties.endColor.b;
+                            def.particleProperties.endColor.r = colorProps["end_color"]["r"] ? colorProps["end_color"]["r"].as<float>() : def.particleProperties.endColor.r;
+                            def.particleProperties.endColor.g = colorProps["end_color"]["g"] ? colorProps["end_color"]["g"].as<float>() : def.particleProperties.endColor.g;
+                            def.particleProperties.endColor.b = colorProps["end_color"]["b"] ? colorProps["end_color"]["b"].as<float>() : def.particleProperties.endColor.b;
                         }
                     }
                 }
@@ -1042,33 +1751,33 @@ namespace Phi
                     std::string sizeType = sizeProps["type"].as<std::string>();
                     if (sizeType == "constant")
                     {
-                        particleProperties.sizeMode = SizeMode::Constant;
-                        particleProperties.size.x = sizeProps["value"]["x"] ? sizeProps["value"]["x"].as<float>() : particleProperties.size.x;
-                        particleProperties.size.y = sizeProps["value"]["y"] ? sizeProps["value"]["y"].as<float>() : particleProperties.size.y;
+                        def.particleProperties.sizeMode = SizeMode::Constant;
+                        def.particleProperties.size.x = sizeProps["value"]["x"] ? sizeProps["value"]["x"].as<float>() : def.particleProperties.size.x;
+                        def.particleProperties.size.y = sizeProps["value"]["y"] ? sizeProps["value"]["y"].as<float>() : def.particleProperties.size.y;
                     }
                     else if (sizeType == "random_min_max")
                     {
-                        particleProperties.sizeMode = SizeMode::RandomMinMax;
-                        particleProperties.sizeMin.x = sizeProps["min"]["x"] ? sizeProps["min"]["x"].as<float>() : particleProperties.sizeMin.x;
-                        particleProperties.sizeMin.y = sizeProps["min"]["y"] ? sizeProps["min"]["y"].as<float>() : particleProperties.sizeMin.y;
-                        particleProperties.sizeMax.x = sizeProps["max"]["x"] ? sizeProps["max"]["x"].as<float>() : particleProperties.sizeMax.x;
-                        particleProperties.sizeMax.y = sizeProps["max"]["y"] ? sizeProps["max"]["y"].as<float>() : particleProperties.sizeMax.y;
+                        def.particleProperties.sizeMode = SizeMode::RandomMinMax;
+                        def.particleProperties.sizeMin.x = sizeProps["min"]["x"] ? sizeProps["min"]["x"].as<float>() : def.particleProperties.sizeMin.x;
+                        def.particleProperties.sizeMin.y = sizeProps["min"]["y"] ? sizeProps["min"]["y"].as<float>() : def.particleProperties.sizeMin.y;
+                        def.particleProperties.sizeMax.x = sizeProps["max"]["x"] ? sizeProps["max"]["x"].as<float>() : def.particleProperties.sizeMax.x;
+                        def.particleProperties.sizeMax.y = sizeProps["max"]["y"] ? sizeProps["max"]["y"].as<float>() : def.particleProperties.sizeMax.y;
                     }
                     else if (sizeType == "random_lerp")
                     {
-                        particleProperties.sizeMode = SizeMode::RandomLerp;
-                        particleProperties.sizeMin.x = sizeProps["min"]["x"] ? sizeProps["min"]["x"].as<float>() : particleProperties.sizeMin.x;
-                        particleProperties.sizeMin.y = sizeProps["min"]["y"] ? sizeProps["min"]["y"].as<float>() : particleProperties.sizeMin.y;
-                        particleProperties.sizeMax.x = sizeProps["max"]["x"] ? sizeProps["max"]["x"].as<float>() : particleProperties.sizeMax.x;
-                        particleProperties.sizeMax.y = sizeProps["max"]["y"] ? sizeProps["max"]["y"].as<float>() : particleProperties.sizeMax.y;
+                        def.particleProperties.sizeMode = SizeMode::RandomLerp;
+                        def.particleProperties.sizeMin.x = sizeProps["min"]["x"] ? sizeProps["min"]["x"].as<float>() : def.particleProperties.sizeMin.x;
+                        def.particleProperties.sizeMin.y = sizeProps["min"]["y"] ? sizeProps["min"]["y"].as<float>() : def.particleProperties.sizeMin.y;
+                        def.particleProperties.sizeMax.x = sizeProps["max"]["x"] ? sizeProps["max"]["x"].as<float>() : def.particleProperties.sizeMax.x;
+                        def.particleProperties.sizeMax.y = sizeProps["max"]["y"] ? sizeProps["max"]["y"].as<float>() : def.particleProperties.sizeMax.y;
                     }
                     else if (sizeType == "lerp_over_lifetime")
                     {
-                        particleProperties.sizeMode = SizeMode::LerpOverLifetime;
-                        particleProperties.startSize.x = sizeProps["start_size"]["x"] ? sizeProps["start_size"]["x"].as<float>() : particleProperties.startSize.x;
-                        particleProperties.startSize.y = sizeProps["start_size"]["y"] ? sizeProps["start_size"]["y"].as<float>() : particleProperties.startSize.y;
-                        particleProperties.endSize.x = sizeProps["end_size"]["x"] ? sizeProps["end_size"]["x"].as<float>() : particleProperties.endSize.x;
-                        particleProperties.endSize.y = sizeProps["end_size"]["y"] ? sizeProps["end_size"]["y"].as<float>() : particleProperties.endSize.y;
+                        def.particleProperties.sizeMode = SizeMode::LerpOverLifetime;
+                        def.particleProperties.startSize.x = sizeProps["start_size"]["x"] ? sizeProps["start_size"]["x"].as<float>() : def.particleProperties.startSize.x;
+                        def.particleProperties.startSize.y = sizeProps["start_size"]["y"] ? sizeProps["start_size"]["y"].as<float>() : def.particleProperties.startSize.y;
+                        def.particleProperties.endSize.x = sizeProps["end_size"]["x"] ? sizeProps["end_size"]["x"].as<float>() : def.particleProperties.endSize.x;
+                        def.particleProperties.endSize.y = sizeProps["end_size"]["y"] ? sizeProps["end_size"]["y"].as<float>() : def.particleProperties.endSize.y;
                     }
                 }
 
@@ -1079,20 +1788,20 @@ namespace Phi
                     std::string opacityType = opacityProps["type"].as<std::string>();
                     if (opacityType == "constant")
                     {
-                        particleProperties.opacityMode = OpacityMode::Constant;
-                        particleProperties.opacity = opacityProps["value"] ? opacityProps["value"].as<float>() : particleProperties.opacity;
+                        def.particleProperties.opacityMode = OpacityMode::Constant;
+                        def.particleProperties.opacity = opacityProps["value"] ? opacityProps["value"].as<float>() : def.particleProperties.opacity;
                     }
                     else if (opacityType == "random_min_max")
                     {
-                        particleProperties.opacityMode = OpacityMode::RandomMinMax;
-                        particleProperties.opacityMin = opacityProps["min"] ? opacityProps["min"].as<float>() : particleProperties.opacityMin;
-                        particleProperties.opacityMax = opacityProps["max"] ? opacityProps["max"].as<float>() : particleProperties.opacityMax;
+                        def.particleProperties.opacityMode = OpacityMode::RandomMinMax;
+                        def.particleProperties.opacityMin = opacityProps["min"] ? opacityProps["min"].as<float>() : def.particleProperties.opacityMin;
+                        def.particleProperties.opacityMax = opacityProps["max"] ? opacityProps["max"].as<float>() : def.particleProperties.opacityMax;
                     }
                     else if (opacityType == "lerp_over_lifetime")
                     {
-                        particleProperties.opacityMode = OpacityMode::LerpOverLifetime;
-                        particleProperties.startOpacity = opacityProps["start_opacity"] ? opacityProps["start_opacity"].as<float>() : particleProperties.startOpacity;
-                        particleProperties.endOpacity = opacityProps["end_opacity"] ? opacityProps["end_opacity"].as<float>() : particleProperties.endOpacity;
+                        def.particleProperties.opacityMode = OpacityMode::LerpOverLifetime;
+                        def.particleProperties.startOpacity = opacityProps["start_opacity"] ? opacityProps["start_opacity"].as<float>() : def.particleProperties.startOpacity;
+                        def.particleProperties.endOpacity = opacityProps["end_opacity"] ? opacityProps["end_opacity"].as<float>() : def.particleProperties.endOpacity;
                     }
                 }
 
@@ -1103,14 +1812,14 @@ namespace Phi
                     std::string lst = lifespanProps["type"].as<std::string>();
                     if (lst == "constant")
                     {
-                        particleProperties.lifespanMode = LifespanMode::Constant;
-                        particleProperties.lifespan = lifespanProps["value"] ? lifespanProps["value"].as<float>() : particleProperties.lifespan;
+                        def.particleProperties.lifespanMode = LifespanMode::Constant;
+                        def.particleProperties.lifespan = lifespanProps["value"] ? lifespanProps["value"].as<float>() : def.particleProperties.lifespan;
                     }
                     else if (lst == "random_min_max")
                     {
-                        particleProperties.lifespanMode = LifespanMode::RandomMinMax;
-                        particleProperties.lifespanMin = lifespanProps["min"] ? lifespanProps["min"].as<float>() : particleProperties.lifespanMin;
-                        particleProperties.lifespanMax = lifespanProps["max"] ? lifespanProps["max"].as<float>() : particleProperties.lifespanMax;
+                        def.particleProperties.lifespanMode = LifespanMode::RandomMinMax;
+                        def.particleProperties.lifespanMin = lifespanProps["min"] ? lifespanProps["min"].as<float>() : def.particleProperties.lifespanMin;
+                        def.particleProperties.lifespanMax = lifespanProps["max"] ? lifespanProps["max"].as<float>() : def.particleProperties.lifespanMax;
                     }
                 }
             }
@@ -1120,8 +1829,55 @@ namespace Phi
             if (affectors)
             {
                 // Simple affectors
-                affectorProperties.gravityEnabled = affectors["gravity"] ? affectors["gravity"].as<bool>() : affectorProperties.gravityEnabled;
-                affectorProperties.addVelocity = affectors["add_velocity"] ? affectors["add_velocity"].as<bool>() : affectorProperties.addVelocity;
+                def.affectorProperties.gravityEnabled = affectors["gravity"] ? affectors["gravity"].as<bool>() : def.affectorProperties.gravityEnabled;
+                def.affectorProperties.addVelocity = affectors["add_velocity"] ? affectors["add_velocity"].as<bool>() : def.affectorProperties.addVelocity;
+                def.affectorProperties.bakeAttractors = affectors["bake_attractors"] ? affectors["bake_attractors"].as<bool>() : def.affectorProperties.bakeAttractors;
+                def.affectorProperties.attractorFieldResolution = affectors["attractor_field_resolution"] ? affectors["attractor_field_resolution"].as<int>() : def.affectorProperties.attractorFieldResolution;
+
+                // Collision
+                YAML::Node collisionNode = affectors["collision"];
+                if (collisionNode)
+                {
+                    std::string cs = collisionNode.as<std::string>();
+                    def.affectorProperties.collisionEnabled = true;
+                    if (cs == "kill")
+                    {
+                        def.affectorProperties.collisionResponse = ParticleCollider::Response::Kill;
+                    }
+                    else if (cs == "bounce")
+                    {
+                        def.affectorProperties.collisionResponse = ParticleCollider::Response::Bounce;
+                    }
+                    else if (cs == "stick")
+                    {
+                        def.affectorProperties.collisionResponse = ParticleCollider::Response::Stick;
+                    }
+                    else
+                    {
+                        def.affectorProperties.collisionEnabled = false;
+                    }
+                }
+                def.affectorProperties.restitution = affectors["restitution"] ? affectors["restitution"].as<float>() : def.affectorProperties.restitution;
+
+                // Turbulence
+                def.affectorProperties.turbulenceEnabled = affectors["turbulence"] ? affectors["turbulence"].as<bool>() : def.affectorProperties.turbulenceEnabled;
+                def.affectorProperties.turbulenceFrequency = affectors["turbulence_frequency"] ? affectors["turbulence_frequency"].as<float>() : def.affectorProperties.turbulenceFrequency;
+                def.affectorProperties.turbulenceStrength = affectors["turbulence_strength"] ? affectors["turbulence_strength"].as<float>() : def.affectorProperties.turbulenceStrength;
+                YAML::Node scrollNode = affectors["turbulence_scroll"];
+                if (scrollNode)
+                {
+                    def.affectorProperties.turbulenceScroll.x = scrollNode["x"] ? scrollNode["x"].as<float>() : def.affectorProperties.turbulenceScroll.x;
+                    def.affectorProperties.turbulenceScroll.y = scrollNode["y"] ? scrollNode["y"].as<float>() : def.affectorProperties.turbulenceScroll.y;
+                    def.affectorProperties.turbulenceScroll.z = scrollNode["z"] ? scrollNode["z"].as<float>() : def.affectorProperties.turbulenceScroll.z;
+                }
+
+                // Flocking
+                def.affectorProperties.flockingEnabled = affectors["flocking"] ? affectors["flocking"].as<bool>() : def.affectorProperties.flockingEnabled;
+                def.affectorProperties.flockingRadius = affectors["flocking_radius"] ? affectors["flocking_radius"].as<float>() : def.affectorProperties.flockingRadius;
+                def.affectorProperties.separation = affectors["separation"] ? affectors["separation"].as<float>() : def.affectorProperties.separation;
+                def.affectorProperties.cohesion = affectors["cohesion"] ? affectors["cohesion"].as<float>() : def.affectorProperties.cohesion;
+                def.affectorProperties.alignment = affectors["alignment"] ? affectors["alignment"].as<float>() : def.affectorProperties.alignment;
+                def.affectorProperties.maxNeighbours = affectors["max_neighbours"] ? affectors["max_neighbours"].as<int>() : def.affectorProperties.maxNeighbours;
             }
 
             // Load attractors
@@ -1142,12 +1898,12 @@ namespace Phi
                     a.relativeToTransform = attractorNode["relative"] ? attractorNode["relative"].as<bool>() : a.relativeToTransform;
 
                     // Add to our list
-                    attractors.push_back(a);
+                    def.attractors.push_back(a);
                 }
             }
 
-            // Initialize particle pool
-            particlePool.resize(maxActiveParticles);
+            // Seed, initialize particle pool and select kernels for the loaded modes
+            SetDefinition(std::make_shared<Definition>(std::move(def)));
             return true;
         }
         
@@ -1156,6 +1912,7 @@ namespace Phi
         {
             Error("YAML parser exception: ", e.msg);
             Reset();
+            UpdateKernels();
             return false;
         }
     }
@@ -1165,19 +1922,23 @@ namespace Phi
         Texture2D* newTex = ResourceManager::Instance().LoadTexture2D(path);
         if (newTex)
         {
-            if (texture) ResourceManager::Instance().UnloadTexture2D(texPath);
-            texPath = path;
-            texture = newTex;
+            // Only releases this emitter's own reference, see EditDefinition()
+            Definition& def = EditDefinition();
+            if (def.texture) ResourceManager::Instance().UnloadTexture2D(def.texPath);
+            def.texPath = path;
+            def.texture = newTex;
         }
     }
 
     void CPUParticleEmitter::RemoveTexture()
     {
-        if (texture)
+        if (definition->texture)
         {
-            ResourceManager::Instance().UnloadTexture2D(texPath);
-            texture = nullptr;
-            texPath = "";
+            // Only releases this emitter's own reference, see EditDefinition()
+            Definition& def = EditDefinition();
+            ResourceManager::Instance().UnloadTexture2D(def.texPath);
+            def.texture = nullptr;
+            def.texPath = "";
         }
     }
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -11,12 +13,22 @@
 
 #include <phi/core/math/noise.hpp>
 #include <phi/core/math/rng.hpp>
+#include <phi/core/math/shapes.hpp>
 #include <phi/core/resource_manager.hpp>
 #include <phi/graphics/texture_2d.hpp>
 #include <phi/graphics/gpu_buffer.hpp>
 #include <phi/graphics/shader.hpp>
 #include <phi/graphics/indirect.hpp>
 #include <phi/graphics/vertex_attributes.hpp>
+#include <phi/scene/components/particles/attractor_field.hpp>
+#include <phi/scene/components/particles/particle_arena.hpp>
+#include <phi/scene/components/particles/particle_collider.hpp>
+#include <phi/scene/components/particles/particle_data.hpp>
+#include <phi/scene/components/particles/particle_flock.hpp>
+#include <phi/scene/components/particles/particle_kernels.hpp>
+#include <phi/scene/components/particles/particle_packing.hpp>
+#include <phi/scene/components/particles/particle_sorter.hpp>
+#include <phi/scene/components/particles/turbulence_field.hpp>
 
 // Forward declaration for editor access
 class ParticleEffectEditor;
@@ -92,37 +104,19 @@ namespace Phi
             RandomMinMax
         };
 
-        // TODO: Benchmark against separating particle vertex data
-        // Potentially saving PCIe bandwidth (and VRAM usage) at the
-        // cost of (some) cache efficiency when iterating particles
-        
-        // Particle data structure
-        struct Particle
-        {
-            glm::vec3 position;
-            glm::vec3 velocity;
-            glm::vec4 color;
-            glm::vec2 size;
-            float ageNormalized;
-            float lifespanNormalized;
-        };
-
         // Particle properties structure
         struct ParticleProperties
         {
             // Spawning mode and rates
             SpawnMode spawnMode{SpawnMode::Continuous};
             float spawnRate = 5.0f;
-            float spawnRateRandom = 5.0f;
             float spawnRateMin = 1.0f;
             float spawnRateMax = 10.0f;
 
             // Burst amounts
             int burstCount = 5;
-            int burstCountRandom = 5;
             int burstCountMin = 1;
             int burstCountMax = 10;
-            bool burstDone = false;
             
             // Position
             PositionMode positionMode{PositionMode::RandomSphere};
@@ -177,6 +171,32 @@ namespace Phi
             // Simple affectors
             bool addVelocity = true;
             bool gravityEnabled = false;
+
+            // Bakes all attractors into a field sampled once per particle (see AttractorField)
+            // Much faster with many attractors, but approximate near their centers
+            bool bakeAttractors = false;
+            int attractorFieldResolution = 32;
+
+            // Collides particles with voxel objects and voxel map chunks (see ParticleCollider)
+            bool collisionEnabled = false;
+            ParticleCollider::Response collisionResponse{ParticleCollider::Response::Kill};
+            float restitution = 0.5f;
+
+            // Pushes particles along a swirling, divergence-free noise flow (see TurbulenceField)
+            // The flow pattern moves through the particles at the scroll velocity
+            bool turbulenceEnabled = false;
+            float turbulenceFrequency = 0.25f;
+            float turbulenceStrength = 4.0f;
+            glm::vec3 turbulenceScroll{0.0f, 0.5f, 0.0f};
+
+            // Steers particles apart, together and along with their neighbours within a radius (see ParticleFlock)
+            // Weights are accelerations, and each particle considers at most maxNeighbours neighbours
+            bool flockingEnabled = false;
+            float flockingRadius = 0.5f;
+            float separation = 4.0f;
+            float cohesion = 1.0f;
+            float alignment = 1.0f;
+            int maxNeighbours = 16;
         };
 
         // Attractor structure
@@ -196,6 +216,34 @@ namespace Phi
             bool relativeToTransform = false;
         };
 
+        // Everything that describes an emitter, as opposed to the state of one instance of it
+        // Instances loaded from the same effect share one definition (see CPUParticleEffect), which
+        // is never modified while shared. Use EditDefinition() to get a private copy to change
+        struct Definition
+        {
+            // Emitter properties
+            std::string name{"New Emitter"};
+            glm::vec3 offset{0.0f};
+            float duration = -1.0f;
+            int maxActiveParticles = 128;
+            bool randomSeed = true;
+            uint32_t seed = 4545;
+            bool orderedPool = false;
+
+            // Rendering properties
+            BlendMode blendMode{BlendMode::Additive};
+            bool depthSort = false;
+            Texture2D* texture = nullptr; // Every definition holds its own ResourceManager reference
+            std::string texPath{""};
+
+            // Particle properties and affectors
+            ParticleProperties particleProperties{};
+            AffectorProperties affectorProperties{};
+
+            // Attractors
+            std::vector<Attractor> attractors;
+        };
+
         // Interface
         public:
 
@@ -209,6 +257,9 @@ namespace Phi
             // Loads an emitter from a YAML node containing the emitter data
             CPUParticleEmitter(const YAML::Node& node);
 
+            // Creates a new instance of an existing definition, without copying or parsing anything
+            CPUParticleEmitter(std::shared_ptr<const Definition> definition);
+
             ~CPUParticleEmitter();
 
             // Delete copy constructor/assignment
@@ -224,23 +275,81 @@ namespace Phi
             // Simulation
 
             // Simulates all active particles
-            void Update(float delta, bool updateSpawns = true, bool spawnRelative = false, const glm::mat4& transform = glm::mat4(1.0f));
+            // Particles are collided with the given collider's volumes if collision is enabled
+            // With a fixed timestep, delta is accumulated and simulated in whole steps
+            void Update(float delta, bool updateSpawns = true, bool spawnRelative = false, const glm::mat4& transform = glm::mat4(1.0f),
+                        const ParticleCollider* collider = nullptr);
+
+            // Simulates in steps of exactly the given length, 0 uses the delta of each update instead
+            // At most maxSubsteps steps are taken per update, any remaining time is dropped
+            // Fixed steps make the simulation independent of frame timing, so that given the same state
+            // (see SaveState()) and the same sequence of updates, results are bit-exact on every run
+            void SetFixedTimestep(float step, int maxSubsteps = 8);
 
             // Removes all active particles and resets counters
             void Reset();
 
+            // Returns true once the emitter can't spawn any more particles and all of its particles have died
+            bool IsFinished() const;
+
+            // Selects the kernels specialized for the current particle and affector modes
+            // Called automatically on construction and Load(), must be called manually
+            // after changing modes or toggling affectors by any other means
+            void UpdateKernels();
+
+            // Returns true if the emitter is evaluated analytically
+            //
+            // Without attractors, damping, turbulence, flocking or collision, a particle's position is a closed form
+            // function of its spawn position, velocity and age, and colors and sizes over lifetime only
+            // depend on age. Such emitters are selected automatically by UpdateKernels(), keep only the
+            // spawn state of each particle, and evaluate positions, colors and sizes when they are drawn,
+            // so updates only spawn, age and despawn particles. Positions are exact rather than integrated,
+            // so they differ slightly from the same emitter simulated step by step
+            bool IsAnalytic() const { return kernels.analytic; }
+
             // Rendering
 
             // Adds the emitter's active particles to the render queue
             // Drawn particles won't be displayed to the screen until 
             // the next call to CPUParticleEmitter::FlushRenderQueue()
-            void Render(const glm::mat4& transform);
+            // If a world space frustum is given, emitters whose bounds lie outside of it are culled instead
+            void Render(const glm::mat4& transform, const Frustum* frustum = nullptr);
 
             // Flushes internal render queues and displays all particles
-            static void FlushRenderQueue();
+            // Standard blended emitters are drawn back to front as seen through the given view matrix
+            static void FlushRenderQueue(const glm::mat4& view);
+
+            // Sets the maximum number of particles depth sorted per flush
+            // Once exceeded, the remaining emitters are drawn in pool order
+            static void SetSortBudget(int particles) { sortBudget = particles; }
+
+            // Returns the number of particles depth sorted during the last flush
+            static int GetSortedParticles() { return sortedParticles; }
+
+            // Emitters queued and culled by Render() calls
+            struct CullingStats
+            {
+                int visibleEmitters = 0;
+                int culledEmitters = 0;
+                int culledParticles = 0;
+            };
+
+            // Returns the culling counters of the Render() calls before the last flush
+            static const CullingStats& GetCullingStats() { return lastCullingStats; }
+
+            // Returns the arena the particles of every emitter are allocated from
+            // Scene::Update() compacts it once all emitters have been updated
+            static ParticleArena& GetArena() { return arena; }
 
             // Serialization
 
+            // Appends the complete simulation state (active particles, counters and RNG state) in a compact binary form
+            // The state can only be restored into an emitter with the same properties, built by the same binary
+            void SaveState(std::vector<char>& out) const;
+
+            // Restores a state written by SaveState() and advances the cursor, returns false if it is invalid
+            bool LoadState(const char*& cursor, const char* end);
+
             // Loads the emitter data from a YAML file
             // Accepts local paths like data:// and user://
             bool Load(const std::string& path);
@@ -250,8 +359,15 @@ namespace Phi
 
             // Mutators / Accessors
 
+            // Returns the definition this emitter is an instance of
+            const std::shared_ptr<const Definition>& GetDefinition() const { return definition; }
+
+            // Returns the definition for modification, copying it first if other emitters share it
+            // Call UpdateKernels() after changing modes or affectors
+            Definition& EditDefinition();
+
             // Sets this emitter's offset
-            void SetOffset(const glm::vec3& offset) { this->offset = offset; }
+            void SetOffset(const glm::vec3& offset) { EditDefinition().offset = offset; }
 
             // Sets this emitter's texture
             // Accepts local paths like data:// and user://
@@ -261,10 +377,34 @@ namespace Phi
             void RemoveTexture();
 
             // Gets this emitter's texture, or nullptr if empty
-            Texture2D* GetTexture() const { return texture; }
+            Texture2D* GetTexture() const { return definition->texture; }
+
+            // Enables back to front sorting of this emitter's particles (standard blend mode only)
+            void SetDepthSort(bool enabled) { EditDefinition().depthSort = enabled; }
+
+            // Keeps particles in spawn order instead of swapping dead particles with the last one
+            // The oldest particles are always the ones recycled, and memory order stays stable between
+            // updates, at the cost of twice the particle storage. Removes all active particles
+            void SetOrderedPool(bool enabled);
+
+            // Gets the number of currently active particles
+            int GetActiveParticles() const { return activeParticles; }
+
+            // Scales the spawn rate, burst sizes and particle limit down on top of the level of detail
+            // Set from the scene's ParticleBudget by the owning effect, particles already alive are unaffected
+            void SetBudgetScale(float scale) { budgetScale = std::clamp(scale, 0.0f, 1.0f); }
+
+            // Gets the current budget scale
+            float GetBudgetScale() const { return budgetScale; }
+
+            // Returns the bounds of the active particles (in the space they are simulated in) as of the last
+            // update, including their billboards. Tracked by the simulation kernel, or the aging kernel for
+            // analytic emitters, so it costs no extra pass over the particles
+            AABB GetBounds() const;
 
             // Gives read-write access to the list of attractors
-            std::vector<Attractor>& Attractors() { return attractors; }
+            // Stops evaluating the emitter analytically, so attractors added through it take effect
+            std::vector<Attractor>& Attractors();
 
         // Data / implementation
         private:
@@ -287,48 +427,119 @@ namespace Phi
                 EmitterData(CPUParticleEmitter* emitter, const glm::mat4& transform) : emitter(emitter), transform(transform) {};
                 CPUParticleEmitter* emitter = nullptr;
                 glm::mat4 transform{1.0f};
+
+                // View depth used to order standard blended emitters, and whether the particles were sorted
+                float depth = 0.0f;
+                bool sorted = false;
             };
             
-            // Emitter properties
-            std::string name{"New Emitter"};
-            glm::vec3 offset{0.0f};
-            float duration = -1.0f;
-            int maxActiveParticles = 128;
-            bool randomSeed = true;
-
-            // Rendering properties
-            BlendMode blendMode{BlendMode::Additive};
-            Texture2D* texture = nullptr; // NON-OWNING! (From ResourceManager)
-            std::string texPath{""};
-
-            // Particle properties and affectors
-            ParticleProperties particleProperties{};
-            AffectorProperties affectorProperties{};
-
-            // Attractors
-            std::vector<Attractor> attractors;
-
-            // Particle data
-            std::vector<Particle> particlePool;
+            // Shared properties, never null
+            std::shared_ptr<const Definition> definition;
+
+            // Particle data, a range [base, base + capacity) of a block of the arena
+            // Active particles occupy [first, first + activeParticles), first is always base in unordered pools
+            // NOTE: oldest is relative to base
+            ParticleData* particles = &noParticles;
+            int base = 0;
+            int capacity = 0;
+            int arenaRange = -1;
             int activeParticles = 0;
+            int first = 0;
             int oldest = 0;
 
+            // Bounds of the active particle positions (spawn positions for analytic emitters), kept up to
+            // date by the simulation and aging kernels and the collider
+            ParticleKernels::Bounds bounds;
+
             // Internal counters
             float totalElapsedTime = 0.0f;
             float spawnAccumulator = 0.0f;
 
+            // Randomized spawn rate and burst size, redrawn after each spawn in the random modes
+            float spawnRateRandom = 5.0f;
+            int burstCountRandom = 5;
+            bool burstDone = false;
+
+            // Spawn rate and particle limit scale, set by the owning effect's level of detail
+            float lodScale = 1.0f;
+
+            // Further spawn rate and particle limit scale, see SetBudgetScale()
+            float budgetScale = 1.0f;
+
+            // Fixed timestep, disabled when 0
+            float fixedTimestep = 0.0f;
+            int maxSubsteps = 8;
+            float stepAccumulator = 0.0f;
+
             // RNG Instance
-            RNG rng{4545};
+            CounterRNG rng{4545};
+
+            // Specialized kernels
+
+            // Initializes one attribute of every newly spawned particle
+            typedef void (CPUParticleEmitter::*SpawnPass)(const int* indices, int count, const glm::mat4& transform);
+
+            // Kernels selected by UpdateKernels()
+            struct Kernels
+            {
+                SpawnPass spawnPositions[2]{}; // Indexed by spawnRelative
+                SpawnPass spawnVelocities = nullptr;
+                SpawnPass spawnColors = nullptr;
+                SpawnPass spawnSizes = nullptr;
+                SpawnPass spawnOpacities = nullptr;
+                SpawnPass spawnLifespans = nullptr;
+                ParticleKernels::SimulateKernel simulate = nullptr;
+                ParticleKernels::SimulateKernel simulateUndamped = nullptr; // Used with baked attractors
+                bool analytic = false; // See IsAnalytic()
+                bool expireInOrder = false; // Ordered pools only remove expired particles from the front
+            };
+
+            Kernels kernels;
+
+            // Per-update scratch space
+            std::vector<int> spawnIndices;
+            std::vector<ParticleKernels::AttractorData> attractorData;
+
+            // Baked attractors, created on first use
+            std::unique_ptr<AttractorField> attractorField;
+
+            // Turbulence, created on first use
+            std::unique_ptr<TurbulenceField> turbulenceField;
+
+            // Neighbour grid, created on first use
+            std::unique_ptr<ParticleFlock> flock;
+
+            // Back to front order of the particles, updated by FlushRenderQueue()
+            ParticleSorter sorter;
+
+            // Spawn passes, one instantiation per mode
+            template <PositionMode Mode, bool Relative>
+            void SpawnPositions(const int* indices, int count, const glm::mat4& transform);
+            template <VelocityMode Mode>
+            void SpawnVelocities(const int* indices, int count, const glm::mat4& transform);
+            template <ColorMode Mode>
+            void SpawnColors(const int* indices, int count, const glm::mat4& transform);
+            template <SizeMode Mode>
+            void SpawnSizes(const int* indices, int count, const glm::mat4& transform);
+            template <OpacityMode Mode>
+            void SpawnOpacities(const int* indices, int count, const glm::mat4& transform);
+            template <LifespanMode Mode>
+            void SpawnLifespans(const int* indices, int count, const glm::mat4& transform);
 
             // Static resources
             
-            // Global RNG instance
-            static inline RNG GLOBAL_RNG{4545};
+            // Global RNG instance, used only to seed new emitters
+            // NOTE: Never touched by Update(), so emitters can be simulated concurrently
+            static inline CounterRNG GLOBAL_RNG{4545};
+
+            // Particle storage of every emitter, and the empty pool of emitters without a range
+            static inline ParticleArena arena;
+            static inline ParticleData noParticles;
 
             // Limits and constants
 
             // Gravitational acceleration
-            static inline glm::vec3 GRAVITATIONAL_ACCELERATION = glm::vec3(0.0f, -9.81f, 0.0f);
+            static inline const glm::vec3 GRAVITATIONAL_ACCELERATION = glm::vec3(0.0f, -9.81f, 0.0f);
 
             // Max number of particles per emitter
             static const int MAX_PARTICLES = 16'384;
@@ -353,6 +564,9 @@ namespace Phi
             static inline VertexAttributes* texturedVAO = nullptr;
             static inline VertexAttributes* untexturedVAO = nullptr;
 
+            // Positions, colors and sizes of the analytic emitter being drawn, reused by every emitter
+            static inline ParticleData evaluated;
+
             // Render queues
             static inline std::vector<Texture2D*> queuedTextures; // TODO: Remove
             static inline std::vector<EmitterData> renderQueues[(int)RenderQueue::COUNT];
@@ -362,6 +576,14 @@ namespace Phi
             static inline size_t queuedParticles = 0;
             static inline int queuedEmitters = 0;
 
+            // Depth sorting limit and usage per flush
+            static inline int sortBudget = MAX_PARTICLES * MAX_EMITTERS;
+            static inline int sortedParticles = 0;
+
+            // Culling counters since the last flush, and as of the last flush
+            static inline CullingStats cullingStats{0, 0, 0};
+            static inline CullingStats lastCullingStats{0, 0, 0};
+
             // Unit billboarded quad verts
             static inline GLfloat quadData[] =
             {
@@ -373,9 +595,55 @@ namespace Phi
                 0.5f, -0.5f, 0.0f
             };
 
+            // Advances the simulation by exactly delta seconds
+            void Step(float delta, bool updateSpawns, bool spawnRelative, const glm::mat4& transform, const ParticleCollider* collider);
+
+            // Serialized simulation state header, followed by each particle stream
+            struct SavedState
+            {
+                int32_t activeParticles;
+                int32_t oldest;
+                float totalElapsedTime;
+                float spawnAccumulator;
+                float stepAccumulator;
+                float spawnRateRandom;
+                int32_t burstCountRandom;
+                uint8_t burstDone;
+                uint8_t padding[3];
+                uint32_t rngSeed;
+                uint32_t rngStream;
+                uint64_t rngCounter;
+            };
+
+            // Despawns all particles with a normalized age above 1
+            void RemoveExpired();
+
+            // Writes the positions (and unless positionsOnly, the colors and sizes) of the active particles of
+            // an analytic emitter to out, starting at index 0
+            void Evaluate(ParticleData& out, bool positionsOnly);
+
+            // Converts the active particles between integrated state and spawn state
+            void SetAnalytic(bool analytic);
+
+            // Makes this emitter an instance of the given definition, then seeds and resets it
+            void SetDefinition(std::shared_ptr<const Definition> definition);
+
+            // Resizes the particle pool for the current particle limit and pool mode
+            // Active particles are moved to the start of the pool and clamped to the new limit
+            void ResizePool();
+
+            // Takes over the particle pool of another emitter, leaving it without one
+            void StealPool(CPUParticleEmitter& other);
+
+            // Called by the arena after it moved the pool to a new offset
+            void Relocate(int offset);
+
             // Reference counting helpers
             static void IncreaseReferences();
 
+            // Creates static OpenGL resources if they don't exist yet
+            static void InitializeResources();
+
             // Friends
 
             // Necessary for effects to edit our properties
@@ -383,5 +651,8 @@ namespace Phi
             
             // Necessary for the particle effect editor to work
             friend class ::ParticleEffectEditor;
+
+            // Necessary for the arena to relocate pools
+            friend class ParticleArena;
     };
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "particle_arena.hpp"
+
+#include <algorithm>
+
+#include <phi/scene/components/particles/cpu_particle_emitter.hpp>
+
+namespace Phi
+{
+    ParticleArena::ParticleArena(int blockCapacity)
+        : blockCapacity(std::max(blockCapacity, 1))
+    {
+    }
+
+    ParticleArena::~ParticleArena()
+    {
+    }
+
+    ParticleArena::Range ParticleArena::Allocate(int capacity, CPUParticleEmitter* owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // First fit, between the ranges of a block or after its last one
+        int block = -1;
+        int offset = 0;
+        int position = 0;
+        for (int b = 0; b < (int)blocks.size() && block < 0; ++b)
+        {
+            if (!blocks[b].data) continue;
+
+            int cursor = 0;
+            const auto& ranges = blocks[b].ranges;
+            for (int r = 0; r <= (int)ranges.size(); ++r)
+            {
+                int end = r < (int)ranges.size() ? records[ranges[r]].offset : blocks[b].capacity;
+                if (end - cursor >= capacity)
+                {
+                    block = b;
+                    offset = cursor;
+                    position = r;
+                    break;
+                }
+                if (r < (int)ranges.size()) cursor = records[ranges[r]].offset + records[ranges[r]].capacity;
+            }
+        }
+
+        // Nothing fits, add a block, reusing the slot of a freed one if there is one
+        if (block < 0)
+        {
+            auto freed = std::find_if(blocks.begin(), blocks.end(), [](const Block& b) { return !b.data; });
+            block = (int)(freed - blocks.begin());
+            if (freed == blocks.end()) blocks.emplace_back();
+
+            Block& newBlock = blocks[block];
+            newBlock.capacity = std::max(capacity, blockCapacity);
+            newBlock.data = std::make_unique<ParticleData>();
+            newBlock.data->Resize(newBlock.capacity);
+            blockAllocations++;
+        }
+
+        // Ranges may reuse the particles of released ones
+        blocks[block].data->Zero(offset, capacity);
+
+        int id = records.Insert({block, offset, capacity, owner});
+        blocks[block].ranges.insert(blocks[block].ranges.begin() + position, id);
+        return {id, blocks[block].data.get(), offset, capacity};
+    }
+
+    void ParticleArena::Release(int id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto& ranges = blocks[records[id].block].ranges;
+        ranges.erase(std::find(ranges.begin(), ranges.end(), id));
+        records.Erase(id);
+    }
+
+    void ParticleArena::SetOwner(int id, CPUParticleEmitter* owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        records[id].owner = owner;
+    }
+
+    int ParticleArena::Compact()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        int moved = 0;
+        for (int b = 0; b < (int)blocks.size(); ++b)
+        {
+            Block& block = blocks[b];
+            if (!block.data) continue;
+
+            // Slide every range down onto the end of the previous one
+            int cursor = 0;
+            for (int id : block.ranges)
+            {
+                Record& record = records[id];
+                if (record.offset != cursor)
+                {
+                    block.data->Move(record.offset, cursor, record.capacity);
+                    record.offset = cursor;
+                    record.owner->Relocate(cursor);
+                    moved += record.capacity;
+                }
+                cursor += record.capacity;
+            }
+
+            // Keep the first block around, the rest only while they're used
+            if (b > 0 && block.ranges.empty())
+            {
+                block.data.reset();
+                block.capacity = 0;
+            }
+        }
+
+        return moved;
+    }
+
+    ParticleArena::Stats ParticleArena::GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        Stats stats;
+        stats.ranges = (int)records.Count();
+        stats.blockAllocations = blockAllocations;
+        for (const Block& block : blocks)
+        {
+            if (!block.data) continue;
+            stats.blocks++;
+            stats.capacity += block.capacity;
+            for (int id : block.ranges) stats.allocated += records[id].capacity;
+        }
+        return stats;
+    }
+}
\ No newline at end of file
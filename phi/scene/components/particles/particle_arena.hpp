@@ -0,0 +1,105 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <phi/core/structures/free_list.hpp>
+#include <phi/scene/components/particles/particle_data.hpp>
+
+namespace Phi
+{
+    // Forward declaration
+    class CPUParticleEmitter;
+
+    // Storage for the particles of many emitters
+    //
+    // Instead of fourteen streams of their own, emitters are given contiguous ranges of a few large
+    // blocks of ParticleData, so creating, resizing and destroying emitters rarely touches the heap,
+    // and emitters allocated together simulate and pack from neighbouring memory. A new block is added
+    // when no free range is large enough, blocks never move, so allocating is safe while other emitters
+    // are being updated. Released ranges leave holes that Compact() closes by sliding the ranges after
+    // them down and telling their owners where they went, which moves particle data and must only
+    // happen while no emitter is being updated
+    class ParticleArena
+    {
+        // Interface
+        public:
+
+            ParticleArena(int blockCapacity = DEFAULT_BLOCK_CAPACITY);
+            ~ParticleArena();
+
+            // Delete copy constructor/assignment
+            ParticleArena(const ParticleArena&) = delete;
+            ParticleArena& operator=(const ParticleArena&) = delete;
+
+            // Delete move constructor/assignment
+            ParticleArena(ParticleArena&& other) = delete;
+            ParticleArena& operator=(ParticleArena&& other) = delete;
+
+            // A range of particles [offset, offset + capacity) of data
+            struct Range
+            {
+                int id = -1;
+                ParticleData* data = nullptr;
+                int offset = 0;
+                int capacity = 0;
+            };
+
+            // Allocates a range of the given capacity (which must be positive) for an emitter
+            // Ranges larger than a block get a block of their own, and all ranges start out zeroed
+            Range Allocate(int capacity, CPUParticleEmitter* owner);
+
+            // Returns a range to the arena, its particles are lost
+            void Release(int id);
+
+            // Changes the emitter told about moves of a range, for when emitters are moved
+            void SetOwner(int id, CPUParticleEmitter* owner);
+
+            // Closes the holes left by released ranges, and frees blocks left without ranges
+            // Returns the number of particles moved
+            int Compact();
+
+            // Usage statistics
+            struct Stats
+            {
+                int blocks = 0;
+                int ranges = 0;
+                long long capacity = 0;
+                long long allocated = 0;
+                long long blockAllocations = 0;
+            };
+            Stats GetStats() const;
+
+        // Data / implementation
+        private:
+
+            // A block and its ranges in ascending offset order
+            struct Block
+            {
+                std::unique_ptr<ParticleData> data;
+                std::vector<int> ranges;
+                int capacity = 0;
+            };
+
+            // Range records, by id
+            struct Record
+            {
+                int block;
+                int offset;
+                int capacity;
+                CPUParticleEmitter* owner;
+            };
+
+            int blockCapacity;
+            std::vector<Block> blocks;
+            FreeList<Record> records;
+            long long blockAllocations = 0;
+
+            // Allocation and compaction can be called from any thread
+            mutable std::mutex mutex;
+
+            // Particles per block unless a larger range is needed
+            static const int DEFAULT_BLOCK_CAPACITY = 65'536;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "particle_budget.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Phi
+{
+    ParticleBudget::ParticleBudget()
+    {
+    }
+
+    ParticleBudget::~ParticleBudget()
+    {
+    }
+
+    void ParticleBudget::Update(int particles, float milliseconds, float delta)
+    {
+        stats.particles = particles;
+        stats.milliseconds = milliseconds;
+
+        // Without limits, quality is always full
+        if (settings.maxParticles <= 0 && settings.maxMilliseconds <= 0.0f)
+        {
+            stats.scale = 1.0f;
+            stats.pressure = 0.0f;
+            appliedScale = 1.0f;
+            return;
+        }
+
+        // Load relative to the tightest limit
+        stats.pressure = 0.0f;
+        if (settings.maxParticles > 0) stats.pressure = std::max(stats.pressure, (float)particles / settings.maxParticles);
+        if (settings.maxMilliseconds > 0.0f) stats.pressure = std::max(stats.pressure, milliseconds / settings.maxMilliseconds);
+
+        // Load is roughly proportional to the scale it was produced at, so the scale the budget fits at follows
+        // Degrade quickly while over budget, recover slowly while there is room to spare, and hold in between
+        float target = stats.scale;
+        float time = 1.0f;
+        if (stats.pressure > 1.0f)
+        {
+            target = std::min(stats.scale, appliedScale / stats.pressure);
+            time = settings.degradeTime;
+        }
+        else if (stats.pressure * stats.scale < appliedScale * settings.recoverThreshold)
+        {
+            target = stats.pressure > 0.0f ? std::min(appliedScale * settings.recoverThreshold / stats.pressure, 1.0f) : 1.0f;
+            time = settings.recoverTime;
+        }
+
+        // Ease towards the target independently of the frame rate
+        auto blend = [delta](float seconds) { return seconds > 0.0f ? 1.0f - std::exp(-delta / seconds) : 1.0f; };
+        stats.scale += (target - stats.scale) * blend(time);
+        stats.scale = std::clamp(stats.scale, std::min(settings.minScale, 1.0f), 1.0f);
+        if (stats.scale > 1.0f - FULL_QUALITY_EPSILON) stats.scale = 1.0f;
+        appliedScale += (stats.scale - appliedScale) * blend(settings.responseTime);
+
+        if (stats.scale < 1.0f) stats.degradedFrames++;
+    }
+
+    float ParticleBudget::GetScale(float priority) const
+    {
+        if (priority <= 0.0f || stats.scale >= 1.0f) return 1.0f;
+        return priority == 1.0f ? stats.scale : std::pow(stats.scale, 1.0f / priority);
+    }
+}
\ No newline at end of file
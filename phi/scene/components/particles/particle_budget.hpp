@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Phi
+{
+    // Scales particle spawning down while simulation exceeds a budget, and back up once it fits again
+    //
+    // The budget is a number of live particles, a number of milliseconds spent simulating them per frame,
+    // or both. Update() is told what each frame cost, and while over budget the quality scale eases towards
+    // the fraction of the load that would fit. Only spawn rates and particle limits are scaled, particles
+    // that are already alive live out their lifespans, so load falls off over a while instead of spiking or
+    // popping. Because of that the load of a frame reflects the scale of the last second or so rather than
+    // the current one, and is compared against a lagging average of the scale so cuts that haven't taken
+    // effect yet aren't made again. Once well under budget the scale eases back up, much slower
+    class ParticleBudget
+    {
+        // Interface
+        public:
+
+            struct Settings
+            {
+                // Live particles across all effects, 0 for no limit
+                int maxParticles = 0;
+
+                // Milliseconds spent simulating particles per frame, 0 for no limit
+                float maxMilliseconds = 0.0f;
+
+                // Lowest quality scale the budget may impose
+                float minScale = 0.1f;
+
+                // Seconds to close ~63% of the distance to the target scale when degrading and recovering
+                float degradeTime = 0.25f;
+                float recoverTime = 1.0f;
+
+                // Seconds the load takes to follow changes of the scale, about the typical particle lifespan
+                float responseTime = 1.0f;
+
+                // Fraction of the budget quality recovers up to, the gap keeps it from oscillating
+                float recoverThreshold = 0.8f;
+            };
+
+            struct Stats
+            {
+                float scale = 1.0f;
+
+                // Load of the last frame, and the largest fraction of a limit it used
+                int particles = 0;
+                float milliseconds = 0.0f;
+                float pressure = 0.0f;
+
+                // Frames spent below full quality
+                uint64_t degradedFrames = 0;
+            };
+
+            ParticleBudget();
+            ~ParticleBudget();
+
+            // Delete copy constructor/assignment
+            ParticleBudget(const ParticleBudget&) = delete;
+            ParticleBudget& operator=(const ParticleBudget&) = delete;
+
+            // Delete move constructor/assignment
+            ParticleBudget(ParticleBudget&& other) = delete;
+            ParticleBudget& operator=(ParticleBudget&& other) = delete;
+
+            // Adjusts the quality scale from the load of a frame that took delta seconds
+            void Update(int particles, float milliseconds, float delta);
+
+            // Returns the quality scale for effects of the given priority
+            // Priorities above 1 are scaled down less and below 1 more (the scale to the power of 1 / priority),
+            // and effects with a priority of 0 or less are exempt from the budget
+            float GetScale(float priority = 1.0f) const;
+
+            // Gives read-write access to the limits, no limits means full quality
+            Settings& GetSettings() { return settings; }
+
+            // Returns the current quality scale and the last frame's load
+            const Stats& GetStats() const { return stats; }
+
+        // Data / implementation
+        private:
+
+            Settings settings;
+            Stats stats;
+
+            // Average of the scale over the last response time, which the load of a frame corresponds to
+            float appliedScale = 1.0f;
+
+            // Recovery snaps to full quality once this close
+            static constexpr float FULL_QUALITY_EPSILON = 0.01f;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "particle_collider.hpp"
+
+#include <cmath>
+
+#include <phi/scene/components/simulation/voxel_map.hpp>
+#include <phi/scene/components/simulation/voxel_object.hpp>
+
+namespace Phi
+{
+    namespace
+    {
+        // Occupancy lookup into the loaded chunks of a voxel map
+        // Remembers the last chunk visited, so only particles that cross chunks search the map
+        struct ChunkCache
+        {
+            const VoxelMap* map = nullptr;
+            const VoxelChunk* chunk = nullptr;
+            glm::ivec3 origin{0};
+            bool valid = false;
+
+            bool operator()(const glm::ivec3& cell)
+            {
+                const int dim = VoxelChunk::CHUNK_DIM;
+                glm::ivec3 local = cell - origin;
+                bool inside = (local.x >= 0) & (local.y >= 0) & (local.z >= 0) & (local.x < dim) & (local.y < dim) & (local.z < dim);
+                if (!valid || !inside)
+                {
+                    // Round towards negative infinity
+                    glm::ivec3 chunkID;
+                    for (int a = 0; a < 3; ++a)
+                    {
+                        chunkID[a] = (cell[a] >= 0 ? cell[a] : cell[a] - dim + 1) / dim;
+                    }
+
+                    origin = chunkID * dim;
+                    chunk = map->GetChunk(chunkID);
+                    local = cell - origin;
+                    valid = true;
+                }
+                return chunk && chunk->IsSolid(local.x, local.y, local.z);
+            }
+        };
+    }
+
+    ParticleCollider::ParticleCollider()
+    {
+    }
+
+    ParticleCollider::~ParticleCollider()
+    {
+    }
+
+    void ParticleCollider::AddObject(const VoxelObject* object, const glm::mat4& particleToLocal)
+    {
+        objects.push_back(MakeVolume(object, particleToLocal));
+    }
+
+    void ParticleCollider::SetMap(const VoxelMap* map, const glm::mat4& particleToWorld)
+    {
+        this->map = map;
+        mapVolume = MakeVolume(nullptr, particleToWorld);
+    }
+
+    void ParticleCollider::Clear()
+    {
+        objects.clear();
+        map = nullptr;
+    }
+
+    int ParticleCollider::Collide(ParticleData& particles, int first, int count, float delta, Response response, float restitution,
+                                  ParticleKernels::Bounds* bounds) const
+    {
+        if (count < 1 || IsEmpty()) return 0;
+
+        int collisions = 0;
+
+        // Voxel map chunks
+        if (map)
+        {
+            ChunkCache cache;
+            cache.map = map;
+            collisions += CollideVolume(particles, first, count, delta, response, restitution, mapVolume, cache, bounds);
+        }
+
+        // Voxel objects
+        if (objects.size() > 0)
+        {
+            // Bounds of the whole batch, used to skip objects no particle can touch
+            glm::vec3 boundsMin{INFINITY};
+            glm::vec3 boundsMax{-INFINITY};
+            for (int i = first; i < first + count; ++i)
+            {
+                glm::vec3 position(particles.posX[i], particles.posY[i], particles.posZ[i]);
+                boundsMin = glm::min(boundsMin, position);
+                boundsMax = glm::max(boundsMax, position);
+            }
+
+            for (const Volume& volume : objects)
+            {
+                // Transform the batch bounds into object local space
+                glm::vec3 localMin{INFINITY};
+                glm::vec3 localMax{-INFINITY};
+                for (int c = 0; c < 8; ++c)
+                {
+                    glm::vec3 corner((c & 1) ? boundsMax.x : boundsMin.x, (c & 2) ? boundsMax.y : boundsMin.y, (c & 4) ? boundsMax.z : boundsMin.z);
+                    glm::vec3 local = glm::vec3(volume.toVolume * glm::vec4(corner, 1.0f));
+                    localMin = glm::min(localMin, local);
+                    localMax = glm::max(localMax, local);
+                }
+
+                const IAABB& aabb = volume.object->GetAABB();
+                if (glm::any(glm::lessThan(localMax, glm::vec3(aabb.min))) || glm::any(glm::greaterThanEqual(localMin, glm::vec3(aabb.max)))) continue;
+
+                const VoxelObject* object = volume.object;
+                auto lookup = [object](const glm::ivec3& cell) { return object->IsSolid(cell.x, cell.y, cell.z); };
+                collisions += CollideVolume(particles, first, count, delta, response, restitution, volume, lookup, bounds);
+            }
+        }
+
+        return collisions;
+    }
+
+    ParticleCollider::Volume ParticleCollider::MakeVolume(const VoxelObject* object, const glm::mat4& toVolume)
+    {
+        // Plane normals map back with the transpose: n_local . (M * p) == (M^T * n_local) . p
+        Volume volume;
+        volume.object = object;
+        volume.toVolume = toVolume;
+        volume.normalToParticle = glm::transpose(glm::mat3(toVolume));
+        return volume;
+    }
+
+    template <typename Lookup>
+    int ParticleCollider::CollideVolume(ParticleData& particles, int first, int count, float delta, Response response, float restitution,
+                                        const Volume& volume, Lookup& isSolid, ParticleKernels::Bounds* bounds)
+    {
+        const glm::mat4& m = volume.toVolume;
+        int collisions = 0;
+
+        for (int i = first; i < first + count; ++i)
+        {
+            // Occupancy of the voxel the particle ended up in
+            glm::vec3 position(particles.posX[i], particles.posY[i], particles.posZ[i]);
+            glm::vec3 local = glm::vec3(m * glm::vec4(position, 1.0f));
+            glm::ivec3 cell = glm::floor(local);
+            if (!isSolid(cell)) continue;
+
+            collisions++;
+
+            // Where the particle came from
+            glm::vec3 velocity(particles.velX[i], particles.velY[i], particles.velZ[i]);
+            glm::vec3 previous = position - velocity * delta;
+            glm::vec3 localPrevious = glm::vec3(m * glm::vec4(previous, 1.0f));
+            glm::ivec3 previousCell = glm::floor(localPrevious);
+            glm::vec3 move = local - localPrevious;
+
+            // The face crossed is the one on the axis entered last (slab test against the hit cell)
+            int axis = -1;
+            float latest = -INFINITY;
+            for (int a = 0; a < 3; ++a)
+            {
+                if (cell[a] == previousCell[a]) continue;
+                float boundary = move[a] > 0.0f ? (float)cell[a] : (float)(cell[a] + 1);
+                float t = (boundary - localPrevious[a]) / move[a];
+                if (t > latest)
+                {
+                    latest = t;
+                    axis = a;
+                }
+            }
+
+            // Already inside a voxel last update, there's no face to resolve against
+            if (axis == -1 || isSolid(previousCell))
+            {
+                if (response == Response::Kill)
+                {
+                    particles.age[i] = 2.0f;
+                }
+                else
+                {
+                    particles.velX[i] = particles.velY[i] = particles.velZ[i] = 0.0f;
+                }
+                continue;
+            }
+
+            // Respond
+            switch (response)
+            {
+                case Response::Kill:
+                    particles.age[i] = 2.0f;
+                    break;
+
+                case Response::Bounce:
+                {
+                    glm::vec3 localNormal{0.0f};
+                    localNormal[axis] = move[axis] > 0.0f ? -1.0f : 1.0f;
+                    glm::vec3 normal = glm::normalize(volume.normalToParticle * localNormal);
+                    velocity -= (1.0f + restitution) * glm::dot(velocity, normal) * normal;
+                    break;
+                }
+
+                case Response::Stick:
+                    velocity = glm::vec3(0.0f);
+                    break;
+            }
+
+            // Back out of the voxel
+            particles.posX[i] = previous.x;
+            particles.posY[i] = previous.y;
+            particles.posZ[i] = previous.z;
+            particles.velX[i] = velocity.x;
+            particles.velY[i] = velocity.y;
+            particles.velZ[i] = velocity.z;
+
+            if (bounds)
+            {
+                bounds->min = glm::min(bounds->min, previous);
+                bounds->max = glm::max(bounds->max, previous);
+            }
+        }
+
+        return collisions;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <phi/scene/components/particles/particle_data.hpp>
+#include <phi/scene/components/particles/particle_kernels.hpp>
+
+namespace Phi
+{
+    // Forward declarations
+    class VoxelObject;
+    class VoxelMap;
+
+    // Collides particles with voxel objects and the loaded chunks of a voxel map
+    //
+    // Each particle costs one occupancy lookup per volume: voxel objects are tested in their local
+    // space after a cheap bounds rejection of the whole batch, and map chunks are found through a
+    // cache of the last chunk visited, so spatially coherent particles rarely touch the chunk map.
+    // Collisions are detected at the particle's final position and resolved against the voxel face
+    // crossed since its previous position (position - velocity * delta), so particles moving more
+    // than a voxel per update may tunnel through walls one voxel thick
+    //
+    // Volumes are only read, so distinct emitters may collide concurrently while the scene isn't modified
+    class ParticleCollider
+    {
+        // Interface
+        public:
+
+            // What happens to a particle that hits a voxel
+            enum class Response : int
+            {
+                Kill = 0,   // Despawned immediately
+                Bounce,     // Reflected off the face it hit, scaled by the restitution
+                Stick       // Stopped at the surface
+            };
+
+            ParticleCollider();
+            ~ParticleCollider();
+
+            // Delete copy constructor/assignment
+            ParticleCollider(const ParticleCollider&) = delete;
+            ParticleCollider& operator=(const ParticleCollider&) = delete;
+
+            // Delete move constructor/assignment
+            ParticleCollider(ParticleCollider&& other) = delete;
+            ParticleCollider& operator=(ParticleCollider&& other) = delete;
+
+            // Volumes
+
+            // Adds a voxel object, particleToLocal maps particle positions into the object's local space
+            void AddObject(const VoxelObject* object, const glm::mat4& particleToLocal);
+
+            // Sets the voxel map to test against, particleToWorld maps particle positions into world space
+            void SetMap(const VoxelMap* map, const glm::mat4& particleToWorld);
+
+            // Removes all volumes
+            void Clear();
+
+            // Returns true if there is nothing to collide with
+            bool IsEmpty() const { return objects.empty() && map == nullptr; }
+
+            // Collision
+
+            // Collides particles [first, first + count) that have just been moved by delta seconds
+            // Killed particles are given an age above 1, the caller is responsible for despawning them
+            // Particles moved back out of a voxel are added to bounds, if given
+            // Returns the number of particles that collided
+            int Collide(ParticleData& particles, int first, int count, float delta, Response response, float restitution,
+                        ParticleKernels::Bounds* bounds = nullptr) const;
+
+        // Data / implementation
+        private:
+
+            // A single transformed volume
+            struct Volume
+            {
+                const VoxelObject* object = nullptr;
+                glm::mat4 toVolume{1.0f};
+                glm::mat3 normalToParticle{1.0f};
+            };
+
+            std::vector<Volume> objects;
+            const VoxelMap* map = nullptr;
+            Volume mapVolume;
+
+            // Builds a volume from a transform
+            static Volume MakeVolume(const VoxelObject* object, const glm::mat4& toVolume);
+
+            // Tests all particles against a single volume with the given occupancy lookup
+            template <typename Lookup>
+            static int CollideVolume(ParticleData& particles, int first, int count, float delta, Response response, float restitution,
+                                     const Volume& volume, Lookup& isSolid, ParticleKernels::Bounds* bounds);
+    };
+}
\ No newline at end of file
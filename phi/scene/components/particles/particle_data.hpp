@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include <phi/core/structures/aligned_allocator.hpp>
+
+namespace Phi
+{
+    // Structure-of-arrays storage for particle simulation state
+    // Every attribute lives in its own aligned stream so simulation
+    // kernels can process many particles per instruction
+    struct ParticleData
+    {
+        // A single aligned attribute stream
+        typedef std::vector<float, AlignedAllocator<float>> Stream;
+
+        // Resizes every stream to hold the given number of particles
+        // Existing particle data within the new capacity is preserved
+        void Resize(int capacity)
+        {
+            for (Stream* stream : Streams()) stream->resize(capacity);
+        }
+
+        // Copies all attributes of the particle at index src into index dst
+        void Copy(int src, int dst)
+        {
+            for (Stream* stream : Streams()) (*stream)[dst] = (*stream)[src];
+        }
+
+        // Copies all attributes of count particles starting at index src to index dst
+        // The ranges may overlap
+        void Move(int src, int dst, int count)
+        {
+            for (Stream* stream : Streams()) std::memmove(stream->data() + dst, stream->data() + src, sizeof(float) * count);
+        }
+
+        // Zeroes all attributes of count particles starting at index first
+        void Zero(int first, int count)
+        {
+            for (Stream* stream : Streams()) std::memset(stream->data() + first, 0, sizeof(float) * count);
+        }
+
+        // Copies all attributes of count particles starting at index src of other to index dst
+        void CopyFrom(const ParticleData& other, int src, int dst, int count)
+        {
+            auto sources = other.Streams();
+            auto destinations = Streams();
+            for (int i = 0; i < NUM_STREAMS; ++i) std::memcpy(destinations[i]->data() + dst, sources[i]->data() + src, sizeof(float) * count);
+        }
+
+        // Returns the number of particles the streams can hold
+        int Capacity() const { return (int)age.size(); }
+
+        // Position
+        Stream posX, posY, posZ;
+
+        // Velocity
+        Stream velX, velY, velZ;
+
+        // Color and opacity
+        Stream colR, colG, colB, colA;
+
+        // Size
+        Stream sizeX, sizeY;
+
+        // Normalized age in [0, 1] and the reciprocal of the particle's lifespan
+        Stream age;
+        Stream invLifespan;
+
+        // Number of streams
+        static const int NUM_STREAMS = 14;
+
+        // Returns pointers to every stream for bulk operations
+        std::array<Stream*, NUM_STREAMS> Streams()
+        {
+            return {&posX, &posY, &posZ, &velX, &velY, &velZ, &colR, &colG, &colB, &colA, &sizeX, &sizeY, &age, &invLifespan};
+        }
+
+        std::array<const Stream*, NUM_STREAMS> Streams() const
+        {
+            return {&posX, &posY, &posZ, &velX, &velY, &velZ, &colR, &colG, &colB, &colA, &sizeX, &sizeY, &age, &invLifespan};
+        }
+    };
+}
\ No newline at end of file
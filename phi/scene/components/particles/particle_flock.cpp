@@ -0,0 +1,151 @@
+#include "particle_flock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Phi
+{
+    namespace
+    {
+        // Rows of cells around a particle as (y, z) offsets, its own first so bounded searches find the nearest neighbours
+        const glm::ivec2 NEIGHBOUR_ROWS[9] =
+        {
+            {0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {-1, 1}, {1, 1}
+        };
+    }
+
+    ParticleFlock::ParticleFlock()
+    {
+    }
+
+    ParticleFlock::~ParticleFlock()
+    {
+    }
+
+    glm::ivec3 ParticleFlock::Cell(const glm::vec3& position) const
+    {
+        return glm::clamp(glm::ivec3((position - origin) * invCellSize), glm::ivec3(0), size - 1);
+    }
+
+    void ParticleFlock::Build(const float* posX, const float* posY, const float* posZ,
+                              const float* velX, const float* velY, const float* velZ, int count, float radius)
+    {
+        this->count = 0;
+        if (count < 1 || !(radius > 0.0f)) return;
+
+        this->count = count;
+        this->radius = radius;
+
+        // Bounds of the particles
+        glm::vec3 min(posX[0], posY[0], posZ[0]);
+        glm::vec3 max = min;
+        for (int i = 1; i < count; ++i)
+        {
+            glm::vec3 position(posX[i], posY[i], posZ[i]);
+            min = glm::min(min, position);
+            max = glm::max(max, position);
+        }
+
+        // Cells of at least one radius, so all neighbours are within the adjacent cells
+        // Counted in floats, since far flung particles would overflow integers
+        const double maxCells = std::max((double)MIN_CELLS, (double)count * CELLS_PER_PARTICLE);
+        const glm::dvec3 extent = glm::dvec3(max - min);
+        float cellSize = radius;
+        glm::dvec3 cellsPerAxis = glm::floor(extent / (double)cellSize) + 1.0;
+        while (cellsPerAxis.x * cellsPerAxis.y * cellsPerAxis.z > maxCells)
+        {
+            cellSize *= 2.0f;
+            cellsPerAxis = glm::floor(extent / (double)cellSize) + 1.0;
+        }
+        size = glm::ivec3(cellsPerAxis);
+        origin = min;
+        invCellSize = 1.0f / cellSize;
+
+        // Storage only ever grows, so steady state doesn't allocate
+        const int cellCount = size.x * size.y * size.z;
+        cellStart.assign(cellCount + 1, 0);
+        cells.resize(count);
+        order.resize(count);
+        positions.resize(count);
+        velocities.resize(count);
+
+        // Count the particles in each cell, then turn the counts into cell ends
+        for (int i = 0; i < count; ++i)
+        {
+            glm::ivec3 cell = Cell(glm::vec3(posX[i], posY[i], posZ[i]));
+            cells[i] = cell.x + size.x * (cell.y + size.y * cell.z);
+            cellStart[cells[i]]++;
+        }
+        uint32_t end = 0;
+        for (int c = 0; c < cellCount; ++c)
+        {
+            end += cellStart[c];
+            cellStart[c] = end;
+        }
+        cellStart[cellCount] = end;
+
+        // Filling each cell from its end leaves every cell start in place, in index order within cells
+        for (int i = count - 1; i >= 0; --i)
+        {
+            uint32_t slot = --cellStart[cells[i]];
+            order[slot] = i;
+            positions[slot] = glm::vec3(posX[i], posY[i], posZ[i]);
+            velocities[slot] = glm::vec3(velX[i], velY[i], velZ[i]);
+        }
+    }
+
+    void ParticleFlock::Apply(float* velX, float* velY, float* velZ, float separation, float cohesion, float alignment,
+                              float delta, int maxNeighbours)
+    {
+        const float radiusSquared = radius * radius;
+        const float invRadius = 1.0f / radius;
+
+        for (int k = 0; k < count; ++k)
+        {
+            const glm::vec3 position = positions[k];
+            const glm::ivec3 cell = Cell(position);
+            const int x0 = std::max(cell.x - 1, 0);
+            const int x1 = std::min(cell.x + 1, size.x - 1);
+
+            glm::vec3 away(0.0f);
+            glm::vec3 offsetSum(0.0f);
+            glm::vec3 velocitySum(0.0f);
+            int neighbours = 0;
+
+            for (int r = 0; r < 9 && neighbours < maxNeighbours; ++r)
+            {
+                const int y = cell.y + NEIGHBOUR_ROWS[r].x;
+                const int z = cell.z + NEIGHBOUR_ROWS[r].y;
+                if (y < 0 || y >= size.y || z < 0 || z >= size.z) continue;
+
+                // Three cells of a row are one range of particles
+                const int row = size.x * (y + size.y * z);
+                const uint32_t end = cellStart[row + x1 + 1];
+                pairTests += end - cellStart[row + x0];
+                for (uint32_t j = cellStart[row + x0]; j < end; ++j)
+                {
+                    glm::vec3 offset = positions[j] - position;
+                    float distanceSquared = glm::dot(offset, offset);
+                    if (distanceSquared >= radiusSquared || distanceSquared <= 0.0f) continue;
+
+                    float distance = std::sqrt(distanceSquared);
+                    away -= offset * ((1.0f - distance * invRadius) / distance);
+                    offsetSum += offset;
+                    velocitySum += velocities[j];
+                    if (++neighbours == maxNeighbours) break;
+                }
+            }
+            if (neighbours == 0) continue;
+
+            const float invNeighbours = 1.0f / neighbours;
+            glm::vec3 acceleration = away * separation +
+                                     offsetSum * (invNeighbours * cohesion) +
+                                     (velocitySum * invNeighbours - velocities[k]) * alignment;
+
+            const uint32_t i = order[k];
+            velX[i] += acceleration.x * delta;
+            velY[i] += acceleration.y * delta;
+            velZ[i] += acceleration.z * delta;
+        }
+    }
+}
\ No newline at end of file
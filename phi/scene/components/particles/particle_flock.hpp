@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Phi
+{
+    // Separation, cohesion and alignment between nearby particles
+    //
+    // Particles are bucketed by a counting sort into a uniform grid over their bounds, with cells at
+    // least one neighbour radius wide, so each particle only visits the 27 cells around it instead of
+    // every other particle. Rows of cells are contiguous in x, so those are 9 contiguous ranges of
+    // particles. The grid is rebuilt from scratch every step in linear time, with the cell size doubled
+    // when the particles spread so far that the grid would outgrow them. Every particle reads the state
+    // from when the grid was built, so results don't depend on the order particles are processed in
+    class ParticleFlock
+    {
+        // Interface
+        public:
+
+            ParticleFlock();
+            ~ParticleFlock();
+
+            // Delete copy constructor/assignment
+            ParticleFlock(const ParticleFlock&) = delete;
+            ParticleFlock& operator=(const ParticleFlock&) = delete;
+
+            // Delete move constructor/assignment
+            ParticleFlock(ParticleFlock&& other) = delete;
+            ParticleFlock& operator=(ParticleFlock&& other) = delete;
+
+            // Buckets count particles into cells for the given neighbour radius
+            void Build(const float* posX, const float* posY, const float* posZ,
+                       const float* velX, const float* velY, const float* velZ, int count, float radius);
+
+            // Accelerates the particles of the last Build() over delta seconds:
+            //  separation: away from each neighbour, stronger the closer it is
+            //  cohesion: towards the center of the neighbours
+            //  alignment: towards the average velocity of the neighbours
+            // At most maxNeighbours neighbours are considered per particle, nearest cells first
+            void Apply(float* velX, float* velY, float* velZ, float separation, float cohesion, float alignment,
+                       float delta, int maxNeighbours);
+
+            // Returns the number of candidate pairs tested so far
+            long long GetPairTests() const { return pairTests; }
+
+        // Data / implementation
+        private:
+
+            // Grid of the last build, cells [0, size) starting at origin
+            float radius = 0.0f;
+            float invCellSize = 0.0f;
+            glm::vec3 origin{0.0f};
+            glm::ivec3 size{0};
+            int count = 0;
+
+            // Particles [cellStart[c], cellStart[c + 1]) in sorted order are in cell c
+            std::vector<uint32_t> cellStart;
+            std::vector<uint32_t> cells;
+
+            // Original index, position and velocity of each particle in sorted order
+            std::vector<uint32_t> order;
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> velocities;
+
+            long long pairTests = 0;
+
+            // Most cells per particle before the cell size is doubled
+            static const int CELLS_PER_PARTICLE = 4;
+            static const int MIN_CELLS = 4'096;
+
+            // Returns the cell containing a position
+            glm::ivec3 Cell(const glm::vec3& position) const;
+    };
+}
\ No newline at end of file
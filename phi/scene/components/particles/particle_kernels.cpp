@@ -0,0 +1,494 @@
+#include "particle_kernels.hpp"
+
+#include <array>
+#include <cmath>
+#include <utility>
+
+// Select the widest instruction set available at compile time
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define PHI_PARTICLE_KERNELS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define PHI_PARTICLE_KERNELS_SSE
+#endif
+
+namespace Phi
+{
+    namespace ParticleKernels
+    {
+        namespace
+        {
+            // Lane operations
+            //
+            // Every kernel is written once in terms of these and instantiated both for
+            // single floats (the scalar path and SIMD remainders) and for SIMD registers,
+            // which is what keeps the two paths bit-identical
+
+            template <typename V> V Load(const float* p);
+            template <typename V> V Set(float v);
+
+            // Scalar lanes
+            template <> inline float Load<float>(const float* p) { return *p; }
+            template <> inline float Set<float>(float v) { return v; }
+            inline void Store(float* p, float v) { *p = v; }
+            inline float Add(float a, float b) { return a + b; }
+            inline float Sub(float a, float b) { return a - b; }
+            inline float Mul(float a, float b) { return a * b; }
+            inline float Div(float a, float b) { return a / b; }
+            inline float Sqrt(float a) { return std::sqrt(a); }
+            inline bool Less(float a, float b) { return a < b; }
+            inline bool Greater(float a, float b) { return a > b; }
+            inline bool And(bool a, bool b) { return a && b; }
+            inline float Select(bool mask, float a, float b) { return mask ? a : b; }
+            inline float Min(float a, float b) { return a < b ? a : b; }
+            inline float Max(float a, float b) { return a > b ? a : b; }
+
+            // Vector lanes
+#if defined(PHI_PARTICLE_KERNELS_AVX)
+            typedef __m256 Vec;
+            constexpr int WIDTH = 8;
+            template <> inline Vec Load<Vec>(const float* p) { return _mm256_loadu_ps(p); }
+            template <> inline Vec Set<Vec>(float v) { return _mm256_set1_ps(v); }
+            inline void Store(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+            inline Vec Add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+            inline Vec Sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+            inline Vec Mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+            inline Vec Div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+            inline Vec Sqrt(Vec a) { return _mm256_sqrt_ps(a); }
+            inline Vec Less(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+            inline Vec Greater(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+            inline Vec And(Vec a, Vec b) { return _mm256_and_ps(a, b); }
+            inline Vec Select(Vec mask, Vec a, Vec b) { return _mm256_blendv_ps(b, a, mask); }
+            inline Vec Min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+            inline Vec Max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+#elif defined(PHI_PARTICLE_KERNELS_SSE)
+            typedef __m128 Vec;
+            constexpr int WIDTH = 4;
+            template <> inline Vec Load<Vec>(const float* p) { return _mm_loadu_ps(p); }
+            template <> inline Vec Set<Vec>(float v) { return _mm_set1_ps(v); }
+            inline void Store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+            inline Vec Add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+            inline Vec Sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+            inline Vec Mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+            inline Vec Div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+            inline Vec Sqrt(Vec a) { return _mm_sqrt_ps(a); }
+            inline Vec Less(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+            inline Vec Greater(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+            inline Vec And(Vec a, Vec b) { return _mm_and_ps(a, b); }
+            inline Vec Select(Vec mask, Vec a, Vec b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+            inline Vec Min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+            inline Vec Max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+#endif
+
+            // Calls lane(V(), i) for every i in [0, count), a whole register at a time where possible
+            template <typename F>
+            inline void Run(int count, F&& lane)
+            {
+                int i = 0;
+#if defined(PHI_PARTICLE_KERNELS_AVX) || defined(PHI_PARTICLE_KERNELS_SSE)
+                for (; i + WIDTH <= count; i += WIDTH) lane(Vec(), i);
+#endif
+                for (; i < count; ++i) lane(0.0f, i);
+            }
+
+            // Calls lane(0.0f, i) for every i in [0, count)
+            template <typename F>
+            inline void RunScalar(int count, F&& lane)
+            {
+                for (int i = 0; i < count; ++i) lane(0.0f, i);
+            }
+
+            // Lane kernels
+
+            template <typename V>
+            inline V Lerp(V start, V end, V t)
+            {
+                return Add(Mul(start, Sub(Set<V>(1.0f), t)), Mul(end, t));
+            }
+
+            template <typename V>
+            inline void Attract(V px, V py, V pz, V& vx, V& vy, V& vz, const AttractorData& attractor, float delta)
+            {
+                const float invRadius = 1.0f / attractor.radius;
+                const float impulse = attractor.strength * delta;
+
+                // Vector from particle to attractor
+                V dx = Sub(Set<V>(attractor.position.x), px);
+                V dy = Sub(Set<V>(attractor.position.y), py);
+                V dz = Sub(Set<V>(attractor.position.z), pz);
+                V distance = Sqrt(Add(Add(Mul(dx, dx), Mul(dy, dy)), Mul(dz, dz)));
+
+                // Only particles within the radius (and not exactly on the attractor) are affected
+                auto mask = And(Less(distance, Set<V>(attractor.radius)), Greater(distance, Set<V>(0.0f)));
+
+                // Linear falloff from full strength at the center to zero at the radius
+                V k = Div(Mul(Set<V>(impulse), Sub(Set<V>(1.0f), Mul(distance, Set<V>(invRadius)))), distance);
+
+                vx = Select(mask, Add(vx, Mul(dx, k)), vx);
+                vy = Select(mask, Add(vy, Mul(dy, k)), vy);
+                vz = Select(mask, Add(vz, Mul(dz, k)), vz);
+            }
+
+            template <typename V>
+            inline void AgeLane(int i, float* age, const float* invLifespan, float delta)
+            {
+                Store(age + i, Add(Load<V>(age + i), Mul(Set<V>(delta), Load<V>(invLifespan + i))));
+            }
+
+            template <typename V>
+            inline void LerpLane(int i, float* out, const float* t, float start, float end)
+            {
+                Store(out + i, Lerp(Set<V>(start), Set<V>(end), Load<V>(t + i)));
+            }
+
+            template <typename V>
+            inline void AddScaledLane(int i, float* dst, const float* src, float scale)
+            {
+                Store(dst + i, Add(Load<V>(dst + i), Mul(Load<V>(src + i), Set<V>(scale))));
+            }
+
+            template <typename V>
+            inline void AddLane(int i, float* dst, float value)
+            {
+                Store(dst + i, Add(Load<V>(dst + i), Set<V>(value)));
+            }
+
+            template <typename V>
+            inline void ScaleLane(int i, float* dst, float value)
+            {
+                Store(dst + i, Mul(Load<V>(dst + i), Set<V>(value)));
+            }
+
+            template <typename V>
+            inline void AttractLane(int i, const float* posX, const float* posY, const float* posZ,
+                                    float* velX, float* velY, float* velZ, const AttractorData& attractor, float delta)
+            {
+                V vx = Load<V>(velX + i);
+                V vy = Load<V>(velY + i);
+                V vz = Load<V>(velZ + i);
+                Attract(Load<V>(posX + i), Load<V>(posY + i), Load<V>(posZ + i), vx, vy, vz, attractor, delta);
+                Store(velX + i, vx);
+                Store(velY + i, vy);
+                Store(velZ + i, vz);
+            }
+
+            // Lane type of each width, so bounds are declared by width rather than by naming the
+            // SIMD register type as a template argument, which would drop its attributes
+            template <int Width> struct LaneType;
+            template <> struct LaneType<1> { typedef float Type; };
+#if defined(PHI_PARTICLE_KERNELS_AVX) || defined(PHI_PARTICLE_KERNELS_SSE)
+            template <> struct LaneType<WIDTH> { typedef Vec Type; };
+#endif
+
+            // Running position bounds of the lanes of one width
+            // NOTE: Min() and Max() keep the running value when a position is NaN
+            template <int Width>
+            struct LaneBounds
+            {
+                typedef typename LaneType<Width>::Type V;
+
+                V minX = Set<V>(INFINITY), minY = Set<V>(INFINITY), minZ = Set<V>(INFINITY);
+                V maxX = Set<V>(-INFINITY), maxY = Set<V>(-INFINITY), maxZ = Set<V>(-INFINITY);
+
+                void Add(V x, V y, V z)
+                {
+                    minX = Min(x, minX);
+                    minY = Min(y, minY);
+                    minZ = Min(z, minZ);
+                    maxX = Max(x, maxX);
+                    maxY = Max(y, maxY);
+                    maxZ = Max(z, maxZ);
+                }
+
+                // Adds the positions of the lanes not set in the mask
+                template <typename M>
+                void AddUnless(M mask, V x, V y, V z)
+                {
+                    const V inf = Set<V>(INFINITY);
+                    const V negInf = Set<V>(-INFINITY);
+                    minX = Min(Select(mask, inf, x), minX);
+                    minY = Min(Select(mask, inf, y), minY);
+                    minZ = Min(Select(mask, inf, z), minZ);
+                    maxX = Max(Select(mask, negInf, x), maxX);
+                    maxY = Max(Select(mask, negInf, y), maxY);
+                    maxZ = Max(Select(mask, negInf, z), maxZ);
+                }
+            };
+
+            // Bounds of every lane type Run() may call a kernel with
+            struct SimulateBounds
+            {
+                LaneBounds<1> scalar;
+                LaneBounds<1>& Get(float) { return scalar; }
+
+#if defined(PHI_PARTICLE_KERNELS_AVX) || defined(PHI_PARTICLE_KERNELS_SSE)
+                LaneBounds<WIDTH> vector;
+                LaneBounds<WIDTH>& Get(Vec) { return vector; }
+#endif
+
+                // Combines every lane into the final bounds
+                Bounds Reduce() const
+                {
+                    LaneBounds<1> total = scalar;
+#if defined(PHI_PARTICLE_KERNELS_AVX) || defined(PHI_PARTICLE_KERNELS_SSE)
+                    alignas(32) float lanes[6][WIDTH];
+                    Store(lanes[0], vector.minX);
+                    Store(lanes[1], vector.minY);
+                    Store(lanes[2], vector.minZ);
+                    Store(lanes[3], vector.maxX);
+                    Store(lanes[4], vector.maxY);
+                    Store(lanes[5], vector.maxZ);
+                    for (int l = 0; l < WIDTH; ++l)
+                    {
+                        total.minX = Min(lanes[0][l], total.minX);
+                        total.minY = Min(lanes[1][l], total.minY);
+                        total.minZ = Min(lanes[2][l], total.minZ);
+                        total.maxX = Max(lanes[3][l], total.maxX);
+                        total.maxY = Max(lanes[4][l], total.maxY);
+                        total.maxZ = Max(lanes[5][l], total.maxZ);
+                    }
+#endif
+                    Bounds bounds;
+                    bounds.min = glm::vec3(total.minX, total.minY, total.minZ);
+                    bounds.max = glm::vec3(total.maxX, total.maxY, total.maxZ);
+                    return bounds;
+                }
+            };
+
+            template <typename V>
+            inline void BallisticLane(int i, const ParticleData& d, int first, const glm::vec3& acceleration,
+                                      float* outX, float* outY, float* outZ, LaneBounds<sizeof(V) / sizeof(float)>& bounds)
+            {
+                const int j = first + i;
+                V t = Div(Load<V>(d.age.data() + j), Load<V>(d.invLifespan.data() + j));
+                V halfT = Mul(t, Set<V>(0.5f));
+
+                V px = Load<V>(d.posX.data() + j);
+                V py = Load<V>(d.posY.data() + j);
+                V pz = Load<V>(d.posZ.data() + j);
+                Store(outX + i, Add(px, Mul(Add(Load<V>(d.velX.data() + j), Mul(Set<V>(acceleration.x), halfT)), t)));
+                Store(outY + i, Add(py, Mul(Add(Load<V>(d.velY.data() + j), Mul(Set<V>(acceleration.y), halfT)), t)));
+                Store(outZ + i, Add(pz, Mul(Add(Load<V>(d.velZ.data() + j), Mul(Set<V>(acceleration.z), halfT)), t)));
+                bounds.Add(px, py, pz);
+            }
+
+            template <typename V>
+            inline void AgeAndBoundLane(int i, ParticleData& d, int first, float delta, LaneBounds<sizeof(V) / sizeof(float)>& bounds)
+            {
+                const int j = first + i;
+                V age = Add(Load<V>(d.age.data() + j), Mul(Set<V>(delta), Load<V>(d.invLifespan.data() + j)));
+                Store(d.age.data() + j, age);
+                bounds.AddUnless(Greater(age, Set<V>(1.0f)), Load<V>(d.posX.data() + j), Load<V>(d.posY.data() + j), Load<V>(d.posZ.data() + j));
+            }
+
+            // Fused simulation of a single lane
+            template <uint32_t Flags, typename V>
+            inline void SimulateLane(int i, const SimulateParams& p, LaneBounds<sizeof(V) / sizeof(float)>& bounds)
+            {
+                ParticleData& d = *p.particles;
+
+                // Over lifetime effects
+                if constexpr ((Flags & (LerpColor | LerpSize | LerpOpacity)) != 0)
+                {
+                    V t = Load<V>(d.age.data() + i);
+
+                    if constexpr ((Flags & LerpColor) != 0)
+                    {
+                        Store(d.colR.data() + i, Lerp(Set<V>(p.startColor.r), Set<V>(p.endColor.r), t));
+                        Store(d.colG.data() + i, Lerp(Set<V>(p.startColor.g), Set<V>(p.endColor.g), t));
+                        Store(d.colB.data() + i, Lerp(Set<V>(p.startColor.b), Set<V>(p.endColor.b), t));
+                    }
+
+                    if constexpr ((Flags & LerpSize) != 0)
+                    {
+                        Store(d.sizeX.data() + i, Lerp(Set<V>(p.startSize.x), Set<V>(p.endSize.x), t));
+                        Store(d.sizeY.data() + i, Lerp(Set<V>(p.startSize.y), Set<V>(p.endSize.y), t));
+                    }
+
+                    if constexpr ((Flags & LerpOpacity) != 0)
+                    {
+                        Store(d.colA.data() + i, Lerp(Set<V>(p.startOpacity), Set<V>(p.endOpacity), t));
+                    }
+                }
+
+                // Affectors, kept in registers between stages
+                V px = Load<V>(d.posX.data() + i);
+                V py = Load<V>(d.posY.data() + i);
+                V pz = Load<V>(d.posZ.data() + i);
+                V vx = Load<V>(d.velX.data() + i);
+                V vy = Load<V>(d.velY.data() + i);
+                V vz = Load<V>(d.velZ.data() + i);
+
+                if constexpr ((Flags & AddVelocity) != 0)
+                {
+                    px = Add(px, Mul(vx, Set<V>(p.delta)));
+                    py = Add(py, Mul(vy, Set<V>(p.delta)));
+                    pz = Add(pz, Mul(vz, Set<V>(p.delta)));
+                }
+                bounds.Add(px, py, pz);
+
+                if constexpr ((Flags & Gravity) != 0)
+                {
+                    vx = Add(vx, Set<V>(p.gravity.x));
+                    vy = Add(vy, Set<V>(p.gravity.y));
+                    vz = Add(vz, Set<V>(p.gravity.z));
+                }
+
+                for (int a = 0; a < p.attractorCount; ++a)
+                {
+                    Attract(px, py, pz, vx, vy, vz, p.attractors[a], p.delta);
+                }
+
+                if constexpr ((Flags & Damping) != 0)
+                {
+                    vx = Mul(vx, Set<V>(p.damping));
+                    vy = Mul(vy, Set<V>(p.damping));
+                    vz = Mul(vz, Set<V>(p.damping));
+                }
+
+                Store(d.posX.data() + i, px);
+                Store(d.posY.data() + i, py);
+                Store(d.posZ.data() + i, pz);
+                Store(d.velX.data() + i, vx);
+                Store(d.velY.data() + i, vy);
+                Store(d.velZ.data() + i, vz);
+            }
+
+            template <uint32_t Flags>
+            void Simulate(const SimulateParams& p)
+            {
+                SimulateBounds bounds;
+                Run(p.count, [&](auto lane, int i) { SimulateLane<Flags, decltype(lane)>(p.first + i, p, bounds.Get(lane)); });
+                if (p.bounds) *p.bounds = bounds.Reduce();
+            }
+
+            // Table of every fused kernel, indexed by flags
+            template <size_t... I>
+            constexpr std::array<SimulateKernel, sizeof...(I)> MakeSimulateKernels(std::index_sequence<I...>)
+            {
+                return {{&Simulate<(uint32_t)I>...}};
+            }
+
+            constexpr auto SIMULATE_KERNELS = MakeSimulateKernels(std::make_index_sequence<SIMULATE_FLAG_COMBINATIONS>());
+        }
+
+        const char* InstructionSet()
+        {
+#if defined(PHI_PARTICLE_KERNELS_AVX)
+            return "AVX";
+#elif defined(PHI_PARTICLE_KERNELS_SSE)
+            return "SSE2";
+#else
+            return "Scalar";
+#endif
+        }
+
+        // Standalone kernels
+
+        void Age(float* age, const float* invLifespan, float delta, int count)
+        {
+            Run(count, [&](auto lane, int i) { AgeLane<decltype(lane)>(i, age, invLifespan, delta); });
+        }
+
+        void Lerp(float* out, const float* t, float start, float end, int count)
+        {
+            Run(count, [&](auto lane, int i) { LerpLane<decltype(lane)>(i, out, t, start, end); });
+        }
+
+        void AddScaled(float* dst, const float* src, float scale, int count)
+        {
+            Run(count, [&](auto lane, int i) { AddScaledLane<decltype(lane)>(i, dst, src, scale); });
+        }
+
+        void Add(float* dst, float value, int count)
+        {
+            Run(count, [&](auto lane, int i) { AddLane<decltype(lane)>(i, dst, value); });
+        }
+
+        void Scale(float* dst, float value, int count)
+        {
+            Run(count, [&](auto lane, int i) { ScaleLane<decltype(lane)>(i, dst, value); });
+        }
+
+        void Attract(const float* posX, const float* posY, const float* posZ,
+                     float* velX, float* velY, float* velZ,
+                     const glm::vec3& position, float radius, float strength, float delta, int count)
+        {
+            AttractorData attractor{position, radius, strength};
+            Run(count, [&](auto lane, int i) { AttractLane<decltype(lane)>(i, posX, posY, posZ, velX, velY, velZ, attractor, delta); });
+        }
+
+        void Ballistic(const ParticleData& particles, int first, int count, const glm::vec3& acceleration,
+                       float* outX, float* outY, float* outZ, Bounds* startBounds)
+        {
+            SimulateBounds bounds;
+            Run(count, [&](auto lane, int i) { BallisticLane<decltype(lane)>(i, particles, first, acceleration, outX, outY, outZ, bounds.Get(lane)); });
+            if (startBounds) *startBounds = bounds.Reduce();
+        }
+
+        void AgeAndBound(ParticleData& particles, int first, int count, float delta, Bounds& bounds)
+        {
+            SimulateBounds laneBounds;
+            Run(count, [&](auto lane, int i) { AgeAndBoundLane<decltype(lane)>(i, particles, first, delta, laneBounds.Get(lane)); });
+            bounds = laneBounds.Reduce();
+        }
+
+        // Fused kernels
+
+        SimulateKernel GetSimulateKernel(uint32_t flags)
+        {
+            return SIMULATE_KERNELS[flags % SIMULATE_FLAG_COMBINATIONS];
+        }
+
+        // Scalar reference implementations
+
+        void Scalar::Age(float* age, const float* invLifespan, float delta, int count)
+        {
+            RunScalar(count, [&](auto lane, int i) { AgeLane<decltype(lane)>(i, age, invLifespan, delta); });
+        }
+
+        void Scalar::Lerp(float* out, const float* t, float start, float end, int count)
+        {
+            RunScalar(count, [&](auto lane, int i) { LerpLane<decltype(lane)>(i, out, t, start, end); });
+        }
+
+        void Scalar::AddScaled(float* dst, const float* src, float scale, int count)
+        {
+            RunScalar(count, [&](auto lane, int i) { AddScaledLane<decltype(lane)>(i, dst, src, scale); });
+        }
+
+        void Scalar::Add(float* dst, float value, int count)
+        {
+            RunScalar(count, [&](auto lane, int i) { AddLane<decltype(lane)>(i, dst, value); });
+        }
+
+        void Scalar::Scale(float* dst, float value, int count)
+        {
+            RunScalar(count, [&](auto lane, int i) { ScaleLane<decltype(lane)>(i, dst, value); });
+        }
+
+        void Scalar::Attract(const float* posX, const float* posY, const float* posZ,
+                             float* velX, float* velY, float* velZ,
+                             const glm::vec3& position, float radius, float strength, float delta, int count)
+        {
+            AttractorData attractor{position, radius, strength};
+            RunScalar(count, [&](auto lane, int i) { AttractLane<decltype(lane)>(i, posX, posY, posZ, velX, velY, velZ, attractor, delta); });
+        }
+
+        void Scalar::Ballistic(const ParticleData& particles, int first, int count, const glm::vec3& acceleration,
+                               float* outX, float* outY, float* outZ, Bounds* startBounds)
+        {
+            SimulateBounds bounds;
+            RunScalar(count, [&](auto lane, int i) { BallisticLane<decltype(lane)>(i, particles, first, acceleration, outX, outY, outZ, bounds.Get(lane)); });
+            if (startBounds) *startBounds = bounds.Reduce();
+        }
+
+        void Scalar::AgeAndBound(ParticleData& particles, int first, int count, float delta, Bounds& bounds)
+        {
+            SimulateBounds laneBounds;
+            RunScalar(count, [&](auto lane, int i) { AgeAndBoundLane<decltype(lane)>(i, particles, first, delta, laneBounds.Get(lane)); });
+            bounds = laneBounds.Reduce();
+        }
+    }
+}
\ No newline at end of file
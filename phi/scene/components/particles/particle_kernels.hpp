@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "particle_data.hpp"
+
+namespace Phi
+{
+    // Data-parallel kernels used to simulate particle attribute streams
+    //
+    // Every kernel processes count contiguous elements starting at the given pointers.
+    // The instruction set is selected at compile time (AVX, then SSE2, then scalar), and
+    // the vectorized versions perform exactly the same floating point operations in the
+    // same order as the reference implementations in ParticleKernels::Scalar, so both
+    // paths produce bit-identical results
+    //
+    // NOTE: Bit-identical results rely on the compiler not contracting the scalar
+    // path into fused multiply-adds, so this file's translation unit is built with
+    // -ffp-contract=off (see CMakeLists.txt)
+    namespace ParticleKernels
+    {
+        // Returns the name of the instruction set the kernels were compiled with
+        const char* InstructionSet();
+
+        // age[i] += delta * invLifespan[i]
+        void Age(float* age, const float* invLifespan, float delta, int count);
+
+        // out[i] = start * (1 - t[i]) + end * t[i]
+        void Lerp(float* out, const float* t, float start, float end, int count);
+
+        // dst[i] += src[i] * scale
+        void AddScaled(float* dst, const float* src, float scale, int count);
+
+        // dst[i] += value
+        void Add(float* dst, float value, int count);
+
+        // dst[i] *= value
+        void Scale(float* dst, float value, int count);
+
+        // Accelerates velocities towards (or away from, if strength is negative) a single attractor
+        // Particles outside of the attractor's radius or exactly at its position are unaffected
+        void Attract(const float* posX, const float* posY, const float* posZ,
+                     float* velX, float* velY, float* velZ,
+                     const glm::vec3& position, float radius, float strength, float delta, int count);
+
+        // Fused simulation
+
+        // Stages of the fused simulation kernel
+        enum SimulateFlags : uint32_t
+        {
+            LerpColor = 1 << 0,
+            LerpSize = 1 << 1,
+            LerpOpacity = 1 << 2,
+            AddVelocity = 1 << 3,
+            Gravity = 1 << 4,
+            Damping = 1 << 5,
+
+            // Number of distinct flag combinations
+            SIMULATE_FLAG_COMBINATIONS = 1 << 6
+        };
+
+        // Attractor with its final (world or emitter space) position
+        struct AttractorData
+        {
+            glm::vec3 position;
+            float radius;
+            float strength;
+        };
+
+        // Axis-aligned bounds of particle positions, empty (min > max) until a position is added
+        struct Bounds
+        {
+            glm::vec3 min{INFINITY};
+            glm::vec3 max{-INFINITY};
+
+            // Returns true if no position was added
+            bool IsEmpty() const { return min.x > max.x; }
+        };
+
+        // Inputs of the fused simulation kernel
+        // Only the values used by the kernel's stages need to be set
+        // The particles simulated are [first, first + count)
+        struct SimulateParams
+        {
+            ParticleData* particles = nullptr;
+            int first = 0;
+            int count = 0;
+            float delta = 0.0f;
+
+            // Over lifetime endpoints
+            glm::vec3 startColor{0.0f};
+            glm::vec3 endColor{0.0f};
+            glm::vec2 startSize{0.0f};
+            glm::vec2 endSize{0.0f};
+            float startOpacity = 0.0f;
+            float endOpacity = 0.0f;
+
+            // Velocity change from gravity for this update (acceleration * delta)
+            glm::vec3 gravity{0.0f};
+
+            // Velocity scale for this update (1 - damping * delta)
+            float damping = 1.0f;
+
+            // Attractors, always applied (the loop is empty when there are none)
+            const AttractorData* attractors = nullptr;
+            int attractorCount = 0;
+
+            // Receives the bounds of every particle's position after the update, if set
+            // Gathered while the positions are in registers anyway, so it costs no extra pass
+            Bounds* bounds = nullptr;
+        };
+
+        // A simulation kernel specialized for one combination of SimulateFlags
+        typedef void (*SimulateKernel)(const SimulateParams& params);
+
+        // Returns the pre-instantiated kernel for the given flags
+        //
+        // The kernel makes a single pass over the particles, applying every enabled
+        // stage to each particle in turn: over lifetime lerps, velocity integration,
+        // gravity, attractors and damping, and tracks the bounds of the positions. Disabled stages are compiled out, and each
+        // stage performs the same operations as its standalone kernel above, so results
+        // are bit-identical to running the standalone kernels one after another
+        SimulateKernel GetSimulateKernel(uint32_t flags);
+
+        // Analytic evaluation
+
+        // Positions of count particles starting at index first, moving at a constant acceleration
+        // out[i] = pos[first + i] + (vel[first + i] + acceleration * t / 2) * t, where t = age / invLifespan
+        // is the particle's age in seconds. Used by analytic emitters, which never integrate positions and
+        // keep the spawn position and velocity instead. Written from index 0 of the outputs, and the bounds
+        // of the spawn positions are returned in startBounds if set
+        void Ballistic(const ParticleData& particles, int first, int count, const glm::vec3& acceleration,
+                       float* outX, float* outY, float* outZ, Bounds* startBounds = nullptr);
+
+        // Ages count particles starting at index first like Age(), and returns the bounds of the positions of the
+        // ones that don't expire (normalized age up to 1). Used by analytic emitters, whose positions aren't
+        // otherwise visited during updates, so the bounds cost no extra pass and never include dead particles
+        void AgeAndBound(ParticleData& particles, int first, int count, float delta, Bounds& bounds);
+
+        // Scalar reference implementations
+        namespace Scalar
+        {
+            void Age(float* age, const float* invLifespan, float delta, int count);
+            void Lerp(float* out, const float* t, float start, float end, int count);
+            void AddScaled(float* dst, const float* src, float scale, int count);
+            void Add(float* dst, float value, int count);
+            void Scale(float* dst, float value, int count);
+            void Attract(const float* posX, const float* posY, const float* posZ,
+                         float* velX, float* velY, float* velZ,
+                         const glm::vec3& position, float radius, float strength, float delta, int count);
+            void Ballistic(const ParticleData& particles, int first, int count, const glm::vec3& acceleration,
+                           float* outX, float* outY, float* outZ, Bounds* startBounds = nullptr);
+            void AgeAndBound(ParticleData& particles, int first, int count, float delta, Bounds& bounds);
+        }
+    }
+}
\ No newline at end of file
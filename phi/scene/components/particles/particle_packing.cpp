@@ -0,0 +1,211 @@
+#include "particle_packing.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <xmmintrin.h>
+    #include <emmintrin.h>
+    #define PHI_PARTICLE_PACKING_SSE
+#endif
+
+namespace Phi
+{
+    namespace ParticlePacking
+    {
+#if defined(PHI_PARTICLE_PACKING_SSE)
+        namespace
+        {
+            // Four lane versions of ToHalf(), ToIntensity() and ToRGBA8(), with exactly the same integer arithmetic
+            // Magnitudes never have the sign bit set, so signed comparisons are safe
+
+            inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+            {
+                return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+            }
+
+            inline __m128i ToHalf4(__m128 value)
+            {
+                __m128i bits = _mm_castps_si128(value);
+                __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+                __m128i magnitude = _mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF));
+
+                magnitude = Select(_mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x477FE000)), _mm_set1_epi32(0x477FE000), magnitude);
+                magnitude = _mm_andnot_si128(_mm_cmplt_epi32(magnitude, _mm_set1_epi32(0x38800000)), _mm_sub_epi32(magnitude, _mm_set1_epi32(0x38000000)));
+
+                __m128i odd = _mm_and_si128(_mm_srli_epi32(magnitude, 13), _mm_set1_epi32(1));
+                return _mm_or_si128(sign, _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(magnitude, _mm_set1_epi32(0x0FFF)), odd), 13));
+            }
+
+            // FromHalf() for the normal halves ToIntensity4() produces
+            inline __m128 FromIntensity4(__m128i intensity)
+            {
+                return _mm_castsi128_ps(_mm_add_epi32(_mm_slli_epi32(intensity, 13), _mm_set1_epi32(0x38000000)));
+            }
+
+            inline __m128i ToIntensity4(__m128 r, __m128 g, __m128 b)
+            {
+                __m128 maximum = _mm_max_ps(_mm_max_ps(r, g), _mm_max_ps(b, _mm_set1_ps(1.0f)));
+                __m128i intensity = ToHalf4(maximum);
+                __m128i roundUp = _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(FromIntensity4(intensity), maximum)),
+                                                _mm_cmplt_epi32(intensity, _mm_set1_epi32(0x7BFF)));
+                return _mm_sub_epi32(intensity, roundUp);
+            }
+
+            inline __m128i ToChannel4(__m128 c)
+            {
+                c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+            }
+        }
+#endif
+
+        uint16_t ToHalf(float value)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            uint32_t sign = (bits >> 16) & 0x8000;
+            uint32_t magnitude = bits & 0x7FFFFFFF;
+
+            // Clamp to 65504 (also catches infinity and NaN), flush below 2^-14 to zero,
+            // and rebias the exponent from 127 to 15
+            magnitude = magnitude > 0x477FE000 ? 0x477FE000 : magnitude;
+            magnitude = magnitude < 0x38800000 ? 0 : magnitude - 0x38000000;
+
+            // Round the 23 bit mantissa to 10 bits, ties to even
+            return (uint16_t)(sign | ((magnitude + 0x0FFF + ((magnitude >> 13) & 1)) >> 13));
+        }
+
+        float FromHalf(uint16_t value)
+        {
+            uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+            uint32_t magnitude = value & 0x7FFF;
+
+            // Only normal halves are ever produced by ToHalf(), zero is the one special case
+            uint32_t bits = sign | (magnitude ? (magnitude << 13) + 0x38000000 : 0);
+            float result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        uint32_t ToRGBA8(float r, float g, float b, float a)
+        {
+            auto channel = [](float c) { return (uint32_t)(glm::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f); };
+            return channel(r) | (channel(g) << 8) | (channel(b) << 16) | (channel(a) << 24);
+        }
+
+        uint16_t ToIntensity(float r, float g, float b)
+        {
+            // Same comparisons as _mm_max_ps() in the four lane version, so NaNs resolve identically
+            float rg = r > g ? r : g;
+            float b1 = b > 1.0f ? b : 1.0f;
+            float maximum = rg > b1 ? rg : b1;
+
+            // Round up rather than to nearest, so no component ends up above 1 once divided by it
+            uint16_t intensity = ToHalf(maximum);
+            return FromHalf(intensity) < maximum && intensity < 0x7BFF ? intensity + 1 : intensity;
+        }
+
+        glm::vec3 Anchor(const ParticleData& particles, int first, int count)
+        {
+            if (count < 1) return glm::vec3(0.0f);
+
+            const float* posX = particles.posX.data() + first;
+            const float* posY = particles.posY.data() + first;
+            const float* posZ = particles.posZ.data() + first;
+            float minX = posX[0], minY = posY[0], minZ = posZ[0];
+            float maxX = minX, maxY = minY, maxZ = minZ;
+            for (int i = 1; i < count; ++i)
+            {
+                minX = posX[i] < minX ? posX[i] : minX;
+                minY = posY[i] < minY ? posY[i] : minY;
+                minZ = posZ[i] < minZ ? posZ[i] : minZ;
+                maxX = posX[i] > maxX ? posX[i] : maxX;
+                maxY = posY[i] > maxY ? posY[i] : maxY;
+                maxZ = posZ[i] > maxZ ? posZ[i] : maxZ;
+            }
+
+            return glm::vec3(minX + maxX, minY + maxY, minZ + maxZ) * 0.5f;
+        }
+
+        void Pack(PackedParticle* dst, const ParticleData& particles, int first, int count,
+                  const glm::vec3& anchor, const uint32_t* order)
+        {
+            int j = 0;
+
+#if defined(PHI_PARTICLE_PACKING_SSE)
+            // Four particles at a time, each field is built for all four and then
+            // transposed so every particle is written as a single 16 byte store
+            const __m128 anchorX = _mm_set1_ps(anchor.x);
+            const __m128 anchorY = _mm_set1_ps(anchor.y);
+            const __m128 anchorZ = _mm_set1_ps(anchor.z);
+            auto gather = [&](const ParticleData::Stream& stream, int j)
+            {
+                if (!order) return _mm_loadu_ps(stream.data() + first + j);
+                const float* s = stream.data() + first;
+                return _mm_setr_ps(s[order[j]], s[order[j + 1]], s[order[j + 2]], s[order[j + 3]]);
+            };
+
+            for (; j + 4 <= count; j += 4)
+            {
+                __m128i posX = ToHalf4(_mm_sub_ps(gather(particles.posX, j), anchorX));
+                __m128i posY = ToHalf4(_mm_sub_ps(gather(particles.posY, j), anchorY));
+                __m128i posZ = ToHalf4(_mm_sub_ps(gather(particles.posZ, j), anchorZ));
+                __m128i sizeX = ToHalf4(gather(particles.sizeX, j));
+                __m128i sizeY = ToHalf4(gather(particles.sizeY, j));
+                __m128 colR = gather(particles.colR, j);
+                __m128 colG = gather(particles.colG, j);
+                __m128 colB = gather(particles.colB, j);
+                __m128i intensity = ToIntensity4(colR, colG, colB);
+                __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), FromIntensity4(intensity));
+                __m128i color = _mm_or_si128(
+                    _mm_or_si128(ToChannel4(_mm_mul_ps(colR, scale)), _mm_slli_epi32(ToChannel4(_mm_mul_ps(colG, scale)), 8)),
+                    _mm_or_si128(_mm_slli_epi32(ToChannel4(_mm_mul_ps(colB, scale)), 16), _mm_slli_epi32(ToChannel4(gather(particles.colA, j)), 24)));
+
+                // Words of the packed layout, then one row per particle
+                __m128 words[4] =
+                {
+                    _mm_castsi128_ps(_mm_or_si128(posX, _mm_slli_epi32(posY, 16))),
+                    _mm_castsi128_ps(_mm_or_si128(posZ, _mm_slli_epi32(intensity, 16))),
+                    _mm_castsi128_ps(_mm_or_si128(sizeX, _mm_slli_epi32(sizeY, 16))),
+                    _mm_castsi128_ps(color)
+                };
+                _MM_TRANSPOSE4_PS(words[0], words[1], words[2], words[3]);
+                for (int lane = 0; lane < 4; ++lane) _mm_storeu_ps((float*)(dst + j + lane), words[lane]);
+            }
+#endif
+
+            // Each particle is assembled locally and stored whole, since the destination
+            // is usually write-combined mapped memory
+            for (; j < count; ++j)
+            {
+                int i = first + (order ? order[j] : j);
+                PackedParticle particle;
+                particle.position[0] = ToHalf(particles.posX[i] - anchor.x);
+                particle.position[1] = ToHalf(particles.posY[i] - anchor.y);
+                particle.position[2] = ToHalf(particles.posZ[i] - anchor.z);
+                particle.intensity = ToIntensity(particles.colR[i], particles.colG[i], particles.colB[i]);
+                particle.size[0] = ToHalf(particles.sizeX[i]);
+                particle.size[1] = ToHalf(particles.sizeY[i]);
+                float scale = 1.0f / FromHalf(particle.intensity);
+                particle.color = ToRGBA8(particles.colR[i] * scale, particles.colG[i] * scale, particles.colB[i] * scale, particles.colA[i]);
+                dst[j] = particle;
+            }
+        }
+
+        glm::vec3 UnpackPosition(const PackedParticle& particle, const glm::vec3& anchor)
+        {
+            return anchor + glm::vec3(FromHalf(particle.position[0]), FromHalf(particle.position[1]), FromHalf(particle.position[2]));
+        }
+
+        glm::vec2 UnpackSize(const PackedParticle& particle)
+        {
+            return glm::vec2(FromHalf(particle.size[0]), FromHalf(particle.size[1]));
+        }
+
+        glm::vec4 UnpackColor(const PackedParticle& particle)
+        {
+            glm::vec4 color = glm::vec4(particle.color & 0xFF, (particle.color >> 8) & 0xFF, (particle.color >> 16) & 0xFF, particle.color >> 24) / 255.0f;
+            return glm::vec4(glm::vec3(color) * FromHalf(particle.intensity), color.a);
+        }
+    }
+}
\ No newline at end of file
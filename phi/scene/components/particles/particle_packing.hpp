@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include <phi/scene/components/particles/particle_data.hpp>
+
+namespace Phi
+{
+    // Compact per-particle render format, 16 bytes instead of the 56 of the full simulation state
+    //
+    // Positions are half floats relative to an anchor (the center of the packed particles' bounds),
+    // which the renderer folds back into the emitter's transform, so precision depends only on the
+    // extent of the particles and not on where they are. Half floats have 11 significant bits, so
+    // the position error is at most extent / 4096 along each axis
+    //
+    // Colors are HDR: RGB is stored divided by the half float intensity (the largest of the
+    // components and 1, rounded up), which the renderer multiplies back in, so the error of
+    // each component is at most about intensity / 510
+    struct PackedParticle
+    {
+        uint16_t position[3];
+        uint16_t intensity;
+        uint16_t size[2];
+        uint32_t color;
+    };
+    static_assert(sizeof(PackedParticle) == 16, "PackedParticle must stay tightly packed");
+
+    // Conversion between simulation state and the packed render format
+    //
+    // Nothing here touches OpenGL, so packing can be run and verified without a context
+    namespace ParticlePacking
+    {
+        // Converts a float to a half float, rounding to nearest even
+        // Values beyond the half range are clamped to the largest finite half, and values
+        // below the smallest normal half are flushed to zero
+        uint16_t ToHalf(float value);
+
+        // Converts a half float back to a float
+        float FromHalf(uint16_t value);
+
+        // Packs a color with components in [0, 1] into RGBA8, red in the lowest byte
+        // Components outside of [0, 1] are clamped
+        uint32_t ToRGBA8(float r, float g, float b, float a);
+
+        // Returns the half float intensity an HDR color is packed with, see PackedParticle
+        uint16_t ToIntensity(float r, float g, float b);
+
+        // Returns the center of the bounds of count particles starting at index first
+        glm::vec3 Anchor(const ParticleData& particles, int first, int count);
+
+        // Packs count particles starting at index first, with positions relative to anchor
+        // Particles are written in the given order of indices (relative to first) if one is provided
+        void Pack(PackedParticle* dst, const ParticleData& particles, int first, int count,
+                  const glm::vec3& anchor, const uint32_t* order = nullptr);
+
+        // Unpacking, for verification
+        glm::vec3 UnpackPosition(const PackedParticle& particle, const glm::vec3& anchor);
+        glm::vec2 UnpackSize(const PackedParticle& particle);
+        glm::vec4 UnpackColor(const PackedParticle& particle);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "particle_sorter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Phi
+{
+    ParticleSorter::ParticleSorter()
+    {
+    }
+
+    ParticleSorter::~ParticleSorter()
+    {
+    }
+
+    float ParticleSorter::Sort(const float* posX, const float* posY, const float* posZ, int count, const glm::mat4& modelView)
+    {
+        if (count < 1) return 0.0f;
+
+        // Ensure scratch space
+        if ((int)order.size() < count)
+        {
+            depths.resize(count);
+            keys.resize(count);
+            keysTemp.resize(count);
+            order.resize(count);
+            orderTemp.resize(count);
+        }
+
+        // View space depth is the negated z component (the camera looks down -z)
+        const float zx = -modelView[0][2];
+        const float zy = -modelView[1][2];
+        const float zz = -modelView[2][2];
+        const float zw = -modelView[3][2];
+
+        float minDepth = INFINITY;
+        float maxDepth = -INFINITY;
+        float totalDepth = 0.0f;
+        for (int i = 0; i < count; ++i)
+        {
+            float depth = zx * posX[i] + zy * posY[i] + zz * posZ[i] + zw;
+            depths[i] = depth;
+            minDepth = std::min(minDepth, depth);
+            maxDepth = std::max(maxDepth, depth);
+            totalDepth += depth;
+        }
+
+        // Quantize so the furthest particle gets key 0, and histogram both key bytes in the same pass
+        const float scale = (maxDepth > minDepth) ? 65535.0f / (maxDepth - minDepth) : 0.0f;
+        uint32_t lowCounts[256] = {};
+        uint32_t highCounts[256] = {};
+        for (int i = 0; i < count; ++i)
+        {
+            uint16_t key = (uint16_t)((maxDepth - depths[i]) * scale);
+            keys[i] = key;
+            lowCounts[key & 0xFF]++;
+            highCounts[key >> 8]++;
+        }
+
+        // Turn histograms into starting offsets
+        // A pass can be skipped entirely when every key shares the same byte
+        bool sortLow = true, sortHigh = true;
+        uint32_t lowSum = 0, highSum = 0;
+        for (int b = 0; b < 256; ++b)
+        {
+            if (lowCounts[b] == (uint32_t)count) sortLow = false;
+            if (highCounts[b] == (uint32_t)count) sortHigh = false;
+
+            uint32_t low = lowCounts[b];
+            uint32_t high = highCounts[b];
+            lowCounts[b] = lowSum;
+            highCounts[b] = highSum;
+            lowSum += low;
+            highSum += high;
+        }
+
+        // First pass by the low byte, reading the identity order
+        if (sortLow)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                uint16_t key = keys[i];
+                uint32_t dst = lowCounts[key & 0xFF]++;
+                keysTemp[dst] = key;
+                orderTemp[dst] = i;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                keysTemp[i] = keys[i];
+                orderTemp[i] = i;
+            }
+        }
+
+        // Second (stable) pass by the high byte
+        if (sortHigh)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                uint32_t dst = highCounts[keysTemp[i] >> 8]++;
+                order[dst] = orderTemp[i];
+            }
+        }
+        else
+        {
+            std::copy(orderTemp.begin(), orderTemp.begin() + count, order.begin());
+        }
+
+        return totalDepth / count;
+    }
+}
\ No newline at end of file
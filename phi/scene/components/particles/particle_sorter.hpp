@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Phi
+{
+    // Orders particles back to front along the view direction for alpha blending
+    //
+    // Depths are quantized to 16 bit keys over the range of the sorted particles and ordered
+    // with a stable two pass LSD radix sort, so the cost is O(n) regardless of the input order.
+    // Particles closer together than (max depth - min depth) / 65535 may be drawn in either order
+    class ParticleSorter
+    {
+        // Interface
+        public:
+
+            ParticleSorter();
+            ~ParticleSorter();
+
+            // Delete copy constructor/assignment
+            ParticleSorter(const ParticleSorter&) = delete;
+            ParticleSorter& operator=(const ParticleSorter&) = delete;
+
+            // Delete move constructor/assignment
+            ParticleSorter(ParticleSorter&& other) = delete;
+            ParticleSorter& operator=(ParticleSorter&& other) = delete;
+
+            // Sorts count particles back to front as seen through the given model-view matrix
+            // Returns the mean view depth of the particles (larger is further away)
+            float Sort(const float* posX, const float* posY, const float* posZ, int count, const glm::mat4& modelView);
+
+            // Returns the particle indices of the last sort, furthest first
+            const uint32_t* GetOrder() const { return order.data(); }
+
+        // Data / implementation
+        private:
+
+            // Scratch space, grows to the largest sorted count
+            std::vector<float> depths;
+            std::vector<uint16_t> keys;
+            std::vector<uint16_t> keysTemp;
+            std::vector<uint32_t> order;
+            std::vector<uint32_t> orderTemp;
+    };
+}
\ No newline at end of file
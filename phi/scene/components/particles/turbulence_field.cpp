@@ -0,0 +1,282 @@
+#include "turbulence_field.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <xmmintrin.h>
+    #include <emmintrin.h>
+    #define PHI_TURBULENCE_SSE
+#endif
+
+namespace Phi
+{
+    namespace
+    {
+        // Curl samples are interpolated as whole registers where possible,
+        // since the padding makes every corner a single load
+#if defined(PHI_TURBULENCE_SSE)
+        typedef __m128 Corner;
+        inline Corner Load(const glm::vec4* p) { return _mm_loadu_ps(&p->x); }
+        inline Corner Lerp(Corner a, Corner b, float t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t))); }
+        inline glm::vec4 ToVec4(Corner c) { glm::vec4 v; _mm_storeu_ps(&v.x, c); return v; }
+#else
+        typedef glm::vec4 Corner;
+        inline Corner Load(const glm::vec4* p) { return *p; }
+        inline Corner Lerp(Corner a, Corner b, float t) { return a + (b - a) * t; }
+        inline glm::vec4 ToVec4(Corner c) { return c; }
+#endif
+
+        // Trilinear interpolation of the cell whose first corner is c000, rows are contiguous in x
+        inline Corner Trilinear(const glm::vec4* c000, int dy, int dz, float fx, float fy, float fz)
+        {
+            const glm::vec4* c010 = c000 + dy;
+            const glm::vec4* c001 = c000 + dz;
+            const glm::vec4* c011 = c001 + dy;
+            Corner x00 = Lerp(Load(c000), Load(c000 + 1), fx);
+            Corner x10 = Lerp(Load(c010), Load(c010 + 1), fx);
+            Corner x01 = Lerp(Load(c001), Load(c001 + 1), fx);
+            Corner x11 = Lerp(Load(c011), Load(c011 + 1), fx);
+            return Lerp(Lerp(x00, x10, fy), Lerp(x01, x11, fy), fz);
+        }
+    }
+
+    TurbulenceField::TurbulenceField(int seed)
+    {
+        // Independent components, sampled in noise space directly
+        for (int i = 0; i < 3; ++i)
+        {
+            noise[i].SetSeed(seed + i);
+            noise[i].SetFrequency(1.0f);
+        }
+    }
+
+    TurbulenceField::~TurbulenceField()
+    {
+    }
+
+    void TurbulenceField::Cover(const float* posX, const float* posY, const float* posZ, int count, float frequency, const glm::vec3& offset)
+    {
+        if (count < 1 || !(frequency > 0.0f)) return;
+
+        // Every sample depends on the frequency
+        if (frequency != this->frequency)
+        {
+            this->frequency = frequency;
+            level = -1;
+        }
+        this->offset = offset;
+
+        // Bounds of the particles
+        float minX = posX[0], minY = posY[0], minZ = posZ[0];
+        float maxX = minX, maxY = minY, maxZ = minZ;
+        for (int i = 1; i < count; ++i)
+        {
+            minX = posX[i] < minX ? posX[i] : minX;
+            minY = posY[i] < minY ? posY[i] : minY;
+            minZ = posZ[i] < minZ ? posZ[i] : minZ;
+            maxX = posX[i] > maxX ? posX[i] : maxX;
+            maxY = posY[i] > maxY ? posY[i] : maxY;
+            maxZ = posZ[i] > maxZ ? posZ[i] : maxZ;
+        }
+        glm::vec3 boundsMin(minX, minY, minZ);
+        glm::vec3 boundsMax(maxX, maxY, maxZ);
+        if (!std::isfinite(minX + minY + minZ + maxX + maxY + maxZ)) return;
+
+        // Lattice cells touched by the particles at a level, with the same arithmetic as Apply()
+        auto cells = [&](int l, glm::ivec3& lo, glm::ivec3& hi)
+        {
+            float scale = frequency / std::ldexp(1.0f / SAMPLES_PER_UNIT, l);
+            lo = glm::ivec3(glm::floor((boundsMin + offset) * scale));
+            hi = glm::ivec3(glm::floor((boundsMax + offset) * scale)) + 1;
+            glm::ivec3 extent = hi - lo + 1 + 2 * MARGIN;
+            return std::max(extent.x, std::max(extent.y, extent.z));
+        };
+
+        // Use the finest spacing that fits, but only refine once it fits comfortably,
+        // so particles hovering around a threshold don't resample every update
+        glm::ivec3 lo, hi;
+        int newLevel = 0;
+        while (newLevel < MAX_LEVEL && cells(newLevel, lo, hi) > (newLevel < level ? MAX_RESOLUTION * 3 / 4 : MAX_RESOLUTION)) newLevel++;
+        cells(newLevel, lo, hi);
+
+        // Already covered
+        if (newLevel == level && glm::all(glm::greaterThanEqual(lo, origin)) && glm::all(glm::lessThan(hi, origin + size))) return;
+
+        Resample(lo - MARGIN, glm::min(hi - lo + 1 + 2 * MARGIN, glm::ivec3(MAX_RESOLUTION)), newLevel);
+    }
+
+    glm::vec3 TurbulenceField::Sample(const glm::vec3& position) const
+    {
+        // A single particle at rest accelerated for one second
+        glm::vec3 acceleration{0.0f};
+        Apply(&position.x, &position.y, &position.z, &acceleration.x, &acceleration.y, &acceleration.z, 1.0f, 1.0f, 1);
+        return acceleration;
+    }
+
+    void TurbulenceField::Apply(const float* posX, const float* posY, const float* posZ,
+                                float* velX, float* velY, float* velZ, float strength, float delta, int count) const
+    {
+        if (level < 0) return;
+
+        const float scale = frequency / spacing;
+        const float impulse = strength * delta;
+        const int dy = size.x;
+        const int dz = size.x * size.y;
+
+        const glm::vec4* cells = &curl(0, 0, 0);
+        int i = 0;
+
+#if defined(PHI_TURBULENCE_SSE)
+        // Four particles at a time, with the same arithmetic as the scalar loop below
+        const __m128 scale4 = _mm_set1_ps(scale);
+        const __m128 offsetX = _mm_set1_ps(offset.x);
+        const __m128 offsetY = _mm_set1_ps(offset.y);
+        const __m128 offsetZ = _mm_set1_ps(offset.z);
+        const __m128 impulse4 = _mm_set1_ps(impulse);
+        for (; i + 4 <= count; i += 4)
+        {
+            // Continuous lattice coordinates
+            __m128 gx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(posX + i), offsetX), scale4);
+            __m128 gy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(posY + i), offsetY), scale4);
+            __m128 gz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(posZ + i), offsetZ), scale4);
+
+            // Round towards negative infinity (comparison masks are -1 where truncation rounded up)
+            __m128i cx = _mm_cvttps_epi32(gx);
+            __m128i cy = _mm_cvttps_epi32(gy);
+            __m128i cz = _mm_cvttps_epi32(gz);
+            cx = _mm_add_epi32(cx, _mm_castps_si128(_mm_cmplt_ps(gx, _mm_cvtepi32_ps(cx))));
+            cy = _mm_add_epi32(cy, _mm_castps_si128(_mm_cmplt_ps(gy, _mm_cvtepi32_ps(cy))));
+            cz = _mm_add_epi32(cz, _mm_castps_si128(_mm_cmplt_ps(gz, _mm_cvtepi32_ps(cz))));
+
+            // Cells within the region and positions within them
+            alignas(16) int x[4], y[4], z[4];
+            alignas(16) float fx[4], fy[4], fz[4];
+            _mm_store_si128((__m128i*)x, _mm_sub_epi32(cx, _mm_set1_epi32(origin.x)));
+            _mm_store_si128((__m128i*)y, _mm_sub_epi32(cy, _mm_set1_epi32(origin.y)));
+            _mm_store_si128((__m128i*)z, _mm_sub_epi32(cz, _mm_set1_epi32(origin.z)));
+            _mm_store_ps(fx, _mm_sub_ps(gx, _mm_cvtepi32_ps(cx)));
+            _mm_store_ps(fy, _mm_sub_ps(gy, _mm_cvtepi32_ps(cy)));
+            _mm_store_ps(fz, _mm_sub_ps(gz, _mm_cvtepi32_ps(cz)));
+
+            // Each particle's corners are gathered separately, then the results are transposed back into streams
+            __m128 acceleration[4];
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                bool inside = (x[lane] >= 0) & (y[lane] >= 0) & (z[lane] >= 0) & (x[lane] < size.x - 1) & (y[lane] < size.y - 1) & (z[lane] < size.z - 1);
+                acceleration[lane] = inside ? Trilinear(cells + x[lane] + dy * y[lane] + dz * z[lane], dy, dz, fx[lane], fy[lane], fz[lane]) : _mm_setzero_ps();
+            }
+            _MM_TRANSPOSE4_PS(acceleration[0], acceleration[1], acceleration[2], acceleration[3]);
+
+            _mm_storeu_ps(velX + i, _mm_add_ps(_mm_loadu_ps(velX + i), _mm_mul_ps(acceleration[0], impulse4)));
+            _mm_storeu_ps(velY + i, _mm_add_ps(_mm_loadu_ps(velY + i), _mm_mul_ps(acceleration[1], impulse4)));
+            _mm_storeu_ps(velZ + i, _mm_add_ps(_mm_loadu_ps(velZ + i), _mm_mul_ps(acceleration[2], impulse4)));
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            // Continuous lattice coordinates
+            float gx = (posX[i] + offset.x) * scale;
+            float gy = (posY[i] + offset.y) * scale;
+            float gz = (posZ[i] + offset.z) * scale;
+
+            // Round towards negative infinity without a library call
+            int cx = (int)gx - (gx < (float)(int)gx);
+            int cy = (int)gy - (gy < (float)(int)gy);
+            int cz = (int)gz - (gz < (float)(int)gz);
+
+            // Cell within the region and position within it
+            int x = cx - origin.x;
+            int y = cy - origin.y;
+            int z = cz - origin.z;
+
+            // Only particles beyond the coarsest region are left out
+            // NOTE: Bitwise & keeps this a single, well predicted branch
+            bool inside = (x >= 0) & (y >= 0) & (z >= 0) & (x < size.x - 1) & (y < size.y - 1) & (z < size.z - 1);
+            if (!inside) continue;
+
+            glm::vec4 acceleration = ToVec4(Trilinear(cells + x + dy * y + dz * z, dy, dz, gx - (float)cx, gy - (float)cy, gz - (float)cz));
+            velX[i] += acceleration.x * impulse;
+            velY[i] += acceleration.y * impulse;
+            velZ[i] += acceleration.z * impulse;
+        }
+    }
+
+    glm::vec3 TurbulenceField::Evaluate(const glm::vec3& position) const
+    {
+        // Central differences with a step far below the lattice spacing
+        const float h = 1e-3f;
+        glm::vec3 s = (position + offset) * frequency;
+        glm::vec3 dx = (Potential(s + glm::vec3(h, 0.0f, 0.0f)) - Potential(s - glm::vec3(h, 0.0f, 0.0f))) / (2.0f * h);
+        glm::vec3 dy = (Potential(s + glm::vec3(0.0f, h, 0.0f)) - Potential(s - glm::vec3(0.0f, h, 0.0f))) / (2.0f * h);
+        glm::vec3 dz = (Potential(s + glm::vec3(0.0f, 0.0f, h)) - Potential(s - glm::vec3(0.0f, 0.0f, h))) / (2.0f * h);
+        return glm::vec3(dy.z - dz.y, dz.x - dx.z, dx.y - dy.x);
+    }
+
+    void TurbulenceField::Resample(const glm::ivec3& origin, const glm::ivec3& size, int level)
+    {
+        // Potential regions include a border of one lattice point for the central differences
+        const glm::ivec3 oldOrigin = this->origin - 1;
+        const glm::ivec3 oldSize = this->size + 2;
+        const bool reuse = level == this->level;
+
+        std::swap(potential, previousPotential);
+        this->origin = origin;
+        this->size = size;
+        this->level = level;
+        spacing = std::ldexp(1.0f / SAMPLES_PER_UNIT, level);
+
+        // Potential, reusing every lattice point the previous region shares
+        const glm::ivec3 potentialOrigin = origin - 1;
+        const glm::ivec3 potentialSize = size + 2;
+        potential.resize(potentialSize.x * potentialSize.y * potentialSize.z);
+        int index = 0;
+        for (int z = 0; z < potentialSize.z; ++z)
+        {
+            for (int y = 0; y < potentialSize.y; ++y)
+            {
+                for (int x = 0; x < potentialSize.x; ++x, ++index)
+                {
+                    glm::ivec3 lattice = potentialOrigin + glm::ivec3(x, y, z);
+                    glm::ivec3 old = lattice - oldOrigin;
+                    if (reuse && glm::all(glm::greaterThanEqual(old, glm::ivec3(0))) && glm::all(glm::lessThan(old, oldSize)))
+                    {
+                        potential[index] = previousPotential[old.x + oldSize.x * (old.y + oldSize.y * old.z)];
+                    }
+                    else
+                    {
+                        potential[index] = Potential(glm::vec3(lattice) * spacing);
+                        evaluatedSamples++;
+                    }
+                }
+            }
+        }
+
+        // Curl by central differences over the lattice, in noise space units
+        const float scale = 0.5f / spacing;
+        const int sx = 1;
+        const int sy = potentialSize.x;
+        const int sz = potentialSize.x * potentialSize.y;
+        curl.Resize(size.x, size.y, size.z);
+        for (int z = 0; z < size.z; ++z)
+        {
+            for (int y = 0; y < size.y; ++y)
+            {
+                for (int x = 0; x < size.x; ++x)
+                {
+                    int c = (x + 1) + sy * (y + 1) + sz * (z + 1);
+                    glm::vec3 dx = (potential[c + sx] - potential[c - sx]) * scale;
+                    glm::vec3 dy = (potential[c + sy] - potential[c - sy]) * scale;
+                    glm::vec3 dz = (potential[c + sz] - potential[c - sz]) * scale;
+                    curl(x, y, z) = glm::vec4(dy.z - dz.y, dz.x - dx.z, dx.y - dy.x, 0.0f);
+                }
+            }
+        }
+    }
+
+    glm::vec3 TurbulenceField::Potential(const glm::vec3& position) const
+    {
+        return glm::vec3(noise[0].Sample(position), noise[1].Sample(position), noise[2].Sample(position));
+    }
+}
\ No newline at end of file
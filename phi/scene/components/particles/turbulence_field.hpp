@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <phi/core/math/noise.hpp>
+#include <phi/core/structures/grid_3d.hpp>
+
+namespace Phi
+{
+    // Divergence-free turbulence from the curl of a 3D noise vector potential
+    //
+    // The potential is sampled on a lattice in noise space (position * frequency) with
+    // SAMPLES_PER_UNIT samples per unit, and its curl is taken by central differences, so the
+    // whole field costs three noise evaluations per lattice point instead of twelve per particle.
+    // Only the lattice region covering the particles is kept, and when the particles (or the
+    // scrolling offset) move past it, lattice points shared with the previous region are reused
+    // and only the new ones are evaluated. Lattice values don't depend on the region, so results
+    // are the same however the region moved. Particles are then moved with one trilinear fetch each
+    class TurbulenceField
+    {
+        // Interface
+        public:
+
+            TurbulenceField(int seed = 0);
+            ~TurbulenceField();
+
+            // Delete copy constructor/assignment
+            TurbulenceField(const TurbulenceField&) = delete;
+            TurbulenceField& operator=(const TurbulenceField&) = delete;
+
+            // Delete move constructor/assignment
+            TurbulenceField(TurbulenceField&& other) = delete;
+            TurbulenceField& operator=(TurbulenceField&& other) = delete;
+
+            // Ensures the field covers count particles, sampling the noise at (position + offset) * frequency
+            // Moving the offset over time scrolls the flow pattern through the particles
+            void Cover(const float* posX, const float* posY, const float* posZ, int count, float frequency, const glm::vec3& offset);
+
+            // Returns the interpolated curl at the given position, which must be covered
+            glm::vec3 Sample(const glm::vec3& position) const;
+
+            // Accelerates count covered particles by the interpolated curl times strength over delta seconds
+            void Apply(const float* posX, const float* posY, const float* posZ,
+                       float* velX, float* velY, float* velZ, float strength, float delta, int count) const;
+
+            // Returns the curl of the noise potential at a position, differentiated directly instead of through the lattice
+            glm::vec3 Evaluate(const glm::vec3& position) const;
+
+            // Returns the number of lattice points evaluated so far
+            long long GetEvaluatedSamples() const { return evaluatedSamples; }
+
+        // Data / implementation
+        private:
+
+            // One noise instance per potential component
+            Noise noise[3];
+
+            // Noise space mapping
+            float frequency = 0.0f;
+            glm::vec3 offset{0.0f};
+
+            // Lattice spacing in noise space, doubled per level when the particles spread too far
+            int level = -1;
+            float spacing = 1.0f;
+
+            // Curl samples at lattice points [origin, origin + size)
+            // NOTE: Padded to four floats so every corner is a single vector load in Apply()
+            glm::ivec3 origin{0};
+            glm::ivec3 size{0};
+            Grid3D<glm::vec4> curl{1, 1, 1, glm::vec4(0.0f)};
+
+            // Potential samples at lattice points [origin - 1, origin + size + 1), and the previous region's for reuse
+            std::vector<glm::vec3> potential;
+            std::vector<glm::vec3> previousPotential;
+
+            long long evaluatedSamples = 0;
+
+            // Lattice samples per noise space unit at level 0
+            static constexpr float SAMPLES_PER_UNIT = 8.0f;
+
+            // Lattice points kept beyond the particles on each side, so small movements don't resample
+            static const int MARGIN = 2;
+
+            // Maximum curl samples along each axis, and the number of times the spacing may double to stay below it
+            static const int MAX_RESOLUTION = 48;
+            static const int MAX_LEVEL = 8;
+
+            // Moves the lattice region to [origin, origin + size) at the given level
+            void Resample(const glm::ivec3& origin, const glm::ivec3& size, int level);
+
+            // Returns the potential at a noise space position
+            glm::vec3 Potential(const glm::vec3& position) const;
+    };
+}
\ No newline at end of file
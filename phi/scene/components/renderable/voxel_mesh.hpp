@@ -25,6 +25,9 @@ namespace Phi
             // Constants
             static inline const size_t MAX_VOXELS = 1'048'576;
 
+            // Material of vertices that draw nothing, for keeping slots of removed voxels
+            static inline const int16_t HIDDEN_MATERIAL = -2;
+
             // Vertex format
             struct Vertex
             {
@@ -0,0 +1,156 @@
+#include "voxel_bricks.hpp"
+
+#include <algorithm>
+
+namespace Phi
+{
+    VoxelBricks::VoxelBricks(int width, int height, int depth)
+    {
+        Resize(width, height, depth);
+    }
+
+    VoxelBricks::~VoxelBricks()
+    {
+    }
+
+    void VoxelBricks::Set(int x, int y, int z, int16_t material, uint16_t flags)
+    {
+        int& b = table[BrickIndex(x, y, z)];
+        if (b == -1)
+        {
+            Brick brick{};
+            brick.origin = glm::ivec3(x, y, z) & ~BRICK_MASK;
+            b = bricks.Insert(brick);
+        }
+
+        Brick& brick = bricks[b];
+        int i = VoxelIndex(x, y, z);
+        if (!brick.IsSet(i))
+        {
+            brick.occupancy[i >> 6] |= uint64_t(1) << (i & 63);
+            brick.count++;
+            count++;
+        }
+        brick.materials[i] = material;
+        brick.flags[i] = flags;
+    }
+
+    bool VoxelBricks::Erase(int x, int y, int z)
+    {
+        int& b = table[BrickIndex(x, y, z)];
+        if (b == -1) return false;
+
+        Brick& brick = bricks[b];
+        int i = VoxelIndex(x, y, z);
+        if (!brick.IsSet(i)) return false;
+
+        brick.occupancy[i >> 6] &= ~(uint64_t(1) << (i & 63));
+        count--;
+        if (--brick.count == 0)
+        {
+            bricks.Erase(b);
+            b = -1;
+        }
+        return true;
+    }
+
+    bool VoxelBricks::IsEnclosed(int x, int y, int z) const
+    {
+        if (x <= 0 || y <= 0 || z <= 0 || x >= width - 1 || y >= height - 1 || z >= depth - 1) return false;
+        return IsSolid(x, y, z) && IsSolid(x - 1, y, z) && IsSolid(x + 1, y, z) && IsSolid(x, y - 1, z) &&
+               IsSolid(x, y + 1, z) && IsSolid(x, y, z - 1) && IsSolid(x, y, z + 1);
+    }
+
+    void VoxelBricks::GetEnclosed(int id, uint64_t enclosed[BRICK_SIZE]) const
+    {
+        // Bits of the voxels at x = 0 and y = 0 of a slice
+        const uint64_t FIRST_COLUMN = 0x0101010101010101ull;
+        const uint64_t FIRST_ROW = 0xFFull;
+        const int ROW_SHIFT = BRICK_SIZE * (BRICK_SIZE - 1);
+
+        // Occupancy of the six neighbouring bricks, empty where there are none
+        const Brick& brick = bricks[id];
+        const uint64_t empty[BRICK_SIZE] = {};
+        const uint64_t* neighbours[6];
+        const glm::ivec3 directions[6] = { {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1} };
+        for (int d = 0; d < 6; ++d)
+        {
+            glm::ivec3 n = brick.origin + directions[d] * BRICK_SIZE;
+            bool inside = n.x >= 0 && n.y >= 0 && n.z >= 0 && n.x < width && n.y < height && n.z < depth;
+            int b = inside ? table[BrickIndex(n.x, n.y, n.z)] : -1;
+            neighbours[d] = b != -1 ? bricks[b].occupancy : empty;
+        }
+
+        // Shift each slice against itself for neighbours within it, and take the edges from the neighbouring bricks
+        for (int z = 0; z < BRICK_SIZE; ++z)
+        {
+            const uint64_t slice = brick.occupancy[z];
+            const uint64_t left = ((slice << 1) & ~FIRST_COLUMN) | ((neighbours[0][z] >> (BRICK_SIZE - 1)) & FIRST_COLUMN);
+            const uint64_t right = ((slice >> 1) & ~(FIRST_COLUMN << (BRICK_SIZE - 1))) | ((neighbours[1][z] & FIRST_COLUMN) << (BRICK_SIZE - 1));
+            const uint64_t below = (slice << BRICK_SIZE) | (neighbours[2][z] >> ROW_SHIFT);
+            const uint64_t above = (slice >> BRICK_SIZE) | ((neighbours[3][z] & FIRST_ROW) << ROW_SHIFT);
+            const uint64_t back = z > 0 ? brick.occupancy[z - 1] : neighbours[4][BRICK_SIZE - 1];
+            const uint64_t front = z < BRICK_SIZE - 1 ? brick.occupancy[z + 1] : neighbours[5][0];
+            enclosed[z] = slice & left & right & below & above & back & front;
+        }
+    }
+
+    bool VoxelBricks::GetBounds(glm::ivec3& min, glm::ivec3& max) const
+    {
+        min = glm::ivec3(width, height, depth);
+        max = glm::ivec3(-1);
+        for (int b : table)
+        {
+            if (b == -1) continue;
+
+            // Fold the brick's bits onto each axis, slices give z, rows of all slices y, and bits of all rows x
+            const Brick& brick = bricks[b];
+            uint64_t slices = 0;
+            int zBits = 0;
+            for (int z = 0; z < BRICK_SIZE; ++z)
+            {
+                slices |= brick.occupancy[z];
+                zBits |= (brick.occupancy[z] != 0) << z;
+            }
+
+            int xBits = 0, yBits = 0;
+            for (int y = 0; y < BRICK_SIZE; ++y)
+            {
+                int row = (int)((slices >> (y * BRICK_SIZE)) & 0xFF);
+                xBits |= row;
+                yBits |= (row != 0) << y;
+            }
+
+            // Bricks are never empty, so every axis has a bit set
+            auto lowest = [](int bits) { int i = 0; while (!(bits & (1 << i))) i++; return i; };
+            auto highest = [](int bits) { int i = BRICK_SIZE - 1; while (!(bits & (1 << i))) i--; return i; };
+            min = glm::min(min, brick.origin + glm::ivec3(lowest(xBits), lowest(yBits), lowest(zBits)));
+            max = glm::max(max, brick.origin + glm::ivec3(highest(xBits), highest(yBits), highest(zBits)));
+        }
+        return count > 0;
+    }
+
+    void VoxelBricks::Clear()
+    {
+        std::fill(table.begin(), table.end(), -1);
+        bricks.Clear();
+        count = 0;
+    }
+
+    void VoxelBricks::Resize(int width, int height, int depth)
+    {
+        this->width = width;
+        this->height = height;
+        this->depth = depth;
+        bricksPerAxis = (glm::ivec3(width, height, depth) + BRICK_MASK) >> BRICK_SHIFT;
+        table.assign(bricksPerAxis.x * bricksPerAxis.y * bricksPerAxis.z, -1);
+        bricks.Clear();
+        count = 0;
+    }
+
+    size_t VoxelBricks::GetMemoryUsage() const
+    {
+        // Each brick is stored with the index of the next free one
+        return table.capacity() * sizeof(int) + bricks.Size() * (sizeof(Brick) + sizeof(int));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <phi/core/structures/free_list.hpp>
+
+namespace Phi
+{
+    // Sparse storage for the voxels of a bounded grid
+    //
+    // The grid is split into bricks of 8x8x8 voxels, which are only allocated once a voxel is set in
+    // them and freed again once they are empty. Each brick holds one occupancy bit per voxel and the
+    // material and flags of every voxel, and a dense table with an entry per brick maps positions to
+    // bricks. Empty space costs 4 bytes per brick instead of per voxel, and positions are implied by
+    // where voxels are stored instead of being stored with them. All positions are grid-local, in
+    // [0, width) x [0, height) x [0, depth), and are not bounds checked
+    class VoxelBricks
+    {
+        // Interface
+        public:
+
+            static const int BRICK_SHIFT = 3;
+            static const int BRICK_SIZE = 1 << BRICK_SHIFT;
+            static const int BRICK_MASK = BRICK_SIZE - 1;
+            static const int BRICK_VOXELS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+            // A single brick of voxels
+            struct Brick
+            {
+                // Grid position of the brick's first voxel
+                glm::ivec3 origin{0};
+
+                // Number of voxels set
+                int count = 0;
+
+                // One bit per voxel, bit x + 8 * y of word z
+                uint64_t occupancy[BRICK_SIZE] = {};
+
+                // Material and flags of each voxel, only meaningful where the occupancy bit is set
+                int16_t materials[BRICK_VOXELS];
+                uint16_t flags[BRICK_VOXELS];
+
+                // Returns true if the voxel at the given index is set
+                inline bool IsSet(int i) const { return (occupancy[i >> 6] >> (i & 63)) & 1; }
+
+                // Calls fn(i) for the index of every voxel set, in ascending order
+                template <typename F>
+                void ForEachVoxel(F&& fn) const;
+            };
+
+            VoxelBricks(int width, int height, int depth);
+            ~VoxelBricks();
+
+            // Delete copy constructor/assignment
+            VoxelBricks(const VoxelBricks&) = delete;
+            VoxelBricks& operator=(const VoxelBricks&) = delete;
+
+            // Delete move constructor/assignment
+            VoxelBricks(VoxelBricks&& other) = delete;
+            VoxelBricks& operator=(VoxelBricks&& other) = delete;
+
+            // Data access
+
+            // Returns true if a voxel is set at the given position
+            inline bool IsSolid(int x, int y, int z) const
+            {
+                int brick = table[BrickIndex(x, y, z)];
+                return brick != -1 && bricks[brick].IsSet(VoxelIndex(x, y, z));
+            }
+
+            // Returns the material of the voxel at the given position, or -1 if it is empty
+            inline int16_t GetMaterial(int x, int y, int z) const
+            {
+                int brick = table[BrickIndex(x, y, z)];
+                int i = VoxelIndex(x, y, z);
+                return brick != -1 && bricks[brick].IsSet(i) ? bricks[brick].materials[i] : -1;
+            }
+
+            // Returns the flags of the voxel at the given position, or 0 if it is empty
+            inline uint16_t GetFlags(int x, int y, int z) const
+            {
+                int brick = table[BrickIndex(x, y, z)];
+                int i = VoxelIndex(x, y, z);
+                return brick != -1 && bricks[brick].IsSet(i) ? bricks[brick].flags[i] : 0;
+            }
+
+            // Calls fn(x, y, z, material, flags) for every voxel, brick by brick in grid order
+            template <typename F>
+            void ForEach(F&& fn) const;
+
+            // Returns true if a voxel is set at the given position and at all six positions next to it
+            bool IsEnclosed(int x, int y, int z) const;
+
+            // Sets enclosed to the voxels of a brick that are enclosed on all six sides, in the layout of occupancy
+            void GetEnclosed(int id, uint64_t enclosed[BRICK_SIZE]) const;
+
+            // Sets min and max to the smallest and largest positions of any voxel, returns false if there are none
+            bool GetBounds(glm::ivec3& min, glm::ivec3& max) const;
+
+            // Brick access
+
+            // Returns the id of the brick containing the given position, or -1 if none is allocated
+            inline int FindBrick(int x, int y, int z) const { return table[BrickIndex(x, y, z)]; }
+
+            // Returns the brick with the given id
+            inline Brick& GetBrick(int id) { return bricks[id]; }
+            inline const Brick& GetBrick(int id) const { return bricks[id]; }
+
+            // Returns true if the brick with the given id is allocated, freed bricks are left empty
+            inline bool IsAllocated(int id) const { return id >= 0 && id < (int)bricks.Size() && bricks[id].count > 0; }
+
+            // Returns one more than the largest brick id in use, for storing data alongside bricks
+            inline int GetBrickSlots() const { return (int)bricks.Size(); }
+
+            // Index of the brick position containing a position, below GetBrickPositions()
+            // Unlike ids, these stay the same while bricks are freed and allocated
+            inline int BrickIndex(int x, int y, int z) const
+            {
+                return (x >> BRICK_SHIFT) + bricksPerAxis.x * ((y >> BRICK_SHIFT) + bricksPerAxis.y * (z >> BRICK_SHIFT));
+            }
+
+            // Returns the number of brick positions in the grid
+            inline int GetBrickPositions() const { return (int)table.size(); }
+
+            // Index of a position within its brick
+            static inline int VoxelIndex(int x, int y, int z)
+            {
+                return (x & BRICK_MASK) + BRICK_SIZE * ((y & BRICK_MASK) + BRICK_SIZE * (z & BRICK_MASK));
+            }
+
+            // Position within its brick of a voxel index
+            static inline glm::ivec3 VoxelPosition(int i)
+            {
+                return glm::ivec3(i & BRICK_MASK, (i >> BRICK_SHIFT) & BRICK_MASK, i >> (2 * BRICK_SHIFT));
+            }
+
+            // Data modification
+
+            // Sets the voxel at the given position, allocating its brick if needed
+            void Set(int x, int y, int z, int16_t material, uint16_t flags = 0);
+
+            // Replaces the flags of the voxel at the given position, which must be set
+            inline void SetFlags(int x, int y, int z, uint16_t flags)
+            {
+                bricks[table[BrickIndex(x, y, z)]].flags[VoxelIndex(x, y, z)] = flags;
+            }
+
+            // Empties the voxel at the given position, freeing its brick once it is empty
+            // Returns false if there was no voxel
+            bool Erase(int x, int y, int z);
+
+            // Removes every voxel and brick
+            void Clear();
+
+            // Resizes the grid and removes every voxel
+            void Resize(int width, int height, int depth);
+
+            // Accessors
+            int GetWidth() const { return width; }
+            int GetHeight() const { return height; }
+            int GetDepth() const { return depth; }
+            size_t GetCount() const { return count; }
+            int GetBrickCount() const { return (int)bricks.Count(); }
+
+            // Returns the number of bytes allocated for the table and bricks
+            size_t GetMemoryUsage() const;
+
+        // Data / implementation
+        private:
+
+            // Grid dimensions, in voxels and in bricks
+            int width, height, depth;
+            glm::ivec3 bricksPerAxis{0};
+
+            // Index of the brick at each brick position, -1 where nothing is allocated
+            std::vector<int> table;
+
+            // Allocated bricks, emptied ones are reused
+            FreeList<Brick> bricks;
+
+            // Number of voxels set
+            size_t count = 0;
+
+            // Index of the lowest set bit of a non-zero word
+            static inline int LowestBit(uint64_t bits)
+            {
+            #if defined(__GNUC__) || defined(__clang__)
+                return __builtin_ctzll(bits);
+            #else
+                int i = 0;
+                while (!(bits & 1)) { bits >>= 1; i++; }
+                return i;
+            #endif
+            }
+    };
+
+    // Template implementation
+
+    template <typename F>
+    void VoxelBricks::Brick::ForEachVoxel(F&& fn) const
+    {
+        for (int word = 0; word < BRICK_SIZE; ++word)
+        {
+            uint64_t bits = occupancy[word];
+            while (bits)
+            {
+                fn(word * 64 + LowestBit(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    template <typename F>
+    void VoxelBricks::ForEach(F&& fn) const
+    {
+        for (int b : table)
+        {
+            if (b == -1) continue;
+
+            const Brick& brick = bricks[b];
+            brick.ForEachVoxel([&](int i)
+            {
+                glm::ivec3 position = brick.origin + VoxelPosition(i);
+                fn(position.x, position.y, position.z, brick.materials[i], brick.flags[i]);
+            });
+        }
+    }
+}
\ No newline at end of file
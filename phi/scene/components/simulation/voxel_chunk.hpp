@@ -35,6 +35,12 @@ namespace Phi
             // Steps the chunk simulation forward by delta seconds
             void Update(float delta);
 
+            // Voxel data access
+
+            // Returns true if the voxel at the chunk local coordinates provided is occupied
+            // NOTE: Does not validate position
+            inline bool IsSolid(int x, int y, int z) const { return voxelGrid(x, y, z) != 0; }
+
         // Data / implementation
         private:
 
@@ -69,6 +69,16 @@ namespace Phi
             // Updates the voxel world with the given elapsed time in seconds
             void Update(float delta);
 
+            // Chunk access
+
+            // Returns the loaded chunk with the given ID, or nullptr if it isn't loaded
+            // Chunk IDs are world voxel coordinates divided by VoxelChunk::CHUNK_DIM, rounded down
+            const VoxelChunk* GetChunk(const glm::ivec3& chunkID) const
+            {
+                auto it = loadedChunks.find(chunkID);
+                return it == loadedChunks.end() ? nullptr : it->second;
+            }
+
         // Data / implementation
         private:
 
@@ -33,7 +33,7 @@ namespace Phi
 
         // Simulation data
         Flags::type flags;
-        float flammability; // 0 = nonflammable, 1 = catches instantly on contact with fire
+        float flammability = 0.0f; // 0 = nonflammable, 1 = catches instantly on contact with fire
 
         // PBR material ID for rendering
         int pbrID;
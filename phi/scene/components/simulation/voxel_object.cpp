@@ -1,12 +1,16 @@
 #include "voxel_object.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
 #include <phi/core/file.hpp>
 #include <phi/scene/node.hpp>
 
 namespace Phi
 {
     VoxelObject::VoxelObject(int width, int height, int depth, const glm::ivec3& offset)
-        : voxelGrid(width, height, depth, -1), offset(offset), flags(Flags::UpdateMesh)
+        : voxels(width, height, depth), offset(offset), flags(Flags::UpdateMesh)
     {
         aabb.min = offset;
         aabb.max = glm::ivec3(width + offset.x, height + offset.y, depth + offset.z);
@@ -16,8 +20,40 @@ namespace Phi
     {
     }
 
+    namespace
+    {
+        // Neighbour offsets, below first so falling takes priority over every other move
+        // Voxels never move up, the remaining directions are tried in this order when moves conflict
+        const glm::ivec3 DIRECTIONS[6] = { {0, -1, 0}, {0, 1, 0}, {-1, 0, 0}, {1, 0, 0}, {0, 0, -1}, {0, 0, 1} };
+        const int BELOW = 0;
+        const int ABOVE = 1;
+
+        // Offsets of the same neighbours within a brick
+        const int NEIGHBOUR_OFFSETS[6] =
+        {
+            -VoxelBricks::BRICK_SIZE, VoxelBricks::BRICK_SIZE, -1, 1,
+            -VoxelBricks::BRICK_SIZE * VoxelBricks::BRICK_SIZE, VoxelBricks::BRICK_SIZE * VoxelBricks::BRICK_SIZE
+        };
+
+        // Positions the random draws of each pass start at in a brick's stream, per tick
+        inline uint64_t StreamPosition(uint64_t tick, int pass) { return (tick << 32) | ((uint64_t)pass << 24); }
+
+        // Vertex of a voxel at an object local position, burning voxels are drawn as fire
+        inline VoxelMesh::Vertex MakeVertex(const glm::ivec3& position, const std::vector<VoxelMaterial>& materials, int16_t material, uint16_t flags)
+        {
+            VoxelMesh::Vertex vertex;
+            vertex.x = position.x;
+            vertex.y = position.y;
+            vertex.z = position.z;
+            vertex.material = (flags & Voxel::Flags::OnFire) ? -1 : materials[material].pbrID;
+            return vertex;
+        }
+    }
+
     void VoxelObject::Update(float delta)
     {
+        UpdateAABB();
+
         // Update timer
         timeAccum += delta;
         if (timeAccum < updateRate) return;
@@ -30,135 +66,374 @@ namespace Phi
         const bool simulateFluids = (flags | Flags::SimulateFluids) == flags;
         const bool simulateFire = (flags | Flags::SimulateFire) == flags;
 
-        // Grab relevant data
-        int empty = voxelGrid.GetEmptyValue();
-        const auto& voxelMaterials = GetNode()->GetScene().GetVoxelMaterials();
+        // Simulate
+        Scene& scene = GetNode()->GetScene();
+        if (simulateFluids || simulateFire) Step(scene.GetVoxelMaterials(), scene.GetSimulationThreadPool());
 
-        // RNG used by the simulation
-        static RNG rng;
+        if (updateMesh && meshDirty) UpdateMesh();
+    }
 
-        // Iterate all voxels
-        for (auto& voxel : voxels)
+    void VoxelObject::Step(const std::vector<VoxelMaterial>& materials, ThreadPool* pool)
+    {
+        // Bricks put to sleep under different flags may have something to do now
+        const Flags::type simulationFlags = flags & (Flags::SimulateFluids | Flags::SimulateFire);
+        if (simulationFlags != simulatedFlags)
         {
-            // Grab material
-            const auto& material = voxelMaterials[voxel.material];
-            const bool isLiquid = (bool)(material.flags & VoxelMaterial::Flags::Liquid);
-            const bool isFire = (bool)(material.flags & VoxelMaterial::Flags::Fire);
-            const bool isOnFire = (bool)(voxel.flags & Voxel::Flags::OnFire);
+            simulatedFlags = simulationFlags;
+            WakeAll();
+        }
+
+        // Bricks woken during this tick are appended, and only simulated from the next one
+        const int simulated = (int)activeBricks.size();
+        auto forEachBrick = [&](const std::function<void(int)>& job)
+        {
+            if (pool) pool->ParallelFor(simulated, job);
+            else for (int i = 0; i < simulated; ++i) job(i);
+        };
+
+        // Every voxel decides what it wants from the state at the start of the tick, then conflicting moves are
+        // settled and fire spreads, then ignitions are applied. Each pass only writes its own brick
+        forEachBrick([&](int i) { DecideMoves(activeBricks[i], materials); });
+        forEachBrick([&](int i) { ResolveMoves(activeBricks[i], materials); });
+        forEachBrick([&](int i) { ApplyIgnitions(activeBricks[i]); });
+
+        // Apply the moves, they can cross bricks and allocate or free them, so this is done serially
+        // Their targets were all empty and are all distinct, so the order doesn't change the result
+        // Waking bricks can grow the states, so they are looked up by id rather than held
+        for (int i = 0; i < simulated; ++i)
+        {
+            const int id = activeBricks[i];
+            const uint8_t brickFlags = simulationBricks[id].resolvedFlags;
+
+            // Voxels that may still catch fire keep their brick and the burning bricks around it awake
+            if (brickFlags & HAS_CANDIDATES)
+            {
+                WakeBrick(id);
+                for (int d = 0; d < 6; ++d) WakeBrick(FindNeighbourBrick(id, d));
+            }
+            if (!(brickFlags & (HAS_MOVES | HAS_IGNITIONS))) continue;
+
+            const glm::ivec3 origin = voxels.GetBrick(id).origin;
+            for (int v = 0; v < VoxelBricks::BRICK_VOXELS; ++v)
+            {
+                const uint8_t resolved = simulationBricks[id].resolved[v];
+                const uint8_t move = simulationBricks[id].voxels[v] & MOVE_MASK;
+                glm::ivec3 from = origin + VoxelBricks::VoxelPosition(v);
+                if (resolved & IGNITES) VoxelChanged(from);
+                if (!(resolved & MOVE_WON)) continue;
+
+                glm::ivec3 to = from + DIRECTIONS[move];
+                int16_t material = voxels.GetMaterial(from.x, from.y, from.z);
+                uint16_t voxelFlags = voxels.GetFlags(from.x, from.y, from.z);
+                voxels.Erase(from.x, from.y, from.z);
+                voxels.Set(to.x, to.y, to.z, material, voxelFlags);
+                VoxelChanged(from);
+                VoxelChanged(to);
+            }
+        }
 
-            // Fire simulation step
-            if (simulateFire)
+        // Put bricks that went long enough without changes to sleep, and forget freed ones
+        int kept = 0;
+        for (int id : activeBricks)
+        {
+            SimulationBrick& state = simulationBricks[id];
+            if (voxels.IsAllocated(id) && state.stableTicks++ < sleepTicks)
             {
-                if (isFire || isOnFire)
+                activeBricks[kept++] = id;
+                continue;
+            }
+
+            std::fill(std::begin(state.voxels), std::end(state.voxels), NO_MOVE);
+            state.flags = 0;
+            state.awake = false;
+        }
+        activeBricks.resize(kept);
+
+        tick++;
+    }
+
+    int VoxelObject::FindNeighbourBrick(int id, int direction) const
+    {
+        glm::ivec3 neighbour = voxels.GetBrick(id).origin + DIRECTIONS[direction] * VoxelBricks::BRICK_SIZE;
+        if (glm::any(glm::lessThan(neighbour, glm::ivec3(0))) ||
+            glm::any(glm::greaterThanEqual(neighbour, glm::ivec3(voxels.GetWidth(), voxels.GetHeight(), voxels.GetDepth()))))
+        {
+            return -1;
+        }
+
+        return voxels.FindBrick(neighbour.x, neighbour.y, neighbour.z);
+    }
+
+    void VoxelObject::Wake(const glm::ivec3& position)
+    {
+        WakeBrick(voxels.FindBrick(position.x, position.y, position.z));
+
+        // Neighbours across a brick boundary
+        const glm::ivec3 size(voxels.GetWidth(), voxels.GetHeight(), voxels.GetDepth());
+        for (const auto& direction : DIRECTIONS)
+        {
+            glm::ivec3 n = position + direction;
+            if ((n >> VoxelBricks::BRICK_SHIFT) == (position >> VoxelBricks::BRICK_SHIFT)) continue;
+            if (glm::any(glm::lessThan(n, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(n, size))) continue;
+
+            WakeBrick(voxels.FindBrick(n.x, n.y, n.z));
+        }
+    }
+
+    void VoxelObject::WakeBrick(int id)
+    {
+        if (id == -1) return;
+        if ((int)simulationBricks.size() <= id) simulationBricks.resize(voxels.GetBrickSlots());
+
+        SimulationBrick& state = simulationBricks[id];
+        state.stableTicks = 0;
+        if (state.awake) return;
+
+        state.awake = true;
+        activeBricks.push_back(id);
+    }
+
+    void VoxelObject::WakeAll()
+    {
+        for (int id = 0; id < voxels.GetBrickSlots(); ++id)
+        {
+            if (voxels.IsAllocated(id)) WakeBrick(id);
+        }
+    }
+
+    void VoxelObject::ClearActiveBricks()
+    {
+        activeBricks.clear();
+        simulationBricks.clear();
+    }
+
+    void VoxelObject::VoxelChanged(const glm::ivec3& position)
+    {
+        Wake(position);
+        meshDirty = true;
+
+        // Voxels can be added or move past a shrunk AABB
+        if (voxels.IsSolid(position.x, position.y, position.z))
+        {
+            aabb.min = glm::min(aabb.min, position + offset);
+            aabb.max = glm::max(aabb.max, position + offset + 1);
+        }
+
+        // Past a point, revisiting every change costs more than rebuilding the mesh
+        if (meshRebuild) return;
+        meshChanges.push_back(position);
+        if (meshChanges.size() > voxels.GetCount() / 4 + 1024)
+        {
+            meshChanges.clear();
+            meshRebuild = true;
+        }
+    }
+
+    const uint8_t* VoxelObject::GetSimulationState(const glm::ivec3& position) const
+    {
+        if (glm::any(glm::lessThan(position, glm::ivec3(0))) ||
+            glm::any(glm::greaterThanEqual(position, glm::ivec3(voxels.GetWidth(), voxels.GetHeight(), voxels.GetDepth()))))
+        {
+            return nullptr;
+        }
+
+        int id = voxels.FindBrick(position.x, position.y, position.z);
+        int v = VoxelBricks::VoxelIndex(position.x, position.y, position.z);
+        return id != -1 && voxels.GetBrick(id).IsSet(v) ? &simulationBricks[id].voxels[v] : nullptr;
+    }
+
+    void VoxelObject::DecideMoves(int id, const std::vector<VoxelMaterial>& materials)
+    {
+        const VoxelBricks::Brick& brick = voxels.GetBrick(id);
+        SimulationBrick& state = simulationBricks[id];
+        std::fill(std::begin(state.voxels), std::end(state.voxels), NO_MOVE);
+        state.flags = 0;
+
+        const bool simulateFluids = flags & Flags::SimulateFluids;
+        const bool simulateFire = flags & Flags::SimulateFire;
+        const glm::ivec3 size(voxels.GetWidth(), voxels.GetHeight(), voxels.GetDepth());
+
+        // Each brick draws from its own stream, identified by its position
+        CounterRNG rng(seed, (uint32_t)(brick.origin.x + size.x * (brick.origin.y + size.y * brick.origin.z)));
+        rng.SetCounter(StreamPosition(tick, 0));
+
+        brick.ForEachVoxel([&](int v)
+        {
+            const auto& materialFlags = materials[brick.materials[v]].flags;
+            const bool isLiquid = materialFlags & VoxelMaterial::Flags::Liquid;
+            const bool isFire = materialFlags & VoxelMaterial::Flags::Fire;
+            const bool isOnFire = brick.flags[v] & Voxel::Flags::OnFire;
+
+            // Fire spreads from here in the next pass
+            if (simulateFire && (isFire || isOnFire))
+            {
+                state.voxels[v] |= BURNING;
+                state.flags |= HAS_BURNING;
+            }
+
+            if (!simulateFluids || !isLiquid) return;
+
+            // Find the empty neighbours we could move to, looking within the brick directly where possible
+            const glm::ivec3 local = VoxelBricks::VoxelPosition(v);
+            const glm::ivec3 position = brick.origin + local;
+            bool inside[6];
+            int moves[6];
+            int possibleMoves = 0;
+            for (int d = 0; d < 6; ++d)
+            {
+                glm::ivec3 n = local + DIRECTIONS[d];
+                bool inBrick = ((n.x | n.y | n.z) & ~VoxelBricks::BRICK_MASK) == 0;
+                n += brick.origin;
+                inside[d] = inBrick || (glm::all(glm::greaterThanEqual(n, glm::ivec3(0))) && glm::all(glm::lessThan(n, size)));
+                if (d == ABOVE || !inside[d]) continue;
+
+                bool solid = inBrick ? brick.IsSet(v + NEIGHBOUR_OFFSETS[d]) : voxels.IsSolid(n.x, n.y, n.z);
+                if (!solid) moves[possibleMoves++] = d;
+            }
+
+            // Fall if we can, otherwise flow sideways while touching other fluid
+            // TODO: Prefer adjacent positions over opposite ones (somewhat mocking surface tension)
+            if (possibleMoves == 0) return;
+            int move = BELOW;
+            if (moves[0] != BELOW)
+            {
+                bool fluidNeighbour = false;
+                for (int d = 0; d < 6 && !fluidNeighbour; ++d)
                 {
-                    // Calculate grid position
-                    int gridX = voxel.x - offset.x;
-                    int gridY = voxel.y - offset.y;
-                    int gridZ = voxel.z - offset.z;
-
-                    // Grab current voxel index reference
-                    int& index = voxelGrid(gridX, gridY, gridZ);
-
-                    // Initialize neighbour index pointers
-                    int* pBelow = (voxel.y > aabb.min.y) ? &voxelGrid(gridX, gridY - 1, gridZ) : nullptr;
-                    int* pAbove = (voxel.y < aabb.max.y - 1) ? &voxelGrid(gridX, gridY + 1, gridZ) : nullptr;
-                    int* pLeft = (voxel.x > aabb.min.x) ? &voxelGrid(gridX - 1, gridY, gridZ) : nullptr;
-                    int* pRight = (voxel.x < aabb.max.x - 1) ? &voxelGrid(gridX + 1, gridY, gridZ) : nullptr;
-                    int* pForward = (voxel.z > aabb.min.z) ? &voxelGrid(gridX, gridY, gridZ - 1) : nullptr;
-                    int* pBack = (voxel.z < aabb.max.z - 1) ? &voxelGrid(gridX, gridY, gridZ + 1) : nullptr;
-                    int* pNeighbours[] = { pBelow, pAbove, pLeft, pRight, pForward, pBack };
-
-                    // Iterate all neighbours
-                    for (int i = 0; i < 6; ++i)
-                    {
-                        int* pNeighbour = pNeighbours[i];
-                        if (pNeighbour && *pNeighbour != empty)
-                        {
-                            // Grab neighbour data
-                            Voxel& vNeighbour = voxels[*pNeighbour];
-                            const float& flammability = voxelMaterials[vNeighbour.material].flammability;
-                            float n = rng.NextFloat(0.0f, 1.0f) * 30;
-                            if (flammability >= 1.0f || n < flammability)
-                            {
-                                // Spread
-                                vNeighbour.flags |= Voxel::Flags::OnFire;
-                                meshDirty = true;
-                            }
-                        }
-                    }
+                    glm::ivec3 n = position + DIRECTIONS[d];
+                    int16_t neighbourMaterial = inside[d] ? voxels.GetMaterial(n.x, n.y, n.z) : -1;
+                    fluidNeighbour = neighbourMaterial != -1 && (materials[neighbourMaterial].flags & VoxelMaterial::Flags::Liquid);
                 }
+                if (!fluidNeighbour) return;
+                move = moves[rng.NextInt(0, possibleMoves - 1)];
             }
 
-            // Fluid simulation step
-            if (simulateFluids && isLiquid)
+            state.voxels[v] = (state.voxels[v] & ~MOVE_MASK) | move;
+            state.flags |= HAS_MOVES;
+        });
+    }
+
+    void VoxelObject::ResolveMoves(int id, const std::vector<VoxelMaterial>& materials)
+    {
+        const VoxelBricks::Brick& brick = voxels.GetBrick(id);
+        SimulationBrick& state = simulationBricks[id];
+        std::fill(std::begin(state.resolved), std::end(state.resolved), 0);
+        state.resolvedFlags = 0;
+
+        // A move wins unless a voxel with an earlier direction wants the same target
+        if (state.flags & HAS_MOVES)
+        {
+            brick.ForEachVoxel([&](int v)
             {
-                // Calculate grid position
-                int gridX = voxel.x - offset.x;
-                int gridY = voxel.y - offset.y;
-                int gridZ = voxel.z - offset.z;
-
-                // Grab current voxel index reference
-                int& index = voxelGrid(gridX, gridY, gridZ);
-
-                // Initialize neighbour index pointers
-                int* pBelow = (voxel.y > aabb.min.y) ? &voxelGrid(gridX, gridY - 1, gridZ) : nullptr;
-                int* pAbove = (voxel.y < aabb.max.y - 1) ? &voxelGrid(gridX, gridY + 1, gridZ) : nullptr;
-                int* pLeft = (voxel.x > aabb.min.x) ? &voxelGrid(gridX - 1, gridY, gridZ) : nullptr;
-                int* pRight = (voxel.x < aabb.max.x - 1) ? &voxelGrid(gridX + 1, gridY, gridZ) : nullptr;
-                int* pForward = (voxel.z > aabb.min.z) ? &voxelGrid(gridX, gridY, gridZ - 1) : nullptr;
-                int* pBack = (voxel.z < aabb.max.z - 1) ? &voxelGrid(gridX, gridY, gridZ + 1) : nullptr;
-                int* pNeighbours[] = { pBelow, pAbove, pLeft, pRight, pForward, pBack };
-
-                // Pointers to the grid index of each possible move detected
-                int* pMoveInds[6];
-                int possibleMoves = 0;
-                int fluidNeighbours = 0;
-
-                // Iterate all neighbours
-                for (int i = 0; i < 6; ++i)
+                int move = state.voxels[v] & MOVE_MASK;
+                if (move == NO_MOVE) return;
+
+                glm::ivec3 target = brick.origin + VoxelBricks::VoxelPosition(v) + DIRECTIONS[move];
+                for (int d = 0; d < move; ++d)
                 {
-                    int* pNeighbour = pNeighbours[i];
-                    if (pNeighbour)
-                    {
-                        // Grab neighbour data if it exists
-                        Voxel* vNeighbour = *pNeighbour == empty ? nullptr : &voxels[*pNeighbour];
-
-                        // If neighbour exists
-                        if (vNeighbour)
-                        {
-                            // Count fluid neighbours
-                            const auto& neighbourMaterialFlags = voxelMaterials[vNeighbour->material].flags;
-                            fluidNeighbours += (bool)(neighbourMaterialFlags & VoxelMaterial::Flags::Liquid);
-                        }
-                        else
-                        {
-                            // Neighbour does not exist, should we move?
-                            pMoveInds[possibleMoves++] = pNeighbour != pAbove ? pNeighbour : pMoveInds[--possibleMoves];
-                        }
-                    }
+                    const uint8_t* rival = GetSimulationState(target - DIRECTIONS[d]);
+                    if (rival && (*rival & MOVE_MASK) == d) return;
                 }
 
-                // Move if we can
-                if (possibleMoves > 0)
-                {
-                    // Make decision
-                    // TODO: Prefer adjacent positions over opposite ones (somewhat mocking surface tension)
-                    int* pMoveIndex = (pMoveInds[0] == pBelow) ? pMoveInds[0] : (fluidNeighbours > 0) ? pMoveInds[rng.NextInt(0, possibleMoves - 1)] : nullptr;
+                state.resolved[v] |= MOVE_WON;
+                state.resolvedFlags |= HAS_MOVES;
+            });
+        }
 
-                    // Update voxel
-                    if (pMoveIndex)
-                    {
-                        voxel.x += pMoveIndex == pLeft ? -1 : pMoveIndex == pRight ? 1 : 0;
-                        voxel.y += pMoveIndex == pBelow ? -1 : pMoveIndex == pAbove ? 1 : 0;
-                        voxel.z += pMoveIndex == pForward ? -1 : pMoveIndex == pBack ? 1 : 0;
-                        std::swap(*pMoveIndex, index);
-                        meshDirty = true;
-                    }
+        // Fire only spreads to bricks next to burning ones
+        bool burningNearby = state.flags & HAS_BURNING;
+        for (int d = 0; d < 6 && !burningNearby; ++d)
+        {
+            int neighbourID = FindNeighbourBrick(id, d);
+            burningNearby = neighbourID != -1 && (simulationBricks[neighbourID].flags & HAS_BURNING);
+        }
+        if (!burningNearby) return;
+
+        // Each burning neighbour sets a voxel on fire with a chance depending on its flammability
+        const glm::ivec3 size(voxels.GetWidth(), voxels.GetHeight(), voxels.GetDepth());
+        CounterRNG rng(seed, (uint32_t)(brick.origin.x + size.x * (brick.origin.y + size.y * brick.origin.z)));
+        rng.SetCounter(StreamPosition(tick, 1));
+
+        brick.ForEachVoxel([&](int v)
+        {
+            if (brick.flags[v] & Voxel::Flags::OnFire) return;
+
+            const float flammability = materials[brick.materials[v]].flammability;
+            if (flammability <= 0.0f) return;
+
+            const glm::ivec3 position = brick.origin + VoxelBricks::VoxelPosition(v);
+            for (int d = 0; d < 6; ++d)
+            {
+                const uint8_t* neighbour = GetSimulationState(position + DIRECTIONS[d]);
+                if (!neighbour || !(*neighbour & BURNING)) continue;
+
+                state.resolvedFlags |= HAS_CANDIDATES;
+                if (flammability >= 1.0f || rng.NextFloat(0.0f, 1.0f) * 30 < flammability)
+                {
+                    state.resolved[v] |= IGNITES;
+                    state.resolvedFlags |= HAS_IGNITIONS;
+                    break;
                 }
             }
+        });
+    }
+
+    void VoxelObject::ApplyIgnitions(int id)
+    {
+        const SimulationBrick& state = simulationBricks[id];
+        if (!(state.resolvedFlags & HAS_IGNITIONS)) return;
+
+        VoxelBricks::Brick& brick = voxels.GetBrick(id);
+        brick.ForEachVoxel([&](int v)
+        {
+            if (state.resolved[v] & IGNITES) brick.flags[v] |= Voxel::Flags::OnFire;
+        });
+    }
+
+    bool VoxelObject::RemoveVoxel(int16_t x, int16_t y, int16_t z)
+    {
+        glm::ivec3 position = glm::ivec3(x, y, z) - offset;
+        if (!voxels.Erase(position.x, position.y, position.z)) return false;
+
+        VoxelChanged(position);
+        aabbShrinkable = true;
+        return true;
+    }
+
+    size_t VoxelObject::RemoveVoxels(const glm::ivec3* positions, size_t count)
+    {
+        size_t removed = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::ivec3 position = positions[i] - offset;
+            if (!voxels.Erase(position.x, position.y, position.z)) continue;
+
+            // Mesh changes stop being queued once a rebuild is cheaper, so nothing here grows with the batch
+            VoxelChanged(position);
+            removed++;
         }
 
-        if (updateMesh && meshDirty) UpdateMesh();
+        if (removed > 0) aabbShrinkable = true;
+        return removed;
+    }
+
+    void VoxelObject::UpdateAABB()
+    {
+        if (!aabbShrinkable) return;
+        aabbShrinkable = false;
+
+        // An empty object gets an inverted AABB, which contains nothing and grows to fit the next voxel
+        glm::ivec3 min, max;
+        if (voxels.GetBounds(min, max))
+        {
+            aabb.min = min + offset;
+            aabb.max = max + offset + 1;
+        }
+        else
+        {
+            aabb.min = offset + glm::ivec3(voxels.GetWidth(), voxels.GetHeight(), voxels.GetDepth());
+            aabb.max = offset;
+        }
     }
 
     bool VoxelObject::Load(const std::string& path)
@@ -243,7 +518,9 @@ namespace Phi
             }
             
             // Update all internal voxel data
-            voxelGrid.Resize(max.x - min.x + 1, max.y - min.y + 1, max.z - min.z + 1);
+            voxels.Resize(max.x - min.x + 1, max.y - min.y + 1, max.z - min.z + 1);
+            ClearActiveBricks();
+            meshRebuild = true;
             offset = min;
             for (const auto& voxel : newVoxels)
             {
@@ -267,8 +544,16 @@ namespace Phi
 
     void VoxelObject::Reset()
     {
-        voxelGrid.Clear();
-        if (mesh) mesh->Vertices().clear();
+        voxels.Clear();
+        ClearActiveBricks();
+        meshChanges.clear();
+        meshRebuild = true;
+        aabbShrinkable = true;
+        if (mesh)
+        {
+            mesh->Vertices().clear();
+            meshVertices = 0;
+        }
     }
 
     VoxelObject::RaycastInfo VoxelObject::Raycast(const Ray& ray, int maxSteps)
@@ -320,29 +605,18 @@ namespace Phi
                 if (gridXYZ.x >= 0 &&
                     gridXYZ.y >= 0 &&
                     gridXYZ.z >= 0 &&
-                    gridXYZ.x < voxelGrid.GetWidth() &&
-                    gridXYZ.y < voxelGrid.GetHeight() &&
-                    gridXYZ.z < voxelGrid.GetDepth())
+                    gridXYZ.x < voxels.GetWidth() &&
+                    gridXYZ.y < voxels.GetHeight() &&
+                    gridXYZ.z < voxels.GetDepth())
                 {
-                    // Check for voxel at current position
-                    int& index = voxelGrid(gridXYZ.x, gridXYZ.y, gridXYZ.z);
-
-                    if (index != voxelGrid.GetEmptyValue())
+                    // Check for voxel at current position, empty voxels have the material -1
+                    result.visitedVoxels.push_back(GetVoxel(xyz.x, xyz.y, xyz.z));
+                    if (result.visitedVoxels.back().material != -1)
                     {
-                        // We hit a voxel, add to result and stop
-                        result.visitedVoxels.push_back(voxels[index]);
+                        // We hit a voxel, stop
                         result.firstHit = result.visitedVoxels.size() - 1;
                         break;
                     }
-                    else
-                    {
-                        // We did not hit a voxel, add an empty one to the list
-                        Voxel v;
-                        v.x = xyz.x;
-                        v.y = xyz.y;
-                        v.z = xyz.z;
-                        result.visitedVoxels.push_back(v);
-                    }
                 }
 
                 // Step to next voxel
@@ -395,26 +669,149 @@ namespace Phi
             }
         }
 
-        // Grab material list
-        const auto& materials = GetNode()->GetScene().GetVoxelMaterials();
+        UpdateVertices(GetNode()->GetScene().GetVoxelMaterials(), mesh->Vertices());
+    }
+
+    void VoxelObject::UpdateVertices(const std::vector<VoxelMaterial>& materials, std::vector<VoxelMesh::Vertex>& vertices,
+                                     const std::function<void(size_t, size_t)>& changed)
+    {
+        // Rebuild when slots can't be trusted, or once hidden vertices make up a quarter of the list
+        if (meshRebuild || vertices.size() != meshVertices || freeSlots.size() * 4 > vertices.size())
+        {
+            vertices.clear();
+            freeSlots.clear();
+            meshSlots.clear();
+            meshSlotCounts.clear();
+            freeMeshBricks.clear();
+            meshBrickTable.assign(voxels.GetBrickPositions(), -1);
+
+            // A brick at a time, finding its enclosed voxels from the occupancy bits
+            uint64_t enclosed[VoxelBricks::BRICK_SIZE];
+            for (int id = 0; id < voxels.GetBrickSlots(); ++id)
+            {
+                if (!voxels.IsAllocated(id)) continue;
 
-        // Grab vertex list reference and clear old verts
-        auto& verts = mesh->Vertices();
-        verts.clear();
+                const VoxelBricks::Brick& brick = voxels.GetBrick(id);
+                voxels.GetEnclosed(id, enclosed);
+                int meshBrick = -1;
+                brick.ForEachVoxel([&](int v)
+                {
+                    if ((enclosed[v >> 6] >> (v & 63)) & 1) return;
 
-        // Iterate all voxels
-        for (const Voxel& voxel : voxels)
+                    if (meshBrick == -1) meshBrick = GetMeshBrick(brick.origin);
+                    meshSlots[meshBrick * VoxelBricks::BRICK_VOXELS + v] = (int)vertices.size();
+                    meshSlotCounts[meshBrick]++;
+                    vertices.push_back(MakeVertex(brick.origin + VoxelBricks::VoxelPosition(v) + offset, materials, brick.materials[v], brick.flags[v]));
+                });
+            }
+
+            if (changed) changed(0, vertices.size());
+        }
+        else
         {
-            // Add the voxel to the new mesh
-            VoxelMesh::Vertex vert;
-            vert.x = voxel.x;
-            vert.y = voxel.y;
-            vert.z = voxel.z;
-            vert.material = (voxel.flags & Voxel::Flags::OnFire) ? -1 : materials[voxel.material].pbrID;
-            verts.push_back(vert);
+            // Changes can reveal or enclose the voxels next to them, so those are revisited too
+            const glm::ivec3 size(voxels.GetWidth(), voxels.GetHeight(), voxels.GetDepth());
+            for (const auto& position : meshChanges)
+            {
+                UpdateMeshSlot(position, materials, vertices, changed);
+                for (const auto& direction : DIRECTIONS)
+                {
+                    glm::ivec3 n = position + direction;
+                    if (glm::all(glm::greaterThanEqual(n, glm::ivec3(0))) && glm::all(glm::lessThan(n, size)))
+                    {
+                        UpdateMeshSlot(n, materials, vertices, changed);
+                    }
+                }
+            }
         }
-        
+
+        meshChanges.clear();
+        meshRebuild = false;
+        meshVertices = vertices.size();
+
         // Reset flag
         meshDirty = false;
     }
+
+    void VoxelObject::UpdateMeshSlot(const glm::ivec3& position, const std::vector<VoxelMaterial>& materials,
+                                     std::vector<VoxelMesh::Vertex>& vertices, const std::function<void(size_t, size_t)>& changed)
+    {
+        int slot = FindMeshSlot(position);
+        int16_t material = voxels.GetMaterial(position.x, position.y, position.z);
+        if (material == -1 || voxels.IsEnclosed(position.x, position.y, position.z))
+        {
+            // Hide the vertex, its slot is reused by the next voxel shown
+            if (slot == -1) return;
+            vertices[slot] = VoxelMesh::Vertex{ 0, 0, 0, VoxelMesh::HIDDEN_MATERIAL };
+            freeSlots.push_back(slot);
+            SetMeshSlot(position, -1);
+        }
+        else
+        {
+            VoxelMesh::Vertex vertex = MakeVertex(position + offset, materials, material, voxels.GetFlags(position.x, position.y, position.z));
+            if (slot == -1)
+            {
+                if (freeSlots.empty())
+                {
+                    slot = (int)vertices.size();
+                    vertices.emplace_back();
+                }
+                else
+                {
+                    slot = freeSlots.back();
+                    freeSlots.pop_back();
+                }
+                SetMeshSlot(position, slot);
+            }
+            else if (std::memcmp(&vertices[slot], &vertex, sizeof(vertex)) == 0)
+            {
+                return;
+            }
+            vertices[slot] = vertex;
+        }
+
+        if (changed) changed(slot, 1);
+    }
+
+    int VoxelObject::FindMeshSlot(const glm::ivec3& position) const
+    {
+        int b = meshBrickTable[voxels.BrickIndex(position.x, position.y, position.z)];
+        return b != -1 ? meshSlots[b * VoxelBricks::BRICK_VOXELS + VoxelBricks::VoxelIndex(position.x, position.y, position.z)] : -1;
+    }
+
+    void VoxelObject::SetMeshSlot(const glm::ivec3& position, int slot)
+    {
+        int& b = meshBrickTable[voxels.BrickIndex(position.x, position.y, position.z)];
+        if (b == -1 && slot == -1) return;
+
+        int meshBrick = GetMeshBrick(position);
+        int& current = meshSlots[meshBrick * VoxelBricks::BRICK_VOXELS + VoxelBricks::VoxelIndex(position.x, position.y, position.z)];
+        meshSlotCounts[meshBrick] += (slot != -1) - (current != -1);
+        current = slot;
+        if (meshSlotCounts[meshBrick] == 0)
+        {
+            freeMeshBricks.push_back(meshBrick);
+            b = -1;
+        }
+    }
+
+    int VoxelObject::GetMeshBrick(const glm::ivec3& position)
+    {
+        int& b = meshBrickTable[voxels.BrickIndex(position.x, position.y, position.z)];
+        if (b != -1) return b;
+
+        // Reuse a freed block, its slots were all emptied before it was freed
+        if (!freeMeshBricks.empty())
+        {
+            b = freeMeshBricks.back();
+            freeMeshBricks.pop_back();
+        }
+        else
+        {
+            b = (int)meshSlotCounts.size();
+            meshSlotCounts.push_back(0);
+            meshSlots.resize(meshSlots.size() + VoxelBricks::BRICK_VOXELS, -1);
+        }
+        return b;
+    }
 }
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
+
+#include <phi/core/thread_pool.hpp>
 #include <phi/core/math/rng.hpp>
 #include <phi/core/math/shapes.hpp>
-#include <phi/core/structures/grid_3d.hpp>
 #include <phi/scene/components/base_component.hpp>
 #include <phi/scene/components/renderable/voxel_mesh.hpp>
+#include <phi/scene/components/simulation/voxel_bricks.hpp>
+#include <phi/scene/components/simulation/voxel_material.hpp>
 
 namespace Phi
 {
@@ -85,8 +90,27 @@ namespace Phi
             // Simulation
 
             // Updates the object according to the simulation flags set
+            // Simulation ticks are spread across the scene's simulation threads
             void Update(float delta);
 
+            // Runs a single simulation tick with the given materials, spread across the pool if there is one
+            // Every voxel reads the state from the start of the tick, conflicting moves are settled by a fixed
+            // priority, and random choices come from a stream per brick, so the results only depend on the
+            // seed and the voxels, never on the number of threads
+            // Only bricks in which or next to which something changed recently are simulated, the rest would
+            // do nothing and are skipped, so the cost of a tick follows the active part of the object
+            void Step(const std::vector<VoxelMaterial>& materials, ThreadPool* pool = nullptr);
+
+            // Sets the seed for random choices made by the simulation
+            inline void SetSeed(uint32_t seed) { this->seed = seed; }
+
+            // Sets the number of ticks a brick has to go without changes before it is no longer simulated
+            // It is woken again as soon as a voxel in or next to it changes
+            inline void SetSleepTicks(int ticks) { sleepTicks = std::max(ticks, 1); }
+
+            // Returns the number of bricks being simulated
+            inline int GetActiveBrickCount() const { return (int)activeBricks.size(); }
+
             // Sets the given simulation flags
             inline void Enable(Flags::type flags) { this->flags |= flags; }
 
@@ -95,43 +119,55 @@ namespace Phi
 
             // Voxel data management
 
-            // Gets a pointer to the voxel at the object local coordinates provided,
-            // or nullptr if the given position is empty
+            // Gets the voxel at the object local coordinates provided,
+            // with the material index -1 if the given position is empty
             // NOTE: Does not validate position
-            inline const Voxel* GetVoxel(int16_t x, int16_t y, int16_t z)
+            inline Voxel GetVoxel(int16_t x, int16_t y, int16_t z) const
+            {
+                Voxel voxel;
+                voxel.x = x;
+                voxel.y = y;
+                voxel.z = z;
+                voxel.material = voxels.GetMaterial(x - offset.x, y - offset.y, z - offset.z);
+                if (voxel.material != -1) voxel.flags = voxels.GetFlags(x - offset.x, y - offset.y, z - offset.z);
+                return voxel;
+            }
+
+            // Returns true if the voxel at the object local coordinates provided is occupied
+            // Positions outside of the grid are always empty
+            inline bool IsSolid(int x, int y, int z) const
             {
-                int index = voxelGrid(x - offset.x, y - offset.y, z - offset.z);
-                return index == -1 ? nullptr : &voxels[index];
+                x -= offset.x;
+                y -= offset.y;
+                z -= offset.z;
+                bool inside = (x >= 0) & (y >= 0) & (z >= 0) & (x < voxels.GetWidth()) & (y < voxels.GetHeight()) & (z < voxels.GetDepth());
+                return inside && voxels.IsSolid(x, y, z);
             }
 
             // Sets the voxel data to a specific material
             // NOTE: Does not validate position
             inline void SetVoxel(int16_t x, int16_t y, int16_t z, int16_t material)
             {
-                // Initialize voxel data
-                Voxel voxel;
-                voxel.x = x;
-                voxel.y = y;
-                voxel.z = z;
-                voxel.material = material;
+                voxels.Set(x - offset.x, y - offset.y, z - offset.z, material);
+                VoxelChanged(glm::ivec3(x, y, z) - offset);
+            }
 
-                // Place on grid (update existing or push back)
-                int& index = voxelGrid(x - offset.x, y - offset.y, z - offset.z);
-                if (index == -1)
-                {
-                    index = voxels.size();
-                    voxels.push_back(voxel);
-                }
-                else
-                {
-                    voxels[index] = voxel;
-                }
+            // Empties the voxel at the object local coordinates provided, returns false if it was already empty
+            // Other voxels are unaffected, a brick is only freed once its last voxel is removed
+            // NOTE: Does not validate position
+            bool RemoveVoxel(int16_t x, int16_t y, int16_t z);
 
-                // Set flag
-                meshDirty = true;
-            }
+            // Empties the voxels at the object local coordinates provided, returns the number removed
+            // Takes time linear in the count and allocates nothing per voxel, large batches let the next mesh
+            // update rebuild instead of patching
+            // NOTE: Does not validate positions
+            size_t RemoveVoxels(const glm::ivec3* positions, size_t count);
 
-            // TODO: Remove voxels without rebuilding all indices...
+            // Returns the number of voxels in the object
+            inline size_t GetVoxelCount() const { return voxels.GetCount(); }
+
+            // Returns the number of bytes used to store the voxels
+            inline size_t GetMemoryUsage() const { return voxels.GetMemoryUsage(); }
 
             // Loads voxel data from a .vobj file, replacing any existing data
             // Accepts local paths like data:// and user://
@@ -150,23 +186,128 @@ namespace Phi
             // Updates the internal mesh to match the voxel grid
             void UpdateMesh();
 
+            // Brings a list of vertices in line with the voxels, calling changed(first, count), if given, for the parts it wrote
+            // Voxels enclosed on all six sides are left out. Each voxel keeps its vertex slot while it is shown, so only
+            // voxels that changed since the last call and their neighbours are revisited, and the slots of voxels that
+            // stop being shown are hidden until reused. The same list has to be passed every time, it is rebuilt when
+            // its size doesn't match or hidden slots make up too much of it
+            void UpdateVertices(const std::vector<VoxelMaterial>& materials, std::vector<VoxelMesh::Vertex>& vertices,
+                                const std::function<void(size_t, size_t)>& changed = nullptr);
+
             // Returns a pointer to the internal mesh component,
             // or nullptr if none exists
             inline VoxelMesh *GetMesh() const { return mesh; }
 
             // Returns a const reference to the voxel-space integer AABB
+            // It always contains every voxel, but may be larger than needed after voxels are removed until the
+            // next call to UpdateAABB()
             inline const IAABB &GetAABB() const { return aabb; }
 
+            // Shrinks the AABB to the voxels if any were removed since the last call, called by Update()
+            void UpdateAABB();
+
         // Data / implementation
         private:
 
-            // Spatial index for voxels
-            // -1 indicates an empty spot on the grid
-            // Any other non-negative value indicates an index into the internal voxel array
-            Grid3D<int> voxelGrid;
+            // Voxel data, stored sparsely in bricks in grid space
+            VoxelBricks voxels;
+
+            // Simulation state
+            uint32_t seed = 0;
+            uint64_t tick = 0;
+
+            // State of each voxel during a tick, stored alongside the brick with the same id
+            // What a voxel wants is decided first, the low bits hold the direction it wants to move in and
+            // the rest are flags. Neighbouring bricks read it while settling what each voxel gets, so that
+            // is kept apart and no pass writes state another brick reads during the same pass
+            // Sleeping bricks keep a decided state without moves or fire, which is what they would decide
+            struct SimulationBrick
+            {
+                uint8_t voxels[VoxelBricks::BRICK_VOXELS];
+                uint8_t flags;
+                uint8_t resolved[VoxelBricks::BRICK_VOXELS];
+                uint8_t resolvedFlags;
+
+                // Whether the brick is simulated, and for how many ticks nothing changed in or next to it
+                bool awake;
+                int stableTicks;
+            };
+            std::vector<SimulationBrick> simulationBricks;
+
+            // Ids of the bricks being simulated, and the simulation flags they were woken for
+            std::vector<int> activeBricks;
+            Flags::type simulatedFlags = Flags::None;
+            int sleepTicks = DEFAULT_SLEEP_TICKS;
+
+            // Decided voxel state
+            static constexpr uint8_t NO_MOVE = 7;
+            static constexpr uint8_t MOVE_MASK = 7;
+            static constexpr uint8_t BURNING = 1 << 4;
+
+            // Resolved voxel state
+            static constexpr uint8_t MOVE_WON = 1 << 3;
+            static constexpr uint8_t IGNITES = 1 << 5;
+
+            // Brick flags, HAS_MOVES is set in both states (moves wanted, and moves won)
+            static constexpr uint8_t HAS_MOVES = 1;
+            static constexpr uint8_t HAS_BURNING = 1 << 1;
+            static constexpr uint8_t HAS_IGNITIONS = 1 << 2;
+            static constexpr uint8_t HAS_CANDIDATES = 1 << 3;
+
+            static const int DEFAULT_SLEEP_TICKS = 8;
+
+            // Passes of a tick, each only writes to the brick with the given id: its decided state, its resolved
+            // state and its voxels' flags. Only the decided state of other bricks is read, after it was written
+            void DecideMoves(int id, const std::vector<VoxelMaterial>& materials);
+            void ResolveMoves(int id, const std::vector<VoxelMaterial>& materials);
+            void ApplyIgnitions(int id);
+
+            // Returns the state of the voxel at a grid position, or nullptr if outside the grid or empty
+            const uint8_t* GetSimulationState(const glm::ivec3& position) const;
+
+            // Returns the id of the brick next to the given one in a direction, or -1 if there is none
+            int FindNeighbourBrick(int id, int direction) const;
+
+            // Wakes the bricks containing a grid position and its neighbours, after the voxel there changed
+            void Wake(const glm::ivec3& position);
+
+            // Wakes a brick, or keeps it awake, ignoring -1
+            void WakeBrick(int id);
+
+            // Wakes every brick
+            void WakeAll();
+
+            // Forgets which bricks are awake, for when every brick was freed
+            void ClearActiveBricks();
+
+            // Records a change of the voxel at a grid position, waking the bricks around it, queueing a mesh update,
+            // and growing the AABB to contain it if it is set
+            void VoxelChanged(const glm::ivec3& position);
+
+            // Vertex slot of each voxel shown in the mesh, -1 for the rest, in blocks of a brick's voxels
+            // Blocks are found by brick position, since bricks can be freed and reallocated elsewhere before the
+            // mesh is updated, and are freed once none of their voxels are shown
+            std::vector<int> meshBrickTable;
+            std::vector<int> meshSlots;
+            std::vector<int> meshSlotCounts;
+            std::vector<int> freeMeshBricks;
+
+            // Slots of hidden vertices, grid positions changed since the last mesh update, and the size of the list
+            std::vector<int> freeSlots;
+            std::vector<glm::ivec3> meshChanges;
+            size_t meshVertices = 0;
+            bool meshRebuild = true;
+
+            // Returns the vertex slot of the voxel at a grid position, or -1 if it isn't in the mesh
+            int FindMeshSlot(const glm::ivec3& position) const;
+            void SetMeshSlot(const glm::ivec3& position, int slot);
+
+            // Returns the block of slots for the brick containing a grid position, allocating it if needed
+            int GetMeshBrick(const glm::ivec3& position);
 
-            // Array of all voxel data
-            std::vector<Voxel> voxels;
+            // Shows, updates or hides the vertex of the voxel at a grid position
+            void UpdateMeshSlot(const glm::ivec3& position, const std::vector<VoxelMaterial>& materials,
+                                std::vector<VoxelMesh::Vertex>& vertices, const std::function<void(size_t, size_t)>& changed);
 
             // Offset to apply to obtain object-local space coordinates
             glm::ivec3 offset;
@@ -179,8 +320,9 @@ namespace Phi
             // Simulation flags
             Flags::type flags;
 
-            // AABB that bounds voxels in object local space
+            // AABB that bounds voxels in object local space, and whether it may be larger than needed
             IAABB aabb;
+            bool aabbShrinkable = false;
 
             // Internal mesh component (NON-OWNING)
             VoxelMesh *mesh = nullptr;
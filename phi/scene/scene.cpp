@@ -1,5 +1,6 @@
 #include "scene.hpp"
 
+#include <chrono>
 #include <fstream>
 #include <sstream>
 #include <imgui/imgui.h>
@@ -155,6 +156,9 @@ namespace Phi
         delete ssaoRotationTexture;
         delete ssaoScreenTexture;
         delete ssaoFBO;
+
+        // Simulation resources
+        delete simulationThreadPool;
     }
 
     Node* Scene::CreateNode()
@@ -223,10 +227,36 @@ namespace Phi
         if (activeVoxelMap) activeVoxelMap->Update(delta);
 
         // Update all particle effects
+        auto particleStart = std::chrono::steady_clock::now();
+        if (simulationThreadPool)
+        {
+            // Gather emitter updates on this thread, then spread them across the pool
+            particleUpdates.clear();
+            for (auto&&[_, effect] : registry.view<CPUParticleEffect>().each())
+            {
+                effect.QueueUpdates(particleUpdates, delta);
+            }
+            simulationThreadPool->ParallelFor((int)particleUpdates.size(), [&](int i) { particleUpdates[i].Run(); });
+        }
+        else
+        {
+            for (auto&&[_, effect] : registry.view<CPUParticleEffect>().each())
+            {
+                effect.Update(delta);
+            }
+        }
+
+        // Measure the load against the particle budget
+        float particleMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - particleStart).count();
+        int liveParticles = 0;
         for (auto&&[_, effect] : registry.view<CPUParticleEffect>().each())
         {
-            effect.Update(delta);
+            liveParticles += effect.GetActiveParticles();
         }
+        particleBudget.Update(liveParticles, particleMilliseconds, delta);
+
+        // No emitter is being updated, so holes left by destroyed emitters can be closed
+        CPUParticleEmitter::GetArena().Compact();
 
         // Update all voxel objects
         for (auto&&[_, voxelObject] : registry.view<VoxelObject>().each())
@@ -487,7 +517,7 @@ namespace Phi
         {
             effect.Render();
         }
-        CPUParticleEffect::FlushRenderQueue();
+        CPUParticleEffect::FlushRenderQueue(activeCamera->GetView());
 
         // Make sure blending state is disabled
         glDisable(GL_BLEND);
@@ -762,6 +792,20 @@ namespace Phi
         activeVoxelMap = nullptr;
     }
 
+    void Scene::SetSimulationThreads(int count)
+    {
+        // Resolve the actual thread count
+        if (count < 1) count = (int)std::thread::hardware_concurrency();
+        if (count < 1) count = 1;
+
+        // Nothing to do if unchanged
+        if (count == GetSimulationThreads()) return;
+
+        // Serial simulation doesn't need a pool
+        delete simulationThreadPool;
+        simulationThreadPool = count > 1 ? new ThreadPool(count) : nullptr;
+    }
+
     void Scene::ShowDebug(int x, int y, int width, int height)
     {
         ImGui::SetNextWindowPos(ImVec2(x, y));
@@ -772,6 +816,38 @@ namespace Phi
         ImGui::Checkbox("SSAO", &ssao);
         ImGui::Checkbox("Debug Drawing", &debugDrawing);
 
+        ImGui::SeparatorText("Simulation Settings");
+        int simulationThreads = GetSimulationThreads();
+        if (ImGui::SliderInt("Threads", &simulationThreads, 1, std::max(1, (int)std::thread::hardware_concurrency())))
+        {
+            SetSimulationThreads(simulationThreads);
+        }
+
+        // Particle level of detail summary
+        int lodCounts[3] = {0, 0, 0};
+        uint64_t lodTicks = 0, lodSkipped = 0, lodDormant = 0;
+        for (auto&&[_, effect] : registry.view<CPUParticleEffect>().each())
+        {
+            const auto& stats = effect.GetLODStats();
+            lodCounts[(int)stats.level]++;
+            lodTicks += stats.ticks;
+            lodSkipped += stats.skippedTicks;
+            lodDormant += stats.dormantFrames;
+        }
+        ImGui::Text("Particle LOD (full / reduced / dormant): %d / %d / %d", lodCounts[0], lodCounts[1], lodCounts[2]);
+        ImGui::Text("Effect updates: %llu, skipped: %llu, dormant: %llu", (unsigned long long)lodTicks, (unsigned long long)lodSkipped, (unsigned long long)lodDormant);
+
+        // Particle budget
+        auto& budget = particleBudget.GetSettings();
+        ImGui::DragInt("Particle Budget", &budget.maxParticles, 100.0f, 0, 10'000'000);
+        ImGui::DragFloat("Particle Budget (ms)", &budget.maxMilliseconds, 0.01f, 0.0f, 100.0f, "%.2f");
+        const auto& budgetStats = particleBudget.GetStats();
+        ImGui::Text("Particle quality: %.2f, particles: %d, simulation: %.2f ms", budgetStats.scale, budgetStats.particles, budgetStats.milliseconds);
+
+        // Particle culling summary
+        const auto& culling = CPUParticleEmitter::GetCullingStats();
+        ImGui::Text("Emitters (visible / culled): %d / %d, culled particles: %d", culling.visibleEmitters, culling.culledEmitters, culling.culledParticles);
+
         ImGui::SeparatorText("Environment");
         ImGui::ColorEdit3("Ambient Light", &ambientLight.x);
 
@@ -9,6 +9,7 @@
 #include <entt.hpp>
 
 // Core systems
+#include <phi/core/thread_pool.hpp>
 #include <phi/core/structures/quadtree.hpp>
 
 // Graphics
@@ -21,6 +22,8 @@
 #include <phi/scene/components/transform.hpp>
 #include <phi/scene/components/collision/bounding_sphere.hpp>
 #include <phi/scene/components/lighting/directional_light.hpp>
+#include <phi/scene/components/particles/cpu_particle_effect.hpp>
+#include <phi/scene/components/particles/particle_budget.hpp>
 #include <phi/scene/components/renderable/basic_mesh.hpp>
 #include <phi/scene/components/renderable/environment.hpp>
 #include <phi/scene/components/renderable/voxel_mesh.hpp>
@@ -217,6 +220,24 @@ namespace Phi
             // Gets the base ambient light in the scene
             const glm::vec3& GetAmbientLight() const { return ambientLight; }
 
+            // Simulation settings
+
+            // Sets the number of threads used to simulate particle emitters and voxel objects
+            // A value of 1 simulates everything serially on the calling thread,
+            // and values less than 1 use every hardware thread available
+            // Results are identical regardless of thread count
+            void SetSimulationThreads(int count);
+
+            // Gets the number of threads used to simulate particle emitters
+            int GetSimulationThreads() const { return simulationThreadPool ? simulationThreadPool->GetThreadCount() : 1; }
+
+            // Gets the pool simulations are spread across, or nullptr if they run serially
+            ThreadPool* GetSimulationThreadPool() const { return simulationThreadPool; }
+
+            // Gives access to the budget that scales particle spawning down when simulation gets too expensive
+            // Measured every Update(), effects pick up its scale on their next update
+            ParticleBudget& GetParticleBudget() { return particleBudget; }
+
             // Shows debug statistics in an ImGui window
             // TODO: Delete this
             void ShowDebug(int x, int y, int width, int height);
@@ -323,6 +344,11 @@ namespace Phi
             bool debugDrawing = true;
             bool depthPrePass = false;
 
+            // Simulation threading
+            ThreadPool* simulationThreadPool = nullptr;
+            std::vector<CPUParticleEffect::EmitterUpdate> particleUpdates;
+            ParticleBudget particleBudget;
+
             // Internal statistics
             float totalElapsedTime = 0.0f;
             size_t nodeCount = 0;
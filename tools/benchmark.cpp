@@ -0,0 +1,1509 @@
+#include "benchmark.hpp"
+#include "headless_effects.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+namespace Benchmark
+{
+    // Registered benchmarks
+    struct Entry
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    static const Entry BENCHMARKS[] =
+    {
+        {"rng", RNGEngines},
+        {"effects", Effects},
+        {"effectload", EffectLoading},
+        {"attractors", AttractorFields},
+        {"sort", DepthSorting},
+        {"collision", VoxelCollision},
+        {"snapshot", Snapshots},
+        {"pool", ParticlePools},
+        {"turbulence", Turbulence},
+        {"packing", Packing},
+        {"analytic", AnalyticEmitters},
+        {"flocking", Flocking},
+        {"arena", ParticleArenas},
+        {"budget", ParticleBudgets},
+        {"voxelmemory", VoxelStorage},
+        {"voxelsim", VoxelSimulation},
+        {"voxelmesh", VoxelMeshing},
+        {"voxelremove", VoxelRemoval},
+    };
+
+    void Report(const std::string& name, double nsPerOp, double baselineNsPerOp)
+    {
+        if (baselineNsPerOp > 0.0)
+        {
+            std::printf("  %-40s %10.2f ns  (%.2fx)\n", name.c_str(), nsPerOp, baselineNsPerOp / nsPerOp);
+        }
+        else
+        {
+            std::printf("  %-40s %10.2f ns\n", name.c_str(), nsPerOp);
+        }
+    }
+
+    void RNGEngines()
+    {
+        const int N = 1'000'000;
+        std::vector<float> floats(N);
+        std::vector<int> ints(N);
+        std::vector<glm::vec3> vectors(N);
+
+        RNG rng(4545);
+        CounterRNG counter(4545);
+
+        std::printf("RNG engines (per value, speedup relative to RNG)\n");
+
+        // Single floats
+        double base = Time(N, [&](int i) { floats[i] = rng.NextFloat(-1.0f, 1.0f); });
+        Report("RNG::NextFloat", base);
+        Report("CounterRNG::NextFloat", Time(N, [&](int i) { floats[i] = counter.NextFloat(-1.0f, 1.0f); }), base);
+        Report("CounterRNG::FillFloats", Time(1, [&](int) { counter.FillFloats(floats.data(), N, -1.0f, 1.0f); }) / N, base);
+        Consume(floats[N / 2]);
+
+        // Single ints
+        base = Time(N, [&](int i) { ints[i] = rng.NextInt(0, 100); });
+        Report("RNG::NextInt", base);
+        Report("CounterRNG::NextInt", Time(N, [&](int i) { ints[i] = counter.NextInt(0, 100); }), base);
+        Report("CounterRNG::FillInts", Time(1, [&](int) { counter.FillInts(ints.data(), N, 0, 100); }) / N, base);
+        Consume(ints[N / 2]);
+
+        // Directions
+        base = Time(N, [&](int i) { vectors[i] = rng.RandomDirection(); });
+        Report("RNG::RandomDirection", base);
+        Report("CounterRNG::RandomDirection", Time(N, [&](int i) { vectors[i] = counter.RandomDirection(); }), base);
+        Report("CounterRNG::FillDirections", Time(1, [&](int) { counter.FillDirections(vectors.data(), N); }) / N, base);
+        Consume(vectors[N / 2]);
+
+        // Positions
+        glm::vec3 min(-5.0f), max(5.0f);
+        base = Time(N, [&](int i) { vectors[i] = rng.RandomPosition(min, max); });
+        Report("RNG::RandomPosition", base);
+        Report("CounterRNG::RandomPosition", Time(N, [&](int i) { vectors[i] = counter.RandomPosition(min, max); }), base);
+        Report("CounterRNG::FillPositions", Time(1, [&](int) { counter.FillPositions(vectors.data(), N, min, max); }) / N, base);
+        Consume(vectors[N / 2]);
+
+        // Sub-streams
+        Report("CounterRNG::Split + NextFloat", Time(N, [&](int i) { floats[i] = counter.Split(i).NextFloat(); }));
+        Consume(floats[N / 2]);
+    }
+
+    void Effects()
+    {
+        const float DELTA = 1.0f / 60.0f;
+        const int WARMUP_STEPS = 600;
+        const int STEPS = 3'600;
+
+        std::printf("Effects (per particle update, %d steps of %.4fs after %d warmup steps)\n", STEPS, DELTA, WARMUP_STEPS);
+
+        for (const auto& path : HeadlessEffects::Find())
+        {
+            CPUParticleEffect effect;
+            HeadlessEffects::Load(effect, path);
+
+            // Reach a steady state before measuring
+            for (int i = 0; i < WARMUP_STEPS; ++i) HeadlessEffects::Update(effect, DELTA);
+
+            // Measure
+            long long particleUpdates = 0;
+            double ns = Time(STEPS, [&](int)
+            {
+                particleUpdates += effect.GetActiveParticles();
+                HeadlessEffects::Update(effect, DELTA);
+            }) * STEPS;
+
+            Report(path.filename().string(), ns / std::max(particleUpdates, 1LL));
+        }
+    }
+
+    void EffectLoading()
+    {
+        const int ITERATIONS = 200;
+
+        std::printf("Effect loading (per load, speedup relative to YAML)\n");
+
+        for (const auto& path : HeadlessEffects::Find())
+        {
+            // Textures need an OpenGL context, so load copies with emitter textures removed
+            std::string yamlPath = HeadlessEffects::WriteCopy(path);
+            std::string binaryPath = yamlPath + "bin";
+
+            // Convert
+            CPUParticleEffect converted;
+            converted.Load(yamlPath);
+            converted.SaveBinary(binaryPath);
+
+            // Files are only read on their first load, later loads just create instances of the cached definitions
+            CPUParticleEffect loaded;
+            double base = Time(ITERATIONS, [&](int) { CPUParticleEffect::ClearCache(); loaded.Load(yamlPath); });
+            Report(path.filename().string() + " (YAML)", base);
+            Report(path.filename().string() + " (binary)", Time(ITERATIONS, [&](int) { CPUParticleEffect::ClearCache(); loaded.Load(binaryPath); }), base);
+            Report(path.filename().string() + " (cached)", Time(ITERATIONS, [&](int) { loaded.Load(yamlPath); }), base);
+
+            // What CPUParticleEffectPool::Acquire() does to a released instance
+            Report(path.filename().string() + " (pooled)", Time(ITERATIONS, [&](int) { loaded.Restart(); }), base);
+            CPUParticleEffect::ClearCache();
+
+            std::filesystem::remove(yamlPath);
+            std::filesystem::remove(binaryPath);
+        }
+    }
+
+    void AttractorFields()
+    {
+        const int PARTICLES = 16'384;
+        const int RESOLUTION = 32;
+        const float DELTA = 1.0f / 60.0f;
+
+        std::printf("Attractor fields (%d particles, %d^3 field, per particle update, speedup relative to exact)\n", PARTICLES, RESOLUTION);
+
+        CounterRNG rng(4545);
+        for (int count : {1, 8, 64})
+        {
+            // Attractors scattered through a 40m cube, particles filling the same volume
+            std::vector<ParticleKernels::AttractorData> attractors(count);
+            for (auto& a : attractors)
+            {
+                a.position = rng.RandomPosition(glm::vec3(-15.0f), glm::vec3(15.0f));
+                a.radius = rng.NextFloat(5.0f, 10.0f);
+                a.strength = rng.NextFloat(-25.0f, 25.0f);
+            }
+
+            ParticleData particles;
+            particles.Resize(PARTICLES);
+            for (int i = 0; i < PARTICLES; ++i)
+            {
+                glm::vec3 p = rng.RandomPosition(glm::vec3(-20.0f), glm::vec3(20.0f));
+                particles.posX[i] = p.x;
+                particles.posY[i] = p.y;
+                particles.posZ[i] = p.z;
+            }
+
+            // Exact path, one pass per attractor
+            double base = Time(50, [&](int)
+            {
+                for (const auto& a : attractors)
+                {
+                    ParticleKernels::Attract(particles.posX.data(), particles.posY.data(), particles.posZ.data(),
+                                             particles.velX.data(), particles.velY.data(), particles.velZ.data(),
+                                             a.position, a.radius, a.strength, DELTA, PARTICLES);
+                }
+            }) / PARTICLES;
+            Report(std::to_string(count) + " attractors (exact)", base);
+
+            // Baked path
+            AttractorField field;
+            double bake = Time(5, [&](int) { field.Bake(attractors.data(), count, RESOLUTION); });
+            Report(std::to_string(count) + " attractors (baked)", Time(50, [&](int)
+            {
+                field.Apply(particles.posX.data(), particles.posY.data(), particles.posZ.data(),
+                            particles.velX.data(), particles.velY.data(), particles.velZ.data(), DELTA, PARTICLES);
+            }) / PARTICLES, base);
+            Report(std::to_string(count) + " attractors (bake, whole field)", bake);
+
+            // Acceleration error against the exact field, and against the analytic bound
+            double maxError = 0.0, totalError = 0.0, maxBound = 0.0;
+            int violations = 0;
+            for (int i = 0; i < PARTICLES; ++i)
+            {
+                glm::vec3 p(particles.posX[i], particles.posY[i], particles.posZ[i]);
+                float error = glm::distance(field.Sample(p), AttractorField::Evaluate(attractors.data(), count, p));
+                float bound = field.ErrorBound(p);
+                maxError = std::max(maxError, (double)error);
+                maxBound = std::max(maxBound, (double)bound);
+                totalError += error;
+                if (error > bound * 1.0001f + 1e-4f) violations++;
+            }
+            std::printf("  %-40s mean %.4f, max %.4f m/s^2 (bound max %.4f, %d over bound)\n",
+                "  acceleration error", totalError / PARTICLES, maxError, maxBound, violations);
+        }
+    }
+
+    void DepthSorting()
+    {
+        const int EMITTERS = 8;
+        const int PARTICLES = 16'384;
+        const int TOTAL = EMITTERS * PARTICLES;
+
+        std::printf("Depth sorting (%d emitters x %d particles, per frame, speedup relative to std::sort)\n", EMITTERS, PARTICLES);
+
+        // Particles scattered through a 100m cube in front of the camera
+        CounterRNG rng(4545);
+        std::vector<ParticleData> emitters(EMITTERS);
+        for (auto& particles : emitters)
+        {
+            particles.Resize(PARTICLES);
+            for (int i = 0; i < PARTICLES; ++i)
+            {
+                glm::vec3 p = rng.RandomPosition(glm::vec3(-50.0f), glm::vec3(50.0f));
+                particles.posX[i] = p.x;
+                particles.posY[i] = p.y;
+                particles.posZ[i] = p.z;
+            }
+        }
+        glm::mat4 view = glm::lookAt(glm::vec3(60.0f, 20.0f, 90.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        // Comparison sort on exact depths
+        std::vector<uint32_t> order(PARTICLES);
+        std::vector<float> depths(PARTICLES);
+        double base = Time(20, [&](int)
+        {
+            for (auto& particles : emitters)
+            {
+                for (int i = 0; i < PARTICLES; ++i)
+                {
+                    depths[i] = -(view[0][2] * particles.posX[i] + view[1][2] * particles.posY[i] + view[2][2] * particles.posZ[i] + view[3][2]);
+                    order[i] = i;
+                }
+                std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return depths[a] > depths[b]; });
+                Consume(order[0]);
+            }
+        });
+        Report("std::sort", base);
+
+        // Radix sort on quantized keys
+        ParticleSorter sorter;
+        Report("ParticleSorter", Time(20, [&](int)
+        {
+            for (auto& particles : emitters)
+            {
+                Consume(sorter.Sort(particles.posX.data(), particles.posY.data(), particles.posZ.data(), PARTICLES, view));
+            }
+        }), base);
+
+        // Ordering quality: depth increases between consecutive particles only within the quantization step
+        int inversions = 0;
+        float maxInversion = 0.0f;
+        for (auto& particles : emitters)
+        {
+            sorter.Sort(particles.posX.data(), particles.posY.data(), particles.posZ.data(), PARTICLES, view);
+            const uint32_t* sorted = sorter.GetOrder();
+            float previous = INFINITY;
+            for (int j = 0; j < PARTICLES; ++j)
+            {
+                int i = sorted[j];
+                float depth = -(view[0][2] * particles.posX[i] + view[1][2] * particles.posY[i] + view[2][2] * particles.posZ[i] + view[3][2]);
+                if (depth > previous)
+                {
+                    inversions++;
+                    maxInversion = std::max(maxInversion, depth - previous);
+                }
+                previous = depth;
+            }
+        }
+        std::printf("  %-40s %d of %d pairs, max %.5f m\n", "  order inversions", inversions, TOTAL, maxInversion);
+    }
+
+    void VoxelCollision()
+    {
+        const int PARTICLES = 32'768;
+        const float DELTA = 1.0f / 60.0f;
+
+        std::printf("Voxel collision (%d particles, 64^3 voxel object, per particle, speedup relative to Raycast)\n", PARTICLES);
+
+        // Uneven ground filling the bottom of the object
+        CounterRNG rng(4545);
+        VoxelObject object(64, 64, 64, glm::ivec3(-32));
+        for (int z = -32; z < 32; ++z)
+        {
+            for (int x = -32; x < 32; ++x)
+            {
+                int height = rng.NextInt(-24, -16);
+                for (int y = -32; y <= height; ++y) object.SetVoxel(x, y, z, 0);
+            }
+        }
+
+        // Rain falling through the volume above it
+        ParticleData source;
+        source.Resize(PARTICLES);
+        for (int i = 0; i < PARTICLES; ++i)
+        {
+            glm::vec3 p = rng.RandomPosition(glm::vec3(-32.0f, -15.0f, -32.0f), glm::vec3(32.0f));
+            glm::vec3 v = rng.RandomPosition(glm::vec3(-4.0f, -64.0f, -4.0f), glm::vec3(4.0f, -32.0f, 4.0f));
+            source.posX[i] = p.x;
+            source.posY[i] = p.y;
+            source.posZ[i] = p.z;
+            source.velX[i] = v.x;
+            source.velY[i] = v.y;
+            source.velZ[i] = v.z;
+        }
+
+        // One ray per particle along the distance it moved
+        double base = Time(5, [&](int)
+        {
+            int hits = 0;
+            for (int i = 0; i < PARTICLES; ++i)
+            {
+                glm::vec3 p(source.posX[i], source.posY[i], source.posZ[i]);
+                glm::vec3 v(source.velX[i], source.velY[i], source.velZ[i]);
+                auto info = object.Raycast(Ray(p - v * DELTA, glm::normalize(v)), 4);
+                if (info.firstHit >= 0) hits++;
+            }
+            Consume(hits);
+        }) / PARTICLES;
+        Report("Raycast", base);
+
+        // Occupancy lookups, excluding the cost of restoring the particles each iteration
+        ParticleCollider collider;
+        collider.AddObject(&object, glm::mat4(1.0f));
+        ParticleData particles;
+        particles.Resize(PARTICLES);
+        double copy = Time(20, [&](int) { particles = source; });
+        double collide = Time(20, [&](int)
+        {
+            particles = source;
+            Consume(collider.Collide(particles, 0, PARTICLES, DELTA, ParticleCollider::Response::Bounce, 0.5f));
+        });
+        Report("ParticleCollider", (collide - copy) / PARTICLES, base);
+
+        // Simulate two seconds of falling, no particle should ever come to rest inside the ground
+        const char* names[] = {"kill", "bounce", "stick"};
+        for (auto response : {ParticleCollider::Response::Kill, ParticleCollider::Response::Bounce, ParticleCollider::Response::Stick})
+        {
+            particles = source;
+            int collisions = 0, inside = 0;
+            for (int frame = 0; frame < 120; ++frame)
+            {
+                for (int i = 0; i < PARTICLES; ++i)
+                {
+                    if (particles.age[i] > 1.0f) continue;
+                    particles.velY[i] -= 9.81f * DELTA;
+                    particles.posX[i] += particles.velX[i] * DELTA;
+                    particles.posY[i] += particles.velY[i] * DELTA;
+                    particles.posZ[i] += particles.velZ[i] * DELTA;
+                }
+                collisions += collider.Collide(particles, 0, PARTICLES, DELTA, response, 0.5f);
+                for (int i = 0; i < PARTICLES; ++i)
+                {
+                    glm::ivec3 cell = glm::floor(glm::vec3(particles.posX[i], particles.posY[i], particles.posZ[i]));
+                    if (particles.age[i] <= 1.0f && object.IsSolid(cell.x, cell.y, cell.z)) inside++;
+                }
+            }
+            std::printf("  %-40s %d collisions, %d particle frames inside the ground\n", (std::string("  ") + names[(int)response]).c_str(), collisions, inside);
+        }
+    }
+
+    void Snapshots()
+    {
+        const float STEP = 1.0f / 60.0f;
+        const int WARMUP_FRAMES = 600;
+        const int FRAMES = 600;
+
+        std::printf("Snapshots (fixed %.4fs steps, %d warmup frames, %d frames replayed, restore speedup relative to warming up)\n", STEP, WARMUP_FRAMES, FRAMES);
+
+        // Frame deltas jitter around the step, so frames take zero, one or two steps
+        CounterRNG jitter(4545);
+        std::vector<float> deltas(WARMUP_FRAMES + FRAMES);
+        for (float& delta : deltas) delta = jitter.NextFloat(0.5f, 1.5f) * STEP;
+
+        ThreadPool pool(4);
+        for (const auto& path : HeadlessEffects::Find())
+        {
+            auto load = [&](CPUParticleEffect& effect)
+            {
+                HeadlessEffects::Load(effect, path);
+                effect.SetFixedTimestep(STEP);
+            };
+
+            // Warm up and snapshot
+            CPUParticleEffect original;
+            load(original);
+            double warmup = Time(1, [&](int)
+            {
+                for (int i = 0; i < WARMUP_FRAMES; ++i) HeadlessEffects::Update(original, deltas[i]);
+            });
+            std::vector<char> snapshot;
+            original.SaveSnapshot(snapshot);
+
+            // Continue on this thread, in order
+            for (int i = WARMUP_FRAMES; i < WARMUP_FRAMES + FRAMES; ++i) HeadlessEffects::Update(original, deltas[i]);
+            std::vector<char> expected;
+            original.SaveSnapshot(expected);
+
+            // Restore into a freshly loaded (and differently seeded) effect and replay across the pool
+            CPUParticleEffect restored;
+            load(restored);
+            double restore = Time(1, [&](int) { restored.LoadSnapshot(snapshot); });
+            for (int i = WARMUP_FRAMES; i < WARMUP_FRAMES + FRAMES; ++i) HeadlessEffects::Update(restored, deltas[i], &pool);
+            std::vector<char> replayed;
+            restored.SaveSnapshot(replayed);
+
+            Report(path.filename().string() + " (warmup)", warmup);
+            Report(path.filename().string() + " (restore)", restore, warmup);
+            std::printf("  %-40s %zu bytes, replay on %d threads %s\n", "  snapshot", snapshot.size(), pool.GetThreadCount(),
+                replayed == expected ? "bit-exact" : "DIFFERS");
+        }
+    }
+
+    void ParticlePools()
+    {
+        const float DELTA = 1.0f / 60.0f;
+        const int WARMUP_STEPS = 600;
+        const int STEPS = 3'600;
+
+        std::printf("Particle pools (per particle update at saturation, %d steps of %.4fs, speedup relative to the unordered pool)\n", STEPS, DELTA);
+
+        // Spawns twice as many particles as the pool holds over a lifespan, so the pool stays full and recycles every update
+        const char* EMITTER =
+            "{max_particles: 16384, spawn_mode: continuous, spawn_rate: 16384, seed: 4545,"
+            " particle_properties: {lifespan: {type: constant, value: 2.0}},"
+            " affectors: {gravity: true}}";
+
+        const char* lifespans[] = {"constant lifespan", "random lifespan"};
+        for (int l = 0; l < 2; ++l)
+        {
+            double baseline = 0.0;
+            for (int ordered = 0; ordered < 2; ++ordered)
+            {
+                YAML::Node node = YAML::Load(EMITTER);
+                if (l == 1) node["particle_properties"]["lifespan"] = YAML::Load("{type: random_min_max, min: 1.0, max: 3.0}");
+                node["ordered_pool"] = ordered == 1;
+                CPUParticleEmitter emitter(node);
+
+                for (int i = 0; i < WARMUP_STEPS; ++i) emitter.Update(DELTA);
+
+                long long particleUpdates = 0;
+                double ns = Time(STEPS, [&](int)
+                {
+                    particleUpdates += emitter.GetActiveParticles();
+                    emitter.Update(DELTA);
+                }) * STEPS;
+                ns /= std::max(particleUpdates, 1LL);
+
+                std::string name = std::string(lifespans[l]) + (ordered ? " (ordered)" : " (unordered)");
+                Report(name, ns, baseline);
+                if (!ordered) baseline = ns;
+            }
+        }
+    }
+
+    void Turbulence()
+    {
+        const int PARTICLES = 16'384;
+        const float DELTA = 1.0f / 60.0f;
+        const int STEPS = 600;
+        const float FREQUENCY = 0.25f;
+        const glm::vec3 SCROLL(0.0f, 0.5f, 0.0f);
+
+        std::printf("Turbulence (%d particles, per particle update, speedup relative to the first row of each group)\n", PARTICLES);
+
+        // Particles filling a 20m cube
+        CounterRNG rng(4545);
+        ParticleData particles;
+        particles.Resize(PARTICLES);
+        for (int i = 0; i < PARTICLES; ++i)
+        {
+            glm::vec3 p = rng.RandomPosition(glm::vec3(-10.0f), glm::vec3(10.0f));
+            particles.posX[i] = p.x;
+            particles.posY[i] = p.y;
+            particles.posZ[i] = p.z;
+        }
+
+        // Curl evaluated per particle straight from the noise vs the scrolling lattice
+        TurbulenceField field;
+        field.Cover(particles.posX.data(), particles.posY.data(), particles.posZ.data(), PARTICLES, FREQUENCY, glm::vec3(0.0f));
+        double base = Time(PARTICLES, [&](int i)
+        {
+            glm::vec3 p(particles.posX[i], particles.posY[i], particles.posZ[i]);
+            glm::vec3 curl = field.Evaluate(p);
+            particles.velX[i] += curl.x * DELTA;
+            particles.velY[i] += curl.y * DELTA;
+            particles.velZ[i] += curl.z * DELTA;
+        });
+        Report("per particle noise", base);
+
+        long long evaluated = field.GetEvaluatedSamples();
+        Report("lattice (scrolling)", Time(STEPS, [&](int i)
+        {
+            glm::vec3 offset = -SCROLL * (i * DELTA);
+            field.Cover(particles.posX.data(), particles.posY.data(), particles.posZ.data(), PARTICLES, FREQUENCY, offset);
+            field.Apply(particles.posX.data(), particles.posY.data(), particles.posZ.data(),
+                        particles.velX.data(), particles.velY.data(), particles.velZ.data(), 1.0f, DELTA, PARTICLES);
+        }) / PARTICLES, base);
+        std::printf("  %-40s %.1f lattice points per update (%lld on the first cover)\n", "  noise evaluations",
+            (double)(field.GetEvaluatedSamples() - evaluated) / STEPS, evaluated);
+
+        // Lattice error against the curl taken directly from the noise
+        double totalError = 0.0, maxError = 0.0, totalMagnitude = 0.0;
+        for (int i = 0; i < PARTICLES; ++i)
+        {
+            glm::vec3 p(particles.posX[i], particles.posY[i], particles.posZ[i]);
+            glm::vec3 exact = field.Evaluate(p);
+            float error = glm::distance(field.Sample(p), exact);
+            totalError += error;
+            maxError = std::max(maxError, (double)error);
+            totalMagnitude += glm::length(exact);
+        }
+        std::printf("  %-40s mean %.4f, max %.4f (mean curl magnitude %.4f)\n", "  curl error", totalError / PARTICLES, maxError, totalMagnitude / PARTICLES);
+
+        // Whole emitter updates: turbulence faked with 8 exact attractors vs the turbulence affector
+        const char* EMITTER =
+            "{max_particles: 16384, spawn_mode: continuous, spawn_rate: 4096, seed: 4545,"
+            " particle_properties: {position: {type: random_min_max, min: {x: -10, y: -10, z: -10}, max: {x: 10, y: 10, z: 10}},"
+            " lifespan: {type: constant, value: 4.0}}}";
+        double attractorsNs = 0.0;
+        for (int turbulence = 0; turbulence < 2; ++turbulence)
+        {
+            YAML::Node node = YAML::Load(EMITTER);
+            if (turbulence)
+            {
+                node["affectors"] = YAML::Load("{turbulence: true, turbulence_frequency: 0.25, turbulence_strength: 4.0}");
+            }
+            CPUParticleEmitter emitter(node);
+            if (!turbulence)
+            {
+                for (int a = 0; a < 8; ++a)
+                {
+                    emitter.Attractors().emplace_back(rng.RandomPosition(glm::vec3(-10.0f), glm::vec3(10.0f)), 6.0f, rng.NextFloat(-8.0f, 8.0f), false);
+                }
+                emitter.UpdateKernels();
+            }
+
+            for (int i = 0; i < STEPS; ++i) emitter.Update(DELTA);
+
+            long long particleUpdates = 0;
+            double ns = Time(STEPS, [&](int)
+            {
+                particleUpdates += emitter.GetActiveParticles();
+                emitter.Update(DELTA);
+            }) * STEPS / std::max(particleUpdates, 1LL);
+
+            Report(turbulence ? "emitter, turbulence affector" : "emitter, 8 attractors", ns, attractorsNs);
+            if (!turbulence) attractorsNs = ns;
+        }
+    }
+
+    void Packing()
+    {
+        const int PARTICLES = 16'384;
+
+        std::printf("Particle packing (%d particles, per particle, speedup relative to the interleaved float format)\n", PARTICLES);
+
+        // Particles scattered through a 20m cube far from the origin, with random sizes and colors,
+        // half of them HDR (like fire.effect's) and a few with every component at an exact half
+        CounterRNG rng(4545);
+        ParticleData particles;
+        particles.Resize(PARTICLES);
+        for (int i = 0; i < PARTICLES; ++i)
+        {
+            glm::vec3 p = rng.RandomPosition(glm::vec3(990.0f), glm::vec3(1010.0f));
+            particles.posX[i] = p.x;
+            particles.posY[i] = p.y;
+            particles.posZ[i] = p.z;
+            float intensity = i % 2 ? rng.NextFloat(1.0f, 8.0f) : 1.0f;
+            particles.colR[i] = rng.NextFloat(0.0f, intensity);
+            particles.colG[i] = rng.NextFloat(0.0f, intensity);
+            particles.colB[i] = rng.NextFloat(0.0f, intensity);
+            particles.colA[i] = rng.NextFloat(0.0f, 1.0f);
+            particles.sizeX[i] = rng.NextFloat(0.1f, 2.0f);
+            particles.sizeY[i] = particles.sizeX[i];
+        }
+        particles.colR[1] = particles.colG[1] = particles.colB[1] = 3.0f;
+        particles.colR[3] = particles.colG[3] = particles.colB[3] = 1.0f;
+
+        // The previous upload format, every simulated attribute as floats
+        struct Interleaved
+        {
+            glm::vec3 position;
+            glm::vec3 velocity;
+            glm::vec4 color;
+            glm::vec2 size;
+            float ageNormalized;
+            float lifespanNormalized;
+        };
+        std::vector<Interleaved> interleaved(PARTICLES);
+        double base = Time(200, [&](int)
+        {
+            for (int i = 0; i < PARTICLES; ++i)
+            {
+                Interleaved& particle = interleaved[i];
+                particle.position = glm::vec3(particles.posX[i], particles.posY[i], particles.posZ[i]);
+                particle.velocity = glm::vec3(particles.velX[i], particles.velY[i], particles.velZ[i]);
+                particle.color = glm::vec4(particles.colR[i], particles.colG[i], particles.colB[i], particles.colA[i]);
+                particle.size = glm::vec2(particles.sizeX[i], particles.sizeY[i]);
+                particle.ageNormalized = particles.age[i];
+                particle.lifespanNormalized = particles.invLifespan[i];
+            }
+            Consume(interleaved[0]);
+        }) / PARTICLES;
+        Report("interleaved (" + std::to_string(sizeof(Interleaved)) + " bytes)", base);
+
+        std::vector<PackedParticle> packed(PARTICLES);
+        glm::vec3 anchor;
+        Report("packed (" + std::to_string(sizeof(PackedParticle)) + " bytes)", Time(200, [&](int)
+        {
+            anchor = ParticlePacking::Anchor(particles, 0, PARTICLES);
+            ParticlePacking::Pack(packed.data(), particles, 0, PARTICLES, anchor);
+            Consume(packed[0]);
+        }) / PARTICLES, base);
+
+        // Round trip error, color relative to the particle's intensity
+        float positionError = 0.0f, sizeError = 0.0f, colorError = 0.0f;
+        for (int i = 0; i < PARTICLES; ++i)
+        {
+            glm::vec3 position(particles.posX[i], particles.posY[i], particles.posZ[i]);
+            glm::vec4 color(particles.colR[i], particles.colG[i], particles.colB[i], particles.colA[i]);
+            glm::vec2 size(particles.sizeX[i], particles.sizeY[i]);
+            float intensity = std::max({color.r, color.g, color.b, 1.0f});
+            positionError = std::max(positionError, glm::length(ParticlePacking::UnpackPosition(packed[i], anchor) - position));
+            sizeError = std::max(sizeError, glm::length(ParticlePacking::UnpackSize(packed[i]) - size));
+            colorError = std::max(colorError, glm::length(ParticlePacking::UnpackColor(packed[i]) - color) / intensity);
+        }
+        std::printf("  %-40s position %.5f m, size %.5f m, color %.5f (relative)\n", "  max round trip error", positionError, sizeError, colorError);
+
+        // Every component must be within half an RGBA8 step (scaled by the intensity, which
+        // rounds up by at most one part in 1024) of the original, and colors at an exact half
+        // must come back exactly
+        bool hdr = colorError <= 0.5f / 255.0f * 2.0f * (1.0f + 1.0f / 1024.0f) &&
+            glm::vec3(ParticlePacking::UnpackColor(packed[1])) == glm::vec3(3.0f) &&
+            glm::vec3(ParticlePacking::UnpackColor(packed[3])) == glm::vec3(1.0f);
+
+        // Packing one particle at a time takes the scalar path, which must match the four lane one
+        std::vector<PackedParticle> single(PARTICLES);
+        for (int i = 0; i < PARTICLES; ++i) ParticlePacking::Pack(&single[i], particles, i, 1, anchor);
+        bool exact = std::memcmp(single.data(), packed.data(), PARTICLES * sizeof(PackedParticle)) == 0;
+        std::printf("  %-40s HDR colors %s, scalar packing %s\n", "  round trip", hdr ? "preserved" : "CLAMPED", exact ? "bit-exact" : "DIFFERS");
+    }
+
+    void AnalyticEmitters()
+    {
+        const float DELTA = 1.0f / 60.0f;
+        const int WARMUP_STEPS = 600;
+        const int STEPS = 1'200;
+
+        std::printf("Analytic emitters (ballistic emitter at saturation, per particle, speedup relative to integrating it)\n");
+
+        // Fountain under gravity, with a tiny amount of damping to force the integrated path for comparison
+        const char* EMITTER =
+            "{max_particles: 16384, spawn_mode: continuous, spawn_rate: 8192, seed: 4545,"
+            " particle_properties: {lifespan: {type: constant, value: 2.0},"
+            " velocity: {type: random_min_max, min: {x: -2.0, y: 6.0, z: -2.0}, max: {x: 2.0, y: 10.0, z: 2.0}},"
+            " color: {type: lerp_over_lifetime, start_color: {r: 1.0, g: 0.8, b: 0.2}, end_color: {r: 0.8, g: 0.1, b: 0.0}}},"
+            " affectors: {gravity: true}}";
+
+        double baseline = 0.0;
+        for (int analytic = 0; analytic < 2; ++analytic)
+        {
+            YAML::Node node = YAML::Load(EMITTER);
+            if (!analytic) node["particle_properties"]["velocity"]["damping"] = 0.0001f;
+            CPUParticleEmitter emitter(node);
+
+            // Warming up is what analytic emitters make cheap, it only spawns and ages
+            double warmup = Time(1, [&](int)
+            {
+                for (int i = 0; i < WARMUP_STEPS; ++i) emitter.Update(DELTA);
+            });
+
+            long long particleUpdates = 0;
+            double ns = Time(STEPS, [&](int)
+            {
+                particleUpdates += emitter.GetActiveParticles();
+                emitter.Update(DELTA);
+            }) * STEPS;
+            ns /= std::max(particleUpdates, 1LL);
+
+            std::string name = emitter.IsAnalytic() ? "analytic" : "integrated";
+            Report(name + " (update)", ns, baseline);
+            std::printf("  %-40s %.2f ms for %d steps\n", "  warmup", warmup * 1e-6, WARMUP_STEPS);
+            if (!analytic) baseline = ns;
+        }
+
+        // What analytic emitters pay instead, once per frame they are drawn
+        const int PARTICLES = 16'384;
+        CounterRNG rng(4545);
+        ParticleData particles;
+        particles.Resize(PARTICLES);
+        for (int i = 0; i < PARTICLES; ++i)
+        {
+            glm::vec3 v = rng.RandomPosition(glm::vec3(-2.0f, 6.0f, -2.0f), glm::vec3(2.0f, 10.0f, 2.0f));
+            particles.velX[i] = v.x;
+            particles.velY[i] = v.y;
+            particles.velZ[i] = v.z;
+            particles.invLifespan[i] = 0.5f;
+            particles.age[i] = rng.NextFloat(0.0f, 1.0f);
+        }
+
+        ParticleData evaluated;
+        evaluated.Resize(PARTICLES);
+        Report("analytic (evaluate)", Time(200, [&](int)
+        {
+            ParticleKernels::Ballistic(particles, 0, PARTICLES, glm::vec3(0.0f, -9.81f, 0.0f), evaluated.posX.data(), evaluated.posY.data(), evaluated.posZ.data());
+            ParticleKernels::Lerp(evaluated.colR.data(), particles.age.data(), 1.0f, 0.8f, PARTICLES);
+            ParticleKernels::Lerp(evaluated.colG.data(), particles.age.data(), 0.8f, 0.1f, PARTICLES);
+            ParticleKernels::Lerp(evaluated.colB.data(), particles.age.data(), 0.2f, 0.0f, PARTICLES);
+            Consume(evaluated.posX[0]);
+        }) / PARTICLES, baseline);
+    }
+
+    void Flocking()
+    {
+        const float RADIUS = 0.5f;
+        const float DENSITY = 8.0f;
+        const float DELTA = 1.0f / 60.0f;
+        const int MAX_NEIGHBOURS = 16;
+
+        std::printf("Flocking (%.0f particles per cubic metre, %.1fm radius, per particle, speedup relative to testing every pair)\n", DENSITY, RADIUS);
+
+        for (int particleCount : {1'024, 4'096, 16'384})
+        {
+            // Constant density, so the grid's cost per particle should stay flat as the count grows
+            const float extent = std::cbrt(particleCount / DENSITY);
+            CounterRNG rng(4545);
+            ParticleData particles;
+            particles.Resize(particleCount);
+            for (int i = 0; i < particleCount; ++i)
+            {
+                glm::vec3 p = rng.RandomPosition(glm::vec3(0.0f), glm::vec3(extent));
+                glm::vec3 v = rng.RandomPosition(glm::vec3(-1.0f), glm::vec3(1.0f));
+                particles.posX[i] = p.x;
+                particles.posY[i] = p.y;
+                particles.posZ[i] = p.z;
+                particles.velX[i] = v.x;
+                particles.velY[i] = v.y;
+                particles.velZ[i] = v.z;
+            }
+
+            // Every pair, with the same forces as ParticleFlock and no neighbour limit
+            std::vector<glm::vec3> exact(particleCount);
+            double naive = Time(1, [&](int)
+            {
+                for (int i = 0; i < particleCount; ++i)
+                {
+                    glm::vec3 position(particles.posX[i], particles.posY[i], particles.posZ[i]);
+                    glm::vec3 velocity(particles.velX[i], particles.velY[i], particles.velZ[i]);
+                    glm::vec3 away(0.0f), offsetSum(0.0f), velocitySum(0.0f);
+                    int neighbours = 0;
+                    for (int j = 0; j < particleCount; ++j)
+                    {
+                        glm::vec3 offset = glm::vec3(particles.posX[j], particles.posY[j], particles.posZ[j]) - position;
+                        float distanceSquared = glm::dot(offset, offset);
+                        if (distanceSquared >= RADIUS * RADIUS || distanceSquared <= 0.0f) continue;
+
+                        float distance = std::sqrt(distanceSquared);
+                        away -= offset * ((1.0f - distance / RADIUS) / distance);
+                        offsetSum += offset;
+                        velocitySum += glm::vec3(particles.velX[j], particles.velY[j], particles.velZ[j]);
+                        neighbours++;
+                    }
+                    exact[i] = velocity;
+                    if (neighbours > 0)
+                    {
+                        exact[i] += (away * 4.0f + offsetSum / (float)neighbours + velocitySum / (float)neighbours - velocity) * DELTA;
+                    }
+                }
+                Consume(exact[0]);
+            }) / particleCount;
+
+            std::string name = std::to_string(particleCount) + " particles";
+            Report(name + " (every pair)", naive);
+
+            ParticleFlock flock;
+            for (int bounded = 0; bounded < 2; ++bounded)
+            {
+                const int maxNeighbours = bounded ? MAX_NEIGHBOURS : particleCount;
+                ParticleData::Stream velX, velY, velZ;
+                long long pairTests = 0;
+                double ns = Time(20, [&](int)
+                {
+                    velX = particles.velX;
+                    velY = particles.velY;
+                    velZ = particles.velZ;
+                    long long before = flock.GetPairTests();
+                    flock.Build(particles.posX.data(), particles.posY.data(), particles.posZ.data(), velX.data(), velY.data(), velZ.data(), particleCount, RADIUS);
+                    flock.Apply(velX.data(), velY.data(), velZ.data(), 4.0f, 1.0f, 1.0f, DELTA, maxNeighbours);
+                    pairTests = flock.GetPairTests() - before;
+                    Consume(velX[0]);
+                }) / particleCount;
+
+                float error = 0.0f;
+                for (int i = 0; i < particleCount; ++i) error = std::max(error, glm::length(glm::vec3(velX[i], velY[i], velZ[i]) - exact[i]));
+
+                Report(name + (bounded ? " (grid, 16 neighbours)" : " (grid)"), ns, naive);
+                std::printf("  %-40s %.1f pair tests per particle, max velocity difference %.6f m/s\n", "", (double)pairTests / particleCount, error);
+            }
+        }
+
+        // Whole emitter updates with and without the affector, at saturation
+        for (int flocking = 0; flocking < 2; ++flocking)
+        {
+            YAML::Node node = YAML::Load(
+                "{max_particles: 16384, spawn_mode: continuous, spawn_rate: 8192, seed: 4545,"
+                " particle_properties: {lifespan: {type: constant, value: 2.0}, velocity: {damping: 0.5}}}");
+            if (flocking) node["affectors"] = YAML::Load("{flocking: true, flocking_radius: 0.5, max_neighbours: 16}");
+            CPUParticleEmitter emitter(node);
+            for (int i = 0; i < 240; ++i) emitter.Update(DELTA);
+
+            long long particleUpdates = 0;
+            double ns = Time(120, [&](int)
+            {
+                particleUpdates += emitter.GetActiveParticles();
+                emitter.Update(DELTA);
+            }) * 120;
+            ns /= std::max(particleUpdates, 1LL);
+
+            Report(flocking ? "emitter update, flocking" : "emitter update", ns, 0.0);
+        }
+    }
+
+    void ParticleArenas()
+    {
+        const int EMITTERS = 256;
+        const int ROUNDS = 20;
+
+        std::printf("Particle arena (%d emitters of up to 512 particles, per emitter created and destroyed, speedup relative to streams per emitter)\n", EMITTERS);
+
+        const CPUParticleEmitter prototype(YAML::Load("{max_particles: 512}"));
+        const auto& definition = prototype.GetDefinition();
+
+        // What every emitter used to do, fourteen streams of its own
+        double base = Time(ROUNDS, [&](int)
+        {
+            std::vector<ParticleData> pools(EMITTERS);
+            for (auto& pool : pools) pool.Resize(definition->maxActiveParticles);
+            Consume(pools[0].age[0]);
+        }) / EMITTERS;
+        Report("own streams (" + std::to_string(ParticleData::NUM_STREAMS) + " allocations each)", base);
+
+        ParticleArena& arena = CPUParticleEmitter::GetArena();
+        arena.Compact();
+        long long blockAllocations = arena.GetStats().blockAllocations;
+        double pooled = Time(ROUNDS, [&](int)
+        {
+            std::vector<CPUParticleEmitter> emitters;
+            emitters.reserve(EMITTERS);
+            for (int i = 0; i < EMITTERS; ++i) emitters.emplace_back(definition);
+            Consume(emitters[0]);
+        }) / EMITTERS;
+        blockAllocations = arena.GetStats().blockAllocations - blockAllocations;
+        Report("arena ranges", pooled, base);
+        std::printf("  %-40s %lld for %d emitters, vs %d\n", "  heap allocations of particle storage", blockAllocations, EMITTERS * ROUNDS, EMITTERS * ROUNDS * ParticleData::NUM_STREAMS);
+
+        // Closing the holes of destroyed emitters, as Scene::Update() does once all emitters are updated
+        std::vector<CPUParticleEmitter> emitters;
+        emitters.reserve(EMITTERS);
+        for (int i = 0; i < EMITTERS; ++i) emitters.emplace_back(definition);
+        std::vector<CPUParticleEmitter> kept;
+        kept.reserve(EMITTERS / 2);
+        for (int i = 0; i < EMITTERS; i += 2) kept.push_back(std::move(emitters[i]));
+        emitters.clear();
+
+        ParticleArena::Stats before = arena.GetStats();
+        int moved = 0;
+        double compact = Time(1, [&](int) { moved = arena.Compact(); });
+        ParticleArena::Stats after = arena.GetStats();
+        std::printf("  %-40s %.1f us, %d particles moved, %d -> %d blocks\n", "  compaction after destroying half", compact * 1e-3, moved, before.blocks, after.blocks);
+    }
+    void ParticleBudgets()
+    {
+        const float DELTA = 1.0f / 60.0f;
+        const int CALM_EMITTERS = 4;
+        const int SURGE_EMITTERS = 32;
+
+        // Seconds of calm, then a surge of emitters, then calm again
+        const float PHASES[3] = {3.0f, 6.0f, 8.0f};
+        const char* PHASE_NAMES[3] = {"calm", "surge", "after"};
+
+        std::printf("Particle budget (%d emitters surging to %d at 60 Hz, per frame simulation cost and quality scale)\n", CALM_EMITTERS, SURGE_EMITTERS);
+
+        const CPUParticleEmitter prototype(YAML::Load(
+            "{max_particles: 4096, spawn_rate: 1024,"
+            " particle_properties: {velocity: {type: random_min_max, min: {x: -1, y: 2, z: -1}, max: {x: 1, y: 4, z: 1}, damping: 0.5},"
+            " lifespan: {type: constant, value: 2}}}"));
+
+        struct Result
+        {
+            double meanMs[3] = {0.0, 0.0, 0.0};
+            double worstMs[3] = {0.0, 0.0, 0.0};
+            int peakParticles = 0;
+            int settledParticles = 0;
+            float minScale = 1.0f;
+            float recovery = -1.0f;
+        };
+
+        // Runs the scenario, measuring the same way Scene::Update() does
+        auto run = [&](int maxParticles, float maxMilliseconds)
+        {
+            ParticleBudget budget;
+            budget.GetSettings().maxParticles = maxParticles;
+            budget.GetSettings().maxMilliseconds = maxMilliseconds;
+
+            std::vector<CPUParticleEmitter> emitters;
+            emitters.reserve(SURGE_EMITTERS);
+            for (int i = 0; i < SURGE_EMITTERS; ++i) emitters.emplace_back(prototype.GetDefinition());
+
+            Result result;
+            float time = 0.0f;
+            for (int phase = 0; phase < 3; ++phase)
+            {
+                const int active = phase == 1 ? SURGE_EMITTERS : CALM_EMITTERS;
+                const int frames = (int)(PHASES[phase] / DELTA);
+                for (int frame = 0; frame < frames; ++frame, time += DELTA)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    int particles = 0;
+                    for (int i = 0; i < SURGE_EMITTERS; ++i)
+                    {
+                        emitters[i].SetBudgetScale(budget.GetScale());
+                        emitters[i].Update(DELTA, i < active, false);
+                        particles += emitters[i].GetActiveParticles();
+                    }
+                    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    budget.Update(particles, ms, DELTA);
+
+                    result.meanMs[phase] += ms / frames;
+                    result.worstMs[phase] = std::max(result.worstMs[phase], (double)ms);
+                    result.peakParticles = std::max(result.peakParticles, particles);
+                    if (phase == 1) result.settledParticles = particles;
+                    result.minScale = std::min(result.minScale, budget.GetStats().scale);
+                    if (phase == 2 && result.recovery < 0.0f && result.minScale < 1.0f && budget.GetStats().scale >= 1.0f) result.recovery = time - PHASES[0] - PHASES[1];
+                }
+            }
+            return result;
+        };
+
+        auto print = [&](const char* name, const Result& result)
+        {
+            std::printf("  %s\n", name);
+            for (int phase = 0; phase < 3; ++phase)
+            {
+                std::printf("    %-38s %8.3f ms mean, %8.3f ms worst\n", PHASE_NAMES[phase], result.meanMs[phase], result.worstMs[phase]);
+            }
+            std::printf("    %-38s %d particles peak, %d at the end of the surge\n", "particles", result.peakParticles, result.settledParticles);
+            std::printf("    %-38s lowest %.2f", "scale", result.minScale);
+            if (result.recovery >= 0.0f) std::printf(", full quality %.2fs after the surge\n", result.recovery);
+            else std::printf(", %s\n", result.minScale < 1.0f ? "not recovered" : "never degraded");
+        };
+
+        // Budgets of twice the calm load, so the surge (8x) is well over and the calm fits comfortably
+        Result unlimited = run(0, 0.0f);
+        print("no budget", unlimited);
+        print("particle budget", run(CALM_EMITTERS * 2 * 2'048, 0.0f));
+        print("time budget", run(0, (float)unlimited.meanMs[0] * 2.0f));
+    }
+
+    void VoxelStorage()
+    {
+        const int LOOKUPS = 1'000'000;
+
+        std::printf("Voxel storage (every model in data://models, dense index grid and voxel array vs bricks, lookups per voxel)\n");
+
+        // Gather model files in a stable order
+        std::vector<std::filesystem::path> paths;
+        for (const auto& entry : std::filesystem::directory_iterator(File::GlobalizePath("data://models")))
+        {
+            if (entry.path().extension() == ".vobj") paths.push_back(entry.path());
+        }
+        std::sort(paths.begin(), paths.end());
+
+        for (const auto& path : paths)
+        {
+            // Read the voxel positions, materials need a scene and don't affect storage
+            std::ifstream file(path);
+            std::vector<glm::ivec3> positions;
+            std::string line;
+            bool voxelSection = false, zAxisVertical = false;
+            while (std::getline(file, line))
+            {
+                if (line.empty() || line[0] == '#') continue;
+                if (line == ".z_axis_vertical") zAxisVertical = true;
+                if (line[0] == '.') { voxelSection = line == ".voxels"; continue; }
+                if (!voxelSection) continue;
+
+                glm::ivec3 p;
+                std::istringstream(line) >> p.x >> p.y >> p.z;
+                if (zAxisVertical) std::swap(p.y, p.z);
+                positions.push_back(p);
+            }
+            if (positions.empty()) continue;
+
+            glm::ivec3 min = positions[0], max = positions[0];
+            for (const auto& p : positions)
+            {
+                min = glm::min(min, p);
+                max = glm::max(max, p);
+            }
+            glm::ivec3 size = max - min + 1;
+
+            // The previous layout, an index per cell of the bounds and a voxel with its position per voxel
+            Grid3D<int> grid(size.x, size.y, size.z, -1);
+            std::vector<Voxel> voxels;
+            for (const auto& p : positions)
+            {
+                int& index = grid(p.x - min.x, p.y - min.y, p.z - min.z);
+                if (index != -1) continue;
+                index = (int)voxels.size();
+                Voxel voxel;
+                voxel.x = p.x;
+                voxel.y = p.y;
+                voxel.z = p.z;
+                voxel.material = 0;
+                voxels.push_back(voxel);
+            }
+            size_t dense = (size_t)size.x * size.y * size.z * sizeof(int) + voxels.size() * sizeof(Voxel);
+
+            VoxelObject object(size.x, size.y, size.z, min);
+            for (const auto& p : positions) object.SetVoxel(p.x, p.y, p.z, 0);
+            size_t sparse = object.GetMemoryUsage();
+
+            std::printf("  %-40s %zu voxels in %dx%dx%d, %.1f KiB -> %.1f KiB (%.1fx smaller)\n", path.filename().string().c_str(),
+                        object.GetVoxelCount(), size.x, size.y, size.z, dense / 1024.0, sparse / 1024.0, (double)dense / sparse);
+
+            // Occupancy lookups at random positions within the bounds
+            CounterRNG rng(4545);
+            std::vector<glm::ivec3> queries(LOOKUPS);
+            for (auto& q : queries) q = glm::ivec3(rng.NextInt(0, size.x - 1), rng.NextInt(0, size.y - 1), rng.NextInt(0, size.z - 1));
+
+            double denseLookup = Time(1, [&](int)
+            {
+                int solid = 0;
+                for (const auto& q : queries) solid += grid(q.x, q.y, q.z) != -1;
+                Consume(solid);
+            }) / LOOKUPS;
+            double sparseLookup = Time(1, [&](int)
+            {
+                int solid = 0;
+                for (const auto& q : queries) solid += object.IsSolid(q.x + min.x, q.y + min.y, q.z + min.z);
+                Consume(solid);
+            }) / LOOKUPS;
+            Report("  dense lookup", denseLookup);
+            Report("  brick lookup (IsSolid)", sparseLookup, denseLookup);
+        }
+    }
+
+    void VoxelSimulation()
+    {
+        const glm::ivec3 SIZE(96, 48, 96);
+        const int TICKS = 60;
+
+        // Stone, water, wood and lava
+        std::vector<VoxelMaterial> materials;
+        materials.emplace_back("stone", VoxelMaterial::Flags::Solid);
+        materials.emplace_back("water", VoxelMaterial::Flags::Liquid);
+        materials.emplace_back("wood", VoxelMaterial::Flags::Solid);
+        materials.emplace_back("lava", VoxelMaterial::Flags::Liquid | VoxelMaterial::Flags::Fire);
+        materials[2].flammability = 0.5f;
+
+        // A stone basin with a raised block of water inside, and a wooden pier with lava spilling onto it
+        auto build = [&](VoxelObject& object)
+        {
+            object.SetSeed(4545);
+            object.Enable(VoxelObject::Flags::SimulateFluids | VoxelObject::Flags::SimulateFire);
+            for (int z = 0; z < SIZE.z; ++z)
+            {
+                for (int x = 0; x < SIZE.x; ++x)
+                {
+                    bool wall = x == 0 || z == 0 || x == SIZE.x - 1 || z == SIZE.z - 1;
+                    for (int y = 0; y < SIZE.y; ++y)
+                    {
+                        if (y == 0 || (wall && y < SIZE.y / 2)) object.SetVoxel(x, y, z, 0);
+                        else if (x >= 8 && x < 56 && z >= 8 && z < 88 && y >= 16 && y < 40) object.SetVoxel(x, y, z, 1);
+                        else if (x >= 64 && x < 88 && z >= 40 && z < 56 && y == 20) object.SetVoxel(x, y, z, 2);
+                        else if (x >= 70 && x < 82 && z >= 44 && z < 52 && y >= 30 && y < 34) object.SetVoxel(x, y, z, 3);
+                    }
+                }
+            }
+        };
+
+        // Hash of every voxel, to compare runs
+        auto hash = [&](VoxelObject& object)
+        {
+            uint64_t h = 1469598103934665603ull;
+            for (int z = 0; z < SIZE.z; ++z)
+            {
+                for (int y = 0; y < SIZE.y; ++y)
+                {
+                    for (int x = 0; x < SIZE.x; ++x)
+                    {
+                        Voxel v = object.GetVoxel(x, y, z);
+                        h = (h ^ (uint16_t)v.material) * 1099511628211ull;
+                        h = (h ^ v.flags) * 1099511628211ull;
+                    }
+                }
+            }
+            return h;
+        };
+
+        VoxelObject reference(SIZE.x, SIZE.y, SIZE.z, glm::ivec3(0));
+        build(reference);
+        double base = 0.0;
+        std::printf("Voxel simulation (%zu voxels in %dx%dx%d, fluid and fire, per voxel per tick over %d ticks, speedup relative to in place)\n",
+                    reference.GetVoxelCount(), SIZE.x, SIZE.y, SIZE.z, TICKS);
+
+        // What VoxelObject used to do: one serial pass over a voxel array indexed by a dense grid,
+        // moving voxels in place, so results depend on the order voxels were added in
+        {
+            Grid3D<int> grid(SIZE.x, SIZE.y, SIZE.z, -1);
+            std::vector<Voxel> voxels;
+            for (int z = 0; z < SIZE.z; ++z)
+            {
+                for (int y = 0; y < SIZE.y; ++y)
+                {
+                    for (int x = 0; x < SIZE.x; ++x)
+                    {
+                        Voxel v = reference.GetVoxel(x, y, z);
+                        if (v.material == -1) continue;
+                        grid(x, y, z) = (int)voxels.size();
+                        voxels.push_back(v);
+                    }
+                }
+            }
+
+            CounterRNG rng;
+            const glm::ivec3 directions[6] = { {0, -1, 0}, {0, 1, 0}, {-1, 0, 0}, {1, 0, 0}, {0, 0, -1}, {0, 0, 1} };
+            auto inside = [&](const glm::ivec3& p) { return glm::all(glm::greaterThanEqual(p, glm::ivec3(0))) && glm::all(glm::lessThan(p, SIZE)); };
+            double ns = Time(TICKS, [&](int)
+            {
+                for (auto& voxel : voxels)
+                {
+                    const auto& material = materials[voxel.material];
+                    glm::ivec3 p(voxel.x, voxel.y, voxel.z);
+                    if ((material.flags & VoxelMaterial::Flags::Fire) || (voxel.flags & Voxel::Flags::OnFire))
+                    {
+                        for (const auto& d : directions)
+                        {
+                            if (!inside(p + d) || grid(p.x + d.x, p.y + d.y, p.z + d.z) == -1) continue;
+                            Voxel& neighbour = voxels[grid(p.x + d.x, p.y + d.y, p.z + d.z)];
+                            float flammability = materials[neighbour.material].flammability;
+                            if (flammability >= 1.0f || rng.NextFloat(0.0f, 1.0f) * 30 < flammability) neighbour.flags |= Voxel::Flags::OnFire;
+                        }
+                    }
+                    if (!(material.flags & VoxelMaterial::Flags::Liquid)) continue;
+
+                    int moves[6];
+                    int possibleMoves = 0, fluidNeighbours = 0;
+                    for (int i = 0; i < 6; ++i)
+                    {
+                        glm::ivec3 n = p + directions[i];
+                        if (!inside(n)) continue;
+                        int index = grid(n.x, n.y, n.z);
+                        if (index != -1) fluidNeighbours += (bool)(materials[voxels[index].material].flags & VoxelMaterial::Flags::Liquid);
+                        else if (i != 1) moves[possibleMoves++] = i;
+                    }
+                    if (possibleMoves == 0) continue;
+                    int move = moves[0] == 0 ? 0 : fluidNeighbours > 0 ? moves[rng.NextInt(0, possibleMoves - 1)] : -1;
+                    if (move == -1) continue;
+
+                    glm::ivec3 n = p + directions[move];
+                    std::swap(grid(p.x, p.y, p.z), grid(n.x, n.y, n.z));
+                    voxel.x = n.x;
+                    voxel.y = n.y;
+                    voxel.z = n.z;
+                }
+            }) / voxels.size();
+            Report("in place, serial", ns);
+            base = ns;
+        }
+
+        // Every brick simulated every tick, which the active set must match exactly
+        uint64_t expected = 0;
+        {
+            VoxelObject object(SIZE.x, SIZE.y, SIZE.z, glm::ivec3(0));
+            build(object);
+            object.SetSleepTicks(std::numeric_limits<int>::max());
+            Report("double buffered, every brick", Time(TICKS, [&](int) { object.Step(materials); }) / object.GetVoxelCount(), base);
+            expected = hash(object);
+        }
+
+        for (int threads : {1, 2, 4})
+        {
+            VoxelObject object(SIZE.x, SIZE.y, SIZE.z, glm::ivec3(0));
+            build(object);
+            std::unique_ptr<ThreadPool> pool(threads > 1 ? new ThreadPool(threads) : nullptr);
+            double ns = Time(TICKS, [&](int) { object.Step(materials, pool.get()); }) / object.GetVoxelCount();
+
+            Report("active bricks, " + std::to_string(threads) + (threads == 1 ? " thread" : " threads"), ns, base);
+            std::printf("  %-40s %s\n", "  result", hash(object) == expected ? "bit-exact" : "DIFFERS");
+        }
+
+        // A large static object with a small puddle and fire on it, where most bricks should be asleep
+        // Everything starts awake, so the first ticks aren't measured
+        std::printf("Voxel simulation, mostly static (stone block with a puddle and a fire, per tick over %d ticks after %d)\n", TICKS, TICKS);
+        auto buildStatic = [&](VoxelObject& object)
+        {
+            object.SetSeed(4545);
+            object.Enable(VoxelObject::Flags::SimulateFluids | VoxelObject::Flags::SimulateFire);
+            for (int z = 0; z < SIZE.z; ++z)
+            {
+                for (int y = 0; y < SIZE.y; ++y)
+                {
+                    for (int x = 0; x < SIZE.x; ++x)
+                    {
+                        if (y < 24) object.SetVoxel(x, y, z, 0);
+                        else if (x >= 20 && x < 28 && z >= 20 && z < 28 && y >= 30 && y < 34) object.SetVoxel(x, y, z, 1);
+                        else if (x >= 60 && x < 76 && z >= 60 && z < 64 && y == 24) object.SetVoxel(x, y, z, 2);
+                        else if (x == 60 && z == 60 && y == 25) object.SetVoxel(x, y, z, 3);
+                    }
+                }
+            }
+        };
+
+        {
+            VoxelObject object(SIZE.x, SIZE.y, SIZE.z, glm::ivec3(0));
+            buildStatic(object);
+            object.SetSleepTicks(std::numeric_limits<int>::max());
+            for (int i = 0; i < TICKS; ++i) object.Step(materials);
+            double every = Time(TICKS, [&](int) { object.Step(materials); });
+            Report("every brick (" + std::to_string(object.GetVoxelCount()) + " voxels)", every);
+            expected = hash(object);
+
+            VoxelObject active(SIZE.x, SIZE.y, SIZE.z, glm::ivec3(0));
+            buildStatic(active);
+            for (int i = 0; i < TICKS; ++i) active.Step(materials);
+            int activeBricks = 0;
+            double ns = Time(TICKS, [&](int) { active.Step(materials); activeBricks += active.GetActiveBrickCount(); });
+            Report("active bricks", ns, every);
+            std::printf("  %-40s %s\n", "  result", hash(active) == expected ? "bit-exact" : "DIFFERS");
+            std::printf("  %-40s %.1f bricks awake on average\n", "  active set", (double)activeBricks / TICKS);
+        }
+    }
+
+
+    void VoxelMeshing()
+    {
+        const int REBUILDS = 20;
+        const int UPDATES = 200;
+        const int CHANGES = 64;
+
+        std::printf("Voxel meshing (every model in data://models, every voxel vs enclosed voxels culled, per rebuild or update)\n");
+
+        // Stone, and the same stone drawn differently for changes to switch to
+        std::vector<VoxelMaterial> materials;
+        materials.emplace_back("stone", VoxelMaterial::Flags::Solid, 1);
+        materials.emplace_back("stone_painted", VoxelMaterial::Flags::Solid, 2);
+
+        // Gather model files in a stable order
+        std::vector<std::filesystem::path> paths;
+        for (const auto& entry : std::filesystem::directory_iterator(File::GlobalizePath("data://models")))
+        {
+            if (entry.path().extension() == ".vobj") paths.push_back(entry.path());
+        }
+        std::sort(paths.begin(), paths.end());
+
+        for (const auto& path : paths)
+        {
+            // Read the voxel positions, the model's materials need a scene
+            std::ifstream file(path);
+            std::vector<glm::ivec3> positions;
+            std::string line;
+            bool voxelSection = false, zAxisVertical = false;
+            while (std::getline(file, line))
+            {
+                if (line.empty() || line[0] == '#') continue;
+                if (line == ".z_axis_vertical") zAxisVertical = true;
+                if (line[0] == '.') { voxelSection = line == ".voxels"; continue; }
+                if (!voxelSection) continue;
+
+                glm::ivec3 p;
+                std::istringstream(line) >> p.x >> p.y >> p.z;
+                if (zAxisVertical) std::swap(p.y, p.z);
+                positions.push_back(p);
+            }
+            if (positions.empty()) continue;
+
+            glm::ivec3 min = positions[0], max = positions[0];
+            for (const auto& p : positions)
+            {
+                min = glm::min(min, p);
+                max = glm::max(max, p);
+            }
+            glm::ivec3 size = max - min + 1;
+
+            VoxelObject object(size.x, size.y, size.z, min);
+            for (const auto& p : positions) object.SetVoxel(p.x, p.y, p.z, 0);
+            std::printf("  %s, %zu voxels in %dx%dx%d\n", path.filename().string().c_str(), object.GetVoxelCount(), size.x, size.y, size.z);
+
+            // What UpdateMesh used to do, a vertex for every voxel of the object's bricks
+            VoxelBricks bricks(size.x, size.y, size.z);
+            for (const auto& p : positions) bricks.Set(p.x - min.x, p.y - min.y, p.z - min.z, 0);
+            std::vector<VoxelMesh::Vertex> vertices;
+            double base = Time(REBUILDS, [&](int)
+            {
+                vertices.clear();
+                bricks.ForEach([&](int x, int y, int z, int16_t material, uint16_t)
+                {
+                    vertices.push_back({ (int16_t)(x + min.x), (int16_t)(y + min.y), (int16_t)(z + min.z), (int16_t)materials[material].pbrID });
+                });
+            });
+            size_t allVertices = vertices.size();
+
+            // A list the object didn't fill is always rebuilt
+            std::vector<VoxelMesh::Vertex> culled;
+            double rebuild = Time(REBUILDS, [&](int) { culled.clear(); object.UpdateVertices(materials, culled); });
+            Report("  rebuild, every voxel", base);
+            Report("  rebuild, enclosed culled", rebuild, base);
+            std::printf("  %-40s %zu -> %zu (%.1f%% of voxels)\n", "  vertices", allVertices, culled.size(), 100.0 * culled.size() / allVertices);
+
+            // Repaint, remove and add voxels around the model's, then patch the list
+            CounterRNG rng(4545);
+            long long changedVertices = 0;
+            double update = Time(UPDATES, [&](int)
+            {
+                for (int i = 0; i < CHANGES; ++i)
+                {
+                    glm::ivec3 p = positions[rng.NextInt(0, (int)positions.size() - 1)];
+                    if (i % 3 == 1)
+                    {
+                        if (object.IsSolid(p.x, p.y, p.z)) object.SetVoxel(p.x, p.y, p.z, object.GetVoxel(p.x, p.y, p.z).material ^ 1);
+                        continue;
+                    }
+                    if (i % 3 == 2)
+                    {
+                        object.RemoveVoxel(p.x, p.y, p.z);
+                        continue;
+                    }
+
+                    glm::ivec3 n = glm::clamp(p + glm::ivec3(rng.NextInt(-1, 1), rng.NextInt(-1, 1), rng.NextInt(-1, 1)), min, max);
+                    if (!object.IsSolid(n.x, n.y, n.z)) object.SetVoxel(n.x, n.y, n.z, 0);
+                }
+
+                object.UpdateVertices(materials, culled, [&](size_t, size_t count) { changedVertices += count; });
+            });
+            Report("  " + std::to_string(CHANGES) + " changes, patched", update, rebuild);
+            std::printf("  %-40s %.1f of %zu vertices per update\n", "  changed", (double)changedVertices / UPDATES, culled.size());
+
+            // The patched list has to show the same voxels as a fresh one
+            std::vector<VoxelMesh::Vertex> fresh;
+            object.UpdateVertices(materials, fresh);
+            auto shown = [](std::vector<VoxelMesh::Vertex> list)
+            {
+                list.erase(std::remove_if(list.begin(), list.end(), [](const VoxelMesh::Vertex& v) { return v.material == VoxelMesh::HIDDEN_MATERIAL; }), list.end());
+                std::sort(list.begin(), list.end(), [](const VoxelMesh::Vertex& a, const VoxelMesh::Vertex& b)
+                {
+                    return std::tie(a.x, a.y, a.z, a.material) < std::tie(b.x, b.y, b.z, b.material);
+                });
+                return list;
+            };
+            std::vector<VoxelMesh::Vertex> patched = shown(culled), rebuilt = shown(fresh);
+            bool same = patched.size() == rebuilt.size() && std::memcmp(patched.data(), rebuilt.data(), patched.size() * sizeof(VoxelMesh::Vertex)) == 0;
+            std::printf("  %-40s %s (%zu hidden slots)\n", "  result", same ? "matches rebuild" : "DIFFERS", culled.size() - patched.size());
+        }
+    }
+
+    void VoxelRemoval()
+    {
+        const int SIZE = 64;
+
+        std::printf("Voxel removal (spheres out of a solid %d^3 block, per voxel removed, speedup relative to rebuilding)\n", SIZE);
+
+        auto build = [&](VoxelObject& object)
+        {
+            for (int z = 0; z < SIZE; ++z)
+            {
+                for (int y = 0; y < SIZE; ++y)
+                {
+                    for (int x = 0; x < SIZE; ++x) object.SetVoxel(x, y, z, 0);
+                }
+            }
+        };
+
+        for (int radius : {6, 13, 29})
+        {
+            std::vector<glm::ivec3> positions;
+            const glm::ivec3 center(SIZE / 2);
+            for (int z = 0; z < SIZE; ++z)
+            {
+                for (int y = 0; y < SIZE; ++y)
+                {
+                    for (int x = 0; x < SIZE; ++x)
+                    {
+                        glm::ivec3 d = glm::ivec3(x, y, z) - center;
+                        if (d.x * d.x + d.y * d.y + d.z * d.z <= radius * radius) positions.emplace_back(x, y, z);
+                    }
+                }
+            }
+            std::printf("  radius %d, %zu voxels\n", radius, positions.size());
+
+            // Without removal, the object had to be rebuilt from the voxels that are left
+            double base;
+            {
+                VoxelObject object(SIZE, SIZE, SIZE, glm::ivec3(0));
+                build(object);
+                base = Time(1, [&](int)
+                {
+                    VoxelObject rebuilt(SIZE, SIZE, SIZE, glm::ivec3(0));
+                    for (int z = 0; z < SIZE; ++z)
+                    {
+                        for (int y = 0; y < SIZE; ++y)
+                        {
+                            for (int x = 0; x < SIZE; ++x)
+                            {
+                                glm::ivec3 d = glm::ivec3(x, y, z) - center;
+                                if (d.x * d.x + d.y * d.y + d.z * d.z > radius * radius) rebuilt.SetVoxel(x, y, z, object.GetVoxel(x, y, z).material);
+                            }
+                        }
+                    }
+                    Consume(rebuilt.GetVoxelCount());
+                }) / positions.size();
+            }
+            Report("  rebuild without them", base);
+
+            VoxelObject single(SIZE, SIZE, SIZE, glm::ivec3(0));
+            build(single);
+            Report("  RemoveVoxel", Time(1, [&](int)
+            {
+                for (const auto& p : positions) single.RemoveVoxel(p.x, p.y, p.z);
+            }) / positions.size(), base);
+
+            VoxelObject batched(SIZE, SIZE, SIZE, glm::ivec3(0));
+            build(batched);
+            size_t removed = 0;
+            Report("  RemoveVoxels", Time(1, [&](int) { removed = batched.RemoveVoxels(positions.data(), positions.size()); }) / positions.size(), base);
+            std::printf("  %-40s %zu removed, %zu left\n", "  result", removed, batched.GetVoxelCount());
+        }
+
+        // The AABB only shrinks once asked to
+        VoxelObject object(SIZE, SIZE, SIZE, glm::ivec3(0));
+        build(object);
+        std::vector<glm::ivec3> half;
+        for (int z = 0; z < SIZE; ++z)
+        {
+            for (int y = 0; y < SIZE; ++y)
+            {
+                for (int x = SIZE / 2 - 3; x < SIZE; ++x) half.emplace_back(x, y, z);
+            }
+        }
+        object.RemoveVoxels(half.data(), half.size());
+        const IAABB& aabb = object.GetAABB();
+        std::printf("  %-40s x %d..%d before UpdateAABB, ", "AABB after removing x >= 29", aabb.min.x, aabb.max.x);
+        object.UpdateAABB();
+        std::printf("x %d..%d after\n", aabb.min.x, aabb.max.x);
+    }
+
+}
+
+int main(int argc, char** argv)
+{
+    // Resolve data:// and phi:// paths relative to the working directory
+    File::Init();
+
+    // Run everything by default, otherwise only the requested benchmarks
+    for (const auto& benchmark : Benchmark::BENCHMARKS)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], benchmark.name) == 0) selected = true;
+        }
+
+        if (selected)
+        {
+            benchmark.run();
+            std::printf("\n");
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// Phi engine
+#include <phi/phi.hpp>
+
+using namespace Phi;
+
+// Headless micro-benchmarks for engine systems
+//
+// Usage: benchmark [name ...]
+// Runs every registered benchmark when no names are given
+namespace Benchmark
+{
+    // Returns the average number of nanoseconds per iteration of fn
+    template <typename F>
+    double Time(int iterations, F&& fn)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) fn(i);
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    }
+
+    // Keeps the optimizer from discarding a computed value
+    template <typename T>
+    void Consume(const T& value)
+    {
+        static volatile char sink;
+        sink = *(const volatile char*)&value;
+        (void)sink;
+    }
+
+    // Prints a single result row
+    void Report(const std::string& name, double nsPerOp, double baselineNsPerOp = 0.0);
+
+    // Benchmarks
+
+    // RNG vs CounterRNG, single value and bulk generation
+    void RNGEngines();
+
+    // Steady-state simulation cost of every effect in data://effects
+    void Effects();
+
+    // Load time of every effect in data://effects, YAML vs compiled binary
+    void EffectLoading();
+
+    // Exact attractors vs a baked AttractorField, with error measurements
+    void AttractorFields();
+
+    // std::sort vs ParticleSorter ordering of particles back to front
+    void DepthSorting();
+
+    // Per particle Raycast vs ParticleCollider occupancy lookups against a voxel object
+    void VoxelCollision();
+
+    // Warming effects up vs restoring a snapshot, and bit-exact replay from it across threads
+    void Snapshots();
+
+    // Unordered (swap with last) vs ordered (spawn order) particle pools under saturation
+    void ParticlePools();
+
+    // Curl noise turbulence per particle vs a scrolling lattice, and vs faking it with attractors
+    void Turbulence();
+
+    // Packing particles into the interleaved float upload format vs the quantized one
+    void Packing();
+
+    // Integrating a ballistic emitter vs evaluating it in closed form, and what evaluation costs when drawn
+    void AnalyticEmitters();
+
+    // Flocking by testing every pair vs ParticleFlock's counting sort grid, at increasing particle counts
+    void Flocking();
+
+    // Particle storage per emitter vs ranges of the shared ParticleArena, and compacting it
+    void ParticleArenas();
+
+    // A surge of emitters without a ParticleBudget vs with particle and time budgets, and recovery after it
+    void ParticleBudgets();
+
+    // Memory of every model as a dense index grid and voxel array vs VoxelObject's bricks, and lookup cost
+    void VoxelStorage();
+
+    // Fluid and fire simulation of a VoxelObject on 1, 2 and 4 threads, with and without sleeping bricks, and that all give the same result
+    void VoxelSimulation();
+
+    // Rebuilding every model's mesh from every voxel vs culling enclosed ones, and patching it after small edits
+    void VoxelMeshing();
+
+    // Rebuilding a VoxelObject without some of its voxels vs removing them one at a time and in a batch
+    void VoxelRemoval();
+}
\ No newline at end of file
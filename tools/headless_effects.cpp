@@ -0,0 +1,69 @@
+#include "headless_effects.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+    // Updates queued by Update(), reused across calls so steady-state updates don't allocate
+    thread_local std::vector<CPUParticleEffect::EmitterUpdate> queued;
+}
+
+namespace HeadlessEffects
+{
+    std::vector<std::filesystem::path> Find(const std::string& directory)
+    {
+        std::vector<std::filesystem::path> paths;
+        for (const auto& entry : std::filesystem::directory_iterator(File::GlobalizePath(directory)))
+        {
+            if (entry.path().extension() == ".effect") paths.push_back(entry.path());
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    std::string WriteCopy(const std::filesystem::path& path)
+    {
+        YAML::Node effect = YAML::LoadFile(path.string());
+        YAML::Node emitters = effect["emitters"];
+        for (size_t i = 0; i < emitters.size(); ++i)
+        {
+            if (emitters[i]["file"]) emitters[i] = YAML::LoadFile(File::GlobalizePath(emitters[i]["file"].as<std::string>()));
+            emitters[i].remove("texture");
+        }
+
+        std::string copyPath = (std::filesystem::temp_directory_path() / ("phi_headless_" + path.filename().string())).generic_string();
+        YAML::Emitter out;
+        out << effect;
+        std::ofstream(copyPath) << out.c_str();
+        return copyPath;
+    }
+
+    bool Load(CPUParticleEffect& effect, const std::filesystem::path& path)
+    {
+        std::string copyPath = WriteCopy(path);
+        bool loaded = effect.Load(copyPath);
+        std::filesystem::remove(copyPath);
+
+        // Grow the update queue now rather than during the first measured update
+        queued.reserve(effect.GetEmitterCount());
+        return loaded;
+    }
+
+    void Update(CPUParticleEffect& effect, float delta, ThreadPool* pool)
+    {
+        std::vector<CPUParticleEffect::EmitterUpdate>& updates = queued;
+        updates.clear();
+        effect.QueueDetachedUpdates(updates, delta);
+
+        if (pool)
+        {
+            // Workers see their own thread_local, so they go through the reference
+            pool->ParallelFor((int)updates.size(), [&updates](int i) { updates[i].Run(); });
+        }
+        else
+        {
+            for (const auto& update : updates) update.Run();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Phi engine
+#include <phi/phi.hpp>
+
+using namespace Phi;
+
+// Loading and simulating particle effects without an OpenGL context or a scene, shared by the benchmarks
+//
+// Effects go through CPUParticleEffect::Load(), so effect settings like fixed_timestep,
+// max_substeps, spawn_relative and render_relative apply exactly as they do in the engine
+namespace HeadlessEffects
+{
+    // Returns the paths of every .effect file in the given directory, in a stable order
+    std::vector<std::filesystem::path> Find(const std::string& directory = "data://effects");
+
+    // Writes a copy of the effect at path to the temp directory and returns its path
+    // Textures need an OpenGL context and don't affect simulation, so they are removed,
+    // and emitters included from other files are inlined so theirs are removed too
+    // The caller removes the copy once done with it
+    std::string WriteCopy(const std::filesystem::path& path);
+
+    // Loads the effect at path into effect through a temporary copy (see WriteCopy())
+    bool Load(CPUParticleEffect& effect, const std::filesystem::path& path);
+
+    // Updates every emitter of the effect, across the pool if given
+    // See CPUParticleEffect::QueueDetachedUpdates()
+    void Update(CPUParticleEffect& effect, float delta, ThreadPool* pool = nullptr);
+}
\ No newline at end of file
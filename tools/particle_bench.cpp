@@ -0,0 +1,224 @@
+#include "particle_bench.hpp"
+#include "headless_effects.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <vector>
+
+// Allocation tracking
+//
+// Every global allocation in the program goes through these replacements,
+// counted only while a simulation is being measured
+namespace
+{
+    std::atomic<bool> trackAllocations{false};
+    std::atomic<long long> allocationCount{0};
+    std::atomic<long long> allocationBytes{0};
+
+    void Track(size_t size)
+    {
+        if (trackAllocations.load(std::memory_order_relaxed))
+        {
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+            allocationBytes.fetch_add((long long)size, std::memory_order_relaxed);
+        }
+    }
+
+    void* Allocate(size_t size)
+    {
+        Track(size);
+        void* p = std::malloc(size ? size : 1);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+
+    void* AllocateAligned(size_t size, std::align_val_t alignment)
+    {
+        Track(size);
+        size_t align = std::max((size_t)alignment, sizeof(void*));
+#ifdef _MSC_VER
+        void* p = _aligned_malloc(size ? size : 1, align);
+#else
+        // aligned_alloc requires the size to be a multiple of the alignment
+        void* p = std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align);
+#endif
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+
+    void FreeAligned(void* p)
+    {
+#ifdef _MSC_VER
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+
+void* operator new(size_t size) { return Allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { FreeAligned(p); }
+
+namespace ParticleBench
+{
+    EffectResult Run(const std::string& path, float seconds, float delta)
+    {
+        EffectResult result;
+        result.name = std::filesystem::path(path).filename().string();
+
+        CPUParticleEffect effect;
+        HeadlessEffects::Load(effect, path);
+        result.emitters = effect.GetEmitterCount();
+
+        // Simulate from a cold start, so spawn ramp-up is part of the measurement
+        result.updates = std::max((int)std::ceil(seconds / delta), 1);
+        allocationCount = 0;
+        allocationBytes = 0;
+        trackAllocations = true;
+        for (int i = 0; i < result.updates; ++i)
+        {
+            int active = effect.GetActiveParticles();
+            auto start = std::chrono::high_resolution_clock::now();
+            HeadlessEffects::Update(effect, delta);
+            auto end = std::chrono::high_resolution_clock::now();
+
+            result.totalNs += std::chrono::duration<double, std::nano>(end - start).count();
+            result.particleUpdates += active;
+            result.peakActiveParticles = std::max(result.peakActiveParticles, active);
+        }
+        trackAllocations = false;
+        result.allocations = allocationCount;
+        result.allocatedBytes = allocationBytes;
+
+        return result;
+    }
+
+    void WriteJSON(std::string& out, const EffectResult& result)
+    {
+        char buffer[512];
+        double nsPerParticle = result.particleUpdates > 0 ? result.totalNs / result.particleUpdates : 0.0;
+        std::snprintf(buffer, sizeof(buffer),
+            ", \"emitters\": %d, \"updates\": %d, \"particle_updates\": %lld, "
+            "\"ns_per_update\": %.1f, \"ns_per_particle_update\": %.3f, \"peak_active_particles\": %d, "
+            "\"allocations\": %lld, \"allocated_bytes\": %lld}",
+            result.emitters, result.updates, result.particleUpdates,
+            result.totalNs / std::max(result.updates, 1), nsPerParticle, result.peakActiveParticles,
+            result.allocations, result.allocatedBytes);
+        out += "    {\"name\": ";
+        WriteJSONString(out, result.name);
+        out += buffer;
+    }
+
+    void WriteJSONString(std::string& out, const std::string& value)
+    {
+        out += '"';
+        for (char c : value)
+        {
+            switch (c)
+            {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if ((unsigned char)c < 0x20)
+                    {
+                        // Other control characters, UTF-8 passes through unchanged
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+                        out += escaped;
+                    }
+                    else
+                    {
+                        out += c;
+                    }
+            }
+        }
+        out += '"';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // Resolve data:// and phi:// paths relative to the working directory
+    File::Init();
+
+    // Parse arguments
+    float seconds = 10.0f;
+    float delta = 1.0f / 60.0f;
+    std::string outputPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            seconds = std::strtof(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--delta") == 0 && i + 1 < argc)
+        {
+            delta = std::strtof(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [--seconds N] [--delta D] [--output path]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!(seconds > 0.0f) || !(delta > 0.0f))
+    {
+        std::fprintf(stderr, "Simulated time and delta must be positive\n");
+        return 1;
+    }
+
+    // Gather effect files in a stable order
+    std::vector<std::filesystem::path> paths = HeadlessEffects::Find();
+
+    // Simulate and build the report
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "{\n  \"instruction_set\": \"%s\",\n  \"seconds\": %g,\n  \"delta\": %g,\n  \"effects\":\n  [\n",
+        ParticleKernels::InstructionSet(), seconds, delta);
+    std::string json = buffer;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        ParticleBench::WriteJSON(json, ParticleBench::Run(paths[i].string(), seconds, delta));
+        json += i + 1 < paths.size() ? ",\n" : "\n";
+    }
+    json += "  ]\n}\n";
+
+    // Write to the requested file, or stdout
+    if (outputPath.empty())
+    {
+        std::fputs(json.c_str(), stdout);
+    }
+    else
+    {
+        std::ofstream file(outputPath);
+        if (!file)
+        {
+            std::fprintf(stderr, "Failed to open %s\n", outputPath.c_str());
+            return 1;
+        }
+        file << json;
+    }
+
+    return 0;
+}
\ No newline at end of file
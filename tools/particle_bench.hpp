@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+
+// Phi engine
+#include <phi/phi.hpp>
+
+using namespace Phi;
+
+// Headless particle simulation harness for regression tracking
+//
+// Usage: particle_bench [--seconds N] [--delta D] [--output path]
+// Simulates every effect in data://effects for N seconds at a fixed delta without
+// an OpenGL context, and writes the results as JSON to the output file or stdout
+namespace ParticleBench
+{
+    // Results of simulating a single effect
+    struct EffectResult
+    {
+        std::string name;
+        int emitters = 0;
+        int updates = 0;
+        long long particleUpdates = 0;
+        double totalNs = 0.0;
+        int peakActiveParticles = 0;
+
+        // Heap allocations made during simulation (not while loading)
+        long long allocations = 0;
+        long long allocatedBytes = 0;
+    };
+
+    // Loads the effect at path and simulates it for the given time in steps of delta
+    EffectResult Run(const std::string& path, float seconds, float delta);
+
+    // Appends a result as a JSON object
+    void WriteJSON(std::string& out, const EffectResult& result);
+
+    // Appends a string as a quoted JSON string, escaping it as needed
+    void WriteJSONString(std::string& out, const std::string& value);
+}
\ No newline at end of file
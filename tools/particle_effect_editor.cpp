@@ -141,7 +141,7 @@ void ParticleEffectEditor::ShowEditorWindow()
                 else
                 {
                     // Load a new effect from disk
-                    auto effectFile = pfd::open_file("Load Effect File", File::GetDataPath() + "effects", {"Effect Files (.effect)", "*.effect"}, pfd::opt::none);
+                    auto effectFile = pfd::open_file("Load Effect File", File::GetDataPath() + "effects", {"Effect Files (.effect .effectbin)", "*.effect *.effectbin"}, pfd::opt::none);
                     if (effectFile.result().size() > 0)
                     {
                         // Grab the effect path, and convert it to the proper format
@@ -203,6 +203,22 @@ void ParticleEffectEditor::ShowEditorWindow()
                     lastTime = glfwGetTime();
                 }
             }
+            if (ImGui::MenuItem("Save (compiled binary)"))
+            {
+                if (currentEffect)
+                {
+                    // Compile the current effect to a binary file that loads without parsing
+                    auto saveFile = pfd::save_file("Save Compiled Effect", File::GetDataPath() + "effects", {"Compiled Effect Files (.effectbin)", "*.effectbin"}, pfd::opt::none);
+
+                    if (saveFile.result().size() > 0)
+                    {
+                        // Grab the path in proper format
+                        auto savePath = std::filesystem::path(saveFile.result()).generic_string();
+                        currentEffect->SaveBinary(savePath);
+                    }
+                    lastTime = glfwGetTime();
+                }
+            }
             if (ImGui::MenuItem("Close"))
             {
                 // Close the current loaded effect
@@ -271,7 +287,7 @@ void ParticleEffectEditor::ShowEditorWindow()
         if (ImGui::Button("OK", ImVec2(128, 0)))
         {
             // Load a new effect from disk
-            auto effectFile = pfd::open_file("Select Effect File", File::GetDataPath() + "effects", {"Effect Files (.effect)", "*.effect"}, pfd::opt::none);
+            auto effectFile = pfd::open_file("Select Effect File", File::GetDataPath() + "effects", {"Effect Files (.effect .effectbin)", "*.effect *.effectbin"}, pfd::opt::none);
 
             // Grab the path in proper format and load
             if (effectFile.result().size() > 0)
@@ -308,6 +324,31 @@ void ParticleEffectEditor::ShowEditorWindow()
         ImGui::InputText("Name", &currentEffect->name);
         ImGui::Checkbox("Spawn Relative to Transform", &currentEffect->spawnRelativeTransform);
         ImGui::Checkbox("Render Relative to Transform", &currentEffect->renderRelativeTransform);
+        ImGui::DragFloat("Fixed Timestep", &currentEffect->fixedTimestep, 0.0001f, 0.0f, 1.0f, "%.4f");
+        if (currentEffect->fixedTimestep > 0.0f)
+        {
+            ImGui::SliderInt("Max Substeps", &currentEffect->maxSubsteps, 1, 32);
+        }
+
+        // Level of detail
+        if (ImGui::CollapsingHeader("Level of Detail"))
+        {
+            auto& lod = currentEffect->LOD();
+            ImGui::Checkbox("Enabled", &lod.enabled);
+            ImGui::DragFloat("Radius", &lod.radius, 0.01f, 0.0f, 16'384.0f);
+            ImGui::DragFloat("Near Distance", &lod.nearDistance, 0.1f, 0.0f, 16'384.0f);
+            ImGui::DragFloat("Far Distance", &lod.farDistance, 0.1f, 0.0f, 16'384.0f);
+            ImGui::SliderInt("Max Tick Interval", &lod.maxTickInterval, 1, 60);
+            ImGui::SliderFloat("Min Spawn Scale", &lod.minSpawnScale, 0.0f, 1.0f);
+            ImGui::DragFloat("Budget Priority", &lod.budgetPriority, 0.01f, 0.0f, 16.0f);
+
+            const auto& stats = currentEffect->GetLODStats();
+            const char* levels[] = {"Full", "Reduced", "Dormant"};
+            ImGui::Text("Level: %s (%s), distance: %.1f", levels[(int)stats.level], stats.visible ? "visible" : "hidden", stats.distance);
+            ImGui::Text("Tick interval: %d, spawn scale: %.2f, budget scale: %.2f", stats.tickInterval, stats.spawnScale, stats.budgetScale);
+            ImGui::Text("Updates: %llu, skipped: %llu", (unsigned long long)stats.ticks, (unsigned long long)stats.skippedTicks);
+            ImGui::Text("Dormant frames: %llu, fast-forwards: %llu", (unsigned long long)stats.dormantFrames, (unsigned long long)stats.fastForwards);
+        }
 
         // Emitters
         ImGui::SeparatorText("Emitters");
@@ -328,41 +369,47 @@ void ParticleEffectEditor::ShowEditorWindow()
             // Push a unique identifier to the ID stack
             ImGui::PushID(&emitter);
 
-            if (ImGui::CollapsingHeader((emitter.name + "###").c_str(), &keepEmitter, ImGuiTreeNodeFlags_None))
+            if (ImGui::CollapsingHeader((emitter.GetDefinition()->name + "###").c_str(), &keepEmitter, ImGuiTreeNodeFlags_None))
             {
+                // Edits go to a private copy, other instances of the effect keep the loaded definition
+                auto& definition = emitter.EditDefinition();
+
                 // Load default selections
-                const char* blendSelection = blendOptions[(int)emitter.blendMode];
-                const char* spawnSelection = spawnOptions[(int)emitter.particleProperties.spawnMode];
-                const char* positionSelection = positionOptions[(int)emitter.particleProperties.positionMode];
-                const char* velocitySelection = velocityOptions[(int)emitter.particleProperties.velocityMode];
-                const char* colorSelection = colorOptions[(int)emitter.particleProperties.colorMode];
-                const char* sizeSelection = sizeOptions[(int)emitter.particleProperties.sizeMode];
-                const char* opacitySelection = opacityOptions[(int)emitter.particleProperties.opacityMode];
-                const char* lifespanSelection = lifespanOptions[(int)emitter.particleProperties.lifespanMode];
+                const char* blendSelection = blendOptions[(int)definition.blendMode];
+                const char* spawnSelection = spawnOptions[(int)definition.particleProperties.spawnMode];
+                const char* positionSelection = positionOptions[(int)definition.particleProperties.positionMode];
+                const char* velocitySelection = velocityOptions[(int)definition.particleProperties.velocityMode];
+                const char* colorSelection = colorOptions[(int)definition.particleProperties.colorMode];
+                const char* sizeSelection = sizeOptions[(int)definition.particleProperties.sizeMode];
+                const char* opacitySelection = opacityOptions[(int)definition.particleProperties.opacityMode];
+                const char* lifespanSelection = lifespanOptions[(int)definition.particleProperties.lifespanMode];
+                const char* collisionSelection = collisionOptions[(int)definition.affectorProperties.collisionResponse];
                 
                 // Display global properties
                 ImGui::SeparatorText("Emitter Properties");
-                ImGui::InputText("Name", &emitter.name);
-                ImGui::DragFloat("Duration", &emitter.duration, 0.001f, -1.0f, 65'536.0f);
-                if (ImGui::DragInt("Max Particles", &emitter.maxActiveParticles, 1, 0, CPUParticleEmitter::MAX_PARTICLES))
+                ImGui::InputText("Name", &definition.name);
+                ImGui::DragFloat("Duration", &definition.duration, 0.001f, -1.0f, 65'536.0f);
+                if (ImGui::DragInt("Max Particles", &definition.maxActiveParticles, 1, 0, CPUParticleEmitter::MAX_PARTICLES))
                 {
                     // Adjust particle pool and ensure stable simulation
-                    emitter.particlePool.resize(emitter.maxActiveParticles);
-                    if (emitter.activeParticles > emitter.maxActiveParticles)
-                    {
-                        emitter.activeParticles = emitter.maxActiveParticles;
-                    }
+                    emitter.ResizePool();
                 }
-                ImGui::DragFloat3("Offset", &emitter.offset[0], 0.001f, 0.0f, 0.0f);
+                bool orderedPool = definition.orderedPool;
+                if (ImGui::Checkbox("Ordered Pool", &orderedPool)) emitter.SetOrderedPool(orderedPool);
+                ImGui::DragFloat3("Offset", &definition.offset[0], 0.001f, 0.0f, 0.0f);
 
                 // Seed
-                ImGui::Checkbox("Random Seed", &emitter.randomSeed);
-                if (!emitter.randomSeed)
+                ImGui::Checkbox("Random Seed", &definition.randomSeed);
+                if (!definition.randomSeed)
                 {
-                    int seed = emitter.rng.GetSeed();
+                    int seed = definition.seed;
                     int oldSeed = seed;
                     ImGui::DragInt("Seed", &seed, 1.0f, INT32_MIN, INT32_MAX);
-                    if (seed != oldSeed) emitter.rng.SetSeed(seed);
+                    if (seed != oldSeed)
+                    {
+                        definition.seed = seed;
+                        emitter.rng.SetSeed(seed);
+                    }
                 }
 
                 // Display rendering properties
@@ -374,13 +421,17 @@ void ParticleEffectEditor::ShowEditorWindow()
                         bool is_selected = (blendSelection == blendOptions[n]);
                         if (ImGui::Selectable(blendOptions[n], is_selected))
                         {
-                            emitter.blendMode = (CPUParticleEmitter::BlendMode)n;
+                            definition.blendMode = (CPUParticleEmitter::BlendMode)n;
                         }
                         if (is_selected) ImGui::SetItemDefaultFocus();
                     }
                     ImGui::EndCombo();
                 }
-                ImGui::InputText("Texture", &emitter.texPath, ImGuiInputTextFlags_ReadOnly);
+                if (definition.blendMode == CPUParticleEmitter::BlendMode::Standard)
+                {
+                    ImGui::Checkbox("Depth Sort", &definition.depthSort);
+                }
+                ImGui::InputText("Texture", &definition.texPath, ImGuiInputTextFlags_ReadOnly);
                 if (ImGui::Button("Load"))
                 {
                     // Load a new texture
@@ -411,7 +462,7 @@ void ParticleEffectEditor::ShowEditorWindow()
                         bool is_selected = (spawnSelection == spawnOptions[n]);
                         if (ImGui::Selectable(spawnOptions[n], is_selected))
                         {
-                            emitter.particleProperties.spawnMode = (CPUParticleEmitter::SpawnMode)n;
+                            definition.particleProperties.spawnMode = (CPUParticleEmitter::SpawnMode)n;
                         }
                         if (is_selected) ImGui::SetItemDefaultFocus();
                     }
@@ -419,28 +470,28 @@ void ParticleEffectEditor::ShowEditorWindow()
                 }
 
                 // Show spawn rates if necessary
-                if (emitter.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::Continuous ||
-                    emitter.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::ContinuousBurst)
+                if (definition.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::Continuous ||
+                    definition.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::ContinuousBurst)
                 {
-                    ImGui::DragFloat("Spawn Rate", &emitter.particleProperties.spawnRate, 0.001f, 0.0f, 65'536.0f);
+                    ImGui::DragFloat("Spawn Rate", &definition.particleProperties.spawnRate, 0.001f, 0.0f, 65'536.0f);
                 }
-                else if (emitter.particleProperties.spawnMode != CPUParticleEmitter::SpawnMode::SingleBurst)
+                else if (definition.particleProperties.spawnMode != CPUParticleEmitter::SpawnMode::SingleBurst)
                 {
                     // Only display min and max if the mode is one of the random ones
-                    ImGui::DragFloat("Spawn Rate Min", &emitter.particleProperties.spawnRateMin, 0.001f, 0.0f, 65'536.0f);
-                    ImGui::DragFloat("Spawn Rate Max", &emitter.particleProperties.spawnRateMax, 0.001f, 0.0f, 65'536.0f);
+                    ImGui::DragFloat("Spawn Rate Min", &definition.particleProperties.spawnRateMin, 0.001f, 0.0f, 65'536.0f);
+                    ImGui::DragFloat("Spawn Rate Max", &definition.particleProperties.spawnRateMax, 0.001f, 0.0f, 65'536.0f);
                 }
 
                 // Show the burst counts if necessary
-                if (emitter.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::ContinuousBurst ||
-                    emitter.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::SingleBurst)
+                if (definition.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::ContinuousBurst ||
+                    definition.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::SingleBurst)
                 {
-                    ImGui::DragInt("Burst Count", &emitter.particleProperties.burstCount, 1, 1, CPUParticleEmitter::MAX_PARTICLES);
+                    ImGui::DragInt("Burst Count", &definition.particleProperties.burstCount, 1, 1, CPUParticleEmitter::MAX_PARTICLES);
                 }
-                else if (emitter.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::RandomBurst)
+                else if (definition.particleProperties.spawnMode == CPUParticleEmitter::SpawnMode::RandomBurst)
                 {
-                    ImGui::DragInt("Burst Count Min", &emitter.particleProperties.burstCountMin, 1, 1, CPUParticleEmitter::MAX_PARTICLES);
-                    ImGui::DragInt("Burst Count Max", &emitter.particleProperties.burstCountMax, 1, 1, CPUParticleEmitter::MAX_PARTICLES);
+                    ImGui::DragInt("Burst Count Min", &definition.particleProperties.burstCountMin, 1, 1, CPUParticleEmitter::MAX_PARTICLES);
+                    ImGui::DragInt("Burst Count Max", &definition.particleProperties.burstCountMax, 1, 1, CPUParticleEmitter::MAX_PARTICLES);
                 }
 
                 // Position properties
@@ -452,25 +503,25 @@ void ParticleEffectEditor::ShowEditorWindow()
                         bool is_selected = (positionSelection == positionOptions[n]);
                         if (ImGui::Selectable(positionOptions[n], is_selected))
                         {
-                            emitter.particleProperties.positionMode = (CPUParticleEmitter::PositionMode)n;
+                            definition.particleProperties.positionMode = (CPUParticleEmitter::PositionMode)n;
                         }
                         if (is_selected) ImGui::SetItemDefaultFocus();
                     }
                     ImGui::EndCombo();
                 }
-                if (emitter.particleProperties.positionMode == CPUParticleEmitter::PositionMode::Constant)
+                if (definition.particleProperties.positionMode == CPUParticleEmitter::PositionMode::Constant)
                 {
-                    ImGui::DragFloat3("Position", &emitter.particleProperties.position[0], 0.001f, 0.0f, 0.0f);
+                    ImGui::DragFloat3("Position", &definition.particleProperties.position[0], 0.001f, 0.0f, 0.0f);
                 }
-                else if (emitter.particleProperties.positionMode == CPUParticleEmitter::PositionMode::RandomMinMax)
+                else if (definition.particleProperties.positionMode == CPUParticleEmitter::PositionMode::RandomMinMax)
                 {
-                    ImGui::DragFloat3("Position Min", &emitter.particleProperties.positionMin[0], 0.001f, 0.0f, 0.0f);
-                    ImGui::DragFloat3("Position Max", &emitter.particleProperties.positionMax[0], 0.001f, 0.0f, 0.0f);
+                    ImGui::DragFloat3("Position Min", &definition.particleProperties.positionMin[0], 0.001f, 0.0f, 0.0f);
+                    ImGui::DragFloat3("Position Max", &definition.particleProperties.positionMax[0], 0.001f, 0.0f, 0.0f);
                 }
                 else
                 {
-                    ImGui::DragFloat3("Position", &emitter.particleProperties.position[0], 0.001f, 0.0f, 0.0f);
-                    ImGui::DragFloat("Radius", &emitter.particleProperties.spawnRadius, 0.001f, 0.0f, 0.0f);
+                    ImGui::DragFloat3("Position", &definition.particleProperties.position[0], 0.001f, 0.0f, 0.0f);
+                    ImGui::DragFloat("Radius", &definition.particleProperties.spawnRadius, 0.001f, 0.0f, 0.0f);
                 }
 
                 // Velocity properties
@@ -482,22 +533,22 @@ void ParticleEffectEditor::ShowEditorWindow()
                         bool is_selected = (velocitySelection == velocityOptions[n]);
                         if (ImGui::Selectable(velocityOptions[n], is_selected))
                         {
-                            emitter.particleProperties.velocityMode = (CPUParticleEmitter::VelocityMode)n;
+                            definition.particleProperties.velocityMode = (CPUParticleEmitter::VelocityMode)n;
                         }
                         if (is_selected) ImGui::SetItemDefaultFocus();
                     }
                     ImGui::EndCombo();
                 }
-                if (emitter.particleProperties.velocityMode == CPUParticleEmitter::VelocityMode::Constant)
+                if (definition.particleProperties.velocityMode == CPUParticleEmitter::VelocityMode::Constant)
                 {
-                    ImGui::DragFloat3("Velocity", &emitter.particleProperties.velocity[0], 0.001f, 0.0f, 0.0f);
+                    ImGui::DragFloat3("Velocity", &definition.particleProperties.velocity[0], 0.001f, 0.0f, 0.0f);
                 }
-                else if (emitter.particleProperties.velocityMode == CPUParticleEmitter::VelocityMode::RandomMinMax)
+                else if (definition.particleProperties.velocityMode == CPUParticleEmitter::VelocityMode::RandomMinMax)
                 {
-                    ImGui::DragFloat3("Velocity Min", &emitter.particleProperties.velocityMin[0], 0.001f, 0.0f, 0.0f);
-                    ImGui::DragFloat3("Velocity Max", &emitter.particleProperties.velocityMax[0], 0.001f, 0.0f, 0.0f);
+                    ImGui::DragFloat3("Velocity Min", &definition.particleProperties.velocityMin[0], 0.001f, 0.0f, 0.0f);
+                    ImGui::DragFloat3("Velocity Max", &definition.particleProperties.velocityMax[0], 0.001f, 0.0f, 0.0f);
                 }
-                ImGui::DragFloat("Damping", &emitter.particleProperties.damping, 0.001f, 0.0f, 1.0f);
+                ImGui::DragFloat("Damping", &definition.particleProperties.damping, 0.001f, 0.0f, 1.0f);
 
                 // Color properties
                 ImGui::Separator();
@@ -508,32 +559,32 @@ void ParticleEffectEditor::ShowEditorWindow()
                         bool is_selected = (colorSelection == colorOptions[n]);
                         if (ImGui::Selectable(colorOptions[n], is_selected))
                         {
-                            emitter.particleProperties.colorMode = (CPUParticleEmitter::ColorMode)n;
+                            definition.particleProperties.colorMode = (CPUParticleEmitter::ColorMode)n;
                         }
                         if (is_selected) ImGui::SetItemDefaultFocus();
                     }
                     ImGui::EndCombo();
                 }
                 static const auto colorFlags = ImGuiColorEditFlags_HDR | ImGuiColorEditFlags_Float;
-                switch (emitter.particleProperties.colorMode)
+                switch (definition.particleProperties.colorMode)
                 {
                     case CPUParticleEmitter::ColorMode::Constant:
-                        ImGui::ColorEdit3("Color", &emitter.particleProperties.color[0], colorFlags);
+                        ImGui::ColorEdit3("Color", &definition.particleProperties.color[0], colorFlags);
                         break;
                     
                     case CPUParticleEmitter::ColorMode::RandomMinMax:
-                        ImGui::ColorEdit3("Color Min", &emitter.particleProperties.colorMin[0], colorFlags);
-                        ImGui::ColorEdit3("Color Max", &emitter.particleProperties.colorMax[0], colorFlags);
+                        ImGui::ColorEdit3("Color Min", &definition.particleProperties.colorMin[0], colorFlags);
+                        ImGui::ColorEdit3("Color Max", &definition.particleProperties.colorMax[0], colorFlags);
                         break;
                     
                     case CPUParticleEmitter::ColorMode::RandomLerp:
-                        ImGui::ColorEdit3("Color A", &emitter.particleProperties.colorA[0], colorFlags);
-                        ImGui::ColorEdit3("Color B", &emitter.particleProperties.colorB[0], colorFlags);
+                        ImGui::ColorEdit3("Color A", &definition.particleProperties.colorA[0], colorFlags);
+                        ImGui::ColorEdit3("Color B", &definition.particleProperties.colorB[0], colorFlags);
                         break;
                     
                     case CPUParticleEmitter::ColorMode::LerpOverLifetime:
-                        ImGui::ColorEdit3("Start Color", &emitter.particleProperties.startColor[0], colorFlags);
-                        ImGui::ColorEdit3("End Color", &emitter.particleProperties.endColor[0], colorFlags);
+                        ImGui::ColorEdit3("Start Color", &definition.particleProperties.startColor[0], colorFlags);
+                        ImGui::ColorEdit3("End Color", &definition.particleProperties.endColor[0], colorFlags);
                         break;
                 }
 
@@ -546,31 +597,31 @@ void ParticleEffectEditor::ShowEditorWindow()
                         bool is_selected = (sizeSelection == sizeOptions[n]);
                         if (ImGui::Selectable(sizeOptions[n], is_selected))
                         {
-                            emitter.particleProperties.sizeMode = (CPUParticleEmitter::SizeMode)n;
+                            definition.particleProperties.sizeMode = (CPUParticleEmitter::SizeMode)n;
                         }
                         if (is_selected) ImGui::SetItemDefaultFocus();
                     }
                     ImGui::EndCombo();
                 }
-                switch (emitter.particleProperties.sizeMode)
+                switch (definition.particleProperties.sizeMode)
                 {
                     case CPUParticleEmitter::SizeMode::Constant:
-                        ImGui::DragFloat2("Size", &emitter.particleProperties.size[0], 0.001f, 0.0f, 1024.0f);
+                        ImGui::DragFloat2("Size", &definition.particleProperties.size[0], 0.001f, 0.0f, 1024.0f);
                         break;
                     
                     case CPUParticleEmitter::SizeMode::RandomMinMax:
-                        ImGui::DragFloat2("Size Min", &emitter.particleProperties.sizeMin[0], 0.001f, 0.0f, 1024.0f);
-                        ImGui::DragFloat2("Size Max", &emitter.particleProperties.sizeMax[0], 0.001f, 0.0f, 1024.0f);
+                        ImGui::DragFloat2("Size Min", &definition.particleProperties.sizeMin[0], 0.001f, 0.0f, 1024.0f);
+                        ImGui::DragFloat2("Size Max", &definition.particleProperties.sizeMax[0], 0.001f, 0.0f, 1024.0f);
                         break;
                     
                     case CPUParticleEmitter::SizeMode::RandomLerp:
-                        ImGui::DragFloat2("Size Min", &emitter.particleProperties.sizeMin[0], 0.001f, 0.0f, 1024.0f);
-                        ImGui::DragFloat2("Size Max", &emitter.particleProperties.sizeMax[0], 0.001f, 0.0f, 1024.0f);
+                        ImGui::DragFloat2("Size Min", &definition.particleProperties.sizeMin[0], 0.001f, 0.0f, 1024.0f);
+                        ImGui::DragFloat2("Size Max", &definition.particleProperties.sizeMax[0], 0.001f, 0.0f, 1024.0f);
                         break;
                     
                     case CPUParticleEmitter::SizeMode::LerpOverLifetime:
-                        ImGui::DragFloat2("Start Size", &emitter.particleProperties.startSize[0], 0.001f, 0.0f, 1024.0f);
-                        ImGui::DragFloat2("End Size", &emitter.particleProperties.endSize[0], 0.001f, 0.0f, 1024.0f);
+                        ImGui::DragFloat2("Start Size", &definition.particleProperties.startSize[0], 0.001f, 0.0f, 1024.0f);
+                        ImGui::DragFloat2("End Size", &definition.particleProperties.endSize[0], 0.001f, 0.0f, 1024.0f);
                         break;   
                 }
 
@@ -583,26 +634,26 @@ void ParticleEffectEditor::ShowEditorWindow()
                         bool is_selected = (opacitySelection == opacityOptions[n]);
                         if (ImGui::Selectable(opacityOptions[n], is_selected))
                         {
-                            emitter.particleProperties.opacityMode = (CPUParticleEmitter::OpacityMode)n;
+                            definition.particleProperties.opacityMode = (CPUParticleEmitter::OpacityMode)n;
                         }
                         if (is_selected) ImGui::SetItemDefaultFocus();
                     }
                     ImGui::EndCombo();
                 }
-                switch (emitter.particleProperties.opacityMode)
+                switch (definition.particleProperties.opacityMode)
                 {
                     case CPUParticleEmitter::OpacityMode::Constant:
-                        ImGui::SliderFloat("Opacity", &emitter.particleProperties.opacity, 0.0f, 1.0f);
+                        ImGui::SliderFloat("Opacity", &definition.particleProperties.opacity, 0.0f, 1.0f);
                         break;
                     
                     case CPUParticleEmitter::OpacityMode::RandomMinMax:
-                        ImGui::SliderFloat("Opacity Min", &emitter.particleProperties.opacityMin, 0.0f, 1.0f);
-                        ImGui::SliderFloat("Opacity Max", &emitter.particleProperties.opacityMax, 0.0f, 1.0f);
+                        ImGui::SliderFloat("Opacity Min", &definition.particleProperties.opacityMin, 0.0f, 1.0f);
+                        ImGui::SliderFloat("Opacity Max", &definition.particleProperties.opacityMax, 0.0f, 1.0f);
                         break;
                     
                     case CPUParticleEmitter::OpacityMode::LerpOverLifetime:
-                        ImGui::SliderFloat("Start Opacity", &emitter.particleProperties.startOpacity, 0.0f, 1.0f);
-                        ImGui::SliderFloat("End Opacity", &emitter.particleProperties.endOpacity, 0.0f, 1.0f);
+                        ImGui::SliderFloat("Start Opacity", &definition.particleProperties.startOpacity, 0.0f, 1.0f);
+                        ImGui::SliderFloat("End Opacity", &definition.particleProperties.endOpacity, 0.0f, 1.0f);
                         break;
                 }
 
@@ -615,28 +666,70 @@ void ParticleEffectEditor::ShowEditorWindow()
                         bool is_selected = (lifespanSelection == lifespanOptions[n]);
                         if (ImGui::Selectable(lifespanOptions[n], is_selected))
                         {
-                            emitter.particleProperties.lifespanMode = (CPUParticleEmitter::LifespanMode)n;
+                            definition.particleProperties.lifespanMode = (CPUParticleEmitter::LifespanMode)n;
                         }
                         if (is_selected) ImGui::SetItemDefaultFocus();
                     }
                     ImGui::EndCombo();
                 }
-                if (emitter.particleProperties.lifespanMode == CPUParticleEmitter::LifespanMode::Constant)
+                if (definition.particleProperties.lifespanMode == CPUParticleEmitter::LifespanMode::Constant)
                 {
-                    ImGui::DragFloat("Lifespan", &emitter.particleProperties.lifespan, 0.001f, 0.0f, 65'536.0f);
+                    ImGui::DragFloat("Lifespan", &definition.particleProperties.lifespan, 0.001f, 0.0f, 65'536.0f);
                 }
-                else if (emitter.particleProperties.lifespanMode == CPUParticleEmitter::LifespanMode::RandomMinMax)
+                else if (definition.particleProperties.lifespanMode == CPUParticleEmitter::LifespanMode::RandomMinMax)
                 {
-                    ImGui::DragFloat("Lifespan Min", &emitter.particleProperties.lifespanMin, 0.001f, 0.0f, 65'536.0f);
-                    ImGui::DragFloat("Lifespan Max", &emitter.particleProperties.lifespanMax, 0.001f, 0.0f, 65'536.0f);
+                    ImGui::DragFloat("Lifespan Min", &definition.particleProperties.lifespanMin, 0.001f, 0.0f, 65'536.0f);
+                    ImGui::DragFloat("Lifespan Max", &definition.particleProperties.lifespanMax, 0.001f, 0.0f, 65'536.0f);
                 }
 
                 // Display all affectors
 
                 // Basic affectors
                 ImGui::SeparatorText("Affectors");
-                ImGui::Checkbox("Add Velocity", &emitter.affectorProperties.addVelocity);
-                ImGui::Checkbox("Gravity", &emitter.affectorProperties.gravityEnabled);
+                ImGui::Checkbox("Add Velocity", &definition.affectorProperties.addVelocity);
+                ImGui::Checkbox("Gravity", &definition.affectorProperties.gravityEnabled);
+                ImGui::Checkbox("Bake Attractors", &definition.affectorProperties.bakeAttractors);
+                if (definition.affectorProperties.bakeAttractors)
+                {
+                    ImGui::SliderInt("Field Resolution", &definition.affectorProperties.attractorFieldResolution, 2, 128);
+                }
+                ImGui::Checkbox("Collision", &definition.affectorProperties.collisionEnabled);
+                if (definition.affectorProperties.collisionEnabled)
+                {
+                    if (ImGui::BeginCombo("Collision Response", collisionSelection))
+                    {
+                        for (int n = 0; n < IM_ARRAYSIZE(collisionOptions); n++)
+                        {
+                            bool is_selected = (collisionSelection == collisionOptions[n]);
+                            if (ImGui::Selectable(collisionOptions[n], is_selected))
+                            {
+                                definition.affectorProperties.collisionResponse = (ParticleCollider::Response)n;
+                            }
+                            if (is_selected) ImGui::SetItemDefaultFocus();
+                        }
+                        ImGui::EndCombo();
+                    }
+                    if (definition.affectorProperties.collisionResponse == ParticleCollider::Response::Bounce)
+                    {
+                        ImGui::SliderFloat("Restitution", &definition.affectorProperties.restitution, 0.0f, 1.0f);
+                    }
+                }
+                ImGui::Checkbox("Turbulence", &definition.affectorProperties.turbulenceEnabled);
+                if (definition.affectorProperties.turbulenceEnabled)
+                {
+                    ImGui::DragFloat("Turbulence Frequency", &definition.affectorProperties.turbulenceFrequency, 0.001f, 0.001f, 16.0f);
+                    ImGui::DragFloat("Turbulence Strength", &definition.affectorProperties.turbulenceStrength, 0.01f, -1'024.0f, 1'024.0f);
+                    ImGui::DragFloat3("Turbulence Scroll", &definition.affectorProperties.turbulenceScroll[0], 0.001f);
+                }
+                ImGui::Checkbox("Flocking", &definition.affectorProperties.flockingEnabled);
+                if (definition.affectorProperties.flockingEnabled)
+                {
+                    ImGui::DragFloat("Flocking Radius", &definition.affectorProperties.flockingRadius, 0.001f, 0.01f, 16.0f);
+                    ImGui::DragFloat("Separation", &definition.affectorProperties.separation, 0.01f, 0.0f, 1'024.0f);
+                    ImGui::DragFloat("Cohesion", &definition.affectorProperties.cohesion, 0.01f, 0.0f, 1'024.0f);
+                    ImGui::DragFloat("Alignment", &definition.affectorProperties.alignment, 0.01f, 0.0f, 1'024.0f);
+                    ImGui::SliderInt("Max Neighbours", &definition.affectorProperties.maxNeighbours, 1, 64);
+                }
 
                 // Attractors
                 ImGui::SeparatorText("Attractors");
@@ -644,10 +737,10 @@ void ParticleEffectEditor::ShowEditorWindow()
                 {
                     emitter.Attractors().emplace_back();
                 }
-                for (int i = 0; i < emitter.attractors.size(); ++i)
+                for (int i = 0; i < definition.attractors.size(); ++i)
                 {
                     // Grab attractor reference
-                    auto& a = emitter.attractors[i];
+                    auto& a = definition.attractors[i];
                     bool keepAttractor = true;
 
                     ImGui::PushID(&a);
@@ -670,6 +763,9 @@ void ParticleEffectEditor::ShowEditorWindow()
                     // Pop the attractor ID from the stack
                     ImGui::PopID();
                 }
+
+                // Modes or affectors may have changed, reselect specialized kernels
+                emitter.UpdateKernels();
             }
 
             // Delete the emitter if requested
@@ -57,4 +57,5 @@ class ParticleEffectEditor : public Phi::App
         static inline const char* sizeOptions[] = {"Constant", "Random Min Max", "Random Lerp", "Lerp Over Lifetime"};
         static inline const char* opacityOptions[] = {"Constant", "Random Min Max", "Lerp Over Lifetime"};
         static inline const char* lifespanOptions[] = {"Constant", "Random Min Max"};
+        static inline const char* collisionOptions[] = {"Kill", "Bounce", "Stick"};
 };
\ No newline at end of file
@@ -120,7 +120,9 @@ void VoxelEditor::Update(float delta)
     VoxelObject::RaycastInfo result = object->Raycast(ray);
     if (result.firstHit != -1)
     {
-        const Voxel& hitVoxel = result.visitedVoxels[result.firstHit > 0 ? result.firstHit - 1 : 0];
+        // Erasing selects the voxel hit, everything else the empty one in front of it
+        int selected = brushMode == BrushMode::Erase || result.firstHit == 0 ? result.firstHit : result.firstHit - 1;
+        const Voxel& hitVoxel = result.visitedVoxels[selected];
         selectedVoxel.x = hitVoxel.x;
         selectedVoxel.y = hitVoxel.y;
         selectedVoxel.z = hitVoxel.z;
@@ -153,7 +155,8 @@ void VoxelEditor::Update(float delta)
         for (const auto& it : currentEdits)
         {
             const Voxel& v = it.second;
-            object->SetVoxel(v.x, v.y, v.z, v.material);
+            if (brushMode == BrushMode::Erase) object->RemoveVoxel(v.x, v.y, v.z);
+            else object->SetVoxel(v.x, v.y, v.z, v.material);
         }
         currentEdits.clear();
         object->UpdateMesh();